@@ -68,5 +68,5 @@ uint16_t bal_compute_imbalance_with_target(
  * 
  * @returns	amount of cells to be discharged
  */
-uint16_t bal_exclude_neighbors(uint16_t indexes[], uint16_t count, uint32_t cells);
+uint16_t bal_exclude_neighbors(uint16_t indexes[], uint16_t count, uint32_t * cells);
 #endif
\ No newline at end of file
@@ -52,10 +52,23 @@ typedef struct {
     uint32_t cycle_length;
     voltage_t target;
     uint16_t threshold;
+    float duty; // Fraction of each period in which the resistors are on
 } bal_fsm_params;
 
+/** @brief Discharge plan computed by the mainboard */
+typedef struct {
+    bool is_active;
+    uint8_t seq;
+    uint32_t received;                           // Each bit represent a cell whose duration was received
+    uint32_t pending[CELLBOARD_CELL_COUNT];      // Discharge time of the plan being received (ms)
+    uint32_t remaining[CELLBOARD_CELL_COUNT];    // Remaining discharge time of each cell (ms)
+} bal_fsm_plan;
+
 extern bal_fsm_transition_request set_bal_request;
 extern bal_fsm_params bal_params;
+extern bal_fsm_plan bal_plan;
+extern float bal_energy[CELLBOARD_CELL_COUNT];
+extern float bal_charge[CELLBOARD_CELL_COUNT];
 
 // State human-readable names
 extern const char * state_names[];
@@ -116,6 +129,51 @@ bal_state_t fsm_get_state();
  * @return false Otherwise
  */
 bool bal_is_cells_empty();
+/**
+ * @brief Set the discharge time of a group of cells
+ * @details The plan is used by the FSM, instead of the threshold and target
+ * values, only when the durations of all the cells with the same sequence
+ * number are received
+ * 
+ * The dissipated energy and the removed charge are reset only by the plan
+ * which starts the balancing, so they cover the whole balancing even if the
+ * mainboard restarts the board with each new plan
+ * 
+ * @param seq The sequence number of the plan
+ * @param start True if the plan starts the balancing
+ * @param start_index The index of the first cell
+ * @param durations The discharge time of each cell (s)
+ * @param count The number of cells
+ */
+void bal_set_plan(uint8_t seq, bool start, size_t start_index, const uint8_t * durations, size_t count);
+/**
+ * @brief Get the cells which are not yet discharged as requested by the plan
+ * 
+ * @return uint32_t The bitmap of the cells to discharge
+ */
+uint32_t bal_get_plan_cells();
+/**
+ * @brief Get the current discharge duty
+ * 
+ * @return float The fraction of each period in which the resistors are on
+ */
+float bal_get_duty();
+/**
+ * @brief Get the energy dissipated by the resistor of a cell since
+ * the start of the balancing
+ * 
+ * @param index The index of the cell
+ * @return float The dissipated energy (J)
+ */
+float bal_get_energy(size_t index);
+/**
+ * @brief Get the charge removed from a cell by its resistor since
+ * the start of the balancing
+ * 
+ * @param index The index of the cell
+ * @return float The removed charge (mAh)
+ */
+float bal_get_charge(size_t index);
 /**
  * @brief Balancing timer output compare callback function
  * 
@@ -32,6 +32,12 @@
 #define VOLT_MEASURE_INTERVAL 8
 #define VOLT_MEASURE_TIME     5
 
+/**
+ * Time after the last snapshot trigger received from the mainboard (ms)
+ * before going back to the free running voltage measurements
+ */
+#define VOLT_SNAPSHOT_TIMEOUT 200
+
 //===========================================================================
 //================================= Temperature =============================
 //===========================================================================
@@ -41,9 +47,14 @@
  */
 #define TEMP_MEASURE_INTERVAL 200
 
-#define TEMP_ADC_COUNT 6
+#define TEMP_ADC_COUNT CELLBOARD_TEMP_STRIP_COUNT
+
+#define TEMP_ADC_SENSOR_COUNT CELLBOARD_TEMP_STRIP_SENSOR_COUNT
 
-#define TEMP_ADC_SENSOR_COUNT 6
+// The board has 6 ADCs with 6 inputs each
+#if TEMP_ADC_COUNT > 6 || TEMP_ADC_SENSOR_COUNT > 6
+#error "The cellboard cannot read this many temperature sensors"
+#endif
 
 /**
  * How many sensors on each cellboard
@@ -62,6 +73,47 @@
 #define HTIM_DISCHARGE htim15
 #define HTIM_COOLDOWN htim16
 
+//===========================================================================
+//================================= Balancing ===============================
+//===========================================================================
+
+/**
+ * Length of a discharge period, the on time is this period
+ * multiplied by the discharge duty (ms)
+ */
+#define BAL_PERIOD (BAL_TIME_ON + BAL_TIME_OFF)
+
+/**
+ * Minimum time the resistors are kept off in each period so that
+ * the cell voltages can be measured (ms)
+ */
+#define BAL_MIN_TIME_OFF 200
+
+/**
+ * Board temperature the duty controller tries to keep (°C)
+ */
+#define BAL_TEMP_TARGET 45.f
+
+/**
+ * Board temperature above which the resistors are kept off (°C)
+ */
+#define BAL_TEMP_LIMIT 50.f
+
+/**
+ * Maximum power the board can dissipate through the resistors (W)
+ */
+#define BAL_MAX_POWER 6.f
+
+/**
+ * Duty variation for each degree of error in a single period (1/°C)
+ */
+#define BAL_DUTY_GAIN 0.01f
+
+/**
+ * Duty used at the start of the balancing
+ */
+#define BAL_DUTY_DEFAULT ((float)BAL_TIME_ON / BAL_PERIOD)
+
 typedef float temperature_t;
 typedef int16_t current_t;
 
@@ -25,7 +25,8 @@ typedef enum {
     ERROR_TEMP_COMM_3,
     ERROR_TEMP_COMM_4,
     ERROR_TEMP_COMM_5,
-    ERROR_OPEN_WIRE
+    ERROR_OPEN_WIRE,
+    ERROR_TEMP_SENSOR
 } error_types;
 
 typedef uint16_t error_t;
@@ -1,23 +1,45 @@
 #include "tim.h"
+#include "volt_schedule.h"
 
 #define VOLTS_START_CONVERTION_CHANNEL TIM_CHANNEL_1
 #define VOLTS_READ_CHANNEL             TIM_CHANNEL_2
 #define TEMPS_READ_CHANNEL             TIM_CHANNEL_3
+#define VOLTS_SNAPSHOT_READ_CHANNEL    TIM_CHANNEL_4
 
 #define VOLTS_START_CONVERTION_ACTIVE_CHANNEL HAL_TIM_ACTIVE_CHANNEL_1
 #define VOLTS_READ_ACTIVE_CHANNEL             HAL_TIM_ACTIVE_CHANNEL_2
 #define TEMPS_READ_ACTIVE_CHANNEL             HAL_TIM_ACTIVE_CHANNEL_3
+#define VOLTS_SNAPSHOT_READ_ACTIVE_CHANNEL    HAL_TIM_ACTIVE_CHANNEL_4
 
-typedef uint8_t measurements_flag_t;
+typedef volt_schedule_flag_t measurements_flag_t;
 
+// The voltage flags are handled by the schedule
 enum {
-    MEASUREMENTS_VOLTS_START_CONVERTION_FLAG = 1,
-    MEASUREMENTS_VOLTS_READ_FLAG             = 2,
-    MEASUREMENTS_TEMPS_READ_FLAG             = 4
+    MEASUREMENTS_VOLTS_START_CONVERTION_FLAG = VOLT_SCHEDULE_START_FLAG,
+    MEASUREMENTS_VOLTS_READ_FLAG             = VOLT_SCHEDULE_READ_FLAG,
+    MEASUREMENTS_TEMPS_READ_FLAG             = 4,
+    MEASUREMENTS_VOLTS_SNAPSHOT_START_FLAG   = VOLT_SCHEDULE_SNAPSHOT_START_FLAG,
+    MEASUREMENTS_VOLTS_SNAPSHOT_READ_FLAG    = VOLT_SCHEDULE_SNAPSHOT_READ_FLAG
 };
 
 void measurements_init(TIM_HandleTypeDef *htim);
 
 void measurements_flags_check();
 
-void measurements_oc_handler(TIM_HandleTypeDef *htim);
\ No newline at end of file
+void measurements_oc_handler(TIM_HandleTypeDef *htim);
+
+/**
+ * @brief Request a voltage conversion synchronized with the other cellboards
+ * @details While the snapshots are requested by the mainboard the free running
+ * voltage measurements are suspended (the open wire check keeps running)
+ * 
+ * @param seq The sequence number of the snapshot
+ */
+void measurements_snapshot_request(uint8_t seq);
+/**
+ * @brief Get the sequence number of the snapshot of the last voltage
+ * conversion started, which can be older than the last one requested
+ * 
+ * @return uint8_t The sequence number
+ */
+uint8_t measurements_get_snapshot_seq();
\ No newline at end of file
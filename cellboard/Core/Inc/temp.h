@@ -48,4 +48,20 @@ temperature_t temp_get_average();
 temperature_t temp_get_max();
 temperature_t temp_get_min();
 
+/**
+ * @brief Sensors replaced by the interpolation of their neighbors, the ones
+ * excluded in the pack description and the ones found unhealthy at runtime
+ *
+ * @return uint64_t A bit for each sensor
+ */
+uint64_t temp_get_excluded();
+
+/**
+ * @brief Number of sensors found unhealthy at runtime, ERROR_TEMP_SENSOR is
+ * set while it is not zero
+ *
+ * @return uint8_t The number of unhealthy sensors
+ */
+uint8_t temp_get_unhealthy_count();
+
 #endif // TEMP_H
\ No newline at end of file
@@ -0,0 +1,107 @@
+/**
+ * @file		temp_health.h
+ * @brief		Health check of the temperature sensors and interpolation of
+ * 				the excluded ones, without any dependency on the HAL
+ *
+ * @date		Oct 19, 2026
+ */
+
+#ifndef TEMP_HEALTH_H
+#define TEMP_HEALTH_H
+
+#include "../../../fenice_config.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define TEMP_HEALTH_STRIP_COUNT CELLBOARD_TEMP_STRIP_COUNT
+#define TEMP_HEALTH_STRIP_SENSOR_COUNT CELLBOARD_TEMP_STRIP_SENSOR_COUNT
+#define TEMP_HEALTH_SENSOR_COUNT (TEMP_HEALTH_STRIP_COUNT * TEMP_HEALTH_STRIP_SENSOR_COUNT)
+
+/**
+ * Maximum number of neighbors used to interpolate an excluded sensor, the
+ * other sensors of its strip
+ */
+#define TEMP_NEIGHBOR_COUNT (TEMP_HEALTH_STRIP_SENSOR_COUNT - 1)
+
+/**
+ * Range of plausible values (°C), a sensor reading outside of it is excluded.
+ * It is wider than the cell limits so a real fault is always reported
+ */
+#define TEMP_HEALTH_MIN -30.f
+#define TEMP_HEALTH_MAX 120.f
+
+/**
+ * A sensor is stuck if it reads the same value for this many measurements
+ * while the average of the board moves by at least TEMP_HEALTH_STUCK_DELTA (°C)
+ */
+#define TEMP_HEALTH_STUCK_COUNT 150
+#define TEMP_HEALTH_STUCK_DELTA 2.f
+
+/**
+ * Consecutive good measurements before an unhealthy sensor is included again
+ */
+#define TEMP_HEALTH_RECOVERY_COUNT 25
+
+/** @brief Sensors around a sensor and their weights in the interpolation */
+typedef struct {
+    uint8_t index[TEMP_NEIGHBOR_COUNT];
+    uint8_t weight[TEMP_NEIGHBOR_COUNT];
+    uint8_t count;
+} temp_neighbors_t;
+
+/** @brief Runtime health of a sensor */
+typedef struct {
+    float last;        // Last value read, before any substitution (°C)
+    float reference;   // Board average when the value stopped changing (°C)
+    uint8_t unchanged; // Consecutive reads with the same value
+    uint8_t healthy;   // Consecutive plausible reads of an unhealthy sensor
+} temp_sensor_health_t;
+
+/** @brief Health of every sensor of the board */
+typedef struct {
+    temp_neighbors_t neighbors[TEMP_HEALTH_SENSOR_COUNT];
+    temp_sensor_health_t sensors[TEMP_HEALTH_SENSOR_COUNT];
+    uint64_t unhealthy; // A bit for each sensor found unhealthy at runtime
+} temp_health_t;
+
+/**
+ * @brief Reset the health of every sensor and build the interpolation table
+ * @details The neighbors of a sensor are the other sensors of its strip, all
+ * with the same weight: the placement of the strips on the board is not known,
+ * so the sensors of the strips at its sides are not used
+ *
+ * @param health The health structure
+ */
+void temp_health_init(temp_health_t * health);
+
+/**
+ * @brief Update the health of a sensor with a new value
+ * @details A sensor is unhealthy when its value is out of the plausible range
+ * or when it is stuck on the same value while the rest of the board changes
+ * temperature. It is included again after TEMP_HEALTH_RECOVERY_COUNT good reads
+ *
+ * @param health The health structure
+ * @param index The index of the sensor
+ * @param value The value read (°C)
+ * @param average The average of the board at the previous measurement (°C)
+ * @return true If the sensor has just become unhealthy
+ * @return false Otherwise
+ */
+bool temp_health_update(temp_health_t * health, size_t index, float value, float average);
+
+/**
+ * @brief Replace the values of the excluded sensors with the weighted average
+ * of their included neighbors
+ * @details If every neighbor of a sensor is excluded the average of the
+ * included sensors of the board is used, or the fallback if none is included
+ *
+ * @param health The health structure
+ * @param temperatures The values of every sensor of the board (°C)
+ * @param excluded A bit for each sensor to replace
+ * @param fallback The value used when every sensor is excluded (°C)
+ */
+void temp_health_interpolate(const temp_health_t * health, float * temperatures, uint64_t excluded, float fallback);
+
+#endif // TEMP_HEALTH_H
@@ -0,0 +1,101 @@
+/**
+ * @file		volt_schedule.h
+ * @brief		Order of the voltage conversions run on the LTC, without any
+ * 				dependency on the HAL
+ *
+ * @details The free running measurements, the steps of the open wire check
+ * and the snapshots requested by the mainboard share the same conversion.
+ * The timers only raise flags, the schedule turns them into the actions
+ * to run, one at a time, so that a conversion is never read under the
+ * sequence number of the one started after it
+ *
+ * @date		Oct 19, 2026
+ */
+
+#ifndef VOLT_SCHEDULE_H
+#define VOLT_SCHEDULE_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+/** @brief Number of steps of the open wire check, the last one runs the check */
+#define VOLT_SCHEDULE_OPEN_WIRE_STEPS 4U
+
+typedef uint8_t volt_schedule_flag_t;
+
+/** @brief Events of the timers, the bits not listed are left to the caller */
+enum {
+    VOLT_SCHEDULE_START_FLAG          = 1,
+    VOLT_SCHEDULE_READ_FLAG           = 2,
+    VOLT_SCHEDULE_SNAPSHOT_START_FLAG = 8,
+    VOLT_SCHEDULE_SNAPSHOT_READ_FLAG  = 16
+};
+
+/** @brief Type of the voltage conversion currently running on the LTC */
+typedef enum {
+    VOLT_CONVERSION_NONE,
+    VOLT_CONVERSION_NORMAL,
+    VOLT_CONVERSION_OPEN_WIRE,
+    VOLT_CONVERSION_SNAPSHOT
+} volt_conversion_t;
+
+/** @brief What has to be done on the LTC */
+typedef enum {
+    VOLT_SCHEDULE_IDLE,                // Nothing left to do
+    VOLT_SCHEDULE_SNAPSHOT_READ,       // Read and send the snapshot
+    VOLT_SCHEDULE_SNAPSHOT_START,      // Start the snapshot conversion and its read timer
+    VOLT_SCHEDULE_MEASURE_START,       // Start a normal conversion
+    VOLT_SCHEDULE_MEASURE_READ,        // Read and send the voltages
+    VOLT_SCHEDULE_OPEN_WIRE_START,     // Start the step of the open wire check
+    VOLT_SCHEDULE_OPEN_WIRE_READ       // Read the step of the open wire check
+} volt_schedule_action_t;
+
+typedef struct {
+    volt_conversion_t conversion;
+    uint8_t open_wire_step;  // Next step, 0 for a normal measurement, 1 to VOLT_SCHEDULE_OPEN_WIRE_STEPS for the open wire check
+    uint8_t conversion_step; // Step of the open wire conversion started last
+    uint8_t snapshot_seq;    // Sequence number of the last snapshot requested
+    uint8_t conversion_seq;  // Sequence number of the snapshot being converted
+} volt_schedule_t;
+
+/**
+ * @brief Reset the schedule, no conversion running
+ *
+ * @param schedule The schedule
+ */
+void volt_schedule_init(volt_schedule_t * schedule);
+
+/**
+ * @brief Save the sequence number of a snapshot request
+ * @details The caller raises VOLT_SCHEDULE_SNAPSHOT_START_FLAG
+ *
+ * @param schedule The schedule
+ * @param seq The sequence number of the snapshot
+ */
+void volt_schedule_snapshot_request(volt_schedule_t * schedule, uint8_t seq);
+
+/**
+ * @brief Consume the pending flags up to the first one with an action to run
+ * @details A pending snapshot read is handled before a new snapshot restarts
+ * the conversion, then the free running conversions are started and read
+ * unless a snapshot has taken their place. A step of the open wire check
+ * replaced by a snapshot is repeated. The step to start or read is in
+ * conversion_step
+ *
+ * @param schedule The schedule
+ * @param flags The pending flags, the ones handled are cleared
+ * @param snapshot_active True if the mainboard is requesting the snapshots,
+ * the free running measurements are suspended
+ * @return volt_schedule_action_t The action, VOLT_SCHEDULE_IDLE once no flag is left
+ */
+volt_schedule_action_t volt_schedule_next(volt_schedule_t * schedule, volt_schedule_flag_t * flags, bool snapshot_active);
+
+/**
+ * @brief Get the sequence number of the snapshot of the conversion started last
+ *
+ * @param schedule The schedule
+ * @return uint8_t The sequence number
+ */
+uint8_t volt_schedule_get_snapshot_seq(const volt_schedule_t * schedule);
+
+#endif // VOLT_SCHEDULE_H
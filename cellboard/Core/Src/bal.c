@@ -48,12 +48,12 @@ size_t _min_index(voltage_t data[], size_t count) {
  * @param	out	output array
  * @param	out_index	length of output (initialize to 0 please)
  */
-void _bal_hateville_solution(uint16_t DP[], uint16_t i, uint32_t cells, uint16_t *out_index) {
+void _bal_hateville_solution(uint16_t DP[], uint16_t i, uint32_t * cells, uint16_t *out_index) {
     if (i == 0) {
         return;
     } else if (i == 1) {
         if (DP[1] > 0) {
-            cells |= 1;
+            *cells |= 1;
             ++(*out_index);
         }
         return;
@@ -62,7 +62,7 @@ void _bal_hateville_solution(uint16_t DP[], uint16_t i, uint32_t cells, uint16_t
         return;
     } else {
         _bal_hateville_solution(DP, i - 2, cells, out_index);
-        cells |= 1 << ((i - 1) % LTC6813_CELL_COUNT);
+        *cells |= 1U << ((i - 1) % LTC6813_CELL_COUNT);
         ++(*out_index);
         return;
     }
@@ -75,11 +75,11 @@ void _bal_hateville_solution(uint16_t DP[], uint16_t i, uint32_t cells, uint16_t
  * 
  * @param	D			Input data
  * @param	count		Input size
- * @param	solution	Output data
+ * @param	solution	Output bitmap of the cells to discharge
  * 
  * @returns	length of the solution array
  */
-uint16_t _bal_hateville(uint16_t D[], uint16_t count, uint32_t solution) {
+uint16_t _bal_hateville(uint16_t D[], uint16_t count, uint32_t * solution) {
     uint16_t DP[PACK_CELL_COUNT + 1];
 
     DP[0] = 0;
@@ -90,6 +90,7 @@ uint16_t _bal_hateville(uint16_t D[], uint16_t count, uint32_t solution) {
     }
 
     uint16_t out_index = 0;
+    *solution = 0;
     _bal_hateville_solution(DP, count, solution, &out_index);
     return out_index;
 }
@@ -167,6 +168,6 @@ uint16_t bal_compute_imbalance(voltage_t volts[], uint16_t count, voltage_t thre
     return indexes;
 }
 
-uint16_t bal_exclude_neighbors(uint16_t data[], uint16_t count, uint32_t cells) {
+uint16_t bal_exclude_neighbors(uint16_t data[], uint16_t count, uint32_t * cells) {
     return _bal_hateville(data, count, cells);
 }
\ No newline at end of file
@@ -20,8 +20,11 @@ The finite state machine has:
 #include "spi.h"
 #include "ltc6813.h"
 #include "bal.h"
+#include "can_comms.h"
 #include "cellboard_config.h"
+#include "temp.h"
 #include "volt.h"
+#include "../../../fenice_network.h"
 
 // SEARCH FOR Your Code Here FOR CODE INSERTION POINTS!
 
@@ -37,13 +40,25 @@ bal_fsm_params bal_params = {
     .discharge_cells = 0,
     .cycle_length = DCTO_30S,
     .target = CELL_MAX_VOLTAGE,
-    .threshold = BAL_THRESHOLD_DEFAULT
+    .threshold = BAL_THRESHOLD_DEFAULT,
+    .duty = BAL_DUTY_DEFAULT
 };
 bal_fsm_transition_request set_bal_request = {
     .is_new = false,
     .next_state = STATE_OFF
 };
 
+bal_fsm_plan bal_plan = {
+    .is_active = false,
+    .seq = 0,
+    .received = 0
+};
+
+float bal_energy[CELLBOARD_CELL_COUNT] = { 0 };
+float bal_charge[CELLBOARD_CELL_COUNT] = { 0 };
+uint32_t discharge_tick = 0;
+uint32_t discharge_time_on = 0;
+
 bool discharge_timeout = false;
 bool cooldown_timeout = false;
 
@@ -87,6 +102,137 @@ bool bal_is_cells_empty() {
     return bal_params.discharge_cells == 0;
 }
 
+/**
+ * @brief Get the cells to discharge from the plan if available or from
+ * the target and threshold otherwise
+ * 
+ * @param cells The output bitmap of the cells to discharge (can be NULL)
+ * @return size_t The number of cells to discharge
+ */
+size_t _bal_get_cells_to_discharge(uint32_t * cells) {
+    if (!bal_plan.is_active) {
+        return bal_get_cells_to_discharge(
+            volt_get_volts(),
+            cells,
+            bal_params.target,
+            bal_params.threshold
+        );
+    }
+
+    uint32_t planned = bal_get_plan_cells();
+    if (cells != NULL)
+        *cells = planned;
+
+    size_t count = 0;
+    for (; planned != 0; planned &= planned - 1)
+        ++count;
+    return count;
+}
+
+/**
+ * @brief Update the remaining discharge time of the planned cells
+ * 
+ * @param cells The cells that were discharged
+ * @param time The discharge time (ms)
+ */
+void _bal_plan_consume(uint32_t cells, uint32_t time) {
+    for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+        if ((cells & (1U << i)) == 0)
+            continue;
+        bal_plan.remaining[i] = bal_plan.remaining[i] > time ? bal_plan.remaining[i] - time : 0U;
+    }
+}
+
+/**
+ * @brief Get the maximum duty which keeps the power dissipated by the
+ * resistors below the board limit
+ * 
+ * @param cells The bitmap of the cells to discharge
+ * @return float The maximum duty
+ */
+float _bal_get_max_duty(uint32_t cells) {
+    float duty = 1.f - (float)BAL_MIN_TIME_OFF / BAL_PERIOD;
+    float power = 0.f;
+    for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+        if (cells & (1U << i)) {
+            float volt = CONVERT_VALUE_TO_VOLTAGE(voltages[i]);
+            power += volt * volt / DISCHARGE_R;
+        }
+    }
+    if (power > 0.f)
+        duty = MIN(duty, BAL_MAX_POWER / power);
+    return duty;
+}
+/**
+ * @brief Update the discharge duty based on the board temperature
+ * @details Integral controller which raises the duty while the board is
+ * below BAL_TEMP_TARGET and lowers it otherwise, the duty is limited by
+ * the number of active resistors and zeroed above BAL_TEMP_LIMIT
+ * 
+ * @param cells The bitmap of the cells to discharge
+ */
+void _bal_update_duty(uint32_t cells) {
+    temperature_t temp = temp_get_max();
+    if (temp >= BAL_TEMP_LIMIT)
+        bal_params.duty = 0.f;
+    else
+        bal_params.duty += BAL_DUTY_GAIN * (BAL_TEMP_TARGET - temp);
+    bal_params.duty = MAX(0.f, MIN(bal_params.duty, _bal_get_max_duty(cells)));
+}
+/**
+ * @brief Turn on the resistors of the cells to discharge
+ * 
+ * @return uint32_t The time the resistors has to stay on, 0 if they are kept off (ms)
+ */
+uint32_t _bal_discharge_start() {
+    _bal_update_duty(bal_params.discharge_cells);
+    discharge_time_on = (uint32_t)(bal_params.duty * BAL_PERIOD);
+    if (discharge_time_on == 0 || bal_params.discharge_cells == 0) {
+        discharge_time_on = 0;
+        return 0;
+    }
+
+    discharge_tick = HAL_GetTick();
+    bal_params.is_s_pin_high = true;
+    ltc6813_set_balancing(&LTC6813_SPI, bal_params.discharge_cells, bal_params.cycle_length);
+    return discharge_time_on;
+}
+/**
+ * @brief Turn off the resistors and update the dissipated energy, the
+ * removed charge and the plan with the actual discharge time
+ */
+void _bal_discharge_stop() {
+    ltc6813_set_balancing(&LTC6813_SPI, 0, DCTO_DISABLED);
+    if (!bal_params.is_s_pin_high)
+        return;
+    bal_params.is_s_pin_high = false;
+
+    uint32_t time = HAL_GetTick() - discharge_tick;
+    for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+        if (bal_params.discharge_cells & (1U << i)) {
+            float volt = CONVERT_VALUE_TO_VOLTAGE(voltages[i]);
+            bal_energy[i] += volt * volt / DISCHARGE_R * time / 1000.f;
+            bal_charge[i] += volt / DISCHARGE_R * time / 1000.f;
+        }
+    }
+    if (bal_plan.is_active)
+        _bal_plan_consume(bal_params.discharge_cells, time);
+}
+/**
+ * @brief Restart the discharge timer and turn on the resistors
+ */
+void _bal_discharge_timer_start() {
+    uint32_t time_on = _bal_discharge_start();
+
+    // If the resistors are kept off wait for a whole period
+    __HAL_TIM_SetCounter(&HTIM_DISCHARGE, 0U);
+    __HAL_TIM_SetCompare(&HTIM_DISCHARGE, TIM_CHANNEL_1, TIM_MS_TO_TICKS(&HTIM_DISCHARGE, time_on > 0 ? time_on : BAL_PERIOD));
+    __HAL_TIM_CLEAR_IT(&HTIM_DISCHARGE, TIM_IT_UPDATE);
+
+    HAL_TIM_Base_Start_IT(&HTIM_DISCHARGE);
+    HAL_TIM_OC_Start_IT(&HTIM_DISCHARGE, TIM_CHANNEL_1);
+}
+
 /*  ____  _        _       
  * / ___|| |_ __ _| |_ ___ 
  * \___ \| __/ _` | __/ _ \
@@ -152,12 +298,7 @@ bal_state_t do_discharge(state_data_t *data) {
   
   /* Your Code Here */
   // Get cells to discharge
-  size_t count = bal_get_cells_to_discharge(
-    volt_get_volts(),
-    NULL,
-    bal_params.target,
-    bal_params.threshold
-  );
+  size_t count = _bal_get_cells_to_discharge(NULL);
 
   if (_requested_bal_off() || count == 0)
     next_state = STATE_OFF;
@@ -187,12 +328,7 @@ bal_state_t do_cooldown(state_data_t *data) {
   
   /* Your Code Here */
   // Get cells to discharge
-  size_t count = bal_get_cells_to_discharge(
-    volt_get_volts(),
-    NULL,
-    bal_params.target,
-    bal_params.threshold
-  );
+  size_t count = _bal_get_cells_to_discharge(NULL);
 
   if (_requested_bal_off() || count == 0)
     next_state = STATE_OFF;
@@ -249,26 +385,14 @@ void start_discharge(state_data_t * data) {
   HAL_UART_Transmit(&CLI_UART, (uint8_t *)"[FSM] State transition start_discharge\r\n", 40, 100);
   /* Your Code Here */
 
-  // Reset the discharge timer
-  __HAL_TIM_SetCounter(&HTIM_DISCHARGE, 0U);
-  __HAL_TIM_SetCompare(&HTIM_DISCHARGE, TIM_CHANNEL_1, TIM_MS_TO_TICKS(&HTIM_DISCHARGE, BAL_TIME_ON));
-  __HAL_TIM_CLEAR_IT(&HTIM_DISCHARGE, TIM_IT_UPDATE);
+  // Reset the duty, the energy and the charge are reset by the plan which starts the balancing
+  bal_params.duty = BAL_DUTY_DEFAULT;
 
-  // Start discharge timer
-  HAL_TIM_Base_Start_IT(&HTIM_DISCHARGE);
-  HAL_TIM_OC_Start_IT(&HTIM_DISCHARGE, TIM_CHANNEL_1);
-  
   // Calculate cells to discharge
-  bal_get_cells_to_discharge(
-    volt_get_volts(),
-    &bal_params.discharge_cells,
-    bal_params.target,
-    bal_params.threshold
-  );
+  _bal_get_cells_to_discharge(&bal_params.discharge_cells);
 
-  // Start balancing
-  bal_params.is_s_pin_high = true;
-  ltc6813_set_balancing(&LTC6813_SPI, bal_params.discharge_cells, bal_params.cycle_length);
+  // Start balancing and the discharge timer
+  _bal_discharge_timer_start();
 
   discharge_timeout = false;
 }
@@ -291,13 +415,19 @@ void stop_balancing(state_data_t * data) {
   __HAL_TIM_CLEAR_IT(&HTIM_COOLDOWN, TIM_IT_UPDATE);
 
   // Reset balancing
-  bal_params.is_s_pin_high = false;
+  _bal_discharge_stop();
   bal_params.discharge_cells = 0;
-  ltc6813_set_balancing(&LTC6813_SPI, bal_params.discharge_cells, DCTO_DISABLED);
+
+  // Discard the current plan
+  bal_plan.is_active = false;
 
   // Reset timeouts
   discharge_timeout = false;
   cooldown_timeout = false;
+
+  // Send the total dissipated energy and removed charge
+  can_send(BMS_BALANCING_ENERGY_FRAME_ID);
+  can_send(BMS_BALANCING_CHARGE_FRAME_ID);
 }
 
 // This function is called in 1 transition:
@@ -316,8 +446,7 @@ void start_cooldown(state_data_t *data) {
   HAL_TIM_Base_Start_IT(&HTIM_COOLDOWN);
 
   // Reset balancing
-  bal_params.is_s_pin_high = false;
-  ltc6813_set_balancing(&LTC6813_SPI, 0, DCTO_DISABLED);
+  _bal_discharge_stop();
 
   // Reset cooldown timeout
   cooldown_timeout = false;
@@ -333,26 +462,11 @@ void cooldown_to_discharge(state_data_t *data) {
   HAL_TIM_Base_Stop_IT(&HTIM_COOLDOWN);
   __HAL_TIM_CLEAR_IT(&HTIM_COOLDOWN, TIM_IT_UPDATE);
 
-  // Reset the discharge timer
-  __HAL_TIM_SetCounter(&HTIM_DISCHARGE, 0U);
-  __HAL_TIM_SetCompare(&HTIM_DISCHARGE, TIM_CHANNEL_1, TIM_MS_TO_TICKS(&HTIM_DISCHARGE, BAL_TIME_ON));
-  __HAL_TIM_CLEAR_IT(&HTIM_DISCHARGE, TIM_IT_UPDATE);
-
-  // Start discharge timer
-  HAL_TIM_Base_Start_IT(&HTIM_DISCHARGE);
-  HAL_TIM_OC_Start_IT(&HTIM_DISCHARGE, TIM_CHANNEL_1);
-
   // Calculate cells to discharge
-  bal_get_cells_to_discharge(
-    volt_get_volts(),
-    &bal_params.discharge_cells,
-    bal_params.target,
-    bal_params.threshold
-  );
+  _bal_get_cells_to_discharge(&bal_params.discharge_cells);
 
-  // Restart balancing
-  bal_params.is_s_pin_high = true;
-  ltc6813_set_balancing(&LTC6813_SPI, bal_params.discharge_cells, bal_params.cycle_length);
+  // Restart balancing and the discharge timer
+  _bal_discharge_timer_start();
 
   // Reset discharge time
   discharge_timeout = false;
@@ -398,19 +512,74 @@ bal_state_t fsm_get_state() {
     return fsm_state;
 }
 
+void bal_set_plan(uint8_t seq, bool start, size_t start_index, const uint8_t * durations, size_t count) {
+    if (durations == NULL || start_index + count > CELLBOARD_CELL_COUNT)
+        return;
+
+    // Discard the incomplete plan if a new one is received
+    if (seq != bal_plan.seq) {
+        bal_plan.seq = seq;
+        bal_plan.received = 0;
+
+        // Reset the dissipated energy and the removed charge once for each balancing
+        if (start) {
+            memset(bal_energy, 0, sizeof(bal_energy));
+            memset(bal_charge, 0, sizeof(bal_charge));
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        bal_plan.pending[start_index + i] = (uint32_t)durations[i] * 1000U;
+        bal_plan.received |= 1U << (start_index + i);
+    }
+
+    // Activate the plan once all the cells are received
+    if (bal_plan.received == (1U << CELLBOARD_CELL_COUNT) - 1U) {
+        memcpy(bal_plan.remaining, bal_plan.pending, sizeof(bal_plan.remaining));
+        bal_plan.received = 0;
+        bal_plan.is_active = true;
+    }
+}
+uint32_t bal_get_plan_cells() {
+    uint32_t cells = 0;
+    for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+        if (bal_plan.remaining[i] > 0)
+            cells |= 1U << i;
+    }
+    return cells;
+}
+
+float bal_get_duty() {
+    return bal_params.duty;
+}
+float bal_get_energy(size_t index) {
+    if (index >= CELLBOARD_CELL_COUNT)
+        return 0.f;
+    return bal_energy[index];
+}
+float bal_get_charge(size_t index) {
+    if (index >= CELLBOARD_CELL_COUNT)
+        return 0.f;
+    // Convert from C to mAh
+    return bal_charge[index] / 3.6f;
+}
+
 void bal_oc_timer_handler(TIM_HandleTypeDef * htim) {
     if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_1) {
         uint32_t cmp = __HAL_TIM_GetCompare(htim, TIM_CHANNEL_1);
         
         if (bal_params.is_s_pin_high) {
-            ltc6813_set_balancing(&LTC6813_SPI, 0, DCTO_DISABLED);
-            __HAL_TIM_SET_COMPARE(&HTIM_DISCHARGE, TIM_CHANNEL_1, cmp + TIM_MS_TO_TICKS(htim, BAL_TIME_OFF));
+            _bal_discharge_stop();
+            __HAL_TIM_SET_COMPARE(&HTIM_DISCHARGE, TIM_CHANNEL_1, cmp + TIM_MS_TO_TICKS(htim, BAL_PERIOD - discharge_time_on));
         }
         else {
-            ltc6813_set_balancing(&LTC6813_SPI, bal_params.discharge_cells, bal_params.cycle_length);
-            __HAL_TIM_SET_COMPARE(&HTIM_DISCHARGE, TIM_CHANNEL_1, cmp + TIM_MS_TO_TICKS(htim, BAL_TIME_ON));
+            // Cells which have completed their plan are not discharged anymore
+            if (bal_plan.is_active)
+                bal_params.discharge_cells = bal_get_plan_cells();
+
+            // If the resistors are kept off wait for a whole period
+            uint32_t time_on = _bal_discharge_start();
+            __HAL_TIM_SET_COMPARE(&HTIM_DISCHARGE, TIM_CHANNEL_1, cmp + TIM_MS_TO_TICKS(htim, time_on > 0 ? time_on : BAL_PERIOD));
         }
-        bal_params.is_s_pin_high = !bal_params.is_s_pin_high;
     }
 }
 // TODO: Handle discharge timeouts greater than 30s
@@ -21,7 +21,9 @@
 #include "spi.h"
 #include "temp.h"
 #include "volt.h"
+#include "measurements.h"
 #include "bms_network.h"
+#include "../../../fenice_network.h"
 
 #define RETRANSMISSION_MAX_ATTEMPTS 1
 uint8_t retransmission_attempts[3] = { 0 };
@@ -89,6 +91,20 @@ void can_init_with_filter() {
     filter.FilterMaskIdLow = BMS_TOPIC_MASK_FIXED_IDS << 5;
     HAL_CAN_ConfigFilter(&BMS_CAN, &filter);
 
+    // Add voltage snapshot trigger message id to the filters
+    filter.FilterBank = 2;
+    filter.FilterIdLow = BMS_SNAPSHOT_TRIGGER_FRAME_ID << 5;
+    filter.FilterIdHigh = BMS_SNAPSHOT_TRIGGER_FRAME_ID << 5;
+    filter.FilterMaskIdHigh = 0x7FF << 5;
+    filter.FilterMaskIdLow = 0x7FF << 5;
+    HAL_CAN_ConfigFilter(&BMS_CAN, &filter);
+
+    // Add balancing plan message id to the filters
+    filter.FilterBank = 3;
+    filter.FilterIdLow = BMS_BALANCING_PLAN_FRAME_ID << 5;
+    filter.FilterIdHigh = BMS_BALANCING_PLAN_FRAME_ID << 5;
+    HAL_CAN_ConfigFilter(&BMS_CAN, &filter);
+
     // Start CAN
     HAL_CAN_ActivateNotification(&BMS_CAN, CAN_IT_RX_FIFO0_MSG_PENDING | CAN_IT_TX_MAILBOX_EMPTY | CAN_IT_LAST_ERROR_CODE | CAN_IT_ERROR);
     HAL_CAN_Start(&BMS_CAN);
@@ -196,6 +212,25 @@ void can_send(uint16_t id) {
             return;
         tx_header.DLC = data_len;
     } 
+    else if (id == BMS_TEMP_EXCLUDED_FRAME_ID) {
+        uint64_t excluded = temp_get_excluded();
+        for (size_t i = 0; i < CELLBOARD_TEMP_SENSOR_COUNT; i += BMS_TEMP_EXCLUDED_SENSOR_COUNT) {
+            bms_temp_excluded_t raw_excluded = { 0 };
+
+            raw_excluded.cellboard_id = cellboard_index;
+            raw_excluded.group = i / BMS_TEMP_EXCLUDED_SENSOR_COUNT;
+            raw_excluded.unhealthy = temp_get_unhealthy_count();
+            raw_excluded.excluded = (excluded >> i) & ((1ULL << BMS_TEMP_EXCLUDED_SENSOR_COUNT) - 1U);
+
+            int data_len = bms_temp_excluded_pack(buffer, &raw_excluded, BMS_TEMP_EXCLUDED_BYTE_SIZE);
+            if (data_len >= 0) {
+                tx_header.DLC = data_len;
+                _can_send(&BMS_CAN, buffer, &tx_header);
+                HAL_Delay(1);
+            }
+        }
+        return;
+    }
     else if (id == BMS_VOLTAGES_FRAME_ID) {
         for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i += 3) {
             bms_voltages_t raw_volts = { 0 };
@@ -218,6 +253,62 @@ void can_send(uint16_t id) {
         }
         return;
     }
+    else if (id == BMS_SNAPSHOT_VOLTAGES_FRAME_ID) {
+        for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i += BMS_SNAPSHOT_VOLTAGES_CELL_COUNT) {
+            bms_snapshot_voltages_t raw_volts = { 0 };
+
+            raw_volts.cellboard_id = cellboard_index;
+            raw_volts.start_index = i;
+            raw_volts.seq = measurements_get_snapshot_seq();
+            for (size_t j = 0; j < BMS_SNAPSHOT_VOLTAGES_CELL_COUNT; ++j)
+                raw_volts.voltages[j] = voltages[i + j];
+
+            int data_len = bms_snapshot_voltages_pack(buffer, &raw_volts, BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE);
+            if (data_len >= 0) {
+                tx_header.DLC = data_len;
+                _can_send(&BMS_CAN, buffer, &tx_header);
+                HAL_Delay(1);
+            }
+        }
+        return;
+    }
+    else if (id == BMS_BALANCING_ENERGY_FRAME_ID) {
+        for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i += BMS_BALANCING_ENERGY_CELL_COUNT) {
+            bms_balancing_energy_t raw_energy = { 0 };
+
+            raw_energy.cellboard_id = cellboard_index;
+            raw_energy.start_index = i;
+            raw_energy.duty = (uint8_t)(bal_get_duty() * 100.f);
+            for (size_t j = 0; j < BMS_BALANCING_ENERGY_CELL_COUNT; ++j)
+                raw_energy.energies[j] = (uint16_t)MIN(bal_get_energy(i + j), (float)UINT16_MAX);
+
+            int data_len = bms_balancing_energy_pack(buffer, &raw_energy, BMS_BALANCING_ENERGY_BYTE_SIZE);
+            if (data_len >= 0) {
+                tx_header.DLC = data_len;
+                _can_send(&BMS_CAN, buffer, &tx_header);
+                HAL_Delay(1);
+            }
+        }
+        return;
+    }
+    else if (id == BMS_BALANCING_CHARGE_FRAME_ID) {
+        for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i += BMS_BALANCING_CHARGE_CELL_COUNT) {
+            bms_balancing_charge_t raw_charge = { 0 };
+
+            raw_charge.cellboard_id = cellboard_index;
+            raw_charge.start_index = i;
+            for (size_t j = 0; j < BMS_BALANCING_CHARGE_CELL_COUNT; ++j)
+                raw_charge.charges[j] = (uint16_t)MIN(bal_get_charge(i + j) * 10.f, (float)UINT16_MAX);
+
+            int data_len = bms_balancing_charge_pack(buffer, &raw_charge, BMS_BALANCING_CHARGE_BYTE_SIZE);
+            if (data_len >= 0) {
+                tx_header.DLC = data_len;
+                _can_send(&BMS_CAN, buffer, &tx_header);
+                HAL_Delay(1);
+            }
+        }
+        return;
+    }
     else if (id == BMS_VOLTAGES_INFO_FRAME_ID) {
         bms_voltages_info_t raw_volts = { 0 };
         bms_voltages_info_converted_t conv_volts = { 0 };
@@ -269,7 +360,32 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef * hcan) {
         // Reset can errors
         ERROR_UNSET(ERROR_CAN);
 
-        if (rx_header.StdId == BMS_SET_BALANCING_STATUS_FRAME_ID) {
+        if (rx_header.StdId == BMS_SNAPSHOT_TRIGGER_FRAME_ID) {
+            bms_snapshot_trigger_t raw_trigger = { 0 };
+
+            if (bms_snapshot_trigger_unpack(&raw_trigger, rx_data, rx_header.DLC) < 0) {
+                ERROR_SET(ERROR_CAN);
+                return;
+            }
+            measurements_snapshot_request(raw_trigger.seq);
+        }
+        else if (rx_header.StdId == BMS_BALANCING_PLAN_FRAME_ID) {
+            bms_balancing_plan_t raw_plan = { 0 };
+
+            if (bms_balancing_plan_unpack(&raw_plan, rx_data, rx_header.DLC) < 0) {
+                ERROR_SET(ERROR_CAN);
+                return;
+            }
+            if (raw_plan.cellboard_id == cellboard_index && raw_plan.group < BMS_BALANCING_PLAN_GROUP_COUNT) {
+                bal_set_plan(
+                    raw_plan.seq,
+                    raw_plan.start,
+                    raw_plan.group * BMS_BALANCING_PLAN_CELL_COUNT,
+                    raw_plan.durations,
+                    BMS_BALANCING_PLAN_CELL_COUNT);
+            }
+        }
+        else if (rx_header.StdId == BMS_SET_BALANCING_STATUS_FRAME_ID) {
             bms_set_balancing_status_t raw_bal = { 0 };
             bms_set_balancing_status_converted_t conv_bal = { 0 };
 
@@ -1,12 +1,32 @@
 #include "measurements.h"
 
+#include <stdbool.h>
+
+#include "bal_fsm.h"
+#include "can_comms.h"
+#include "cellboard_config.h"
 #include "temp.h"
 #include "tim.h"
 #include "volt.h"
+#include "volt_schedule.h"
+#include "bms_network.h"
+#include "../../../fenice_network.h"
 
 measurements_flag_t flags;
+volt_schedule_t schedule;
+
+uint32_t snapshot_tick = 0;
+bool is_snapshot_requested = false;
 
-uint8_t open_wire_check_status = 0;
+/**
+ * @brief Check if the mainboard is requesting the voltage snapshots
+ * 
+ * @return true If a snapshot was requested in the last VOLT_SNAPSHOT_TIMEOUT ms
+ * @return false Otherwise
+ */
+bool _measurements_is_snapshot_active() {
+    return is_snapshot_requested && (HAL_GetTick() - snapshot_tick) < VOLT_SNAPSHOT_TIMEOUT;
+}
 
 void measurements_init(TIM_HandleTypeDef *htim) {
     __HAL_TIM_SetCompare(
@@ -19,42 +39,75 @@ void measurements_init(TIM_HandleTypeDef *htim) {
     HAL_TIM_OC_Start_IT(htim, VOLTS_START_CONVERTION_CHANNEL);
     HAL_TIM_OC_Start_IT(htim, VOLTS_READ_CHANNEL);
     HAL_TIM_OC_Start_IT(htim, TEMPS_READ_CHANNEL);
+    volt_schedule_init(&schedule);
     flags = 0;
 }
 
 void measurements_flags_check() {
-    if (flags & MEASUREMENTS_VOLTS_START_CONVERTION_FLAG) {
-        if (open_wire_check_status) {
-            volt_start_open_wire_check(open_wire_check_status);
-        } else {
-            volt_start_measure();
+    volt_schedule_action_t action;
+    while ((action = volt_schedule_next(&schedule, &flags, _measurements_is_snapshot_active())) != VOLT_SCHEDULE_IDLE) {
+        switch (action) {
+            case VOLT_SCHEDULE_SNAPSHOT_READ:
+                volt_read();
+                can_send(BMS_SNAPSHOT_VOLTAGES_FRAME_ID);
+                can_send(BMS_VOLTAGES_INFO_FRAME_ID);
+                break;
+            case VOLT_SCHEDULE_SNAPSHOT_START:
+                volt_start_measure();
+                __HAL_TIM_SetCompare(
+                    &HTIM_MEASURES,
+                    VOLTS_SNAPSHOT_READ_CHANNEL,
+                    __HAL_TIM_GetCounter(&HTIM_MEASURES) + TIM_MS_TO_TICKS(&HTIM_MEASURES, VOLT_MEASURE_TIME));
+                __HAL_TIM_CLEAR_IT(&HTIM_MEASURES, TIM_IT_CC4);
+                HAL_TIM_OC_Start_IT(&HTIM_MEASURES, VOLTS_SNAPSHOT_READ_CHANNEL);
+                break;
+            case VOLT_SCHEDULE_MEASURE_START:
+                volt_start_measure();
+                break;
+            case VOLT_SCHEDULE_MEASURE_READ:
+                volt_read();
+                can_send(BMS_VOLTAGES_FRAME_ID);
+                can_send(BMS_VOLTAGES_INFO_FRAME_ID);
+                break;
+            case VOLT_SCHEDULE_OPEN_WIRE_START:
+                volt_start_open_wire_check(schedule.conversion_step);
+                break;
+            case VOLT_SCHEDULE_OPEN_WIRE_READ:
+                volt_read_open_wire(schedule.conversion_step);
+                if (schedule.conversion_step == VOLT_SCHEDULE_OPEN_WIRE_STEPS)
+                    volt_open_wire_check();
+                break;
+            default:
+                break;
         }
-        flags &= ~MEASUREMENTS_VOLTS_START_CONVERTION_FLAG;
-    }
-    if (flags & MEASUREMENTS_VOLTS_READ_FLAG) {
-        if (open_wire_check_status) {
-            volt_read_open_wire(open_wire_check_status);
-            if (open_wire_check_status == 4)
-                volt_open_wire_check();
-        } else {
-            volt_read();
-            can_send(BMS_VOLTAGES_FRAME_ID);
-            can_send(BMS_VOLTAGES_INFO_FRAME_ID);
-        }
-        open_wire_check_status = (open_wire_check_status + 1) % 5;
-        flags &= ~MEASUREMENTS_VOLTS_READ_FLAG;
     }
     if (flags & MEASUREMENTS_TEMPS_READ_FLAG) {
         temp_measure_all();
         can_send(BMS_TEMPERATURES_FRAME_ID);
         can_send(BMS_TEMPERATURES_INFO_FRAME_ID);
+        can_send(BMS_TEMP_EXCLUDED_FRAME_ID);
         can_send(BMS_BOARD_STATUS_FRAME_ID);
         can_send(BMS_CELLBOARD_VERSION_FRAME_ID);
+        if (fsm_get_state() != STATE_OFF) {
+            can_send(BMS_BALANCING_ENERGY_FRAME_ID);
+            can_send(BMS_BALANCING_CHARGE_FRAME_ID);
+        }
         // can_send(0);
         flags &= ~MEASUREMENTS_TEMPS_READ_FLAG;
     }
 }
 
+void measurements_snapshot_request(uint8_t seq) {
+    volt_schedule_snapshot_request(&schedule, seq);
+    snapshot_tick = HAL_GetTick();
+    is_snapshot_requested = true;
+    flags |= MEASUREMENTS_VOLTS_SNAPSHOT_START_FLAG;
+}
+
+uint8_t measurements_get_snapshot_seq() {
+    return volt_schedule_get_snapshot_seq(&schedule);
+}
+
 void measurements_oc_handler(TIM_HandleTypeDef *htim) {
     uint32_t cnt = __HAL_TIM_GetCounter(htim);
     switch (htim->Channel) {
@@ -76,6 +129,11 @@ void measurements_oc_handler(TIM_HandleTypeDef *htim) {
             flags |= MEASUREMENTS_TEMPS_READ_FLAG;
             break;
 
+        case VOLTS_SNAPSHOT_READ_ACTIVE_CHANNEL:
+            HAL_TIM_OC_Stop_IT(htim, VOLTS_SNAPSHOT_READ_CHANNEL);
+            flags |= MEASUREMENTS_VOLTS_SNAPSHOT_READ_FLAG;
+            break;
+
         default:
             break;
     }
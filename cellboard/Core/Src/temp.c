@@ -10,6 +10,7 @@
 
 #include "error.h"
 #include "i2c.h"
+#include "temp_health.h"
 
 #include <math.h>
 #include <float.h>
@@ -22,7 +23,7 @@ temperature_t average = 0;
 temperature_t max = 0;
 temperature_t min = CELL_MAX_TEMPERATURE;
 
-static const uint8_t adc_addresses[6] = {
+static const uint8_t adc_addresses[TEMP_ADC_COUNT] = {
     ADCTEMP_CELL_1_ADR,
     ADCTEMP_CELL_2_ADR,
     ADCTEMP_CELL_3_ADR,
@@ -31,31 +32,17 @@ static const uint8_t adc_addresses[6] = {
     ADCTEMP_CELL_6_ADR
 };
 
-static const bool excluded_temps[CELLBOARD_COUNT][CELLBOARD_TEMP_SENSOR_COUNT] = {
-    [0] = { [7] = true, [26] = true },
-    [1] = { [0] = true, [4] = true, [6] = true, [8] = true, [13] = true, [35] = true },
-    [2] = { [15] = true, [21] = true, [26] = true, [29] = true },
-    [3] = { [5] = true, [6] = true, [25] = true, [26] = true },
-    [4] = { [1] = true, [3] = true, [13] = true, [14] = true, [23] = true, [35] = true },
-    [5] = { [3] = true, [7] = true, [9] = true, [14] = true, [18] = true, [29] = true }
-};
+// Generated from the pack description, a bit for each sensor
+#define _TEMP_EXCLUDED(cellboard, sensors) [cellboard] = (sensors),
+static const uint64_t excluded_temps[CELLBOARD_COUNT] = { PACK_EXCLUDED_TEMPS(_TEMP_EXCLUDED) };
+#undef _TEMP_EXCLUDED
 
-/**
- * @brief Check if a certain temperature sensor value has to be included
- * 
- * @param idx The index of the sensor
- * @return true If the value can be included
- * @return false Otherwise
- */
-bool _temp_include_cell(size_t idx) {
-    if (cellboard_index >= CELLBOARD_COUNT)
-        return false;
-    if (idx >= CELLBOARD_TEMP_SENSOR_COUNT)
-        return false;
-    return !excluded_temps[cellboard_index][idx];
-}
+static temp_health_t health;
+static uint64_t excluded = 0U;
 
 void temp_init() {
+    temp_health_init(&health);
+
     //initialize all ADCs
     for (uint8_t i = 0; i < TEMP_ADC_COUNT; i++) {
         uint8_t retry = 1;
@@ -75,58 +62,63 @@ void temp_set_limits(temperature_t min, temperature_t max) {
     assert_param(max >= min);
 
     for (uint8_t i = 0; i < TEMP_ADC_COUNT; i++) {
-        for (uint8_t sens = ADCTEMP_INPUT_1_REG; sens <= ADCTEMP_INPUT_6_REG; sens++) {
+        for (uint8_t sens = ADCTEMP_INPUT_1_REG; sens < ADCTEMP_INPUT_1_REG + TEMP_ADC_SENSOR_COUNT; sens++) {
             ADCTEMP_set_Temperature_Limit(&hi2c1, adc_addresses[i], sens, max, min);
         }
     }
 }
 
 void temp_measure(uint8_t adc_index) {
-    for (uint8_t sens = ADCTEMP_INPUT_1_REG; sens <= ADCTEMP_INPUT_6_REG; sens++) {
+    for (uint8_t sens = ADCTEMP_INPUT_1_REG; sens < ADCTEMP_INPUT_1_REG + TEMP_ADC_SENSOR_COUNT; sens++) {
         uint8_t temp_index = (adc_index * TEMP_ADC_SENSOR_COUNT) + sens;
 
         if (ADCTEMP_read_Temp(&ADC_I2C, adc_addresses[adc_index], sens, &temperatures[temp_index]) !=
             ADCTEMP_STATE_OK) {
             ERROR_SET(ERROR_TEMP_COMM_0 + adc_index);
+            // The array can hold an interpolated value, go back to the last one read
+            temperatures[temp_index] = health.sensors[temp_index].last;
         } else {
             ERROR_UNSET(ERROR_TEMP_COMM_0 + adc_index);
-
-            // Change excluded temperatures
-            if (!_temp_include_cell(temp_index)) {
-                size_t cnt = 0U;
-                temperature_t temp = 0U;
-
-                size_t base = (temp_index / 6U) * 6U;
-                for (size_t i = base; i < base + 6U; ++i) {
-                    if (_temp_include_cell(i)) {
-                        temp += temperatures[i];
-                        ++cnt;
-                    }
-                }
-                // Average the temperatures
-                temperatures[temp_index] = (cnt > 0) ? (temp / cnt) : average;
-            }
-
-            max = MAX(temperatures[temp_index], max);
-            min = MIN(temperatures[temp_index], min);                
+            if (temp_health_update(&health, temp_index, temperatures[temp_index], average))
+                ERROR_SET(ERROR_TEMP_SENSOR);
         }
     }
 }
 
 void temp_measure_all() {
-    max = 0;
-    min = CELL_MAX_TEMPERATURE;
     for (uint8_t adc = 0; adc < TEMP_ADC_COUNT; adc++) {
         temp_measure(adc);
     }
 
-    double sum = 0;
-    size_t tot = 0;
+    // The error stays set as long as a sensor is unhealthy
+    if (health.unhealthy == 0U)
+        ERROR_UNSET(ERROR_TEMP_SENSOR);
+
+    excluded = health.unhealthy;
+    if (cellboard_index < CELLBOARD_COUNT)
+        excluded |= excluded_temps[cellboard_index];
+    temp_health_interpolate(&health, temperatures, excluded, average);
+
+    max = 0;
+    min = CELL_MAX_TEMPERATURE;
+    temperature_t sum = 0.f;
     for (uint16_t i = 0; i < CELLBOARD_TEMP_SENSOR_COUNT; i++) {
+        max = MAX(temperatures[i], max);
+        min = MIN(temperatures[i], min);
         sum += temperatures[i];
-        tot++;
     }
-    average = sum / tot;
+    average = sum / CELLBOARD_TEMP_SENSOR_COUNT;
+}
+
+uint64_t temp_get_excluded() {
+    return excluded;
+}
+
+uint8_t temp_get_unhealthy_count() {
+    uint8_t count = 0U;
+    for (uint64_t mask = health.unhealthy; mask != 0U; mask &= mask - 1U)
+        ++count;
+    return count;
 }
 
 temperature_t temp_get_average() {
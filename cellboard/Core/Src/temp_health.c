@@ -0,0 +1,98 @@
+/**
+ * @file		temp_health.c
+ * @brief		Health check of the temperature sensors and interpolation of
+ * 				the excluded ones, without any dependency on the HAL
+ *
+ * @date		Oct 19, 2026
+ */
+
+#include "temp_health.h"
+
+#include <math.h>
+#include <string.h>
+
+/**
+ * @brief Add a neighbor to the interpolation table of a sensor
+ *
+ * @param n The neighbors of the sensor
+ * @param index The index of the neighbor
+ * @param weight The weight of the neighbor
+ */
+void _temp_health_add_neighbor(temp_neighbors_t * n, uint8_t index, uint8_t weight) {
+    n->index[n->count]  = index;
+    n->weight[n->count] = weight;
+    ++n->count;
+}
+
+void temp_health_init(temp_health_t * health) {
+    memset(health, 0, sizeof(*health));
+
+    for (int8_t strip = 0; strip < TEMP_HEALTH_STRIP_COUNT; ++strip) {
+        for (int8_t sens = 0; sens < TEMP_HEALTH_STRIP_SENSOR_COUNT; ++sens) {
+            temp_neighbors_t * n = &health->neighbors[strip * TEMP_HEALTH_STRIP_SENSOR_COUNT + sens];
+
+            for (int8_t y = 0; y < TEMP_HEALTH_STRIP_SENSOR_COUNT; ++y) {
+                if (y != sens)
+                    _temp_health_add_neighbor(n, strip * TEMP_HEALTH_STRIP_SENSOR_COUNT + y, 1U);
+            }
+        }
+    }
+}
+
+bool temp_health_update(temp_health_t * health, size_t index, float value, float average) {
+    temp_sensor_health_t * h = &health->sensors[index];
+    bool was_healthy = (health->unhealthy & TEMP_SENSOR(index)) == 0U;
+
+    if (value == h->last) {
+        if (h->unchanged == 0U)
+            h->reference = average;
+        if (h->unchanged < UINT8_MAX)
+            ++h->unchanged;
+    } else {
+        h->unchanged = 0U;
+    }
+    h->last = value;
+
+    bool plausible = value >= TEMP_HEALTH_MIN && value <= TEMP_HEALTH_MAX;
+    bool stuck     = h->unchanged >= TEMP_HEALTH_STUCK_COUNT && fabsf(average - h->reference) >= TEMP_HEALTH_STUCK_DELTA;
+    if (!plausible || stuck) {
+        health->unhealthy |= TEMP_SENSOR(index);
+        h->healthy = 0U;
+        return was_healthy;
+    }
+    if (!was_healthy && ++h->healthy >= TEMP_HEALTH_RECOVERY_COUNT) {
+        health->unhealthy &= ~TEMP_SENSOR(index);
+        h->healthy = 0U;
+    }
+    return false;
+}
+
+void temp_health_interpolate(const temp_health_t * health, float * temperatures, uint64_t excluded, float fallback) {
+    // Average of the included sensors, used when a whole area is excluded
+    float sum  = 0.f;
+    size_t tot = 0;
+    for (size_t i = 0; i < TEMP_HEALTH_SENSOR_COUNT; ++i) {
+        if ((excluded & TEMP_SENSOR(i)) == 0U) {
+            sum += temperatures[i];
+            ++tot;
+        }
+    }
+    if (tot > 0)
+        fallback = sum / tot;
+
+    for (size_t i = 0; i < TEMP_HEALTH_SENSOR_COUNT; ++i) {
+        if ((excluded & TEMP_SENSOR(i)) == 0U)
+            continue;
+
+        const temp_neighbors_t * n = &health->neighbors[i];
+        float weighted  = 0.f;
+        uint8_t weights = 0U;
+        for (uint8_t j = 0; j < n->count; ++j) {
+            if ((excluded & TEMP_SENSOR(n->index[j])) == 0U) {
+                weighted += n->weight[j] * temperatures[n->index[j]];
+                weights += n->weight[j];
+            }
+        }
+        temperatures[i] = (weights > 0U) ? (weighted / weights) : fallback;
+    }
+}
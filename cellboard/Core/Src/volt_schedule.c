@@ -0,0 +1,73 @@
+/**
+ * @file		volt_schedule.c
+ * @brief		Order of the voltage conversions run on the LTC, without any
+ * 				dependency on the HAL
+ *
+ * @date		Oct 19, 2026
+ */
+
+#include "volt_schedule.h"
+
+#include <string.h>
+
+void volt_schedule_init(volt_schedule_t * schedule) {
+    memset(schedule, 0, sizeof(*schedule));
+    schedule->conversion = VOLT_CONVERSION_NONE;
+}
+
+void volt_schedule_snapshot_request(volt_schedule_t * schedule, uint8_t seq) {
+    schedule->snapshot_seq = seq;
+}
+
+volt_schedule_action_t volt_schedule_next(volt_schedule_t * schedule, volt_schedule_flag_t * flags, bool snapshot_active) {
+    // Send the snapshot already converted before a new request restarts the conversion
+    if (*flags & VOLT_SCHEDULE_SNAPSHOT_READ_FLAG) {
+        *flags &= ~VOLT_SCHEDULE_SNAPSHOT_READ_FLAG;
+        schedule->conversion = VOLT_CONVERSION_NONE;
+        return VOLT_SCHEDULE_SNAPSHOT_READ;
+    }
+    // The snapshot has the priority over any other conversion
+    if (*flags & VOLT_SCHEDULE_SNAPSHOT_START_FLAG) {
+        *flags &= ~VOLT_SCHEDULE_SNAPSHOT_START_FLAG;
+        schedule->conversion = VOLT_CONVERSION_SNAPSHOT;
+        // A new request can arrive before the voltages are sent
+        schedule->conversion_seq = schedule->snapshot_seq;
+        return VOLT_SCHEDULE_SNAPSHOT_START;
+    }
+    if (*flags & VOLT_SCHEDULE_START_FLAG) {
+        *flags &= ~VOLT_SCHEDULE_START_FLAG;
+        // Do not override a running snapshot
+        if (schedule->conversion != VOLT_CONVERSION_SNAPSHOT) {
+            if (schedule->open_wire_step != 0) {
+                schedule->conversion      = VOLT_CONVERSION_OPEN_WIRE;
+                schedule->conversion_step = schedule->open_wire_step;
+                return VOLT_SCHEDULE_OPEN_WIRE_START;
+            }
+            if (!snapshot_active) {
+                schedule->conversion = VOLT_CONVERSION_NORMAL;
+                return VOLT_SCHEDULE_MEASURE_START;
+            }
+        }
+    }
+    if (*flags & VOLT_SCHEDULE_READ_FLAG) {
+        *flags &= ~VOLT_SCHEDULE_READ_FLAG;
+        volt_conversion_t conversion = schedule->conversion;
+
+        // If a snapshot has taken the place of an open wire step the same step is repeated
+        if (conversion == VOLT_CONVERSION_SNAPSHOT)
+            return VOLT_SCHEDULE_IDLE;
+        if (schedule->open_wire_step == 0 || conversion == VOLT_CONVERSION_OPEN_WIRE)
+            schedule->open_wire_step = (schedule->open_wire_step + 1) % (VOLT_SCHEDULE_OPEN_WIRE_STEPS + 1);
+        schedule->conversion = VOLT_CONVERSION_NONE;
+
+        if (conversion == VOLT_CONVERSION_OPEN_WIRE)
+            return VOLT_SCHEDULE_OPEN_WIRE_READ;
+        if (conversion == VOLT_CONVERSION_NORMAL)
+            return VOLT_SCHEDULE_MEASURE_READ;
+    }
+    return VOLT_SCHEDULE_IDLE;
+}
+
+uint8_t volt_schedule_get_snapshot_seq(const volt_schedule_t * schedule) {
+    return schedule->conversion_seq;
+}
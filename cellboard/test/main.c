@@ -0,0 +1,20 @@
+#include "main.h"
+
+#include "test_suites.h"
+
+#include <munit.h>
+
+int main(int argc, char *argv[]) {
+    MunitSuite main_suite[] = {
+        test_temp_health_suite,
+        test_volt_schedule_suite,
+        {NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, MUNIT_SUITE_OPTION_NONE}};
+    MunitSuite mainsuite = {
+        "",
+        NULL,
+        main_suite,
+        10000,
+        MUNIT_SUITE_OPTION_NONE,
+    };
+    return munit_suite_main(&mainsuite, NULL, argc, argv);
+}
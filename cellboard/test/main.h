@@ -0,0 +1,6 @@
+#ifndef TEST_MAIN_H
+#define TEST_MAIN_H
+
+int main(int argc, char* argv[]);
+
+#endif
\ No newline at end of file
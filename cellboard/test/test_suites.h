@@ -0,0 +1,9 @@
+#ifndef TEST_SUITES_H
+#define TEST_SUITES_H
+
+#include <munit.h>
+
+extern MunitSuite test_temp_health_suite;
+extern MunitSuite test_volt_schedule_suite;
+
+#endif
\ No newline at end of file
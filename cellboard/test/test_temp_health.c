@@ -0,0 +1,115 @@
+#include "test_temp_health.h"
+
+#include <temp_health.h>
+
+#define TEMP_TEST_STRIP_SENSOR(strip, sensor) ((strip) * TEMP_HEALTH_STRIP_SENSOR_COUNT + (sensor))
+
+MunitResult test_temp_health_range(const MunitParameter params[], void *user_data_or_fixture) {
+	temp_health_t health;
+	temp_health_init(&health);
+
+	munit_assert_false(temp_health_update(&health, 3, 25.f, 25.f));
+	munit_assert_uint64(health.unhealthy, ==, 0);
+
+	// An open sensor is reported only once
+	munit_assert_true(temp_health_update(&health, 3, TEMP_HEALTH_MAX + 10.f, 25.f));
+	munit_assert_false(temp_health_update(&health, 3, TEMP_HEALTH_MAX + 10.f, 25.f));
+	munit_assert_uint64(health.unhealthy, ==, TEMP_SENSOR(3));
+	munit_assert_true(temp_health_update(&health, 7, TEMP_HEALTH_MIN - 10.f, 25.f));
+	munit_assert_uint64(health.unhealthy, ==, TEMP_SENSOR(3) | TEMP_SENSOR(7));
+
+	// Included again only after enough good reads in a row
+	for (uint8_t i = 0; i < TEMP_HEALTH_RECOVERY_COUNT - 1; ++i)
+		temp_health_update(&health, 3, 25.f + (i % 2), 25.f);
+	munit_assert_uint64(health.unhealthy & TEMP_SENSOR(3), !=, 0);
+	temp_health_update(&health, 3, 26.f, 25.f);
+	munit_assert_uint64(health.unhealthy, ==, TEMP_SENSOR(7));
+
+	return MUNIT_OK;
+}
+
+MunitResult test_temp_health_stuck(const MunitParameter params[], void *user_data_or_fixture) {
+	temp_health_t health;
+	temp_health_init(&health);
+
+	// A steady board is not a stuck sensor
+	for (uint16_t i = 0; i < 2 * TEMP_HEALTH_STUCK_COUNT; ++i)
+		munit_assert_false(temp_health_update(&health, 0, 30.f, 30.f));
+	munit_assert_uint64(health.unhealthy, ==, 0);
+
+	// The board warms up while the sensor does not change
+	bool reported = false;
+	uint16_t reads = 0;
+	float average = 30.f;
+	temp_health_update(&health, 1, 20.f, average);
+	while (!reported && reads < 2 * TEMP_HEALTH_STUCK_COUNT) {
+		average += 0.1f;
+		reported = temp_health_update(&health, 1, 20.f, average);
+		++reads;
+	}
+	munit_assert_true(reported);
+	munit_assert_uint16(reads, ==, TEMP_HEALTH_STUCK_COUNT);
+	munit_assert_uint64(health.unhealthy, ==, TEMP_SENSOR(1));
+
+	return MUNIT_OK;
+}
+
+MunitResult test_temp_health_interpolate(const MunitParameter params[], void *user_data_or_fixture) {
+	temp_health_t health;
+	temp_health_init(&health);
+
+	float temperatures[TEMP_HEALTH_SENSOR_COUNT];
+	for (size_t strip = 0; strip < TEMP_HEALTH_STRIP_COUNT; ++strip) {
+		for (size_t sens = 0; sens < TEMP_HEALTH_STRIP_SENSOR_COUNT; ++sens)
+			temperatures[TEMP_TEST_STRIP_SENSOR(strip, sens)] = 20.f + strip * 2.f + sens;
+	}
+
+	// Nothing excluded, nothing changes
+	uint64_t excluded = 0U;
+	temp_health_interpolate(&health, temperatures, excluded, 0.f);
+	munit_assert_float(temperatures[TEMP_TEST_STRIP_SENSOR(1, 2)], ==, 24.f);
+
+	// The included sensors of the strip
+	temperatures[TEMP_TEST_STRIP_SENSOR(1, 2)] = 200.f;
+	temperatures[TEMP_TEST_STRIP_SENSOR(1, 4)] = -50.f;
+	excluded = TEMP_SENSOR(TEMP_TEST_STRIP_SENSOR(1, 2)) | TEMP_SENSOR(TEMP_TEST_STRIP_SENSOR(1, 4));
+	temp_health_interpolate(&health, temperatures, excluded, 0.f);
+	float expected = 0.f;
+	size_t count = 0;
+	for (size_t sens = 0; sens < TEMP_HEALTH_STRIP_SENSOR_COUNT; ++sens) {
+		if (sens != 2 && sens != 4) {
+			expected += 22.f + sens;
+			++count;
+		}
+	}
+	expected /= count;
+	munit_assert_double_equal(temperatures[TEMP_TEST_STRIP_SENSOR(1, 2)], expected, 4);
+	munit_assert_double_equal(temperatures[TEMP_TEST_STRIP_SENSOR(1, 4)], expected, 4);
+
+	// A whole strip excluded reads the average of the rest of the board
+	excluded = 0U;
+	float sum = 0.f;
+	for (size_t i = 0; i < TEMP_HEALTH_SENSOR_COUNT; ++i) {
+		if (i / TEMP_HEALTH_STRIP_SENSOR_COUNT == 0)
+			excluded |= TEMP_SENSOR(i);
+		else
+			sum += temperatures[i];
+	}
+	temp_health_interpolate(&health, temperatures, excluded, 0.f);
+	munit_assert_double_equal(temperatures[TEMP_TEST_STRIP_SENSOR(0, 0)], sum / (TEMP_HEALTH_SENSOR_COUNT - TEMP_HEALTH_STRIP_SENSOR_COUNT), 4);
+
+	// Nothing to interpolate from
+	temp_health_interpolate(&health, temperatures, UINT64_MAX, 42.f);
+	munit_assert_float(temperatures[TEMP_TEST_STRIP_SENSOR(2, 3)], ==, 42.f);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_temp_health_tests[] = {
+	{(char *)"/range", test_temp_health_range, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/stuck", test_temp_health_stuck, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/interpolate", test_temp_health_interpolate, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_temp_health_suite = {"/temp_health", test_temp_health_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_TEMP_HEALTH_H
+#define TEST_TEMP_HEALTH_H
+
+#include <munit.h>
+
+#endif
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include "test_volt_schedule.h"
+
+#include <volt_schedule.h>
+
+/**
+ * @brief	a snapshot requested while the read of the previous one is pending is
+ * 			started only after that read, which is sent with its own sequence number
+ */
+MunitResult test_volt_schedule_back_to_back(const MunitParameter params[], void *user_data_or_fixture) {
+	volt_schedule_t schedule;
+	volt_schedule_flag_t flags = 0;
+	volt_schedule_init(&schedule);
+
+	volt_schedule_snapshot_request(&schedule, 1);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_START);
+	munit_assert_uint8(volt_schedule_get_snapshot_seq(&schedule), ==, 1);
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_IDLE);
+
+	// The conversion ends and the next request arrives before the flags are checked
+	flags |= VOLT_SCHEDULE_SNAPSHOT_READ_FLAG;
+	volt_schedule_snapshot_request(&schedule, 2);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_READ);
+	munit_assert_uint8(volt_schedule_get_snapshot_seq(&schedule), ==, 1);
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_START);
+	munit_assert_uint8(volt_schedule_get_snapshot_seq(&schedule), ==, 2);
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_IDLE);
+	munit_assert_uint8(flags, ==, 0);
+
+	// A request during the conversion restarts it, the single read has the new sequence number
+	volt_schedule_snapshot_request(&schedule, 3);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_START);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_READ_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_READ);
+	munit_assert_uint8(volt_schedule_get_snapshot_seq(&schedule), ==, 3);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the free running measurements alternate with the steps of the open wire check
+ */
+MunitResult test_volt_schedule_open_wire(const MunitParameter params[], void *user_data_or_fixture) {
+	volt_schedule_t schedule;
+	volt_schedule_flag_t flags = 0;
+	volt_schedule_init(&schedule);
+
+	flags |= VOLT_SCHEDULE_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, false), ==, VOLT_SCHEDULE_MEASURE_START);
+	flags |= VOLT_SCHEDULE_READ_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, false), ==, VOLT_SCHEDULE_MEASURE_READ);
+
+	for (uint8_t step = 1; step <= VOLT_SCHEDULE_OPEN_WIRE_STEPS; ++step) {
+		flags |= VOLT_SCHEDULE_START_FLAG;
+		munit_assert_int(volt_schedule_next(&schedule, &flags, false), ==, VOLT_SCHEDULE_OPEN_WIRE_START);
+		munit_assert_uint8(schedule.conversion_step, ==, step);
+		flags |= VOLT_SCHEDULE_READ_FLAG;
+		munit_assert_int(volt_schedule_next(&schedule, &flags, false), ==, VOLT_SCHEDULE_OPEN_WIRE_READ);
+		munit_assert_uint8(schedule.conversion_step, ==, step);
+	}
+
+	flags |= VOLT_SCHEDULE_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, false), ==, VOLT_SCHEDULE_MEASURE_START);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a snapshot replaces the conversion running, the open wire step it replaced is repeated
+ */
+MunitResult test_volt_schedule_snapshot_priority(const MunitParameter params[], void *user_data_or_fixture) {
+	volt_schedule_t schedule;
+	volt_schedule_flag_t flags = 0;
+	volt_schedule_init(&schedule);
+
+	// While the snapshots are requested only the open wire check runs
+	flags |= VOLT_SCHEDULE_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_IDLE);
+	flags |= VOLT_SCHEDULE_READ_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_IDLE);
+	flags |= VOLT_SCHEDULE_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_OPEN_WIRE_START);
+	munit_assert_uint8(schedule.conversion_step, ==, 1);
+
+	volt_schedule_snapshot_request(&schedule, 7);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_START_FLAG | VOLT_SCHEDULE_READ_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_START);
+	// The open wire conversion has been replaced, there is nothing to read
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_IDLE);
+	flags |= VOLT_SCHEDULE_SNAPSHOT_READ_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_SNAPSHOT_READ);
+
+	flags |= VOLT_SCHEDULE_START_FLAG;
+	munit_assert_int(volt_schedule_next(&schedule, &flags, true), ==, VOLT_SCHEDULE_OPEN_WIRE_START);
+	munit_assert_uint8(schedule.conversion_step, ==, 1);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_volt_schedule_tests[] = {
+	{(char *)"/back_to_back", test_volt_schedule_back_to_back, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/open_wire", test_volt_schedule_open_wire, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/snapshot_priority", test_volt_schedule_snapshot_priority, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_volt_schedule_suite = {"/volt_schedule", test_volt_schedule_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_VOLT_SCHEDULE_H
+#define TEST_VOLT_SCHEDULE_H
+
+#include <munit.h>
+
+#endif
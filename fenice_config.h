@@ -15,27 +15,100 @@
 #include <inttypes.h>
 
 //===========================================================================
-//=================================== General ===============================
+//================================ Pack topology ============================
 //===========================================================================
 
-#define DISCHARGE_R     10  //Ohm
-#define CELL_CAPACITY   3.9 //Ah
 /**
- * Maximum can payload. for CAN 2.0A is 8 bytes
+ * The pack is described only here, every table size, loop bound and error
+ * instance count of both boards is derived from these values.
+ * Some limits come from the BMS network instead, the checks at the end of
+ * this section reject the packs it cannot handle
  */
-#define CAN_MAX_PAYLOAD_LENGTH 8
 
 /**
- * Number of daisy chained LTCs
+ * Number of cellboards, one LTC6813 each, in the daisy chain
  */
 #define CELLBOARD_COUNT 6
 
 /**
- * Number of cells a single IC controls. Refer to cell_distribution for
- * configuration
+ * Number of cells in series on each cellboard
  */
 #define CELLBOARD_CELL_COUNT 18
 
+/**
+ * Number of temperature strips on each cellboard, one ADC each
+ */
+#define CELLBOARD_TEMP_STRIP_COUNT 6
+
+/**
+ * Number of sensors on each temperature strip
+ */
+#define CELLBOARD_TEMP_STRIP_SENSOR_COUNT 6
+
+/**
+ * Minimum number of included sensors on a strip to interpolate its excluded
+ * sensors, with fewer the strip is not measured anymore
+ */
+#define CELLBOARD_TEMP_STRIP_MIN_INCLUDED (CELLBOARD_TEMP_STRIP_SENSOR_COUNT / 2)
+
+/**
+ * Broken or unreliable temperature sensors, as X(cellboard, sensor mask).
+ * Excluded sensors read the interpolation of their neighbors
+ */
+#define TEMP_SENSOR(index) ((uint64_t)1U << (index))
+#define PACK_EXCLUDED_TEMPS(X)                                                                                    \
+    X(0, TEMP_SENSOR(7) | TEMP_SENSOR(26))                                                                        \
+    X(1, TEMP_SENSOR(0) | TEMP_SENSOR(4) | TEMP_SENSOR(6) | TEMP_SENSOR(8) | TEMP_SENSOR(13) | TEMP_SENSOR(35))  \
+    X(2, TEMP_SENSOR(15) | TEMP_SENSOR(21) | TEMP_SENSOR(26) | TEMP_SENSOR(29))                                   \
+    X(3, TEMP_SENSOR(5) | TEMP_SENSOR(6) | TEMP_SENSOR(25) | TEMP_SENSOR(26))                                     \
+    X(4, TEMP_SENSOR(1) | TEMP_SENSOR(3) | TEMP_SENSOR(13) | TEMP_SENSOR(14) | TEMP_SENSOR(23) | TEMP_SENSOR(35)) \
+    X(5, TEMP_SENSOR(3) | TEMP_SENSOR(7) | TEMP_SENSOR(9) | TEMP_SENSOR(14) | TEMP_SENSOR(18) | TEMP_SENSOR(29))
+
+/**
+ * Cell's limit voltages (mV * 10)
+ */
+#define CELL_MIN_VOLTAGE 25000
+#define CELL_WARN_VOLTAGE 30000
+#define CELL_MAX_VOLTAGE  42000
+
+/**
+ * Minimum cell temperature (°C)
+ */
+#define CELL_MIN_TEMPERATURE -20.0
+/**
+ * Maximum cell temperature (°C)
+ */
+#define CELL_MAX_TEMPERATURE 60.0
+
+/**
+ * Cell nominal energy (Wh * 10)
+ */
+#define CELL_ENERGY_NOMINAL 576
+
+// An LTC6813 measures up to 18 cells, the balancing masks are 32 bit wide
+#if CELLBOARD_CELL_COUNT < 1 || CELLBOARD_CELL_COUNT > 18
+#error "A cellboard must have between 1 and 18 cells"
+#endif
+// The excluded sensors are a 64 bit mask for each cellboard
+#if CELLBOARD_TEMP_STRIP_COUNT * CELLBOARD_TEMP_STRIP_SENSOR_COUNT > 64
+#error "A cellboard can have at most 64 temperature sensors"
+#endif
+// The cellboard index is sent in 3 bit fields of the BMS network and is the 3 bit address of the bootloaders
+#if CELLBOARD_COUNT < 1 || CELLBOARD_COUNT > 8
+#error "The pack must have between 1 and 8 cellboards"
+#endif
+
+//===========================================================================
+//=================================== General ===============================
+//===========================================================================
+
+#define DISCHARGE_R     10  //Ohm
+#define CELL_CAPACITY   3.9 //Ah
+/**
+ * Maximum can payload. for CAN 2.0A is 8 bytes
+ */
+#define CAN_MAX_PAYLOAD_LENGTH 8
+
 // Voltage value in mV * 10
 typedef uint16_t voltage_t;
 
@@ -56,13 +129,12 @@ typedef uint16_t voltage_t;
 /**
  * Number of daisy chained LTCs
  */
-#define LTC6813_COUNT 6
+#define LTC6813_COUNT CELLBOARD_COUNT
 
 /**
- * Number of cells a single IC controls. Refer to cell_distribution for
- * configuration
+ * Number of cells a single IC controls
  */
-#define LTC6813_CELL_COUNT 18
+#define LTC6813_CELL_COUNT CELLBOARD_CELL_COUNT
 
 /**
  * Number of registers for each LTC
@@ -98,11 +170,15 @@ typedef uint16_t voltage_t;
 /**
  * How many strips in each bus
  */
-#define TEMP_STRIPS_PER_BUS 6
+#define TEMP_STRIPS_PER_BUS (CELLBOARD_TEMP_STRIP_COUNT / TEMP_BUS_COUNT)
+// Every bus must have the same number of strips, the division would drop the remaining ones
+#if CELLBOARD_TEMP_STRIP_COUNT % TEMP_BUS_COUNT != 0
+#error "The temperature strips must be split evenly between the buses"
+#endif
 /**
  * How many sensors are on a strip
  */
-#define TEMP_SENSORS_PER_STRIP 6
+#define TEMP_SENSORS_PER_STRIP CELLBOARD_TEMP_STRIP_SENSOR_COUNT
 
 /**
  * How many sensors on each cellboard
@@ -129,28 +205,6 @@ static const uint8_t TEMP_SENSOR_ADDRESS_CODING[TEMP_SENSORS_PER_STRIP] = {000,
  */
 #define PACK_TEMP_COUNT (TEMP_SENSOR_COUNT * LTC6813_COUNT)
 
-
-/**
- * Cell's limit voltages (mV * 10)
- */
-#define CELL_MIN_VOLTAGE 25000
-#define CELL_WARN_VOLTAGE 30000
-#define CELL_MAX_VOLTAGE  42000
-
-/**
- * Minimum cell temperature (°C)
- */
-#define CELL_MIN_TEMPERATURE -20.0
-/**
- * Maximum cell temperature (°C)
- */
-#define CELL_MAX_TEMPERATURE 60.0
-
-/**
- * Cell nominal energy (Wh * 10)
- */
-#define CELL_ENERGY_NOMINAL 576
-
 /**
  * Pack nominal energy (Wh * 10)
  */
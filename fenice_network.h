@@ -0,0 +1,430 @@
+/**
+ * @file fenice_network.h
+ * @brief CAN messages shared between the mainboard and the cellboards
+ * which are not (yet) part of the generated canlib networks
+ *
+ * @details The messages follow the same conventions of the canlib generated
+ * code: a raw structure plus a pack and an unpack function which return the
+ * number of bytes written/read or a negative value on error.
+ * The values are little endian.
+ * The identifiers are chosen outside the ranges used by the bms and primary
+ * networks, keep them in sync once the messages are moved into the can repo
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef FENICE_NETWORK_H
+#define FENICE_NETWORK_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+//===========================================================================
+//=============================== BMS network ===============================
+//===========================================================================
+
+/**
+ * Broadcast from the mainboard to every cellboard to start a voltage
+ * conversion at the same instant (highest priority of the extra messages).
+ * It comes right after the identifiers of the bootloaders of 8 cellboards
+ * (see BMS_FLASH_CELLBOARD_RX_FRAME_ID)
+ */
+#define BMS_SNAPSHOT_TRIGGER_FRAME_ID 0x014
+#define BMS_SNAPSHOT_TRIGGER_BYTE_SIZE 1
+
+/** Cell voltages measured after a snapshot trigger, tagged with its sequence number */
+#define BMS_SNAPSHOT_VOLTAGES_FRAME_ID 0x6F0
+#define BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE 8
+#define BMS_SNAPSHOT_VOLTAGES_CELL_COUNT 3
+
+/** Discharge time of a group of cells computed by the mainboard balancing planner */
+#define BMS_BALANCING_PLAN_FRAME_ID 0x6F1
+#define BMS_BALANCING_PLAN_BYTE_SIZE 8
+#define BMS_BALANCING_PLAN_CELL_COUNT 6
+#define BMS_BALANCING_PLAN_GROUP_COUNT 3
+
+/** Discharge duty of a cellboard and energy dissipated by its resistors since the start of the balancing */
+#define BMS_BALANCING_ENERGY_FRAME_ID 0x6F2
+#define BMS_BALANCING_ENERGY_BYTE_SIZE 8
+#define BMS_BALANCING_ENERGY_CELL_COUNT 3
+
+/** Charge removed from each cell by its resistor since the start of the balancing */
+#define BMS_BALANCING_CHARGE_FRAME_ID 0x6F3
+#define BMS_BALANCING_CHARGE_BYTE_SIZE 8
+#define BMS_BALANCING_CHARGE_CELL_COUNT 3
+
+/** Convergence of the pack balancing, sent by the mainboard */
+#define BMS_BALANCING_CONVERGENCE_FRAME_ID 0x6F4
+#define BMS_BALANCING_CONVERGENCE_BYTE_SIZE 8
+#define BMS_BALANCING_CONVERGENCE_ETA_UNKNOWN UINT16_MAX
+
+/** Raw sample of a feedback capture, sent by the mainboard when a dump is requested */
+#define BMS_FEEDBACK_CAPTURE_FRAME_ID 0x6F5
+#define BMS_FEEDBACK_CAPTURE_BYTE_SIZE 8
+
+/** Filtered state of the IMD and trend of the insulation resistance, sent by the mainboard */
+#define BMS_IMD_TREND_FRAME_ID 0x6F6
+#define BMS_IMD_TREND_BYTE_SIZE 8
+#define BMS_IMD_TREND_RESISTANCE_UNKNOWN UINT16_MAX
+
+/** Progress of a parallel flashing of the cellboards, sent by the mainboard on the car network */
+#define BMS_FLASH_STATUS_FRAME_ID 0x6F7
+#define BMS_FLASH_STATUS_BYTE_SIZE 8
+
+/**
+ * XCP packets of the parallel flashing on the car network: the host sends
+ * the commands with the RX identifier to the mainboard, which copies them to
+ * every cellboard bootloader and answers with the TX identifier, like the
+ * BMS_FLASH_CELLBOARD_x messages of a single cellboard.
+ * The payload is the raw XCP packet so there is no pack and unpack
+ */
+#define BMS_FLASH_BROADCAST_TX_FRAME_ID 0x6F8
+#define BMS_FLASH_BROADCAST_RX_FRAME_ID 0x6F9
+
+/**
+ * XCP packets of the bootloader of a single cellboard, TX from the bootloader
+ * and RX to it. The identifiers follow the 3 bit address of the cellboard like
+ * BOOT_COM_CAN_TX_MSG_ID and BOOT_COM_CAN_RX_MSG_ID of openblt_cellboard, the
+ * first 6 are the BMS_FLASH_CELLBOARD_x messages of the bms network
+ */
+#define BMS_FLASH_CELLBOARD_TX_FRAME_ID(INDEX) (0x004U + 2U * (INDEX))
+#define BMS_FLASH_CELLBOARD_RX_FRAME_ID(INDEX) (0x005U + 2U * (INDEX))
+/** Check if an identifier belongs to the bootloader of one of the first COUNT cellboards */
+#define BMS_FLASH_CELLBOARD_IS_FRAME_ID(ID, COUNT) \
+    ((ID) >= BMS_FLASH_CELLBOARD_TX_FRAME_ID(0) && (ID) <= BMS_FLASH_CELLBOARD_RX_FRAME_ID((COUNT) - 1))
+/** Index of the cellboard of a bootloader identifier */
+#define BMS_FLASH_CELLBOARD_INDEX(ID) (((ID) - BMS_FLASH_CELLBOARD_TX_FRAME_ID(0)) / 2U)
+
+#if BMS_FLASH_CELLBOARD_IS_FRAME_ID(BMS_SNAPSHOT_TRIGGER_FRAME_ID, 8)
+#error "The snapshot trigger must not be received by the cellboard bootloaders"
+#endif
+
+/** Cells drifting away from the pack, one frame for each suspect ranked by score, sent by the mainboard */
+#define BMS_CELL_ANOMALY_FRAME_ID 0x6FA
+#define BMS_CELL_ANOMALY_BYTE_SIZE 8
+
+/** Temperature sensors of a cellboard replaced by the interpolation of their neighbors */
+#define BMS_TEMP_EXCLUDED_FRAME_ID 0x6FB
+#define BMS_TEMP_EXCLUDED_BYTE_SIZE 8
+#define BMS_TEMP_EXCLUDED_SENSOR_COUNT 48
+
+typedef struct {
+    uint8_t seq;
+} bms_snapshot_trigger_t;
+
+typedef struct {
+    uint8_t cellboard_id; // 3 bits
+    uint8_t start_index;  // 5 bits
+    uint8_t seq;
+    uint16_t voltages[BMS_SNAPSHOT_VOLTAGES_CELL_COUNT]; // mV * 10
+} bms_snapshot_voltages_t;
+
+typedef struct {
+    uint8_t cellboard_id; // 3 bits
+    uint8_t group;        // 2 bits, the first cell is group * BMS_BALANCING_PLAN_CELL_COUNT
+    uint8_t start;        // 1 bit, first plan of the balancing, the removed charge is reset
+    uint8_t seq;
+    uint8_t durations[BMS_BALANCING_PLAN_CELL_COUNT]; // s, 0 if the cell has not to be discharged
+} bms_balancing_plan_t;
+
+typedef struct {
+    uint8_t cellboard_id; // 3 bits
+    uint8_t start_index;  // 5 bits
+    uint8_t duty;         // %
+    uint16_t energies[BMS_BALANCING_ENERGY_CELL_COUNT]; // J
+} bms_balancing_energy_t;
+
+typedef struct {
+    uint8_t cellboard_id; // 3 bits
+    uint8_t start_index;  // 5 bits
+    uint16_t charges[BMS_BALANCING_CHARGE_CELL_COUNT]; // mAh * 10
+} bms_balancing_charge_t;
+
+typedef struct {
+    uint16_t spread; // mV * 10, difference between the maximum and minimum cell voltages
+    int16_t rate;    // uV/s, negative while converging
+    uint16_t eta;    // min, BMS_BALANCING_CONVERGENCE_ETA_UNKNOWN if not converging
+    uint16_t charge; // mAh, total charge removed from the pack
+} bms_balancing_convergence_t;
+
+typedef struct {
+    uint16_t offset; // Position of the sample in the capture
+    uint8_t index;   // 5 bits, index of the feedback
+    uint8_t trigger; // 1 bit, first sample after the trigger
+    uint8_t last;    // 1 bit, last sample of the capture
+    uint16_t value;  // Raw ADC value
+    uint16_t time;   // ms
+} bms_feedback_capture_t;
+
+typedef struct {
+    uint8_t state;           // 3 bits, IMD_STATE
+    uint8_t confidence;      // 7 bits, %
+    uint16_t resistance;     // kOhm, BMS_IMD_TREND_RESISTANCE_UNKNOWN if not measured
+    int16_t rate;            // kOhm/min, negative while the insulation is degrading
+    uint16_t resistance_min; // kOhm, lowest resistance since the start-up
+} bms_imd_trend_t;
+
+typedef struct {
+    uint8_t active;           // 1 bit, a flashing session is in progress
+    uint8_t boards;           // 7 bits, number of cellboards of the session
+    uint8_t retransmissions;  // Commands sent again to a cellboard, saturated
+    uint32_t failed;          // Bit mask of the cellboards which have failed during the session
+    uint16_t commands;        // Commands acknowledged by every cellboard, wraps around
+} bms_flash_status_t;
+
+typedef struct {
+    uint8_t rank;       // 0 for the most suspect cell
+    uint8_t cell;       // Index of the cell in the pack
+    uint8_t flags;      // 3 bits, limits exceeded: z-score, resistance, self discharge
+    uint8_t score;      // %, distance from the closest limit, saturated
+    int8_t z;           // 1/10, z-score of the voltage under load
+    int16_t resistance; // mOhm * 10, resistance compared to the rest of the pack
+    int8_t drift;       // mV/h * 10, voltage drift at rest compared to the rest of the pack
+} bms_cell_anomaly_t;
+
+typedef struct {
+    uint8_t cellboard_id; // 3 bits
+    uint8_t group;        // 1 bit, the first sensor is group * BMS_TEMP_EXCLUDED_SENSOR_COUNT
+    uint8_t unhealthy;    // Sensors of the cellboard found unhealthy at runtime
+    uint64_t excluded;    // 48 bits, bit mask of the excluded sensors of the group
+} bms_temp_excluded_t;
+
+//===========================================================================
+//================================= Helpers =================================
+//===========================================================================
+
+static inline void _fenice_network_set_u16(uint8_t * dst, uint16_t value) {
+    dst[0] = value & 0xFF;
+    dst[1] = (value >> 8) & 0xFF;
+}
+static inline uint16_t _fenice_network_get_u16(const uint8_t * src) {
+    return (uint16_t)src[0] | ((uint16_t)src[1] << 8);
+}
+
+//===========================================================================
+//============================= Pack and unpack =============================
+//===========================================================================
+
+static inline int bms_snapshot_trigger_pack(uint8_t * dst, const bms_snapshot_trigger_t * src, size_t size) {
+    if (size < BMS_SNAPSHOT_TRIGGER_BYTE_SIZE)
+        return -1;
+    dst[0] = src->seq;
+    return BMS_SNAPSHOT_TRIGGER_BYTE_SIZE;
+}
+static inline int bms_snapshot_trigger_unpack(bms_snapshot_trigger_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_SNAPSHOT_TRIGGER_BYTE_SIZE)
+        return -1;
+    dst->seq = src[0];
+    return BMS_SNAPSHOT_TRIGGER_BYTE_SIZE;
+}
+
+static inline int bms_snapshot_voltages_pack(uint8_t * dst, const bms_snapshot_voltages_t * src, size_t size) {
+    if (size < BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->cellboard_id & 0x07) | ((src->start_index & 0x1F) << 3);
+    dst[1] = src->seq;
+    for (size_t i = 0; i < BMS_SNAPSHOT_VOLTAGES_CELL_COUNT; ++i)
+        _fenice_network_set_u16(dst + 2 + i * 2, src->voltages[i]);
+    return BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE;
+}
+static inline int bms_snapshot_voltages_unpack(bms_snapshot_voltages_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE)
+        return -1;
+    dst->cellboard_id = src[0] & 0x07;
+    dst->start_index = (src[0] >> 3) & 0x1F;
+    dst->seq = src[1];
+    for (size_t i = 0; i < BMS_SNAPSHOT_VOLTAGES_CELL_COUNT; ++i)
+        dst->voltages[i] = _fenice_network_get_u16(src + 2 + i * 2);
+    return BMS_SNAPSHOT_VOLTAGES_BYTE_SIZE;
+}
+
+static inline int bms_balancing_plan_pack(uint8_t * dst, const bms_balancing_plan_t * src, size_t size) {
+    if (size < BMS_BALANCING_PLAN_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->cellboard_id & 0x07) | ((src->group & 0x03) << 3) | ((src->start & 0x01) << 5);
+    dst[1] = src->seq;
+    for (size_t i = 0; i < BMS_BALANCING_PLAN_CELL_COUNT; ++i)
+        dst[2 + i] = src->durations[i];
+    return BMS_BALANCING_PLAN_BYTE_SIZE;
+}
+static inline int bms_balancing_plan_unpack(bms_balancing_plan_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_BALANCING_PLAN_BYTE_SIZE)
+        return -1;
+    dst->cellboard_id = src[0] & 0x07;
+    dst->group = (src[0] >> 3) & 0x03;
+    dst->start = (src[0] >> 5) & 0x01;
+    dst->seq = src[1];
+    for (size_t i = 0; i < BMS_BALANCING_PLAN_CELL_COUNT; ++i)
+        dst->durations[i] = src[2 + i];
+    return BMS_BALANCING_PLAN_BYTE_SIZE;
+}
+
+static inline int bms_balancing_energy_pack(uint8_t * dst, const bms_balancing_energy_t * src, size_t size) {
+    if (size < BMS_BALANCING_ENERGY_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->cellboard_id & 0x07) | ((src->start_index & 0x1F) << 3);
+    dst[1] = src->duty;
+    for (size_t i = 0; i < BMS_BALANCING_ENERGY_CELL_COUNT; ++i)
+        _fenice_network_set_u16(dst + 2 + i * 2, src->energies[i]);
+    return BMS_BALANCING_ENERGY_BYTE_SIZE;
+}
+static inline int bms_balancing_energy_unpack(bms_balancing_energy_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_BALANCING_ENERGY_BYTE_SIZE)
+        return -1;
+    dst->cellboard_id = src[0] & 0x07;
+    dst->start_index = (src[0] >> 3) & 0x1F;
+    dst->duty = src[1];
+    for (size_t i = 0; i < BMS_BALANCING_ENERGY_CELL_COUNT; ++i)
+        dst->energies[i] = _fenice_network_get_u16(src + 2 + i * 2);
+    return BMS_BALANCING_ENERGY_BYTE_SIZE;
+}
+
+static inline int bms_balancing_charge_pack(uint8_t * dst, const bms_balancing_charge_t * src, size_t size) {
+    if (size < BMS_BALANCING_CHARGE_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->cellboard_id & 0x07) | ((src->start_index & 0x1F) << 3);
+    dst[1] = 0;
+    for (size_t i = 0; i < BMS_BALANCING_CHARGE_CELL_COUNT; ++i)
+        _fenice_network_set_u16(dst + 2 + i * 2, src->charges[i]);
+    return BMS_BALANCING_CHARGE_BYTE_SIZE;
+}
+static inline int bms_balancing_charge_unpack(bms_balancing_charge_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_BALANCING_CHARGE_BYTE_SIZE)
+        return -1;
+    dst->cellboard_id = src[0] & 0x07;
+    dst->start_index = (src[0] >> 3) & 0x1F;
+    for (size_t i = 0; i < BMS_BALANCING_CHARGE_CELL_COUNT; ++i)
+        dst->charges[i] = _fenice_network_get_u16(src + 2 + i * 2);
+    return BMS_BALANCING_CHARGE_BYTE_SIZE;
+}
+
+static inline int bms_balancing_convergence_pack(uint8_t * dst, const bms_balancing_convergence_t * src, size_t size) {
+    if (size < BMS_BALANCING_CONVERGENCE_BYTE_SIZE)
+        return -1;
+    _fenice_network_set_u16(dst, src->spread);
+    _fenice_network_set_u16(dst + 2, (uint16_t)src->rate);
+    _fenice_network_set_u16(dst + 4, src->eta);
+    _fenice_network_set_u16(dst + 6, src->charge);
+    return BMS_BALANCING_CONVERGENCE_BYTE_SIZE;
+}
+static inline int bms_balancing_convergence_unpack(bms_balancing_convergence_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_BALANCING_CONVERGENCE_BYTE_SIZE)
+        return -1;
+    dst->spread = _fenice_network_get_u16(src);
+    dst->rate = (int16_t)_fenice_network_get_u16(src + 2);
+    dst->eta = _fenice_network_get_u16(src + 4);
+    dst->charge = _fenice_network_get_u16(src + 6);
+    return BMS_BALANCING_CONVERGENCE_BYTE_SIZE;
+}
+
+static inline int bms_feedback_capture_pack(uint8_t * dst, const bms_feedback_capture_t * src, size_t size) {
+    if (size < BMS_FEEDBACK_CAPTURE_BYTE_SIZE)
+        return -1;
+    _fenice_network_set_u16(dst, src->offset);
+    dst[2] = (src->index & 0x1F) | ((src->trigger & 0x01) << 5) | ((src->last & 0x01) << 6);
+    _fenice_network_set_u16(dst + 3, src->value);
+    _fenice_network_set_u16(dst + 5, src->time);
+    dst[7] = 0;
+    return BMS_FEEDBACK_CAPTURE_BYTE_SIZE;
+}
+static inline int bms_feedback_capture_unpack(bms_feedback_capture_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_FEEDBACK_CAPTURE_BYTE_SIZE)
+        return -1;
+    dst->offset = _fenice_network_get_u16(src);
+    dst->index = src[2] & 0x1F;
+    dst->trigger = (src[2] >> 5) & 0x01;
+    dst->last = (src[2] >> 6) & 0x01;
+    dst->value = _fenice_network_get_u16(src + 3);
+    dst->time = _fenice_network_get_u16(src + 5);
+    return BMS_FEEDBACK_CAPTURE_BYTE_SIZE;
+}
+
+static inline int bms_imd_trend_pack(uint8_t * dst, const bms_imd_trend_t * src, size_t size) {
+    if (size < BMS_IMD_TREND_BYTE_SIZE)
+        return -1;
+    dst[0] = src->state & 0x07;
+    dst[1] = src->confidence & 0x7F;
+    _fenice_network_set_u16(dst + 2, src->resistance);
+    _fenice_network_set_u16(dst + 4, (uint16_t)src->rate);
+    _fenice_network_set_u16(dst + 6, src->resistance_min);
+    return BMS_IMD_TREND_BYTE_SIZE;
+}
+static inline int bms_imd_trend_unpack(bms_imd_trend_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_IMD_TREND_BYTE_SIZE)
+        return -1;
+    dst->state = src[0] & 0x07;
+    dst->confidence = src[1] & 0x7F;
+    dst->resistance = _fenice_network_get_u16(src + 2);
+    dst->rate = (int16_t)_fenice_network_get_u16(src + 4);
+    dst->resistance_min = _fenice_network_get_u16(src + 6);
+    return BMS_IMD_TREND_BYTE_SIZE;
+}
+
+static inline int bms_flash_status_pack(uint8_t * dst, const bms_flash_status_t * src, size_t size) {
+    if (size < BMS_FLASH_STATUS_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->active & 0x01) | ((src->boards & 0x7F) << 1);
+    dst[1] = src->retransmissions;
+    _fenice_network_set_u16(dst + 2, src->failed & 0xFFFF);
+    _fenice_network_set_u16(dst + 4, src->failed >> 16);
+    _fenice_network_set_u16(dst + 6, src->commands);
+    return BMS_FLASH_STATUS_BYTE_SIZE;
+}
+static inline int bms_flash_status_unpack(bms_flash_status_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_FLASH_STATUS_BYTE_SIZE)
+        return -1;
+    dst->active = src[0] & 0x01;
+    dst->boards = (src[0] >> 1) & 0x7F;
+    dst->retransmissions = src[1];
+    dst->failed = (uint32_t)_fenice_network_get_u16(src + 2) | ((uint32_t)_fenice_network_get_u16(src + 4) << 16);
+    dst->commands = _fenice_network_get_u16(src + 6);
+    return BMS_FLASH_STATUS_BYTE_SIZE;
+}
+
+static inline int bms_cell_anomaly_pack(uint8_t * dst, const bms_cell_anomaly_t * src, size_t size) {
+    if (size < BMS_CELL_ANOMALY_BYTE_SIZE)
+        return -1;
+    dst[0] = src->rank;
+    dst[1] = src->cell;
+    dst[2] = src->flags & 0x07;
+    dst[3] = src->score;
+    dst[4] = (uint8_t)src->z;
+    _fenice_network_set_u16(dst + 5, (uint16_t)src->resistance);
+    dst[7] = (uint8_t)src->drift;
+    return BMS_CELL_ANOMALY_BYTE_SIZE;
+}
+static inline int bms_cell_anomaly_unpack(bms_cell_anomaly_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_CELL_ANOMALY_BYTE_SIZE)
+        return -1;
+    dst->rank = src[0];
+    dst->cell = src[1];
+    dst->flags = src[2] & 0x07;
+    dst->score = src[3];
+    dst->z = (int8_t)src[4];
+    dst->resistance = (int16_t)_fenice_network_get_u16(src + 5);
+    dst->drift = (int8_t)src[7];
+    return BMS_CELL_ANOMALY_BYTE_SIZE;
+}
+
+static inline int bms_temp_excluded_pack(uint8_t * dst, const bms_temp_excluded_t * src, size_t size) {
+    if (size < BMS_TEMP_EXCLUDED_BYTE_SIZE)
+        return -1;
+    dst[0] = (src->cellboard_id & 0x07) | ((src->group & 0x01) << 3);
+    dst[1] = src->unhealthy;
+    for (size_t i = 0; i < 6; ++i)
+        dst[2 + i] = (src->excluded >> (i * 8)) & 0xFF;
+    return BMS_TEMP_EXCLUDED_BYTE_SIZE;
+}
+static inline int bms_temp_excluded_unpack(bms_temp_excluded_t * dst, const uint8_t * src, size_t size) {
+    if (size < BMS_TEMP_EXCLUDED_BYTE_SIZE)
+        return -1;
+    dst->cellboard_id = src[0] & 0x07;
+    dst->group = (src[0] >> 3) & 0x01;
+    dst->unhealthy = src[1];
+    dst->excluded = 0;
+    for (size_t i = 0; i < 6; ++i)
+        dst->excluded |= (uint64_t)src[2 + i] << (i * 8);
+    return BMS_TEMP_EXCLUDED_BYTE_SIZE;
+}
+
+#endif // FENICE_NETWORK_H
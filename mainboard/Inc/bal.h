@@ -15,6 +15,8 @@
 #include <stdbool.h>
 
 #include "../../fenice_config.h"
+#include "bal_convergence.h"
+#include "bal_planner.h"
 
 #define BAL_THRESHOLD_DEFAULT 300 // mV * 10
 #define BAL_THRESHOLD_MIN 50 // mV * 10
@@ -69,12 +71,82 @@ BalRequest bal_get_request(void);
  */
 void bal_update_status(uint8_t cellboard, bool status);
 
+/**
+ * @brief Get the last discharge plan computed for the cellboards
+ * 
+ * @return const bal_plan_t * The pointer to the plan
+ */
+const bal_plan_t * bal_get_plan(void);
+
+/**
+ * @brief Get the sequence number of the last discharge plan
+ * 
+ * @return uint8_t The sequence number
+ */
+uint8_t bal_get_plan_seq(void);
+
+/**
+ * @brief Check if the last discharge plan has started the balancing
+ * 
+ * @return true If the cellboards have to reset the removed charge
+ * @return false If the plan continues the balancing
+ */
+bool bal_is_plan_start(void);
+
+/**
+ * @brief Update the charge removed from a group of cells of a cellboard
+ * 
+ * @param cellboard The cellboard ID
+ * @param start_index The index of the first cell of the cellboard
+ * @param charges The removed charge of each cell (mAh * 10)
+ * @param count The number of cells
+ */
+void bal_set_cells_charge(uint8_t cellboard, size_t start_index, const uint16_t charges[], size_t count);
+
+/**
+ * @brief Get the charge removed from a cell since the start of the balancing
+ * 
+ * @param index The index of the cell in the pack
+ * @return float The removed charge (mAh)
+ */
+float bal_get_cell_charge(size_t index);
+
+/**
+ * @brief Get the charge removed from the whole pack since the start of the balancing
+ * 
+ * @return float The removed charge (mAh)
+ */
+float bal_get_total_charge(void);
+
+/**
+ * @brief Get the last sampled difference between the maximum and minimum cell voltages
+ * 
+ * @return voltage_t The spread (mV * 10)
+ */
+voltage_t bal_get_spread(void);
+
+/**
+ * @brief Get the variation in time of the cell voltages spread
+ * 
+ * @return float The rate (mV * 10 / s), negative while the pack is converging
+ */
+float bal_get_convergence_rate(void);
+
+/**
+ * @brief Estimate the time needed to balance the pack
+ * 
+ * @return int32_t The remaining time (s), 0 if balanced or
+ * BAL_CONVERGENCE_ETA_UNKNOWN if the pack is not converging
+ */
+int32_t bal_get_eta(void);
+
 /** @brief Stop balancing */
 void bal_stop(void);
 
 /**
  * @brief Routine that keep the current balancing status updated
  * @details This function handles the start and stop mechanism of the balancing
+ * and sends a new discharge plan to the cellboards every BAL_PLANNER_INTERVAL ms
  */
 void bal_routine(void);
 
@@ -0,0 +1,79 @@
+/**
+ * @file bal_convergence.h
+ * @brief Estimation of the balancing convergence speed
+ *
+ * @details The spread between the maximum and the minimum cell voltages is
+ * sampled periodically while balancing, the convergence rate is the slope of
+ * the least squares line through the last samples and it is used to estimate
+ * the time needed to bring the spread below the balancing threshold.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef BAL_CONVERGENCE_H
+#define BAL_CONVERGENCE_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "../../fenice_config.h"
+
+/** @brief Number of spread samples used to compute the convergence rate */
+#define BAL_CONVERGENCE_SAMPLES 16
+/** @brief Interval between two spread samples (ms) */
+#define BAL_CONVERGENCE_INTERVAL 10000U
+/** @brief Value returned when the time to balance cannot be estimated */
+#define BAL_CONVERGENCE_ETA_UNKNOWN -1
+
+/** @brief History of the cell voltages spread */
+typedef struct {
+    uint32_t times[BAL_CONVERGENCE_SAMPLES]; // ms
+    voltage_t spreads[BAL_CONVERGENCE_SAMPLES];
+    size_t head;
+    size_t count;
+} bal_convergence_t;
+
+/**
+ * @brief Clear the spread history
+ *
+ * @param conv The convergence structure
+ */
+void bal_convergence_init(bal_convergence_t * conv);
+
+/**
+ * @brief Add a sample of the spread, the oldest sample is overwritten if the history is full
+ *
+ * @param conv The convergence structure
+ * @param time The time of the sample (ms)
+ * @param spread The difference between the maximum and the minimum cell voltages (mV * 10)
+ */
+void bal_convergence_add(bal_convergence_t * conv, uint32_t time, voltage_t spread);
+
+/**
+ * @brief Get the last spread sample
+ *
+ * @param conv The convergence structure
+ * @return voltage_t The spread or 0 if no sample was added
+ */
+voltage_t bal_convergence_get_spread(const bal_convergence_t * conv);
+
+/**
+ * @brief Get the variation of the spread in time
+ *
+ * @param conv The convergence structure
+ * @return float The rate (mV * 10 / s), negative while the pack is converging
+ */
+float bal_convergence_get_rate(const bal_convergence_t * conv);
+
+/**
+ * @brief Estimate the time needed to bring the spread under a threshold
+ *
+ * @param conv The convergence structure
+ * @param threshold The spread at which the pack is balanced (mV * 10)
+ * @return int32_t The remaining time (s), 0 if already balanced or
+ * BAL_CONVERGENCE_ETA_UNKNOWN if the pack is not converging
+ */
+int32_t bal_convergence_get_eta(const bal_convergence_t * conv, voltage_t threshold);
+
+#endif // BAL_CONVERGENCE_H
@@ -0,0 +1,93 @@
+/**
+ * @file bal_planner.h
+ * @brief Pack level balancing planner
+ *
+ * @details The planner uses the voltages of all the cells of the pack and the
+ * temperature of each cellboard to decide which cells has to be discharged
+ * and for how long, so that every cell reaches a pack-wide target voltage.
+ * Two adjacent cells of the same cellboard are never discharged at the same
+ * time and the number of active resistors of a cellboard is reduced as its
+ * temperature rises.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef BAL_PLANNER_H
+#define BAL_PLANNER_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "../../fenice_config.h"
+
+/** @brief Approximated slope of the cell open circuit voltage curve (V/Ah) */
+#define BAL_PLANNER_CELL_VOLTAGE_SLOPE 0.3f
+/** @brief Maximum number of resistors active at the same time on a cellboard */
+#define BAL_PLANNER_MAX_ACTIVE_CELLS (CELLBOARD_CELL_COUNT / 2)
+/** @brief Temperature above which the number of active resistors is reduced (°C) */
+#define BAL_PLANNER_TEMP_DERATE 40.f
+/** @brief Temperature at which a cellboard stops discharging (°C) */
+#define BAL_PLANNER_TEMP_LIMIT 50.f
+/** @brief Maximum discharge time of a cell in a single plan (s) */
+#define BAL_PLANNER_MAX_DURATION UINT8_MAX
+/** @brief Interval between two consecutive plans (ms) */
+#define BAL_PLANNER_INTERVAL (BAL_CYCLE_LENGTH + BAL_COOLDOWN_DELAY)
+
+/** @brief Discharge plan of a single cellboard */
+typedef struct {
+    uint32_t cells;                              // Each bit represent a cell to discharge
+    uint8_t durations[CELLBOARD_CELL_COUNT];     // Discharge time of each cell (s)
+} bal_plan_board_t;
+
+/** @brief Discharge plan of the whole pack */
+typedef struct {
+    voltage_t target;                            // Voltage that every cell should reach
+    bal_plan_board_t boards[CELLBOARD_COUNT];
+} bal_plan_t;
+
+/**
+ * @brief Select the non adjacent cells with the maximum total imbalance
+ * @details Hateville problem solved with dynamic programming, the solution
+ * is rebuilt iteratively starting from the last cell
+ *
+ * @param weights The imbalance of each cell
+ * @param count The number of cells (at most CELLBOARD_CELL_COUNT)
+ * @return uint32_t The bitmap of the selected cells
+ */
+uint32_t bal_planner_exclude_neighbors(const uint32_t weights[], size_t count);
+
+/**
+ * @brief Get the maximum number of resistors that can be active on a cellboard
+ *
+ * @param temp The maximum temperature of the cellboard (°C)
+ * @return size_t The number of resistors
+ */
+size_t bal_planner_thermal_budget(float temp);
+
+/**
+ * @brief Get the time needed to discharge a cell by a certain voltage
+ *
+ * @param volt The voltage of the cell (mV * 10)
+ * @param delta The voltage to remove from the cell (mV * 10)
+ * @return float The discharge time (s)
+ */
+float bal_planner_discharge_time(voltage_t volt, voltage_t delta);
+
+/**
+ * @brief Compute the discharge plan of the pack
+ *
+ * @param volts The voltages of all the cells of the pack
+ * @param temps The maximum temperature of each cellboard (°C)
+ * @param target The voltage every cell should reach, if 0 the minimum cell voltage is used
+ * @param threshold Cells below target + threshold are not discharged
+ * @param plan The output plan
+ * @return size_t The number of cells to discharge
+ */
+size_t bal_planner_compute(const voltage_t volts[PACK_CELL_COUNT],
+    const float temps[CELLBOARD_COUNT],
+    voltage_t target,
+    voltage_t threshold,
+    bal_plan_t * plan);
+
+#endif // BAL_PLANNER_H
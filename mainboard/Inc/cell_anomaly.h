@@ -0,0 +1,135 @@
+/**
+ * @file cell_anomaly.h
+ * @brief Detection of the cells drifting away from the rest of the pack
+ *
+ * @details Every voltage snapshot updates three indicators for each cell:
+ * - the z-score of its voltage against the pack mean, filtered while the
+ *   pack is under load, when a weak cell sags more than the others
+ *   (the sign follows the current so a weak cell is always negative)
+ * - its resistance compared to the pack, from the voltage variation of the
+ *   cell against the mean one when the current changes quickly
+ * - its self discharge compared to the pack, from the drift of its voltage
+ *   against the mean one while the pack is at rest and not balancing
+ * Each indicator is divided by its limit and the highest ratio is the score
+ * of the cell, so a cell with a score of 1 or more has exceeded a limit.
+ * An update takes O(cells) time and the memory is fixed.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef CELL_ANOMALY_H
+#define CELL_ANOMALY_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../fenice_config.h"
+
+// The index of a cell is sent in 8 bits
+#if PACK_CELL_COUNT > 256
+#error "The anomaly detector supports at most 256 cells"
+#endif
+
+/** @brief Absolute current above which the pack is under load (A) */
+#define CELL_ANOMALY_LOAD_CURRENT 10.f
+/** @brief Absolute current below which the pack is at rest (A) */
+#define CELL_ANOMALY_REST_CURRENT 1.f
+/** @brief Minimum current variation between two snapshots to estimate the resistance (A) */
+#define CELL_ANOMALY_CURRENT_STEP 20.f
+/** @brief Maximum time between two snapshots to estimate the resistance (ms) */
+#define CELL_ANOMALY_STEP_TIME 500U
+/** @brief Time at rest before the voltage drift is measured, to let the cells relax (ms) */
+#define CELL_ANOMALY_REST_SETTLE_TIME 300000U
+/** @brief Minimum time over which the voltage drift is measured (ms) */
+#define CELL_ANOMALY_REST_MIN_TIME 600000U
+/** @brief Standard deviation under which the cells are considered equal (mV * 10) */
+#define CELL_ANOMALY_MIN_SIGMA 25.f
+
+/** @brief Weight of a new z-score in its filter, a snapshot every 50 ms gives ~10 s */
+#define CELL_ANOMALY_Z_ALPHA 0.005f
+/** @brief Weight of a new resistance estimate in its filter */
+#define CELL_ANOMALY_RESISTANCE_ALPHA 0.1f
+
+/** @brief Limits of the indicators */
+#define CELL_ANOMALY_Z_LIMIT 4.f
+#define CELL_ANOMALY_RESISTANCE_LIMIT 50.f // mV * 10 / A, 5 mOhm
+#define CELL_ANOMALY_DRIFT_LIMIT 10.f      // mV * 10 / h, 1 mV/h
+
+/** @brief Number of suspects published */
+#define CELL_ANOMALY_SUSPECT_COUNT 3
+
+/** @brief Limits exceeded by a cell */
+typedef enum {
+    CELL_ANOMALY_FLAG_Z          = 1U << 0,
+    CELL_ANOMALY_FLAG_RESISTANCE = 1U << 1,
+    CELL_ANOMALY_FLAG_DRIFT      = 1U << 2
+} cell_anomaly_flag_t;
+
+/** @brief Indicators of a suspect cell */
+typedef struct {
+    size_t cell;
+    float score;
+    uint8_t flags;    // cell_anomaly_flag_t
+    float z;          // z-score under load, negative if weaker than the pack
+    float resistance; // mV * 10 / A, compared to the pack
+    float drift;      // mV * 10 / h, compared to the pack, negative if discharging faster
+} cell_anomaly_suspect_t;
+
+/** @brief State of the detector */
+typedef struct {
+    float z[PACK_CELL_COUNT];
+    float resistance[PACK_CELL_COUNT];
+    float drift[PACK_CELL_COUNT];
+    float rest_deviation[PACK_CELL_COUNT]; // Distance from the mean when the drift measure started
+
+    voltage_t previous[PACK_CELL_COUNT];
+    float previous_mean;
+    float previous_current;
+    uint32_t previous_time;
+    bool has_previous;
+
+    bool resting;
+    bool rest_started; // The drift reference has been taken
+    uint32_t rest_time;
+} cell_anomaly_t;
+
+/**
+ * @brief Clear every indicator
+ *
+ * @param anomaly The detector
+ */
+void cell_anomaly_init(cell_anomaly_t * anomaly);
+
+/**
+ * @brief Update the indicators with a snapshot of the cell voltages
+ *
+ * @param anomaly The detector
+ * @param time The time of the snapshot (ms)
+ * @param current The pack current when the snapshot was taken, positive in discharge (A)
+ * @param balancing True if the cells are being discharged by the balancing
+ * @param voltages The voltages of every cell of the pack (mV * 10)
+ */
+void cell_anomaly_update(cell_anomaly_t * anomaly, uint32_t time, float current, bool balancing, const voltage_t * voltages);
+
+/**
+ * @brief Get the indicators of a single cell
+ *
+ * @param anomaly The detector
+ * @param cell The index of the cell in the pack
+ * @param suspect The indicators of the cell
+ */
+void cell_anomaly_get_cell(const cell_anomaly_t * anomaly, size_t cell, cell_anomaly_suspect_t * suspect);
+
+/**
+ * @brief Get the cells with the highest score
+ *
+ * @param anomaly The detector
+ * @param suspects The suspects, from the highest score
+ * @param count The maximum number of suspects
+ * @return size_t The number of suspects, the cells with a score of 0 are not included
+ */
+size_t cell_anomaly_get_suspects(const cell_anomaly_t * anomaly, cell_anomaly_suspect_t * suspects, size_t count);
+
+#endif // CELL_ANOMALY_H
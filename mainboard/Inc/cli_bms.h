@@ -14,6 +14,7 @@
 #include "cli.h"
 #include "../../fenice_config.h"
 #include "config.h"
+#include "tx_ring.h"
 
 #define NORMAL_COLOR           "\033[0m"
 #define RED_BG(S)              "\033[0;41m" S NORMAL_COLOR
@@ -23,6 +24,7 @@
 
 extern cli_t cli_bms;
 extern config_t cellboard_distribution;
+extern tx_ring_t cli_tx_ring;
 
 void cli_bms_init();
 
@@ -30,6 +32,24 @@ void cli_bms_init();
  * @brief Print messages in the cli if dmesg is enabled
  */
 void cli_bms_debug(char *text, size_t length);
+/**
+ * @brief Queue a message in the transmit ring, it is sent via DMA without blocking
+ * @details It can be called from any context, the message is dropped if the ring is full
+ */
+bool cli_bms_print(const char *text, size_t length);
+/**
+ * @brief Resume the transmission of the queued messages once the UART is idle
+ */
+void cli_bms_flush();
+/**
+ * @brief Release the transmitted data and send the next block
+ * @attention This function is meant to be called inside the UART TX complete interrupt
+ */
+void _cli_bms_handle_tx_cplt();
+/**
+ * @brief Send a binary snapshot of the pack if the telemetry stream is enabled
+ */
+void cli_bms_telemetry_routine();
 void _cli_timer_handler(TIM_HandleTypeDef *htim);
 void cli_watch_flush_handler();
 
@@ -0,0 +1,112 @@
+/**
+ * @file deadline_heap.h
+ * @brief Min-heap of the deadlines of a set of periodic events
+ *
+ * @details Each entry has a timeout and is reset every time its event
+ * happens; an entry expires when it is not reset for longer than its timeout.
+ * The entries are kept in a binary min-heap ordered by deadline, so checking
+ * for an expiry only looks at the root.
+ * A reset only stores the time of the event, which is O(1) and safe to be
+ * called from an interrupt; the heap is updated lazily by the check: since a
+ * reset can only move a deadline forward, the deadline stored in the heap is
+ * never later than the real one, and when the root looks expired its real
+ * deadline is recomputed and the entry is moved down in O(log n).
+ * Times are in ms and can wrap around.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef DEADLINE_HEAP_H
+#define DEADLINE_HEAP_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Maximum number of entries */
+#define DEADLINE_HEAP_CAPACITY 16U
+
+/** @brief A watched event */
+typedef struct {
+    uint32_t timeout;              // ms
+    uint32_t deadline;             // ms, deadline used to order the heap
+    volatile uint32_t last_reset;  // ms
+    volatile uint16_t misses;      // Consecutive expirations, cleared by the next reset
+} deadline_heap_entry_t;
+
+/** @brief Heap structure */
+typedef struct {
+    deadline_heap_entry_t entries[DEADLINE_HEAP_CAPACITY];
+    uint8_t heap[DEADLINE_HEAP_CAPACITY];  // Indexes of the entries ordered as a heap
+    size_t count;
+} deadline_heap_t;
+
+/**
+ * @brief Remove all the entries
+ *
+ * @param heap The heap structure
+ */
+void deadline_heap_init(deadline_heap_t * heap);
+
+/**
+ * @brief Add an entry, its first deadline is one timeout from now
+ *
+ * @param heap The heap structure
+ * @param timeout The timeout of the entry in ms
+ * @param now The current time in ms
+ * @return int32_t The index of the entry, -1 if the heap is full
+ */
+int32_t deadline_heap_add(deadline_heap_t * heap, uint32_t timeout, uint32_t now);
+
+/**
+ * @brief Reset the deadline of an entry
+ * @details Safe to be called from an interrupt while the heap is checked
+ *
+ * @param heap The heap structure
+ * @param index The index of the entry
+ * @param now The current time in ms
+ */
+void deadline_heap_reset(deadline_heap_t * heap, size_t index, uint32_t now);
+
+/**
+ * @brief Get the first expired entry
+ * @details An expired entry is rescheduled one timeout later, so it expires
+ * again (increasing its misses) if it is still not reset. Call it until it
+ * returns -1 to get every expired entry
+ *
+ * @param heap The heap structure
+ * @param now The current time in ms
+ * @return int32_t The index of the expired entry, -1 if none has expired
+ */
+int32_t deadline_heap_check(deadline_heap_t * heap, uint32_t now);
+
+/**
+ * @brief Check if an entry has expired and was not reset since
+ *
+ * @param heap The heap structure
+ * @param index The index of the entry
+ * @return true If the entry is expired
+ * @return false Otherwise
+ */
+bool deadline_heap_is_expired(deadline_heap_t * heap, size_t index);
+
+/**
+ * @brief Get the number of consecutive expirations of an entry
+ *
+ * @param heap The heap structure
+ * @param index The index of the entry
+ * @return uint16_t The number of timeouts passed since the last reset
+ */
+uint16_t deadline_heap_get_misses(deadline_heap_t * heap, size_t index);
+
+/**
+ * @brief Get the time left before the earliest deadline in the heap
+ *
+ * @param heap The heap structure
+ * @param now The current time in ms
+ * @return uint32_t The time left in ms, 0 if already passed, UINT32_MAX if the heap is empty
+ */
+uint32_t deadline_heap_time_left(deadline_heap_t * heap, uint32_t now);
+
+#endif // DEADLINE_HEAP_H
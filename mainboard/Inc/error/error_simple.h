@@ -6,50 +6,64 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+#include "../../../fenice_config.h"
+
 #define ERROR_SIMPLE_COUNTER_THRESHOLD_CAN_COMM (2U)
 #define ERROR_SIMPLE_COUNTER_THRESHOLD (10U)
 #define ERROR_SIMPLE_DUMP_SIZE         (50U)
 
+/**
+ * @brief Error groups with their number of instances, as X(group, instances)
+ * @details The enum of the groups, the instance counts and the layout of the
+ * state array are generated from this list at compile time
+ */
+#define ERROR_SIMPLE_GROUPS(X)                               \
+    X(ERROR_GROUP_ERROR_CELL_UNDER_VOLTAGE, 1U)              \
+    X(ERROR_GROUP_ERROR_CELL_OVER_VOLTAGE, 1U)               \
+    X(ERROR_GROUP_ERROR_CELL_UNDER_TEMPERATURE, 1U)          \
+    X(ERROR_GROUP_ERROR_CELL_OVER_TEMPERATURE, 1U)           \
+    X(ERROR_GROUP_ERROR_OVER_CURRENT, 1U)                    \
+    X(ERROR_GROUP_ERROR_CAN, 2U)                             \
+    X(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, 2U)            \
+    X(ERROR_GROUP_ERROR_CELLBOARD_COMM, CELLBOARD_COUNT)     \
+    X(ERROR_GROUP_ERROR_CELLBOARD_INTERNAL, CELLBOARD_COUNT) \
+    X(ERROR_GROUP_ERROR_CONNECTOR_DISCONNECTED, 3U)          \
+    X(ERROR_GROUP_ERROR_FANS_DISCONNECTED, 1U)               \
+    X(ERROR_GROUP_ERROR_FEEDBACK, 20U)                       \
+    X(ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY, 20U)             \
+    X(ERROR_GROUP_ERROR_EEPROM_COMM, 1U)                     \
+    X(ERROR_GROUP_ERROR_EEPROM_WRITE, 1U)
+
+#define _ERROR_SIMPLE_GROUP(group, instances) group,
 typedef enum {
-    ERROR_GROUP_ERROR_CELL_UNDER_VOLTAGE,
-    ERROR_GROUP_ERROR_CELL_OVER_VOLTAGE,
-    ERROR_GROUP_ERROR_CELL_UNDER_TEMPERATURE,
-    ERROR_GROUP_ERROR_CELL_OVER_TEMPERATURE,
-    ERROR_GROUP_ERROR_OVER_CURRENT,
-    ERROR_GROUP_ERROR_CAN,
-    ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH,
-    ERROR_GROUP_ERROR_CELLBOARD_COMM,
-    ERROR_GROUP_ERROR_CELLBOARD_INTERNAL,
-    ERROR_GROUP_ERROR_CONNECTOR_DISCONNECTED,
-    ERROR_GROUP_ERROR_FANS_DISCONNECTED,
-    ERROR_GROUP_ERROR_FEEDBACK,
-    ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY,
-    ERROR_GROUP_ERROR_EEPROM_COMM,
-    ERROR_GROUP_ERROR_EEPROM_WRITE,
+    ERROR_SIMPLE_GROUPS(_ERROR_SIMPLE_GROUP)
     N_ERROR_GROUPS
 } error_simple_groups_t;
+#undef _ERROR_SIMPLE_GROUP
+
+// ERROR_GROUP_ERROR_<GROUP>_N_INSTANCES
+#define _ERROR_SIMPLE_INSTANCES(group, instances) group##_N_INSTANCES = (instances),
+enum { ERROR_SIMPLE_GROUPS(_ERROR_SIMPLE_INSTANCES) };
+#undef _ERROR_SIMPLE_INSTANCES
+
+/**
+ * @brief Layout of the state of the errors, a byte for each instance
+ * @details The index of the first instance of a group is its offsetof
+ */
+#define _ERROR_SIMPLE_LAYOUT(group, instances) uint8_t group[instances];
+typedef struct {
+    ERROR_SIMPLE_GROUPS(_ERROR_SIMPLE_LAYOUT)
+} error_simple_layout_t;
+#undef _ERROR_SIMPLE_LAYOUT
+
+#define ERROR_SIMPLE_STATE_SIZE (sizeof(error_simple_layout_t))
 
 typedef struct {
     error_simple_groups_t group;
     size_t instance;
 } error_simple_dump_element_t;
 
-#define ERROR_GROUP_ERROR_CELL_UNDER_VOLTAGE_N_INSTANCES     (1U)
-#define ERROR_GROUP_ERROR_CELL_OVER_VOLTAGE_N_INSTANCES      (1U)
-#define ERROR_GROUP_ERROR_CELL_UNDER_TEMPERATURE_N_INSTANCES (1U)
-#define ERROR_GROUP_ERROR_CELL_OVER_TEMPERATURE_N_INSTANCES  (1U)
-#define ERROR_GROUP_ERROR_OVER_CURRENT_N_INSTANCES           (1U)
-#define ERROR_GROUP_ERROR_CAN_N_INSTANCES                    (2U)
-#define ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH_N_INSTANCES   (1U)
-#define ERROR_GROUP_ERROR_CELLBOARD_COMM_N_INSTANCES         (6U)
-#define ERROR_GROUP_ERROR_CELLBOARD_INTERNAL_N_INSTANCES     (6U)
-#define ERROR_GROUP_ERROR_CONNECTOR_DISCONNECTED_N_INSTANCES (3U)
-#define ERROR_GROUP_ERROR_FANS_DISCONNECTED_N_INSTANCES      (1U)
-#define ERROR_GROUP_ERROR_FEEDBACK_N_INSTANCES               (20U)
-#define ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY_N_INSTANCES     (20U)
-#define ERROR_GROUP_ERROR_EEPROM_COMM_N_INSTANCES            (1U)
-#define ERROR_GROUP_ERROR_EEPROM_WRITE_N_INSTANCES           (1U)
-
+void error_simple_init(void);
 int error_simple_set(error_simple_groups_t group, size_t instance);
 int error_simple_reset(error_simple_groups_t group, size_t instance);
 int error_simple_routine(void);
@@ -58,5 +72,6 @@ size_t get_expired_errors(void);
 extern error_simple_dump_element_t error_simple_dump[ERROR_SIMPLE_DUMP_SIZE];
 
 size_t _error_simple_from_group_and_instance_to_index(error_simple_groups_t group, size_t instance);
+size_t _error_simple_from_index_to_group_and_instance(size_t index, error_simple_groups_t *group);
 
 #endif  // ERROR_SIMPLE_H
@@ -12,6 +12,7 @@
 
 #include <stdbool.h>
 
+#include "fans_control.h"
 #include "main.h"
 #include "pwm.h"
 
@@ -19,7 +20,8 @@
 #define PWM_FANS_CHANNEL   TIM_CHANNEL_3
 
 #define PWM_FANS_STANDARD_PERIOD 0.03846153846  //26kHz
-#define FANS_START_TEMP 30.f
+
+extern fans_control_t fans_control;
 
 /** @brief Initialize fans */
 void fans_init();
@@ -52,12 +54,19 @@ float fans_get_speed();
  */
 void fans_set_speed(float power_percentage);
 /**
- * @brief A function that maps temperatures (°C) to a fans speeds (%)
+ * @brief Add a sample of the pack current to estimate the heat generated by the cells
+ * 
+ * @param current The current (A)
+ */
+void fans_sample_current(float current);
+/**
+ * @brief Update the fans speed to hold the target temperature
+ * @details The speed is left untouched if it is overrided
  * 
- * @param temp The input temperature
- * @return float The fans speed (%)
+ * @param max_temp The temperature of the hottest cell (°C)
+ * @param dt The time since the previous update (s)
  */
-float fans_curve(float temp);
+void fans_routine(float max_temp, float dt);
 
 /**
  * @brief Play something with the buzzer (sborato)
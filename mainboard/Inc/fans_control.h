@@ -0,0 +1,107 @@
+/**
+ * @file fans_control.h
+ * @brief Closed-loop control of the speed of the fans
+ *
+ * @details The pack is modelled as a single thermal mass which receives the
+ * Joule losses of the cells (I^2 * R) and exchanges heat with the ambient
+ * through a conductance which grows linearly with the fans speed.
+ * The speed is the sum of:
+ * - a feed-forward, the speed which would hold the target temperature at
+ *   steady state with the measured losses according to the model; the
+ *   losses are low-pass filtered since the thermal mass of the pack
+ *   averages the current peaks anyway
+ * - a PI on the error between the hottest cell and the target temperature,
+ *   which corrects the mismatch between the model and the real pack
+ * The integral is frozen while the output is limited (anti-windup) and the
+ * output follows a ramp, faster when speeding up than when slowing down, to
+ * avoid audible speed changes. Below the minimum speed the fans would stall
+ * so they are turned off, with hysteresis.
+ * The board has no tachometer nor current sense on the fans, so the speed is
+ * assumed to follow the PWM duty cycle.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef FANS_CONTROL_H
+#define FANS_CONTROL_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Default target temperature of the hottest cell (°C) */
+#define FANS_CONTROL_TARGET_TEMP 40.f
+/** @brief Assumed temperature of the air entering the pack (°C) */
+#define FANS_CONTROL_AMBIENT_TEMP 25.f
+/** @brief Estimated resistance of the whole pack (Ohm) */
+#define FANS_CONTROL_PACK_RESISTANCE 0.3f
+/** @brief Estimated thermal conductance between the pack and the ambient with the fans off (W/K) */
+#define FANS_CONTROL_CONDUCTANCE_OFF 5.f
+/** @brief Estimated thermal conductance added by the fans at full speed (W/K) */
+#define FANS_CONTROL_CONDUCTANCE_FANS 80.f
+/** @brief Time constant of the filter of the losses, much shorter than the one of the pack (s) */
+#define FANS_CONTROL_LOSSES_TIME_CONSTANT 300.f
+/** @brief Proportional gain (1/K) */
+#define FANS_CONTROL_KP 0.1f
+/** @brief Integral gain (1/(K*s)) */
+#define FANS_CONTROL_KI 0.0005f
+/** @brief Maximum increase of the speed (1/s) */
+#define FANS_CONTROL_RAMP_UP 0.1f
+/** @brief Maximum decrease of the speed (1/s) */
+#define FANS_CONTROL_RAMP_DOWN 0.02f
+/** @brief Minimum speed at which the fans spin */
+#define FANS_CONTROL_MIN_SPEED 0.15f
+/** @brief Temperature above the target at which the fans go to full speed ignoring the ramp (K) */
+#define FANS_CONTROL_EMERGENCY_DELTA 10.f
+
+/** @brief Controller structure */
+typedef struct {
+    float target;        // °C
+    float integral;      // Speed contribution of the integral term
+    float feed_forward;  // Speed contribution of the feed-forward
+    float speed;         // Last output, between 0 and 1
+    float losses;        // W, filtered losses
+    float current_sq;    // A^2, sum of the squared current samples of the current period
+    uint32_t samples;    // Number of current samples of the current period
+} fans_control_t;
+
+/**
+ * @brief Reset the controller with the fans off
+ *
+ * @param control The controller structure
+ * @param target The target temperature in °C
+ */
+void fans_control_init(fans_control_t * control, float target);
+
+/**
+ * @brief Add a sample of the pack current, used to estimate the losses
+ *
+ * @param control The controller structure
+ * @param current The current in A
+ */
+void fans_control_sample_current(fans_control_t * control, float current);
+
+/**
+ * @brief Get the speed which holds a temperature at steady state according to the model
+ *
+ * @param losses The heat generated by the pack in W
+ * @param target The temperature in °C
+ * @return float The speed, between 0 and 1
+ */
+float fans_control_feed_forward(float losses, float target);
+
+/**
+ * @brief Compute the new fans speed
+ * @details The losses are updated with the mean of the current samples
+ * added since the previous update, if there are none the previous losses
+ * are used
+ *
+ * @param control The controller structure
+ * @param temp The temperature of the hottest cell in °C
+ * @param dt The time since the previous update in s
+ * @return float The fans speed, between 0 and 1
+ */
+float fans_control_update(fans_control_t * control, float temp, float dt);
+
+#endif // FANS_CONTROL_H
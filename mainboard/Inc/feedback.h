@@ -17,6 +17,7 @@
 
 #include <../../fenice_config.h>
 #include "bms_fsm.h"
+#include "feedback_capture.h"
 
 /**
  * @brief Feedbacks that should be logical high for each state of the FSM
@@ -200,18 +201,24 @@ typedef struct {
     float voltage;
 } feedback_feed_t;
 
+/** @brief Capture of the raw feedback samples, filled by the ADC callbacks */
+extern feedback_capture_t feedback_capture;
 
 
 /** @brief Feedback timer callback handler */
 void _feedback_handle_tim_elapsed_irq();
-/** @brief Feedback ADC callback handler */
+/** @brief Feedback ADC callback handler for the shutdown feedbacks, classifies the new samples and updates the feedbacks state */
 void _feedback_handle_adc_cnv_cmpl_irq();
+/** @brief Feedback ADC injected callback handler for the multiplexer feedbacks, classifies the new sample and switches to the next channel */
+void _feedback_handle_adc_inj_cnv_cmpl_irq();
 
 
 /** @brief Initialize the feedbacks */
 void feedback_init();
 /**
  * @brief Check if the feedbacks specified in the mask are in the right range
+ * @details The state of the feedbacks is already computed by the ADC callback,
+ * this function only compares it with the expected value
  * 
  * @param mask A bitmask to select the feedbacks
  * @param value A bitset used to specify the feedbacks that should have a logic value of 1
@@ -226,6 +233,14 @@ bool feedback_is_ok(feedback_t mask, feedback_t value);
  * @return float The feedback voltage
  */
 float feedback_get_voltage(size_t index);
+/**
+ * @brief Convert a raw sample of a feedback to a voltage
+ * 
+ * @param index The index of the feedback
+ * @param value The raw ADC value
+ * @return float The feedback voltage
+ */
+float feedback_get_voltage_from_raw(size_t index, uint16_t value);
 /**
  * @brief Get the status of a single feedback
  * 
@@ -240,4 +255,23 @@ feedback_feed_t feedback_get_state(size_t index);
  */
 void feedback_get_all_states(feedback_feed_t out_value[FEEDBACK_N]);
 
+/** @brief Start sending the samples of a complete capture via CAN */
+void feedback_dump_start();
+/**
+ * @brief Check if there are samples of the capture still to be sent
+ * 
+ * @return true If the dump is in progress
+ * @return false Otherwise
+ */
+bool feedback_dump_is_pending();
+/**
+ * @brief Get the next sample of the capture to send
+ * 
+ * @param offset The position of the sample in the capture
+ * @param sample The sample
+ * @return true If a sample has been copied
+ * @return false If there are no more samples to send
+ */
+bool feedback_dump_next(size_t * offset, feedback_capture_sample_t * sample);
+
 #endif // FEEDBACK_H
\ No newline at end of file
@@ -0,0 +1,140 @@
+/**
+ * @file feedback_capture.h
+ * @brief Capture of the raw feedback samples around an event
+ *
+ * @details The samples of the selected feedbacks are recorded in a ring
+ * buffer as soon as the capture is armed; when the trigger fires only a
+ * fixed number of samples is added, so that the buffer holds the samples
+ * before (pre-trigger) and after (post-trigger) the event.
+ * Once complete the capture is frozen until it is armed again.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef FEEDBACK_CAPTURE_H
+#define FEEDBACK_CAPTURE_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Maximum number of samples of a capture */
+#define FEEDBACK_CAPTURE_SIZE 512
+/** @brief Default number of samples recorded before the trigger */
+#define FEEDBACK_CAPTURE_DEFAULT_PRE 128
+/** @brief Default number of samples recorded after the trigger */
+#define FEEDBACK_CAPTURE_DEFAULT_POST 384
+/** @brief Number of samples sent via CAN every 10ms during a dump */
+#define FEEDBACK_CAPTURE_CAN_BURST 3
+
+/** @brief State of the capture */
+typedef enum {
+    FEEDBACK_CAPTURE_STATE_IDLE,      // Not recording
+    FEEDBACK_CAPTURE_STATE_ARMED,     // Recording, waiting for the trigger
+    FEEDBACK_CAPTURE_STATE_TRIGGERED, // Recording the post-trigger samples
+    FEEDBACK_CAPTURE_STATE_DONE       // Complete, the samples can be read
+} FEEDBACK_CAPTURE_STATE;
+
+/** @brief Events that can end a capture */
+typedef enum {
+    FEEDBACK_CAPTURE_TRIGGER_MANUAL,      // Only triggered by the user
+    FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR, // The FSM enters the fatal error state
+    FEEDBACK_CAPTURE_TRIGGER_TRANSITION,  // Any transition of the FSM
+    FEEDBACK_CAPTURE_TRIGGER_N
+} FEEDBACK_CAPTURE_TRIGGER;
+
+/** @brief A single raw sample of a feedback */
+typedef struct {
+    uint16_t time;  // ms, lower 16 bits of the system tick
+    uint16_t value; // Raw ADC value
+    uint8_t index;  // Index of the feedback
+} feedback_capture_sample_t;
+
+/** @brief Capture buffer */
+typedef struct {
+    feedback_capture_sample_t samples[FEEDBACK_CAPTURE_SIZE];
+    volatile FEEDBACK_CAPTURE_STATE state;
+    FEEDBACK_CAPTURE_TRIGGER trigger;
+    uint32_t mask;         // Bitmask of the recorded feedbacks (feedback_t)
+    size_t pre;            // Requested number of pre-trigger samples
+    size_t post;           // Requested number of post-trigger samples
+    size_t head;           // Index of the next sample to write
+    size_t count;          // Number of valid samples in the buffer
+    size_t trigger_pre;    // Number of pre-trigger samples available when the trigger fired
+    size_t trigger_post;   // Number of post-trigger samples recorded
+} feedback_capture_t;
+
+/**
+ * @brief Stop and clear the capture
+ *
+ * @param capture The capture structure
+ */
+void feedback_capture_init(feedback_capture_t * capture);
+
+/**
+ * @brief Clear the buffer and start recording
+ *
+ * @param capture The capture structure
+ * @param mask The bitmask of the feedbacks to record
+ * @param trigger The event which ends the capture
+ * @param pre The number of samples to keep before the trigger
+ * @param post The number of samples to record after the trigger
+ * @return true If the capture has been armed
+ * @return false If the parameters are not valid or pre + post exceeds FEEDBACK_CAPTURE_SIZE
+ */
+bool feedback_capture_arm(feedback_capture_t * capture,
+    uint32_t mask,
+    FEEDBACK_CAPTURE_TRIGGER trigger,
+    size_t pre,
+    size_t post);
+
+/**
+ * @brief Notify an event to the capture
+ * @details The event fires the trigger only if the capture is armed and the
+ * event is the selected one, a manual trigger always fires
+ *
+ * @param capture The capture structure
+ * @param event The event that occurred
+ */
+void feedback_capture_trigger(feedback_capture_t * capture, FEEDBACK_CAPTURE_TRIGGER event);
+
+/**
+ * @brief Record a sample of a feedback
+ * @attention This function is meant to be called inside the ADC interrupts
+ *
+ * @param capture The capture structure
+ * @param index The index of the feedback
+ * @param value The raw ADC value
+ * @param time The time of the sample (ms)
+ */
+void feedback_capture_add(feedback_capture_t * capture, size_t index, uint16_t value, uint32_t time);
+
+/**
+ * @brief Get the number of samples of a complete capture
+ *
+ * @param capture The capture structure
+ * @return size_t The number of samples, 0 if the capture is not complete
+ */
+size_t feedback_capture_get_count(const feedback_capture_t * capture);
+
+/**
+ * @brief Get the position of the trigger inside a complete capture
+ *
+ * @param capture The capture structure
+ * @return size_t The index of the first sample recorded after the trigger
+ */
+size_t feedback_capture_get_trigger_offset(const feedback_capture_t * capture);
+
+/**
+ * @brief Get a sample of a complete capture
+ *
+ * @param capture The capture structure
+ * @param offset The index of the sample starting from the oldest one
+ * @param out The copied sample
+ * @return true If the sample exists
+ * @return false Otherwise
+ */
+bool feedback_capture_get_sample(const feedback_capture_t * capture, size_t offset, feedback_capture_sample_t * out);
+
+#endif // FEEDBACK_CAPTURE_H
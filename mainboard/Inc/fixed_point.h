@@ -0,0 +1,110 @@
+/**
+ * @file fixed_point.h
+ * @brief Fixed-point types of the measurement chain
+ *
+ * @details Each physical quantity has its own Q format, a 32 bit signed
+ * integer holding the value multiplied by 2^FRAC:
+ * - voltage: Q11.20, up to +-2048 V with a resolution below 1 uV
+ * - current: Q15.16, up to +-32768 A
+ * - temperature: Q23.8, 1/256 degC
+ * - gain: Q11.20, the ratio between two quantities (e.g. A/V)
+ * The scale factors are fixed at compile time and the constants are
+ * converted by the compiler with FIXED_*_CONST, so the chain from the ADC to
+ * the currents uses only integer operations and the single precision FPU is
+ * needed only where a value leaves the chain as a float.
+ * Each format is wrapped in its own structure, so the compiler rejects a
+ * voltage passed as a current or a plain integer used as a fixed-point value;
+ * the raw value is in the q field and every conversion is explicit.
+ * Every operation rounds to the nearest value, ties towards +inf.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef FIXED_POINT_H
+#define FIXED_POINT_H
+
+#include <inttypes.h>
+
+#define FIXED_VOLTAGE_FRAC 20U
+#define FIXED_CURRENT_FRAC 16U
+#define FIXED_TEMPERATURE_FRAC 8U
+#define FIXED_GAIN_FRAC 20U
+
+typedef struct { int32_t q; } fixed_voltage_t;     // V, Q11.20
+typedef struct { int32_t q; } fixed_current_t;     // A, Q15.16
+typedef struct { int32_t q; } fixed_temperature_t; // degC, Q23.8
+typedef struct { int32_t q; } fixed_gain_t;        // Q11.20
+
+/**
+ * @brief Convert a constant to a raw fixed-point value
+ * @details Computed in double precision, which is folded by the compiler,
+ * so it must be used only with constant expressions
+ */
+#define FIXED_CONST(x, frac) ((int32_t)((x) * (double)(1UL << (frac)) + ((x) < 0 ? -0.5 : 0.5)))
+#define FIXED_VOLTAGE_CONST(x) ((fixed_voltage_t){ FIXED_CONST(x, FIXED_VOLTAGE_FRAC) })
+#define FIXED_CURRENT_CONST(x) ((fixed_current_t){ FIXED_CONST(x, FIXED_CURRENT_FRAC) })
+#define FIXED_TEMPERATURE_CONST(x) ((fixed_temperature_t){ FIXED_CONST(x, FIXED_TEMPERATURE_FRAC) })
+#define FIXED_GAIN_CONST(x) ((fixed_gain_t){ FIXED_CONST(x, FIXED_GAIN_FRAC) })
+
+/** @brief Convert a raw fixed-point value to float, in single precision */
+#define FIXED_TO_FLOAT(x, frac) ((float)(x) * (1.f / (float)(1UL << (frac))))
+
+static inline float fixed_voltage_to_float(fixed_voltage_t value) {
+    return FIXED_TO_FLOAT(value.q, FIXED_VOLTAGE_FRAC);
+}
+static inline float fixed_current_to_float(fixed_current_t value) {
+    return FIXED_TO_FLOAT(value.q, FIXED_CURRENT_FRAC);
+}
+static inline float fixed_temperature_to_float(fixed_temperature_t value) {
+    return FIXED_TO_FLOAT(value.q, FIXED_TEMPERATURE_FRAC);
+}
+
+/** @brief Absolute value of a current */
+static inline fixed_current_t fixed_current_abs(fixed_current_t value) {
+    return (fixed_current_t){ value.q < 0 ? -value.q : value.q };
+}
+
+/**
+ * @brief Multiply two raw fixed-point values
+ *
+ * @param a The first value
+ * @param b The second value
+ * @param shift The fraction bits to remove from the product: FRAC(a) + FRAC(b) - FRAC(result)
+ * @return int32_t The product, saturated to the int32_t range
+ */
+int32_t fixed_mul(int32_t a, int32_t b, uint8_t shift);
+
+/**
+ * @brief Voltage of the sum of samples of an ADC
+ * @details The result is the exact value rounded to the nearest
+ *
+ * @param sum The sum of the samples
+ * @param count The number of samples
+ * @param full_scale The value of the ADC at the reference voltage (e.g. 4095)
+ * @param vref The reference voltage
+ * @return fixed_voltage_t The average voltage of the samples
+ */
+fixed_voltage_t fixed_voltage_from_adc(uint32_t sum, uint32_t count, uint32_t full_scale, fixed_voltage_t vref);
+
+/**
+ * @brief Current measured by a sensor with a linear output
+ *
+ * @param volt The output of the sensor
+ * @param offset The output of the sensor at 0 A
+ * @param gain The current for each volt of output (A / V)
+ * @return fixed_current_t The current
+ */
+fixed_current_t fixed_current_from_voltage(fixed_voltage_t volt, fixed_voltage_t offset, fixed_gain_t gain);
+
+/**
+ * @brief First order low-pass filter of a current: alpha * prev + (1 - alpha) * value
+ *
+ * @param prev The previous output of the filter
+ * @param value The new value
+ * @param alpha The weight of the previous output, between 0 and 1
+ * @return fixed_current_t The filtered current
+ */
+fixed_current_t fixed_current_filter(fixed_current_t prev, fixed_current_t value, fixed_gain_t alpha);
+
+#endif // FIXED_POINT_H
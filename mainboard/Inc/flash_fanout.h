@@ -0,0 +1,183 @@
+/**
+ * @file flash_fanout.h
+ * @brief Flash every cellboard at once through the mainboard
+ *
+ * @details The host talks XCP to a single virtual bootloader: each command it
+ * sends is copied to the OpenBLT bootloader of every cellboard in the session
+ * and a single answer is sent back once every board has acknowledged it, so
+ * the whole pack is updated in about the time needed for a single board.
+ * Each board is tracked on its own: a command which is not acknowledged in
+ * time is sent again to that board only, up to a number of retries.
+ * Programming commands move the memory address (MTA) of the bootloader
+ * forward, so before repeating one of them the address is restored with a
+ * SET_MTA, in case the command was executed and only its answer was lost.
+ * When a board fails (it never answers or answers with an error) the host
+ * receives an error answer, so the update is aborted instead of leaving a
+ * board with a partial image.
+ * Frames are received from the interrupts through single-slot mailboxes
+ * and all the processing happens in the main loop.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef FLASH_FANOUT_H
+#define FLASH_FANOUT_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../fenice_config.h"
+
+/** @brief Number of bootloaders which can be flashed at once */
+#define FLASH_FANOUT_BOARD_COUNT CELLBOARD_COUNT
+/** @brief Maximum length of an XCP packet over CAN */
+#define FLASH_FANOUT_DATA_SIZE 8U
+
+/** @brief Time given to a board to answer a command (ms) */
+#define FLASH_FANOUT_TIMEOUT_MS 100U
+/** @brief Time given to a board to answer a connect, short since the board could still be booting (ms) */
+#define FLASH_FANOUT_CONNECT_TIMEOUT_MS 20U
+/** @brief Time given to a board to erase its memory or to finish the programming (ms) */
+#define FLASH_FANOUT_ERASE_TIMEOUT_MS 3000U
+/** @brief Number of times a command is sent again to a board before giving up */
+#define FLASH_FANOUT_RETRIES 3U
+/** @brief Number of times a connect is sent again, enough to wait for the boards to reboot */
+#define FLASH_FANOUT_CONNECT_RETRIES 50U
+/** @brief Time without commands from the host after which the session ends (ms) */
+#define FLASH_FANOUT_SESSION_TIMEOUT_MS 2000U
+
+#if FLASH_FANOUT_BOARD_COUNT > 32
+#error "The boards have to fit in a 32 bit mask"
+#endif
+
+/** @brief Bit mask with every board of the pack */
+#if FLASH_FANOUT_BOARD_COUNT == 32
+#define FLASH_FANOUT_ALL_BOARDS UINT32_MAX
+#else
+#define FLASH_FANOUT_ALL_BOARDS (((uint32_t)1U << FLASH_FANOUT_BOARD_COUNT) - 1U)
+#endif
+
+/** @brief State of a board during a command */
+typedef enum {
+    FLASH_FANOUT_BOARD_IDLE,      // Not part of the command
+    FLASH_FANOUT_BOARD_SEND,      // The command has to be sent
+    FLASH_FANOUT_BOARD_WAIT,      // Waiting for the answer to the command
+    FLASH_FANOUT_BOARD_SEND_MTA,  // The address has to be restored before sending the command again
+    FLASH_FANOUT_BOARD_WAIT_MTA,  // Waiting for the answer to the address restore
+    FLASH_FANOUT_BOARD_DONE,      // The board has answered
+    FLASH_FANOUT_BOARD_FAILED     // The board has not answered or answered with an error
+} flash_fanout_board_state_t;
+
+/** @brief Frame written by an interrupt and read by the main loop */
+typedef struct {
+    uint8_t data[FLASH_FANOUT_DATA_SIZE];
+    uint8_t length;
+    volatile uint8_t seq;  // Incremented after each write
+} flash_fanout_slot_t;
+
+/** @brief A bootloader of the session */
+typedef struct {
+    flash_fanout_slot_t rx;  // Last answer of the board
+    uint8_t rx_seq;          // Sequence number of the last answer read
+    flash_fanout_board_state_t state;
+    uint8_t retries;
+    uint32_t sent_time;      // ms
+    uint32_t mta;            // Address of the bootloader after the last acknowledged command
+    bool mta_valid;
+    uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+    uint8_t answer_length;
+} flash_fanout_board_t;
+
+/** @brief Fan-out structure */
+typedef struct {
+    flash_fanout_board_t boards[FLASH_FANOUT_BOARD_COUNT];
+    flash_fanout_slot_t request;  // Last command of the host
+    uint8_t request_seq;          // Sequence number of the last command read
+    uint8_t command[FLASH_FANOUT_DATA_SIZE];
+    uint8_t command_length;
+    bool pending;                 // A command is being executed
+    bool answer_ready;            // The answer to the host is ready to be sent
+    uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+    uint8_t answer_length;
+    bool active;
+    uint32_t last_request;        // ms
+    uint32_t mask;                // Boards of the session
+    uint32_t failed;              // Boards which have failed during the session
+    uint16_t retransmissions;
+    uint32_t commands;            // Commands acknowledged by every board
+} flash_fanout_t;
+
+/**
+ * @brief Reset the fan-out, the session will include the given boards
+ *
+ * @param fanout The fan-out structure
+ * @param mask The bit mask of the boards to flash
+ */
+void flash_fanout_init(flash_fanout_t * fanout, uint32_t mask);
+
+/**
+ * @brief Store a command from the host
+ * @details Safe to be called from an interrupt, a new command replaces the
+ * previous one since the host sends one only after the previous has been
+ * answered or has timed out
+ *
+ * @param fanout The fan-out structure
+ * @param data The XCP packet
+ * @param length The length of the packet
+ */
+void flash_fanout_request(flash_fanout_t * fanout, const uint8_t * data, uint8_t length);
+
+/**
+ * @brief Store an answer from a bootloader
+ * @details Safe to be called from an interrupt
+ *
+ * @param fanout The fan-out structure
+ * @param board The index of the board
+ * @param data The XCP packet
+ * @param length The length of the packet
+ */
+void flash_fanout_receive(flash_fanout_t * fanout, size_t board, const uint8_t * data, uint8_t length);
+
+/**
+ * @brief Process the received frames and the timeouts
+ *
+ * @param fanout The fan-out structure
+ * @param now The current time in ms
+ */
+void flash_fanout_update(flash_fanout_t * fanout, uint32_t now);
+
+/**
+ * @brief Get the next frame to send to a bootloader
+ * @details The frame is considered sent, so call it only when it can be transmitted
+ *
+ * @param fanout The fan-out structure
+ * @param now The current time in ms
+ * @param data The buffer where the packet is copied, at least FLASH_FANOUT_DATA_SIZE bytes long
+ * @param length The length of the packet
+ * @return int32_t The index of the destination board, -1 if there is nothing to send
+ */
+int32_t flash_fanout_next(flash_fanout_t * fanout, uint32_t now, uint8_t * data, uint8_t * length);
+
+/**
+ * @brief Get the answer for the host, once per command
+ *
+ * @param fanout The fan-out structure
+ * @param data The buffer where the packet is copied, at least FLASH_FANOUT_DATA_SIZE bytes long
+ * @param length The length of the packet
+ * @return true If an answer has been copied
+ * @return false Otherwise
+ */
+bool flash_fanout_get_answer(flash_fanout_t * fanout, uint8_t * data, uint8_t * length);
+
+/**
+ * @brief Check if a session is in progress
+ *
+ * @param fanout The fan-out structure
+ * @return true If the host is flashing the boards
+ * @return false Otherwise
+ */
+bool flash_fanout_is_active(flash_fanout_t * fanout);
+
+#endif // FLASH_FANOUT_H
@@ -9,19 +9,12 @@
 
 #pragma once
 
+#include "imd_decoder.h"
 #include "main.h"
 #include "mainboard_config.h"
 #include "tim.h"
 
-typedef enum {
-    IMD_SC,
-    IMD_NORMAL,
-    IMD_UNDER_VOLTAGE,
-    IMD_START_MEASURE,
-    IMD_DEVICE_ERROR,
-    IMD_EARTH_FAULT,
-    IMD_STATES_N
-} IMD_STATE;
+extern imd_decoder_t imd_decoder;
 
 void imd_init();
 /**
@@ -49,8 +42,14 @@ float imd_get_duty_cycle_percentage();
 uint8_t imd_is_fault();
 /**
  * @brief	gets the imd state
+ * @details the state is filtered over the last periods of the pwm
  */
 IMD_STATE imd_get_state();
+/**
+ * @brief	gets the share of the last periods which agree with the state
+ * @returns the confidence in %
+ */
+uint8_t imd_get_confidence();
 /**
  * @brief	gets the imd details
  * @details based on the imd state this function 
@@ -60,4 +59,14 @@ IMD_STATE imd_get_state();
  *          IMD_DEVICE_ERROR    ==> 1 when valid, -1 when not
  *          IMD_EARTH_FAULT     ==> 1 when valid, -1 when not
  */
-int32_t imd_get_details();
\ No newline at end of file
+int32_t imd_get_details();
+/**
+ * @brief	gets the insulation resistance
+ * @returns the resistance in kOhm, -1 if not available
+ */
+int32_t imd_get_resistance();
+/**
+ * @brief	samples the insulation resistance to update its trend
+ * @details to be called every second
+ */
+void imd_trend_routine();
@@ -0,0 +1,178 @@
+/**
+ * @file imd_decoder.h
+ * @brief Decoder of the PWM status signal of the IMD
+ *
+ * @details The IMD (Bender IR155) encodes its state in the frequency of a PWM
+ * signal and the measured insulation resistance in its duty cycle.
+ * Each period captured by the timer is classified by its frequency with a
+ * tolerance band and stored in a small window of recent captures; the state
+ * changes only when the majority of the window agrees on it, so a single
+ * noisy edge (which corrupts at most two periods) can never flip it while a
+ * real change is accepted after IMD_DECODER_MAJORITY periods.
+ * The duty cycle and period are the medians of the captures of the current
+ * state, the confidence is the share of the window which agrees with it.
+ * When no edge is received for IMD_DECODER_TIMEOUT_MS the output is stuck
+ * at the level of the last edge, which means a short circuit.
+ * The insulation resistance is also sampled periodically to estimate its
+ * trend.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef IMD_DECODER_H
+#define IMD_DECODER_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Number of captures used to classify the signal */
+#define IMD_DECODER_WINDOW 5U
+/** @brief Number of agreeing captures needed to change state */
+#define IMD_DECODER_MAJORITY (IMD_DECODER_WINDOW / 2U + 1U)
+/** @brief Tolerance of the period of each state (%) */
+#define IMD_DECODER_TOLERANCE 10U
+/** @brief Time without edges after which the signal is considered stuck (ms) */
+#define IMD_DECODER_TIMEOUT_MS 250U
+/** @brief Number of resistance samples used to compute the trend */
+#define IMD_DECODER_TREND_SAMPLES 16U
+/** @brief Resistance reported when the duty cycle is at (or below) its minimum (kOhm) */
+#define IMD_DECODER_RESISTANCE_MAX 50000
+
+#if IMD_DECODER_WINDOW < 5
+#error "The IMD decoder window must outvote the two periods corrupted by a single glitch"
+#endif
+
+typedef enum {
+    IMD_SC,
+    IMD_NORMAL,
+    IMD_UNDER_VOLTAGE,
+    IMD_START_MEASURE,
+    IMD_DEVICE_ERROR,
+    IMD_EARTH_FAULT,
+    IMD_STATES_N
+} IMD_STATE;
+
+/** @brief A single period of the signal */
+typedef struct {
+    uint32_t period;  // us
+    uint16_t duty;    // % * 100
+    IMD_STATE state;  // IMD_STATES_N if the period matches no state
+} imd_decoder_capture_t;
+
+/** @brief Decoder structure */
+typedef struct {
+    imd_decoder_capture_t captures[IMD_DECODER_WINDOW];
+    size_t head;              // Index of the next capture to write
+    size_t count;             // Number of valid captures in the window
+    volatile IMD_STATE state; // Last stable state, held until another one gets the majority
+    volatile uint8_t confidence;  // %
+    volatile uint32_t period; // us, median of the captures of the current state
+    volatile uint16_t duty;   // % * 100, median of the captures of the current state
+    volatile uint32_t last_edge;  // ms
+    volatile bool level;      // Level of the signal after the last edge
+
+    uint32_t trend_times[IMD_DECODER_TREND_SAMPLES];   // ms
+    int32_t trend_values[IMD_DECODER_TREND_SAMPLES];   // kOhm
+    size_t trend_head;
+    size_t trend_count;
+    int32_t resistance_min;   // kOhm, lowest resistance since the initialization, -1 if not available
+} imd_decoder_t;
+
+/**
+ * @brief Clear the captures and the trend
+ *
+ * @param decoder The decoder structure
+ */
+void imd_decoder_init(imd_decoder_t * decoder);
+
+/**
+ * @brief Record an edge of the signal
+ * @details To be called for every edge, before imd_decoder_add_capture on
+ * the rising ones. The captures before a timeout are discarded so that the
+ * decoder starts from scratch once the signal is back
+ *
+ * @param decoder The decoder structure
+ * @param level The level of the signal after the edge
+ * @param now The current time in ms
+ */
+void imd_decoder_edge(imd_decoder_t * decoder, bool level, uint32_t now);
+/**
+ * @brief Add a complete period of the signal and update the state
+ *
+ * @param decoder The decoder structure
+ * @param period The length of the period in us
+ * @param high The time the signal was high during the period in us
+ */
+void imd_decoder_add_capture(imd_decoder_t * decoder, uint32_t period, uint32_t high);
+
+/**
+ * @brief Get the state which matches a period
+ *
+ * @param period The length of the period in us
+ * @return IMD_STATE The state or IMD_STATES_N if the period is out of every tolerance band
+ */
+IMD_STATE imd_decoder_classify(uint32_t period);
+
+/**
+ * @brief Get the current state
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ * @return IMD_STATE The state, IMD_SC if the signal is stuck
+ */
+IMD_STATE imd_decoder_get_state(imd_decoder_t * decoder, uint32_t now);
+/**
+ * @brief Get the share of the recent captures which agree with the current state
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ * @return uint8_t The confidence in %
+ */
+uint8_t imd_decoder_get_confidence(imd_decoder_t * decoder, uint32_t now);
+/**
+ * @brief Get the period of the signal
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ * @return uint32_t The period in us, 0 if the signal is stuck
+ */
+uint32_t imd_decoder_get_period(imd_decoder_t * decoder, uint32_t now);
+/**
+ * @brief Get the duty cycle of the signal
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ * @return uint16_t The duty cycle in % * 100, 0 or 10000 if the signal is stuck
+ */
+uint16_t imd_decoder_get_duty(imd_decoder_t * decoder, uint32_t now);
+/**
+ * @brief Get the insulation resistance
+ * @details The resistance is only measured in the normal and under voltage states
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ * @return int32_t The resistance in kOhm, -1 if not available
+ */
+int32_t imd_decoder_get_resistance(imd_decoder_t * decoder, uint32_t now);
+
+/**
+ * @brief Sample the insulation resistance for the trend
+ * @details To be called periodically, the samples are cleared when the
+ * resistance is not available
+ *
+ * @param decoder The decoder structure
+ * @param now The current time in ms
+ */
+void imd_decoder_trend_sample(imd_decoder_t * decoder, uint32_t now);
+/**
+ * @brief Get the rate of change of the insulation resistance
+ * @details The rate is the slope of the least squares line through the samples
+ *
+ * @param decoder The decoder structure
+ * @return float The rate in kOhm/min, 0 if there are less than two samples
+ */
+float imd_decoder_get_trend(imd_decoder_t * decoder);
+
+#endif // IMD_DECODER_H
@@ -27,10 +27,18 @@ typedef enum {
 } MEASURE_INTERVAL;
 
 
+/** @brief CPU cycles spent by the measures of an interval */
+typedef struct {
+    uint32_t last;
+    uint32_t max;
+} measures_cycles_t;
+
 /** @brief Initialize all measures */
 void measures_init();
 /** @brief Run checks for each measure */
 void measures_check_flags();
+/** @brief Get the CPU cycles spent by the measures of the 50 ms interval, the hot path of the measurement chain */
+measures_cycles_t measures_get_cycles_50ms();
 /**
  * @brief Timer callback function
  * 
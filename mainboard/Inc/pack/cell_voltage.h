@@ -12,20 +12,36 @@
 #ifndef CELL_VOLTAGE_H
 #define CELL_VOLTAGE_H
 
+#include <stdbool.h>
+
 #include "stm32f4xx_hal.h"
 #include "../../fenice_config.h"
+#include "pack/current.h"
+#include "cell_anomaly.h"
 
 #define CONVERT_VOLTAGE_TO_VALUE(x) ((x) * 10000.f)
 #define CONVERT_VALUE_TO_VOLTAGE(x) ((float)(x) / 10000.f)
 
-/** @brief Maximum, minimum and average of the cells of the pack */
+/** @brief Maximum, minimum, average and single values of the cells of the pack */
 typedef struct {
     voltage_t min[CELLBOARD_COUNT];
     voltage_t max[CELLBOARD_COUNT];
     float avg[CELLBOARD_COUNT];
+    voltage_t cells[PACK_CELL_COUNT];
 } cell_voltage;
 
+/** @brief Voltages of all the cells of the pack sampled at the same instant */
+typedef struct {
+    uint8_t seq;                         // Sequence number of the snapshot
+    uint32_t timestamp;                  // Time at which the snapshot was triggered (ms)
+    current_t current;                   // Current sampled when the snapshot was triggered
+    uint16_t bat;                        // Pack voltage read by the internal ADC in the same cycle
+    uint16_t tsp;                        // TS+ voltage read by the internal ADC in the same cycle
+    voltage_t voltages[PACK_CELL_COUNT];
+} cell_voltage_snapshot_t;
+
 extern cell_voltage cell_volts;
+extern cell_anomaly_t cell_anomaly;
 
 /** @brief Intialize the cell voltages */
 void cell_voltage_init();
@@ -43,6 +59,85 @@ HAL_StatusTypeDef cell_voltage_set_cells(size_t cellboard_id,
     voltage_t min,
     voltage_t max,
     float avg);
+/**
+ * @brief Set the voltage of a group of consecutive cells
+ * 
+ * @param cellboard_id The index of the cellboard where the values are read from
+ * @param start_index The index of the first cell inside the cellboard
+ * @param volts The voltage values
+ * @param count The number of values
+ * @return HAL_StatusTypeDef HAL_OK if all the values has been copied to the array
+ */
+HAL_StatusTypeDef cell_voltage_set_cell_values(size_t cellboard_id,
+    size_t start_index,
+    voltage_t * volts,
+    size_t count);
+/**
+ * @brief Get the voltage of a single cell of the pack
+ * 
+ * @param index The index of the cell inside the pack
+ * @return voltage_t The voltage of the cell
+ */
+voltage_t cell_voltage_get_cell(size_t index);
+/**
+ * @brief Get a pointer to the array of voltages of all the cells of the pack
+ * 
+ * @return voltage_t * The pointer to the array of voltages
+ */
+voltage_t * cell_voltage_get_cells();
+
+/**
+ * @brief Start a new voltage snapshot discarding the one not yet completed
+ * @details This function has to be called before the snapshot trigger is sent
+ * 
+ * @param seq The sequence number of the snapshot
+ * @param timestamp The time at which the snapshot is triggered (ms)
+ * @param current The current sampled when the snapshot is triggered
+ * @param bat The pack voltage read by the internal ADC when the snapshot is triggered
+ * @param tsp The TS+ voltage read by the internal ADC when the snapshot is triggered
+ */
+void cell_voltage_snapshot_start(uint8_t seq, uint32_t timestamp, current_t current, uint16_t bat, uint16_t tsp);
+/**
+ * @brief Add the voltages received from a cellboard to the current snapshot
+ * 
+ * @param cellboard_id The index of the cellboard where the values are read from
+ * @param start_index The index of the first cell inside the cellboard
+ * @param seq The sequence number of the snapshot the values belongs to
+ * @param volts The voltage values
+ * @param count The number of values
+ * @return HAL_StatusTypeDef HAL_OK if the values belongs to the current snapshot, HAL_ERROR otherwise
+ */
+HAL_StatusTypeDef cell_voltage_snapshot_set_cells(size_t cellboard_id,
+    size_t start_index,
+    uint8_t seq,
+    voltage_t * volts,
+    size_t count);
+/**
+ * @brief Copy the last snapshot received from all the cellboards
+ * @details The snapshot is completed by the CAN interrupt, so it is copied
+ * with the interrupts disabled
+ * 
+ * @param snapshot Where the snapshot is copied
+ * @return true If a snapshot has been completed
+ * @return false Otherwise, and nothing is copied
+ */
+bool cell_voltage_get_snapshot(cell_voltage_snapshot_t * snapshot);
+/**
+ * @brief Copy the last snapshot received from all the cellboards only once
+ * 
+ * @param snapshot Where the snapshot is copied
+ * @return true If a snapshot has been completed since the last call
+ * @return false Otherwise, and nothing is copied
+ */
+bool cell_voltage_get_new_snapshot(cell_voltage_snapshot_t * snapshot);
+/**
+ * @brief Get the sum of the voltages of a snapshot
+ * 
+ * @param snapshot The snapshot
+ * @return uint32_t The sum of all cells voltages (mV * 10)
+ */
+uint32_t cell_voltage_snapshot_get_sum(const cell_voltage_snapshot_t * snapshot);
+
 /**
  * @brief Get the maximum voltage value of the pack
  * 
@@ -57,6 +152,8 @@ voltage_t cell_voltage_get_max();
 voltage_t cell_voltage_get_min();
 /**
  * @brief Get the sum of all the voltage values of the pack
+ * @details The sum is exact once every cell has been received, before that
+ * it is estimated from the averages of the cellboards
  * 
  * @return float The sum of all cells voltages
  */
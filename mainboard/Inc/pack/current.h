@@ -15,6 +15,8 @@
 #include <stdint.h>
 #include <inttypes.h>
 
+#include "fixed_point.h"
+
 /** @brief Voltage values below this threshold are consider as the sensor is disconnected */
 #define CURRENT_SENSOR_DISCONNECTED_THRESHOLD 0.25 // V
 
@@ -22,6 +24,29 @@
 #define CURRENT_MIN_THRESHOLD -20.f
 #define CURRENT_MAX_THRESHOLD 180.f
 
+/** @brief Samples of each Hall effect sensor averaged at every measure */
+#define CURRENT_SAMPLE_COUNT 128U
+#define CURRENT_ADC_FULL_SCALE 4095U
+#define CURRENT_ADC_VREF 3.3 // V
+
+#define CURRENT_SENSITIVITY_LOW 40e-3 // V / A
+#define CURRENT_SENSITIVITY_HIGH 6.67e-3 // V / A
+#define CURRENT_DIVIDER_RATIO_INVERSE ((330. + 169.) / 330.)
+
+#define CURRENT_SHUNT_VREF_OFFSET 0.454 // V
+#define CURRENT_SHUNT_OP_GAIN 75.
+#define CURRENT_SHUNT_RESISTANCE 1e-4 // Ohm
+
+/** @brief Below this current both Hall effect sensors read the sensor of 50 A */
+#define CURRENT_LOW_RANGE 34 // A
+/** @brief Weight of the previous value in the filter of the current */
+#define CURRENT_FILTER_ALPHA 0.4
+
+/** @brief Current for each volt at the ADC of each sensor (A / V) */
+#define CURRENT_GAIN_LOW FIXED_GAIN_CONST(CURRENT_DIVIDER_RATIO_INVERSE / CURRENT_SENSITIVITY_LOW)
+#define CURRENT_GAIN_HIGH FIXED_GAIN_CONST(CURRENT_DIVIDER_RATIO_INVERSE / CURRENT_SENSITIVITY_HIGH)
+#define CURRENT_GAIN_SHUNT FIXED_GAIN_CONST(1. / (CURRENT_SHUNT_OP_GAIN * CURRENT_SHUNT_RESISTANCE))
+
 enum CURRENT_SENSORS {
     CURRENT_SENSOR_50 = 0,
     CURRENT_SENSOR_300,
@@ -37,10 +62,10 @@ void current_start_measure();
 /**
  * @brief Reads TS current from current sensors
  * 
- * @param shunt_adc_val The voltage value read from the shunt
+ * @param shunt_adc_val The value read from the ADC of the shunt
  * @return uint32_t The timestamp at which the measurement occurred
  */
-uint32_t current_read(float shunt_adc_val);
+uint32_t current_read(uint16_t shunt_adc_val);
 
 /** @brief Zeroes the Hall-effect sensor */
 void current_zero();
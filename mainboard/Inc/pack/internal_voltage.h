@@ -17,26 +17,71 @@
 #include "stm32f4xx_hal.h"
 #include "../../fenice_config.h"
 #include "peripherals/max22530.h"
+#include "pack/cell_voltage.h"
+#include "voltage_crosscheck.h"
 
 #define INTERNAL_VOLTAGE_DIVIDER_RATIO 0.0032 // 0.003
 #define CONVERT_VALUE_TO_INTERNAL_ADC_VOLTAGE(x) MAX22530_CONV_VALUE_TO_VOLTAGE(x)
 #define CONVERT_VALUE_TO_INTERNAL_VOLTAGE(x) (CONVERT_VALUE_TO_INTERNAL_ADC_VOLTAGE(x) / INTERNAL_VOLTAGE_DIVIDER_RATIO)
 
+#define INTERNAL_VOLTAGE_SAMPLE_INTERVAL_MS 1 // Interval between two burst reads of the ADC
+#define INTERNAL_VOLTAGE_TIMEOUT_MS 10       // Maximum age of the last sample
+#define INTERNAL_VOLTAGE_FILTERED true       // Read the filtered ADC registers instead of the raw ones
+
 #define INTERNAL_VOLTAGE_PRECHARGE_THRESHOLD 0.87f
 #define INTERNAL_VOLTAGE_PRECHARGE_HANDCART_THRESHOLD 0.88f // See rules
 
-#define INTERNAL_VOLTAGE_MAX_DELTA 25.f // Maximum delta between measured and calculated battery voltage
+/** @brief Instances of ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH */
+#define INTERNAL_VOLTAGE_MISMATCH_BAT 0U // Sum of the cells against the pack voltage
+#define INTERNAL_VOLTAGE_MISMATCH_TS 1U  // Pack voltage against the TS+ voltage
+
+/** @brief Internal voltages of the mainboard read in the same burst */
+typedef struct {
+    uint16_t tsp;       // TS+ voltage
+    uint16_t bat;       // Battery voltage
+    uint16_t shunt;     // Shunter voltage
+    uint16_t tsn;       // TS- voltage
+    uint32_t timestamp; // Time at which the burst was completed (ms)
+} internal_voltage_sample_t;
+
+/** @brief Counters of the acquisition */
+typedef struct {
+    uint32_t samples;  // Bursts completed
+    uint32_t errors;   // Bursts failed
+    uint32_t overruns; // Bursts skipped because the previous one was still running
+} internal_voltage_stats_t;
 
-/** @brief Initializes the adc and internal voltages */
+extern voltage_crosscheck_t internal_voltage_crosscheck;
+
+/**
+ * @brief Initializes the adc and internal voltages
+ * @details The voltages are then read via DMA every INTERNAL_VOLTAGE_SAMPLE_INTERVAL_MS
+ * by the measures timer, so the getters always return the last sample
+ */
 void internal_voltage_init();
 
 /**
- * @brief Polls for voltages
+ * @brief Check that the voltages are being read
  * 
- * @return HAL_StatusTypeDef The status of the spi communication
+ * @return HAL_StatusTypeDef HAL_OK if the last sample is recent, HAL_TIMEOUT if it is
+ * older than INTERNAL_VOLTAGE_TIMEOUT_MS, HAL_ERROR if no sample has been read yet
  */
 HAL_StatusTypeDef internal_voltage_measure();
+/**
+ * @brief Get the counters of the acquisition
+ * 
+ * @return internal_voltage_stats_t The counters
+ */
+internal_voltage_stats_t internal_voltage_get_stats();
 
+/**
+ * @brief Get the last sample, with all the voltages read in the same burst
+ * @details Use it instead of the single getters when two voltages are
+ * compared, a new sample can be stored between two calls of the getters
+ * 
+ * @return internal_voltage_sample_t The last sample
+ */
+internal_voltage_sample_t internal_voltage_get_sample();
 /**
  * @brief Get the TS+ voltage
  * 
@@ -70,4 +115,19 @@ uint16_t internal_voltage_get_bat();
  */
 bool internal_voltage_is_precharge_complete();
 
+/**
+ * @brief Compare the cell voltages with the internal voltages read in the same cycle
+ * @details The errors are neither set nor reset when the comparison is skipped
+ * 
+ * @param snapshot The snapshot of the cell voltages
+ */
+void internal_voltage_check_errors(const cell_voltage_snapshot_t * snapshot);
+
+/** @brief Timer callback function, start a burst read of the ADC */
+void _internal_voltage_handle_tim_oc_irq();
+/** @brief SPI transfer complete callback function, store the sample */
+void _internal_voltage_handle_spi_txrx_cplt();
+/** @brief SPI error callback function */
+void _internal_voltage_handle_spi_error();
+
 #endif // INTERNAL_VOLTAGE_H
@@ -12,10 +12,14 @@
 #define TEMPERATURE_H
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include "mainboard_config.h"
+#include "fixed_point.h"
 
-#define CONVERT_VALUE_TO_TEMPERATURE(x) ((float)(x) / 2.56 - 20)
+#define CONVERT_VALUE_TO_TEMPERATURE(x) ((float)(x) / 2.56f - 20.f)
 #define CONVERT_TEMPERATURE_TO_VALUE(x) (((x) + 20) * 2.56f)
+/** @brief Exact conversion to fixed-point, x / 2.56 is x * 100 / 256 */
+#define CONVERT_VALUE_TO_FIXED_TEMPERATURE(x) ((fixed_temperature_t){ (int32_t)(x) * 100 - FIXED_CONST(20, FIXED_TEMPERATURE_FRAC) })
 
 typedef uint8_t temperature_t;
 
@@ -24,6 +28,8 @@ typedef struct {
     temperature_t min[CELLBOARD_COUNT];
     temperature_t max[CELLBOARD_COUNT];
     float avg[CELLBOARD_COUNT];
+    uint64_t excluded[CELLBOARD_COUNT]; // Sensors replaced by the interpolation of their neighbors
+    uint8_t unhealthy[CELLBOARD_COUNT]; // Sensors found unhealthy at runtime
 } cell_temperature;
 
 extern cell_temperature cell_temps;
@@ -69,5 +75,35 @@ HAL_StatusTypeDef temperature_set_cells(size_t cellboard_id,
     temperature_t min,
     temperature_t max,
     float avg);
+/**
+ * @brief Set the temperature sensors excluded by a cellboard
+ * 
+ * @param cellboard_id The cellboard index where the sensors are
+ * @param start_index The index of the first sensor of the mask
+ * @param excluded A bit for each excluded sensor, from start_index
+ * @param count The number of sensors in the mask
+ * @param unhealthy The number of sensors of the cellboard found unhealthy at runtime
+ */
+HAL_StatusTypeDef temperature_set_excluded(size_t cellboard_id,
+    size_t start_index,
+    uint64_t excluded,
+    size_t count,
+    uint8_t unhealthy);
+/**
+ * @brief Get the number of temperature sensors found unhealthy by a cellboard
+ * 
+ * @param cellboard_id The cellboard index
+ * @return uint8_t The number of unhealthy sensors, they are excluded and interpolated
+ */
+uint8_t temperature_get_unhealthy(size_t cellboard_id);
+/**
+ * @brief Check if every strip of a cellboard has enough included sensors to
+ * interpolate the excluded ones
+ * 
+ * @param cellboard_id The cellboard index
+ * @return true If every strip has at least CELLBOARD_TEMP_STRIP_MIN_INCLUDED sensors included
+ * @return false Otherwise
+ */
+bool temperature_is_interpolable(size_t cellboard_id);
 
 #endif // TEMPERATURE_H
\ No newline at end of file
@@ -66,6 +66,12 @@ HAL_StatusTypeDef can_car_send(uint16_t id);
  */
 HAL_StatusTypeDef can_bms_send(uint16_t id);
 
+/**
+ * @brief Copy the commands of a parallel flashing to the cellboards and answer the host
+ * @details It has to be called as often as possible since each command waits for it
+ */
+void can_flash_routine();
+
 /** @brief Check if the internal CAN peripheral is working */
 void can_cellboards_check();
 
@@ -11,8 +11,9 @@
 #include <inttypes.h>
 
 #define MAX22530_VREF 1.8f  // Reference voltage
+#define MAX22530_FULL_SCALE 4095U // Value at the reference voltage
 /** @brief Convert 12 bit value to a voltage */
-#define MAX22530_CONV_VALUE_TO_VOLTAGE(x) ((x) * (MAX22530_VREF / 4095))
+#define MAX22530_CONV_VALUE_TO_VOLTAGE(x) ((x) * (MAX22530_VREF / MAX22530_FULL_SCALE))
 
 #define MAX22530_ID_REG      0X00 // Address of the product id
 #define MAX22530_CONTROL_REG 0x14 // Address of the control register
@@ -27,6 +28,7 @@
 #define MAX22530_BURST 1 // Burst mode
 
 #define MAX22530_CHANNEL_COUNT 4 // Number of ADC channels
+#define MAX22530_BURST_SIZE (1 + MAX22530_CHANNEL_COUNT * 2 + 2) // Bytes of a burst read without CRC
 
 
 /** @brief Address of the ADC registers */
@@ -46,6 +48,10 @@ typedef struct {
     SPI_HandleTypeDef * spi;
     GPIO_TypeDef * gpio;
     uint16_t pin;
+
+    // Buffers of the burst read via DMA, they must live until the transfer is complete
+    uint8_t burst_tx[MAX22530_BURST_SIZE];
+    uint8_t burst_rx[MAX22530_BURST_SIZE];
 } MAX22530_HandleTypeDef;
 
 
@@ -101,3 +107,29 @@ uint16_t max22530_read_channel(MAX22530_HandleTypeDef * handler, MAX22530_CH cha
  * @return HAL_StatusTypeDef The status of the SPI communication
  */
 HAL_StatusTypeDef max22530_read_all_channels(MAX22530_HandleTypeDef * handler, uint16_t volts[MAX22530_CHANNEL_COUNT]);
+/**
+ * @brief Start a burst read of all the channels via DMA
+ * @details The chip select stays enabled until max22530_burst_complete
+ * or max22530_burst_abort is called from the SPI callbacks
+ *
+ * @param handler The MAX22530 handler structure
+ * @param filtered If true the data are read from the filtered ADC registers
+ * @return HAL_StatusTypeDef The status of the SPI communication
+ */
+HAL_StatusTypeDef max22530_burst_start(MAX22530_HandleTypeDef * handler, bool filtered);
+/**
+ * @brief End a burst read via DMA and get the data of all the channels
+ * @details This function has to be called when the SPI transfer is complete
+ *
+ * @param handler The MAX22530 handler structure
+ * @param volts Array where the data is stored
+ * @return HAL_StatusTypeDef HAL_ERROR if the parameters are not valid, HAL_OK otherwise
+ */
+HAL_StatusTypeDef max22530_burst_complete(MAX22530_HandleTypeDef * handler, uint16_t volts[MAX22530_CHANNEL_COUNT]);
+/**
+ * @brief End a burst read via DMA discarding its data
+ * @details This function has to be called when the SPI transfer fails
+ *
+ * @param handler The MAX22530 handler structure
+ */
+void max22530_burst_abort(MAX22530_HandleTypeDef * handler);
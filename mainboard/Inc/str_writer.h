@@ -0,0 +1,127 @@
+/**
+ * @file str_writer.h
+ * @brief Bounded text writer used to build the output of the CLI
+ *
+ * @details The writer appends text and numbers to a fixed size buffer keeping
+ * track of the current length, so that each append costs only the length of
+ * the appended text and the buffer can never overflow: once it is full the
+ * output is truncated and the writer is marked as such.
+ * The buffer is always null terminated.
+ * Numbers are formatted with integer arithmetic only, decimal values are
+ * given as fixed-point integers (e.g. a voltage in mV * 10 is printed in
+ * volts with a scale of 4 digits), so no floating point formatting is needed.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef STR_WRITER_H
+#define STR_WRITER_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Maximum number of decimal digits of the fixed-point numbers */
+#define STR_WRITER_MAX_DECIMALS 6U
+
+/** @brief Appending writer on a bounded buffer */
+typedef struct {
+    char * buf;
+    size_t size;     // Size of the buffer, terminator included
+    size_t length;   // Number of characters written
+    bool truncated;  // The output did not fit in the buffer
+} str_writer_t;
+
+/**
+ * @brief Initialize the writer with an empty string
+ *
+ * @param writer The writer
+ * @param buf The output buffer
+ * @param size The size of the buffer
+ */
+void str_writer_init(str_writer_t * writer, char * buf, size_t size);
+
+/**
+ * @brief Append a string
+ *
+ * @param writer The writer
+ * @param str The null terminated string
+ */
+void str_writer_append(str_writer_t * writer, const char * str);
+/**
+ * @brief Append a given number of characters
+ *
+ * @param writer The writer
+ * @param str The characters
+ * @param length The number of characters
+ */
+void str_writer_append_n(str_writer_t * writer, const char * str, size_t length);
+/**
+ * @brief Append a character repeated a given number of times
+ *
+ * @param writer The writer
+ * @param c The character
+ * @param count The number of repetitions
+ */
+void str_writer_append_repeat(str_writer_t * writer, char c, size_t count);
+/**
+ * @brief Append a string left aligned and padded with spaces to the given width
+ *
+ * @param writer The writer
+ * @param str The null terminated string
+ * @param width The minimum number of characters
+ */
+void str_writer_append_padded(str_writer_t * writer, const char * str, size_t width);
+
+/**
+ * @brief Append an unsigned integer right aligned to the given width
+ *
+ * @param writer The writer
+ * @param value The value
+ * @param width The minimum number of characters, 0 for no padding
+ */
+void str_writer_append_uint(str_writer_t * writer, uint32_t value, uint8_t width);
+/**
+ * @brief Append a signed integer right aligned to the given width
+ *
+ * @param writer The writer
+ * @param value The value
+ * @param width The minimum number of characters, 0 for no padding
+ */
+void str_writer_append_int(str_writer_t * writer, int32_t value, uint8_t width);
+/**
+ * @brief Append an unsigned integer in hexadecimal, uppercase and padded with zeros
+ *
+ * @param writer The writer
+ * @param value The value
+ * @param digits The minimum number of digits
+ */
+void str_writer_append_hex(str_writer_t * writer, uint32_t value, uint8_t digits);
+/**
+ * @brief Append a fixed-point number
+ * @details The printed number is value / 10^scale rounded to the given
+ * number of decimal digits, e.g. value 36123 with scale 4 and 2 decimals
+ * is printed as 3.61. The ties are rounded away from zero, unlike printf
+ *
+ * @param writer The writer
+ * @param value The fixed-point value
+ * @param scale The number of decimal digits of the value
+ * @param decimals The number of decimal digits to print, at most STR_WRITER_MAX_DECIMALS
+ * @param width The minimum number of characters, 0 for no padding
+ */
+void str_writer_append_fixed(str_writer_t * writer, int32_t value, uint8_t scale, uint8_t decimals, uint8_t width);
+/**
+ * @brief Append a floating point number with the given number of decimal digits
+ * @details The value is converted to fixed-point, rounding the ties away
+ * from zero, the magnitude is limited to the range of a 32 bit integer once
+ * scaled
+ *
+ * @param writer The writer
+ * @param value The value
+ * @param decimals The number of decimal digits to print, at most STR_WRITER_MAX_DECIMALS
+ * @param width The minimum number of characters, 0 for no padding
+ */
+void str_writer_append_float(str_writer_t * writer, float value, uint8_t decimals, uint8_t width);
+
+#endif // STR_WRITER_H
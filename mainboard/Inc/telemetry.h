@@ -0,0 +1,147 @@
+/**
+ * @file telemetry.h
+ * @brief Binary telemetry frames sent over the CLI UART
+ *
+ * @details Each frame is made of a type, a sequence number, the payload and
+ * a CRC16 (CCITT, little endian) of the previous fields; the whole frame is
+ * then encoded with COBS and enclosed between two zero bytes, so that a
+ * receiver can always find the start of the next frame even if it missed
+ * some bytes or the stream is mixed with text.
+ * All the multi-byte fields are little endian.
+ * The decoder for the host is scripts/telemetry_decode.py
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "../../fenice_config.h"
+
+/** @brief Maximum length of the payload of a frame */
+#define TELEMETRY_MAX_PAYLOAD 256U
+/** @brief Length of a frame before the encoding (type, sequence number, payload and CRC) */
+#define TELEMETRY_RAW_SIZE(LENGTH) ((LENGTH) + 4U)
+/** @brief Maximum length of an encoded frame, delimiters included */
+#define TELEMETRY_ENCODED_SIZE(LENGTH) (TELEMETRY_RAW_SIZE(LENGTH) + TELEMETRY_RAW_SIZE(LENGTH) / 254U + 3U)
+/** @brief Bytes per second sent by the CLI UART, 115200 baud with 10 bits per byte */
+#define TELEMETRY_BYTES_PER_SECOND 11520U
+
+/** @brief Type of the frames */
+typedef enum {
+    TELEMETRY_FRAME_SNAPSHOT = 0x01, // State of the pack, followed by one TELEMETRY_FRAME_CELLBOARD for each cellboard
+    TELEMETRY_FRAME_CELLBOARD = 0x02 // Voltages and temperatures of a cellboard
+} TELEMETRY_FRAME;
+
+/** @brief Snapshot of the state of the pack */
+typedef struct {
+    uint32_t timestamp;                   // ms
+    uint8_t state;                        // State of the BMS FSM
+    int32_t current;                      // mA
+    voltage_t voltages[PACK_CELL_COUNT];  // Cell voltages (mV * 10)
+    uint8_t temp_min[CELLBOARD_COUNT];    // Raw temperature values of each cellboard
+    uint8_t temp_max[CELLBOARD_COUNT];
+    uint8_t temp_avg[CELLBOARD_COUNT];
+    uint32_t feedback_high;               // Bitmask of the feedbacks in the high state
+    uint32_t feedback_error;              // Bitmask of the feedbacks in the error state
+} telemetry_snapshot_t;
+
+/**
+ * @brief Length of the serialized state of the pack: timestamp, state,
+ * current, feedbacks, number of cellboards and of cells of each cellboard
+ */
+#define TELEMETRY_SNAPSHOT_SIZE 19U
+/**
+ * @brief Length of the serialized part of a cellboard: timestamp of the
+ * snapshot, index, temperatures and voltages
+ * @details The snapshot is split by cellboard so that the size of a frame does
+ * not depend on CELLBOARD_COUNT
+ */
+#define TELEMETRY_CELLBOARD_SIZE (8U + CELLBOARD_CELL_COUNT * 2U)
+/** @brief Length of the encoded frames of a whole snapshot */
+#define TELEMETRY_STREAM_SIZE (TELEMETRY_ENCODED_SIZE(TELEMETRY_SNAPSHOT_SIZE) + CELLBOARD_COUNT * TELEMETRY_ENCODED_SIZE(TELEMETRY_CELLBOARD_SIZE))
+/** @brief Maximum number of snapshots per second, limited by the UART baudrate */
+#define TELEMETRY_MAX_RATE (TELEMETRY_BYTES_PER_SECOND / TELEMETRY_STREAM_SIZE)
+
+#if TELEMETRY_CELLBOARD_SIZE > TELEMETRY_MAX_PAYLOAD
+#error "The telemetry frame cannot hold the voltages of a cellboard"
+#endif
+
+/**
+ * @brief Calculate the CRC16 (CCITT-FALSE) of a buffer
+ *
+ * @param data The buffer
+ * @param length The length of the buffer
+ * @return uint16_t The CRC
+ */
+uint16_t telemetry_crc16(const uint8_t * data, size_t length);
+
+/**
+ * @brief Encode a buffer with COBS, the delimiter is not added
+ *
+ * @param data The buffer to encode
+ * @param length The length of the buffer
+ * @param out The encoded buffer, at least length + length / 254 + 1 bytes long
+ * @return size_t The length of the encoded buffer
+ */
+size_t telemetry_cobs_encode(const uint8_t * data, size_t length, uint8_t * out);
+
+/**
+ * @brief Decode a COBS encoded buffer, without the delimiter
+ *
+ * @param data The encoded buffer
+ * @param length The length of the encoded buffer
+ * @param out The decoded buffer, at least length bytes long
+ * @return size_t The length of the decoded buffer, 0 if the buffer is not valid
+ */
+size_t telemetry_cobs_decode(const uint8_t * data, size_t length, uint8_t * out);
+
+/**
+ * @brief Build an encoded frame
+ *
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ * @param payload The payload
+ * @param length The length of the payload, at most TELEMETRY_MAX_PAYLOAD
+ * @param out The encoded frame, at least TELEMETRY_ENCODED_SIZE(length) bytes long
+ * @return size_t The length of the frame including the delimiters, 0 if the payload is too long
+ */
+size_t telemetry_frame_encode(TELEMETRY_FRAME type, uint8_t seq, const uint8_t * payload, size_t length, uint8_t * out);
+
+/**
+ * @brief Decode and check a frame
+ *
+ * @param data The encoded frame, without the delimiters
+ * @param length The length of the encoded frame
+ * @param type The type of the frame
+ * @param seq The sequence number of the frame
+ * @param payload The payload, at least length bytes long
+ * @return int32_t The length of the payload, -1 if the frame is not valid
+ */
+int32_t telemetry_frame_decode(const uint8_t * data, size_t length, uint8_t * type, uint8_t * seq, uint8_t * payload);
+
+/**
+ * @brief Serialize the state of the pack of a snapshot
+ *
+ * @param snapshot The snapshot
+ * @param out The buffer, at least TELEMETRY_SNAPSHOT_SIZE bytes long
+ * @return size_t The length of the serialized state
+ */
+size_t telemetry_snapshot_serialize(const telemetry_snapshot_t * snapshot, uint8_t * out);
+
+/**
+ * @brief Serialize the voltages and temperatures of a cellboard of a snapshot
+ *
+ * @param snapshot The snapshot
+ * @param cellboard The index of the cellboard
+ * @param out The buffer, at least TELEMETRY_CELLBOARD_SIZE bytes long
+ * @return size_t The length of the serialized cellboard, 0 if the index is not valid
+ */
+size_t telemetry_cellboard_serialize(const telemetry_snapshot_t * snapshot, size_t cellboard, uint8_t * out);
+
+#endif // TELEMETRY_H
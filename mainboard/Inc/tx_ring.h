@@ -0,0 +1,86 @@
+/**
+ * @file tx_ring.h
+ * @brief Lock-free ring buffer for the outgoing serial data
+ *
+ * @details Any context (main loop or interrupt) can write a message into the
+ * ring while a single consumer (the UART DMA) reads it. Every message is
+ * either written entirely or dropped when there is not enough space, in
+ * which case the drop counters are incremented.
+ * Writers reserve their space and publish it with atomic operations on a
+ * single word that holds the reserve index, the commit index and the number
+ * of writers still copying their data: the commit index is moved forward
+ * only by the last writer that finishes, so the consumer never reads a
+ * partially copied message and a writer is never blocked by another one.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef TX_RING_H
+#define TX_RING_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** @brief Size of the ring buffer, it has to be a power of two */
+#define TX_RING_SIZE 4096U
+/** @brief Number of bits of the indices, one more than needed to tell a full ring from an empty one */
+#define TX_RING_INDEX_BITS 13U
+/** @brief Maximum number of writers at the same time (interrupt nesting depth) */
+#define TX_RING_MAX_WRITERS ((1U << (32U - 2U * TX_RING_INDEX_BITS)) - 1U)
+
+/** @brief Ring buffer with its drop statistics */
+typedef struct {
+    char data[TX_RING_SIZE];
+    volatile uint32_t state;   // Reserve index, commit index and writers count
+    volatile uint16_t tail;    // Index of the next byte to read, only written by the consumer
+    volatile uint32_t dropped; // Number of messages dropped because the ring was full
+    volatile uint32_t dropped_bytes;
+} tx_ring_t;
+
+/**
+ * @brief Empty the ring and reset its statistics
+ *
+ * @param ring The ring buffer
+ */
+void tx_ring_init(tx_ring_t * ring);
+
+/**
+ * @brief Copy a message into the ring
+ * @details It can be called from any context, even while another write is in progress
+ *
+ * @param ring The ring buffer
+ * @param data The message
+ * @param length The length of the message
+ * @return true If the message has been written
+ * @return false If the message has been dropped
+ */
+bool tx_ring_write(tx_ring_t * ring, const char * data, size_t length);
+
+/**
+ * @brief Get the contiguous block of committed data at the start of the ring
+ *
+ * @param ring The ring buffer
+ * @param data The pointer to the first byte of the block
+ * @return size_t The length of the block, 0 if the ring is empty
+ */
+size_t tx_ring_peek(tx_ring_t * ring, char ** data);
+
+/**
+ * @brief Free the data read by the consumer
+ *
+ * @param ring The ring buffer
+ * @param length The number of bytes to remove, at most the length returned by tx_ring_peek
+ */
+void tx_ring_consume(tx_ring_t * ring, size_t length);
+
+/**
+ * @brief Get the number of bytes waiting to be read
+ *
+ * @param ring The ring buffer
+ * @return size_t The number of committed bytes
+ */
+size_t tx_ring_get_pending(tx_ring_t * ring);
+
+#endif // TX_RING_H
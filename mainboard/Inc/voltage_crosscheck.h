@@ -0,0 +1,101 @@
+/**
+ * @file voltage_crosscheck.h
+ * @brief Plausibility check between the cell voltages and the internal ADC
+ *
+ * @details Every complete voltage snapshot is compared with the pack voltage
+ * (VBATT) and the TS+ voltage read by the internal ADC in the same cycle:
+ * - the pack voltage is expected to be the exact sum of the cells minus the
+ *   drop on the resistance between the cells and the ADC, plus an offset
+ *   learned while the current is low to absorb the gain and offset errors
+ *   of the divider
+ * - once the TS is connected the TS+ voltage is expected to be the pack
+ *   voltage minus the drop on the AIRs and the fuse
+ * The tolerance adapts to the measure: a fixed part, a part proportional to
+ * the pack voltage, one to the current for the uncertainty of the resistance
+ * and one to the filtered noise of the residual. The samples taken during a
+ * fast current variation are skipped since the two measures are not taken
+ * at the same exact instant.
+ * The module does not depend on the HAL so it can be tested on the host
+ *
+ * @date Oct 19, 2026
+ */
+
+#ifndef VOLTAGE_CROSSCHECK_H
+#define VOLTAGE_CROSSCHECK_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+
+/** @brief Resistance between the cells and the VBATT divider (Ohm) */
+#define VOLTAGE_CROSSCHECK_PACK_RESISTANCE 0.02f
+/** @brief Resistance of the AIRs and of the fuse between VBATT and TS+ (Ohm) */
+#define VOLTAGE_CROSSCHECK_TS_RESISTANCE 0.005f
+
+/** @brief Fixed part of the tolerance (V) */
+#define VOLTAGE_CROSSCHECK_TOLERANCE 3.f
+/** @brief Part of the tolerance proportional to the pack voltage, error of the dividers */
+#define VOLTAGE_CROSSCHECK_TOLERANCE_GAIN 0.01f
+/** @brief Part of the tolerance proportional to the current, error of the resistances (Ohm) */
+#define VOLTAGE_CROSSCHECK_TOLERANCE_RESISTANCE 0.02f
+/** @brief Number of standard deviations of the residual noise added to the tolerance */
+#define VOLTAGE_CROSSCHECK_TOLERANCE_SIGMA 4.f
+/** @brief Maximum tolerance (V) */
+#define VOLTAGE_CROSSCHECK_TOLERANCE_MAX 25.f
+
+/** @brief Maximum current variation between two samples to compare them (A) */
+#define VOLTAGE_CROSSCHECK_MAX_STEP 20.f
+/** @brief Absolute current under which the offset and the noise are learned (A) */
+#define VOLTAGE_CROSSCHECK_LEARN_CURRENT 5.f
+/** @brief Weight of a new sample in the learned offset, ~50 s with a sample every 50 ms */
+#define VOLTAGE_CROSSCHECK_OFFSET_ALPHA 0.001f
+/** @brief Weight of a new sample in the residual noise */
+#define VOLTAGE_CROSSCHECK_NOISE_ALPHA 0.01f
+/** @brief Maximum learned offset, a larger difference is a fault (V) */
+#define VOLTAGE_CROSSCHECK_MAX_OFFSET 5.f
+
+/** @brief Result of a comparison */
+typedef enum {
+    VOLTAGE_CROSSCHECK_OK           = 0U,
+    VOLTAGE_CROSSCHECK_BAT_MISMATCH = 1U << 0, // Cell sum and VBATT do not match
+    VOLTAGE_CROSSCHECK_TS_MISMATCH  = 1U << 1, // VBATT and TS+ do not match
+    VOLTAGE_CROSSCHECK_SKIPPED      = 1U << 2  // The sample was not compared
+} voltage_crosscheck_result_t;
+
+/** @brief Measures taken in the same cycle */
+typedef struct {
+    float cell_sum;    // V, exact sum of the cell voltages
+    float bat;         // V, pack voltage read by the internal ADC
+    float tsp;         // V, TS+ voltage read by the internal ADC
+    float current;     // A, positive in discharge
+    bool ts_connected; // The AIRs are closed and the precharge is complete
+} voltage_crosscheck_sample_t;
+
+/** @brief State of the check */
+typedef struct {
+    float offset;        // V, learned difference between VBATT and the expected value
+    float noise;         // V^2, filtered variance of the VBATT residual
+    float bat_residual;  // V, last difference between VBATT and the expected value
+    float ts_residual;   // V, last difference between TS+ and the expected value
+    float bat_tolerance; // V, last tolerance of the VBATT check
+    float ts_tolerance;  // V, last tolerance of the TS+ check
+    float previous_current;
+    bool has_previous;
+} voltage_crosscheck_t;
+
+/**
+ * @brief Forget the learned offset and noise
+ *
+ * @param check The check
+ */
+void voltage_crosscheck_init(voltage_crosscheck_t * check);
+
+/**
+ * @brief Compare the measures of a cycle
+ *
+ * @param check The check
+ * @param sample The measures
+ * @return uint8_t A mask of voltage_crosscheck_result_t
+ */
+uint8_t voltage_crosscheck_update(voltage_crosscheck_t * check, const voltage_crosscheck_sample_t * sample);
+
+#endif // VOLTAGE_CROSSCHECK_H
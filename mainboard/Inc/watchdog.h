@@ -4,6 +4,14 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
+/** @brief Time added to the interval of a message before it is considered lost (ms) */
+#define WATCHDOG_TIMEOUT_MARGIN_MS 100U
+/** @brief Timeout of the messages without an interval in the network definition (ms) */
+#define WATCHDOG_DEFAULT_TIMEOUT_MS 500U
+/** @brief Timeout of a message from its interval in the network definition (ms) */
+#define WATCHDOG_TIMEOUT_MS(interval) \
+    ((interval) > 0 ? (uint32_t)(interval) + WATCHDOG_TIMEOUT_MARGIN_MS : WATCHDOG_DEFAULT_TIMEOUT_MS)
+
 /** @brief Initialize watchdogs */
 void watchdog_init();
 
@@ -17,6 +25,7 @@ bool is_watchdog_timed_out();
 
 /**
  * @brief Reset the watchdog timer
+ * @details Safe to be called from the CAN interrupts
  * 
  * @param id The id
  */
@@ -24,7 +33,8 @@ void watchdog_reset(uint16_t id);
 
 /**
  * @brief Watchdog routine used to check for timeout
- * @details This function should be called periodically
+ * @details This function should be called at every tick of the measures,
+ * it only checks the earliest deadline unless a message is lost
  * */
 void watchdog_routine();
 
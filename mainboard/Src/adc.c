@@ -468,5 +468,10 @@ void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef * hadc) {
         _feedback_handle_adc_cnv_cmpl_irq();
     }
 }
+void HAL_ADCEx_InjectedConvCpltCallback(ADC_HandleTypeDef * hadc) {
+    if (hadc->Instance == ADC_MUX.Instance) {
+        _feedback_handle_adc_inj_cnv_cmpl_irq();
+    }
+}
 
 /* USER CODE END 1 */
@@ -15,20 +15,70 @@
 #include "cli_bms.h"
 #include "fans_buzzer.h"
 #include "temperature.h"
+#include "cell_voltage.h"
 #include "measures.h"
+#include "../../fenice_network.h"
 
 /** @brief Current balancing status */
 struct {
     uint8_t status: CELLBOARD_COUNT; // Each bit represent a celloboard status
     voltage_t threshold;
+    uint32_t plan_tick;              // Time at which the last plan was sent
+    uint32_t convergence_tick;       // Time at which the last spread sample was taken
 } bal_status;
 
 BalRequest bal_request;
 
+bal_plan_t bal_plan;
+uint8_t bal_plan_seq;
+bool bal_plan_start; // The last plan has started the balancing
+
+float bal_charge[PACK_CELL_COUNT]; // mAh
+bal_convergence_t bal_convergence;
+
+/**
+ * @brief Compute a new discharge plan and send it to the cellboards
+ *
+ * @param start True if the plan starts the balancing, the cellboards reset the removed charge
+ */
+void _bal_send_plan(bool start) {
+    float temps[CELLBOARD_COUNT];
+    for (size_t i = 0; i < CELLBOARD_COUNT; ++i)
+        temps[i] = CONVERT_VALUE_TO_TEMPERATURE(cell_temps.max[i]);
+
+    bal_planner_compute(
+        cell_voltage_get_cells(),
+        temps,
+        MAX(CELL_MIN_VOLTAGE, cell_voltage_get_min()),
+        bal_status.threshold,
+        &bal_plan);
+    ++bal_plan_seq;
+    bal_plan_start = start;
+    bal_status.plan_tick = HAL_GetTick();
+
+    can_bms_send(BMS_BALANCING_PLAN_FRAME_ID);
+}
+/** @brief Reset the removed charge and the convergence history */
+void _bal_reset_stats(void) {
+    memset(bal_charge, 0, sizeof(bal_charge));
+    bal_convergence_init(&bal_convergence);
+    bal_status.convergence_tick = HAL_GetTick();
+    bal_convergence_add(&bal_convergence, bal_status.convergence_tick, cell_voltage_get_max() - cell_voltage_get_min());
+}
+
 
 void bal_init(void) {
     bal_status.status = 0;
     bal_status.threshold = BAL_THRESHOLD_DEFAULT;
+    bal_status.plan_tick = 0;
+    bal_status.convergence_tick = 0;
+
+    memset(&bal_plan, 0, sizeof(bal_plan));
+    bal_plan_seq = 0;
+    bal_plan_start = false;
+
+    memset(bal_charge, 0, sizeof(bal_charge));
+    bal_convergence_init(&bal_convergence);
 
     bal_request.status = false;
     bal_request.threshold = BAL_THRESHOLD_DEFAULT;
@@ -55,6 +105,41 @@ void bal_update_status(uint8_t cellboard, bool status) {
     bal_status.status &= ~(1U << cellboard);
     bal_status.status |= (1U << cellboard) * status;
 }
+const bal_plan_t * bal_get_plan(void) {
+    return &bal_plan;
+}
+uint8_t bal_get_plan_seq(void) {
+    return bal_plan_seq;
+}
+bool bal_is_plan_start(void) {
+    return bal_plan_start;
+}
+void bal_set_cells_charge(uint8_t cellboard, size_t start_index, const uint16_t charges[], size_t count) {
+    if (cellboard >= CELLBOARD_COUNT || charges == NULL || start_index + count > CELLBOARD_CELL_COUNT)
+        return;
+    for (size_t i = 0; i < count; ++i)
+        bal_charge[cellboard * CELLBOARD_CELL_COUNT + start_index + i] = charges[i] / 10.f;
+}
+float bal_get_cell_charge(size_t index) {
+    if (index >= PACK_CELL_COUNT)
+        return 0.f;
+    return bal_charge[index];
+}
+float bal_get_total_charge(void) {
+    float total = 0.f;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+        total += bal_charge[i];
+    return total;
+}
+voltage_t bal_get_spread(void) {
+    return bal_convergence_get_spread(&bal_convergence);
+}
+float bal_get_convergence_rate(void) {
+    return bal_convergence_get_rate(&bal_convergence);
+}
+int32_t bal_get_eta(void) {
+    return bal_convergence_get_eta(&bal_convergence, bal_status.threshold);
+}
 void bal_stop(void) {
     bal_change_status_request(false, BAL_THRESHOLD_DEFAULT);
     bal_routine();
@@ -64,9 +149,27 @@ void bal_routine(void) {
         // Update the balancing status if needed
         if (bal_is_balancing() != bal_request.status) {
             bal_status.threshold = bal_request.threshold;
+
+            // The plan has to be received before the balancing starts
+            if (bal_request.status) {
+                _bal_reset_stats();
+                _bal_send_plan(true);
+            }
             can_bms_send(BMS_SET_BALANCING_STATUS_FRAME_ID);
         }
         // Reset request
         bal_request.is_new = false;
     }
+    else if (bal_request.status && HAL_GetTick() - bal_status.plan_tick >= BAL_PLANNER_INTERVAL) {
+        _bal_send_plan(false);
+
+        // Restart the cellboards that have already completed the previous plan
+        can_bms_send(BMS_SET_BALANCING_STATUS_FRAME_ID);
+    }
+
+    // Track how fast the cells are converging
+    if (bal_request.status && HAL_GetTick() - bal_status.convergence_tick >= BAL_CONVERGENCE_INTERVAL) {
+        bal_status.convergence_tick = HAL_GetTick();
+        bal_convergence_add(&bal_convergence, bal_status.convergence_tick, cell_voltage_get_max() - cell_voltage_get_min());
+    }
 }
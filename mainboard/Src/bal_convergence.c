@@ -0,0 +1,72 @@
+/**
+ * @file bal_convergence.c
+ * @brief Estimation of the balancing convergence speed
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "bal_convergence.h"
+
+#include <string.h>
+
+void bal_convergence_init(bal_convergence_t * conv) {
+    if (conv == NULL)
+        return;
+    memset(conv, 0, sizeof(bal_convergence_t));
+}
+
+void bal_convergence_add(bal_convergence_t * conv, uint32_t time, voltage_t spread) {
+    if (conv == NULL)
+        return;
+
+    conv->times[conv->head] = time;
+    conv->spreads[conv->head] = spread;
+    conv->head = (conv->head + 1) % BAL_CONVERGENCE_SAMPLES;
+    if (conv->count < BAL_CONVERGENCE_SAMPLES)
+        ++conv->count;
+}
+
+voltage_t bal_convergence_get_spread(const bal_convergence_t * conv) {
+    if (conv == NULL || conv->count == 0)
+        return 0;
+    return conv->spreads[(conv->head + BAL_CONVERGENCE_SAMPLES - 1) % BAL_CONVERGENCE_SAMPLES];
+}
+
+float bal_convergence_get_rate(const bal_convergence_t * conv) {
+    if (conv == NULL || conv->count < 2)
+        return 0.f;
+
+    // Times are relative to the oldest sample to keep the sums small
+    size_t first = (conv->head + BAL_CONVERGENCE_SAMPLES - conv->count) % BAL_CONVERGENCE_SAMPLES;
+    float t_sum = 0.f, s_sum = 0.f;
+    for (size_t i = 0; i < conv->count; ++i) {
+        size_t index = (first + i) % BAL_CONVERGENCE_SAMPLES;
+        t_sum += (conv->times[index] - conv->times[first]) / 1000.f;
+        s_sum += conv->spreads[index];
+    }
+    float t_avg = t_sum / conv->count;
+    float s_avg = s_sum / conv->count;
+
+    float num = 0.f, den = 0.f;
+    for (size_t i = 0; i < conv->count; ++i) {
+        size_t index = (first + i) % BAL_CONVERGENCE_SAMPLES;
+        float dt = (conv->times[index] - conv->times[first]) / 1000.f - t_avg;
+        num += dt * (conv->spreads[index] - s_avg);
+        den += dt * dt;
+    }
+    return den > 0.f ? num / den : 0.f;
+}
+
+int32_t bal_convergence_get_eta(const bal_convergence_t * conv, voltage_t threshold) {
+    if (conv == NULL || conv->count == 0)
+        return BAL_CONVERGENCE_ETA_UNKNOWN;
+
+    voltage_t spread = bal_convergence_get_spread(conv);
+    if (spread <= threshold)
+        return 0;
+
+    float rate = bal_convergence_get_rate(conv);
+    if (rate >= 0.f)
+        return BAL_CONVERGENCE_ETA_UNKNOWN;
+    return (int32_t)((spread - threshold) / -rate);
+}
@@ -0,0 +1,127 @@
+/**
+ * @file bal_planner.c
+ * @brief Pack level balancing planner
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "bal_planner.h"
+
+#include <string.h>
+
+/**
+ * @brief Count the number of cells set in a bitmap
+ *
+ * @param cells The bitmap of the cells
+ * @return size_t The number of cells
+ */
+size_t _bal_planner_count_cells(uint32_t cells) {
+    size_t count = 0;
+    for (; cells != 0; cells &= cells - 1)
+        ++count;
+    return count;
+}
+
+uint32_t bal_planner_exclude_neighbors(const uint32_t weights[], size_t count) {
+    uint32_t DP[CELLBOARD_CELL_COUNT + 1];
+    uint32_t cells = 0;
+
+    if (count == 0 || count > CELLBOARD_CELL_COUNT)
+        return 0;
+
+    DP[0] = 0;
+    DP[1] = weights[0];
+    for (size_t i = 2; i <= count; ++i)
+        DP[i] = MAX(DP[i - 1], DP[i - 2] + weights[i - 1]);
+
+    size_t i = count;
+    while (i > 0) {
+        if (i == 1) {
+            if (DP[1] > 0)
+                cells |= 1U;
+            break;
+        }
+        if (DP[i] == DP[i - 1]) {
+            --i;
+        } else {
+            cells |= 1U << (i - 1);
+            i -= 2;
+        }
+    }
+    return cells;
+}
+
+size_t bal_planner_thermal_budget(float temp) {
+    if (temp >= BAL_PLANNER_TEMP_LIMIT)
+        return 0;
+    if (temp <= BAL_PLANNER_TEMP_DERATE)
+        return BAL_PLANNER_MAX_ACTIVE_CELLS;
+    return (size_t)(BAL_PLANNER_MAX_ACTIVE_CELLS * (BAL_PLANNER_TEMP_LIMIT - temp) /
+        (BAL_PLANNER_TEMP_LIMIT - BAL_PLANNER_TEMP_DERATE));
+}
+
+float bal_planner_discharge_time(voltage_t volt, voltage_t delta) {
+    if (volt == 0)
+        return 0.f;
+
+    // Charge to remove (Ah) and discharge current through the resistor (A)
+    float charge = (delta / 10000.f) / BAL_PLANNER_CELL_VOLTAGE_SLOPE;
+    float current = (volt / 10000.f) / DISCHARGE_R;
+    return charge * 3600.f / current;
+}
+
+size_t bal_planner_compute(const voltage_t volts[PACK_CELL_COUNT],
+    const float temps[CELLBOARD_COUNT],
+    voltage_t target,
+    voltage_t threshold,
+    bal_plan_t * plan) {
+    if (volts == NULL || temps == NULL || plan == NULL)
+        return 0;
+
+    memset(plan, 0, sizeof(bal_plan_t));
+
+    // Use the minimum cell voltage as the target if not specified
+    if (target == 0) {
+        target = CELL_MAX_VOLTAGE;
+        for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+            target = MIN(target, volts[i]);
+    }
+    plan->target = target;
+
+    size_t count = 0;
+    for (size_t board = 0; board < CELLBOARD_COUNT; ++board) {
+        const voltage_t * board_volts = volts + board * CELLBOARD_CELL_COUNT;
+        bal_plan_board_t * board_plan = &plan->boards[board];
+
+        // Only cells above the threshold are taken into account
+        uint32_t weights[CELLBOARD_CELL_COUNT];
+        for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+            int32_t delta = (int32_t)board_volts[i] - target;
+            weights[i] = delta > threshold ? (uint32_t)delta : 0U;
+        }
+
+        uint32_t cells = bal_planner_exclude_neighbors(weights, CELLBOARD_CELL_COUNT);
+
+        // Drop the less unbalanced cells until the thermal budget is respected
+        size_t budget = bal_planner_thermal_budget(temps[board]);
+        while (_bal_planner_count_cells(cells) > budget) {
+            size_t min_index = CELLBOARD_CELL_COUNT;
+            for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+                if ((cells & (1U << i)) && (min_index == CELLBOARD_CELL_COUNT || weights[i] < weights[min_index]))
+                    min_index = i;
+            }
+            cells &= ~(1U << min_index);
+        }
+
+        // Compute the discharge time of each selected cell
+        for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i) {
+            if ((cells & (1U << i)) == 0)
+                continue;
+            float time = bal_planner_discharge_time(board_volts[i], weights[i]);
+            board_plan->durations[i] = (uint8_t)MAX(1.f, MIN(time, (float)BAL_PLANNER_MAX_DURATION));
+        }
+        board_plan->cells = cells;
+        count += _bal_planner_count_cells(cells);
+    }
+    return count;
+}
@@ -413,6 +413,9 @@ void set_fatal_error(state_data_t *data) {
   cli_bms_debug("[FSM] State transition set_fatal_error", 38);
   /* Your Code Here */
 
+  // Freeze the feedbacks capture around the fault
+  feedback_capture_trigger(&feedback_capture, FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR);
+
   // Send info via CAN
   can_car_send(PRIMARY_HV_ERRORS_FRAME_ID);
 
@@ -579,6 +582,8 @@ bms_state_t run_state(bms_state_t cur_state, state_data_t *data) {
   transition_func_t *transition = transition_table[cur_state][new_state];
   
   if (transition) {
+    feedback_capture_trigger(&feedback_capture, FEEDBACK_CAPTURE_TRIGGER_TRANSITION);
+
     // Send info via CAN
     can_car_send(PRIMARY_HV_FEEDBACK_STATUS_FRAME_ID);
     can_car_send(PRIMARY_HV_STATUS_FRAME_ID);
@@ -0,0 +1,140 @@
+/**
+ * @file cell_anomaly.c
+ * @brief Detection of the cells drifting away from the rest of the pack
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "cell_anomaly.h"
+
+#include <math.h>
+#include <string.h>
+
+#define CELL_ANOMALY_MS_PER_HOUR 3600000.f
+
+void cell_anomaly_init(cell_anomaly_t * anomaly) {
+    if (anomaly == NULL)
+        return;
+    memset(anomaly, 0, sizeof(cell_anomaly_t));
+}
+
+/** @brief Follow the rest periods and take the drift reference once the cells have relaxed */
+void _cell_anomaly_update_rest(cell_anomaly_t * anomaly, uint32_t time, float mean, const voltage_t * voltages) {
+    if (!anomaly->resting) {
+        anomaly->resting = true;
+        anomaly->rest_started = false;
+        anomaly->rest_time = time;
+        return;
+    }
+    if (!anomaly->rest_started) {
+        if (time - anomaly->rest_time < CELL_ANOMALY_REST_SETTLE_TIME)
+            return;
+        for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+            anomaly->rest_deviation[i] = voltages[i] - mean;
+        anomaly->rest_started = true;
+        anomaly->rest_time = time;
+        return;
+    }
+
+    uint32_t elapsed = time - anomaly->rest_time;
+    if (elapsed < CELL_ANOMALY_REST_MIN_TIME)
+        return;
+    const float hours = elapsed / CELL_ANOMALY_MS_PER_HOUR;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+        anomaly->drift[i] = (voltages[i] - mean - anomaly->rest_deviation[i]) / hours;
+}
+
+void cell_anomaly_update(cell_anomaly_t * anomaly, uint32_t time, float current, bool balancing, const voltage_t * voltages) {
+    if (anomaly == NULL || voltages == NULL)
+        return;
+
+    // The mean is removed before the variance to keep the float sums small
+    float mean = 0.f;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+        mean += voltages[i];
+    mean /= PACK_CELL_COUNT;
+
+    float var = 0.f;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i) {
+        float d = voltages[i] - mean;
+        var += d * d;
+    }
+    const float sigma = MAX(sqrtf(var / PACK_CELL_COUNT), CELL_ANOMALY_MIN_SIGMA);
+    const float abs_current = fabsf(current);
+
+    // Under load a weak cell sags more than the others, and rises more while
+    // charging, so the sign follows the current to keep a weak cell negative
+    if (abs_current >= CELL_ANOMALY_LOAD_CURRENT) {
+        const float scale = (current > 0.f ? 1.f : -1.f) / sigma;
+        for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+            anomaly->z[i] += CELL_ANOMALY_Z_ALPHA * ((voltages[i] - mean) * scale - anomaly->z[i]);
+    }
+
+    // On a fast current step the voltage variation is mostly ohmic
+    const float step = current - anomaly->previous_current;
+    if (anomaly->has_previous &&
+        fabsf(step) >= CELL_ANOMALY_CURRENT_STEP &&
+        time - anomaly->previous_time <= CELL_ANOMALY_STEP_TIME) {
+        const float mean_delta = mean - anomaly->previous_mean;
+        for (size_t i = 0; i < PACK_CELL_COUNT; ++i) {
+            float r = -((float)voltages[i] - anomaly->previous[i] - mean_delta) / step;
+            anomaly->resistance[i] += CELL_ANOMALY_RESISTANCE_ALPHA * (r - anomaly->resistance[i]);
+        }
+    }
+
+    // At rest the cells drift apart only by their self discharge
+    if (abs_current < CELL_ANOMALY_REST_CURRENT && !balancing)
+        _cell_anomaly_update_rest(anomaly, time, mean, voltages);
+    else
+        anomaly->resting = false;
+
+    memcpy(anomaly->previous, voltages, sizeof(anomaly->previous));
+    anomaly->previous_mean = mean;
+    anomaly->previous_current = current;
+    anomaly->previous_time = time;
+    anomaly->has_previous = true;
+}
+
+void cell_anomaly_get_cell(const cell_anomaly_t * anomaly, size_t cell, cell_anomaly_suspect_t * suspect) {
+    if (anomaly == NULL || suspect == NULL || cell >= PACK_CELL_COUNT)
+        return;
+
+    suspect->cell = cell;
+    suspect->z = anomaly->z[cell];
+    suspect->resistance = anomaly->resistance[cell];
+    suspect->drift = anomaly->drift[cell];
+
+    // Only the direction of a weak cell counts: low voltage, high resistance, fast discharge
+    const float z = -suspect->z / CELL_ANOMALY_Z_LIMIT;
+    const float resistance = suspect->resistance / CELL_ANOMALY_RESISTANCE_LIMIT;
+    const float drift = -suspect->drift / CELL_ANOMALY_DRIFT_LIMIT;
+
+    suspect->score = MAX(0.f, MAX(z, MAX(resistance, drift)));
+    suspect->flags = 0U;
+    if (z >= 1.f)
+        suspect->flags |= CELL_ANOMALY_FLAG_Z;
+    if (resistance >= 1.f)
+        suspect->flags |= CELL_ANOMALY_FLAG_RESISTANCE;
+    if (drift >= 1.f)
+        suspect->flags |= CELL_ANOMALY_FLAG_DRIFT;
+}
+
+size_t cell_anomaly_get_suspects(const cell_anomaly_t * anomaly, cell_anomaly_suspect_t * suspects, size_t count) {
+    if (anomaly == NULL || suspects == NULL || count == 0)
+        return 0;
+
+    // Insertion in a sorted list as short as the number of suspects
+    size_t found = 0;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i) {
+        cell_anomaly_suspect_t cell;
+        cell_anomaly_get_cell(anomaly, i, &cell);
+        if (cell.score <= 0.f || (found == count && cell.score <= suspects[found - 1].score))
+            continue;
+
+        size_t pos = found < count ? found++ : count - 1;
+        for (; pos > 0 && suspects[pos - 1].score < cell.score; --pos)
+            suspects[pos] = suspects[pos - 1];
+        suspects[pos] = cell;
+    }
+    return found;
+}
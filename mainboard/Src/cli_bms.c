@@ -33,12 +33,17 @@
 #include "internal_voltage.h"
 #include "cell_voltage.h"
 #include "timer_utils.h"
+#include "tx_ring.h"
+#include "telemetry.h"
+#include "str_writer.h"
 
 #define CELLBOARD_DISTR_ADDR 0x50
 #define CELLBOARD_DISTR_VER  0x01
 
 // TODO: don't count manually
-#define N_COMMANDS 21
+#define N_COMMANDS 22
+/** @brief Size of the output buffer given to the commands */
+#define CLI_OUT_SIZE 4096
 
 cli_command_func_t _cli_volts;
 cli_command_func_t _cli_volts_all;
@@ -59,6 +64,7 @@ cli_command_func_t _cli_watch;
 cli_command_func_t _cli_cellboard_distribution;
 cli_command_func_t _cli_fans;
 cli_command_func_t _cli_pack;
+cli_command_func_t _cli_telemetry;
 cli_command_func_t _cli_help;
 cli_command_func_t _cli_sigterm;
 cli_command_func_t _cli_taba;
@@ -124,14 +130,14 @@ char const *const imd_state_names[IMD_STATES_N] = {
 
 char *command_names[N_COMMANDS] = {"volt",       "temp",  "status", "errors", "ts",          "bal",       "soc",
                                    "current",    "dmesg", "reset",  "imd",    "can_forward", "feedbacks", "watch",
-                                   "cell_distr", "fans",  "pack",   "?",      "\003",        "\ta",       "sbor@"};
+                                   "cell_distr", "fans",  "pack",   "telemetry", "?",  "\003",       "\ta",       "sbor@"};
 
 cli_command_func_t *commands[N_COMMANDS] = {
     &_cli_volts,   &_cli_temps,       &_cli_status,    &_cli_errors,  &_cli_ts,
     &_cli_balance, &_cli_soc,         &_cli_current,   &_cli_dmesg,   &_cli_reset,
     &_cli_imd,     &_cli_can_forward, &_cli_feedbacks, &_cli_watch,   &_cli_cellboard_distribution,
-    &_cli_fans,    &_cli_pack,        &_cli_help,      &_cli_sigterm, &_cli_taba,
-    &_cli_sborat};
+    &_cli_fans,    &_cli_pack,        &_cli_telemetry, &_cli_help,    &_cli_sigterm,
+    &_cli_taba,    &_cli_sborat};
 
 cli_t cli_bms;
 bool dmesg_ena = true;
@@ -139,6 +145,14 @@ bool dmesg_ena = true;
 config_t cellboard_distribution;
 
 
+tx_ring_t cli_tx_ring;
+volatile bool cli_tx_busy;
+size_t cli_tx_length;
+
+uint32_t telemetry_period = 0; // ms, 0 if the stream is disabled
+uint32_t telemetry_last = 0;
+uint8_t telemetry_seq = 0;
+
 void cli_bms_init() {
     // Update cellboard distrbution in the EEPROM
     uint8_t cell_distr_default[CELLBOARD_COUNT] = { 0, 1, 2, 3, 4, 5 };
@@ -150,182 +164,233 @@ void cli_bms_init() {
     cli_bms.cmds.count     = N_COMMANDS;
 
     char init[94];
-    sprintf(
-        init,
-        "\r\n\n********* Fenice BMS *********\r\n"
-        " build: %s @ %s\r\n\n type ? for commands\r\n\n",
-        __DATE__,
-        __TIME__);
-
-    strcat(init, cli_ps);
+    str_writer_t writer;
+    str_writer_init(&writer, init, sizeof(init));
+    str_writer_append(&writer, "\r\n\n********* Fenice BMS *********\r\n build: ");
+    str_writer_append(&writer, __DATE__);
+    str_writer_append(&writer, " @ ");
+    str_writer_append(&writer, __TIME__);
+    str_writer_append(&writer, "\r\n\n type ? for commands\r\n\n");
+    str_writer_append(&writer, cli_ps);
+
+    tx_ring_init(&cli_tx_ring);
+    cli_tx_busy = 0;
 
     cli_init(&cli_bms);
     cli_print(&cli_bms, init, strlen(init));
 }
 
+/**
+ * @brief Start the DMA transmission of the data in the ring
+ * @details Nothing is done if a transmission is already in progress or the
+ * UART is used by someone else, in that case the data is sent by the next
+ * call of cli_bms_flush
+ */
+void _cli_bms_tx_start() {
+    if (__atomic_test_and_set(&cli_tx_busy, __ATOMIC_ACQUIRE))
+        return;
+
+    char * data;
+    size_t length = tx_ring_peek(&cli_tx_ring, &data);
+    if (length > 0 && HAL_UART_Transmit_DMA(&CLI_UART, (uint8_t *)data, length) == HAL_OK) {
+        cli_tx_length = length;
+        return;
+    }
+    __atomic_clear(&cli_tx_busy, __ATOMIC_RELEASE);
+}
+void _cli_bms_handle_tx_cplt() {
+    // The UART could have been used outside of the ring
+    if (!cli_tx_busy)
+        return;
+    tx_ring_consume(&cli_tx_ring, cli_tx_length);
+    __atomic_clear(&cli_tx_busy, __ATOMIC_RELEASE);
+    _cli_bms_tx_start();
+}
+
+bool cli_bms_print(const char * text, size_t length) {
+    bool written = tx_ring_write(&cli_tx_ring, text, length);
+    _cli_bms_tx_start();
+    return written;
+}
+void cli_bms_flush() {
+    if (!cli_tx_busy && tx_ring_get_pending(&cli_tx_ring) > 0)
+        _cli_bms_tx_start();
+}
+
+void cli_bms_telemetry_routine() {
+    static uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    static uint8_t frame[TELEMETRY_ENCODED_SIZE(TELEMETRY_MAX_PAYLOAD)];
+    telemetry_snapshot_t snapshot;
+    feedback_feed_t feedbacks[FEEDBACK_N];
+
+    uint32_t tick = HAL_GetTick();
+    if (telemetry_period == 0 || tick - telemetry_last < telemetry_period)
+        return;
+    telemetry_last = tick;
+
+    snapshot.timestamp = tick;
+    snapshot.state = fsm_get_state();
+    snapshot.current = (int32_t)(current_get_current() * 1000.0f);
+    memcpy(snapshot.voltages, cell_voltage_get_cells(), sizeof(snapshot.voltages));
+    for (size_t i = 0; i < CELLBOARD_COUNT; ++i) {
+        snapshot.temp_min[i] = cell_temps.min[i];
+        snapshot.temp_max[i] = cell_temps.max[i];
+        snapshot.temp_avg[i] = (uint8_t)(cell_temps.avg[i] + 0.5f);
+    }
+    snapshot.feedback_high = 0;
+    snapshot.feedback_error = 0;
+    feedback_get_all_states(feedbacks);
+    for (size_t i = 0; i < FEEDBACK_N; ++i) {
+        if (feedbacks[i].cur_state == FEEDBACK_STATE_H)
+            snapshot.feedback_high |= 1U << i;
+        else if (feedbacks[i].cur_state == FEEDBACK_STATE_ERROR)
+            snapshot.feedback_error |= 1U << i;
+    }
+
+    size_t length = telemetry_snapshot_serialize(&snapshot, payload);
+    length = telemetry_frame_encode(TELEMETRY_FRAME_SNAPSHOT, telemetry_seq++, payload, length, frame);
+    cli_bms_print((char *)frame, length);
+    for (size_t i = 0; i < CELLBOARD_COUNT; ++i) {
+        length = telemetry_cellboard_serialize(&snapshot, i, payload);
+        length = telemetry_frame_encode(TELEMETRY_FRAME_CELLBOARD, telemetry_seq++, payload, length, frame);
+        cli_bms_print((char *)frame, length);
+    }
+}
+
 void cli_bms_debug(char *text, size_t length) {
     if (dmesg_ena) {
-        char out[300] = {'\0'};
-        float tick    = (float)HAL_GetTick() / 1000;
+        char out[300];
+        str_writer_t writer;
+        str_writer_init(&writer, out, sizeof(out));
+
         // add prefix
-        sprintf(out, "[%.2f] ", tick);
+        str_writer_append(&writer, "[");
+        str_writer_append_fixed(&writer, HAL_GetTick(), 3, 2, 0);
+        str_writer_append(&writer, "] ");
 
-        strcat(out, text);
-        length += strlen(out);
+        // keep room for the suffix
+        str_writer_append_n(&writer, text, MIN(length, sizeof(out) - writer.length - 5));
 
         // add suffix
-        sprintf(out + length, "\r\n> ");
-        length += 4;
+        str_writer_append(&writer, "\r\n> ");
 
-        cli_print(&cli_bms, out, length);
+        cli_bms_print(out, writer.length);
     }
 }
 
 void _cli_volts(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (strcmp(argv[1], "") == 0) {
-        float max = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_max());
-        float min = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_min());
-        float sum = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_sum());
-        float avg = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_avg());
-        sprintf(
-            out,
-            "vts+........%.2f V\r\n"
-            "vts-........%.2f V\r\n"
-            "vbat........%.2f V\r\n"
-            "vshunt......%.2f V\r\n"
-            "sum.........%.2f V\r\n"
-            "average.....%.2f V\r\n"
-            "max.........%.3f V\r\n"
-            "min.........%.3f V\r\n"
-            "delta.......%.3f V\r\n",
-            CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_tsp()),
-            CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_tsn()),
-            CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_bat()),
-            CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_shunt()),
-            sum,
-            avg,
-            max,
-            min,
-            max - min
-        );
+        const char * names[] = { "vts+", "vts-", "vbat", "vshunt" };
+        internal_voltage_sample_t sample = internal_voltage_get_sample();
+        uint16_t values[] = { sample.tsp, sample.tsn, sample.bat, sample.shunt };
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+            str_writer_append(&writer, names[i]);
+            str_writer_append_repeat(&writer, '.', 12 - strlen(names[i]));
+            str_writer_append_float(&writer, CONVERT_VALUE_TO_INTERNAL_VOLTAGE(values[i]), 2, 0);
+            str_writer_append(&writer, " V\r\n");
+        }
+
+        voltage_t max = cell_voltage_get_max();
+        voltage_t min = cell_voltage_get_min();
+        str_writer_append(&writer, "sum.........");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_sum()), 2, 0);
+        str_writer_append(&writer, " V\r\naverage.....");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_avg()), 2, 0);
+        str_writer_append(&writer, " V\r\nmax.........");
+        str_writer_append_fixed(&writer, max, 4, 3, 0);
+        str_writer_append(&writer, " V\r\nmin.........");
+        str_writer_append_fixed(&writer, min, 4, 3, 0);
+        str_writer_append(&writer, " V\r\ndelta.......");
+        str_writer_append_fixed(&writer, max - min, 4, 3, 0);
+        str_writer_append(&writer, " V\r\n");
     } else if (strcmp(argv[1], "all") == 0) {
         _cli_volts_all(argc, &argv[1], out);
     } else {
-        sprintf(
-            out,
-            "Unknown parameter: %s\r\n"
+        str_writer_append(&writer, "Unknown parameter: ");
+        str_writer_append(&writer, argv[1]);
+        str_writer_append(
+            &writer,
+            "\r\n"
             "valid parameters:\r\n"
-            "- all: returns voltages for all cells\r\n",
-            argv[1]);
+            "- all: returns voltages for all cells\r\n");
     }
 }
 
 void _cli_volts_all(uint16_t argc, char **argv, char *out) {
-    sprintf(out, "     MIN      MAX      AVG\r\n");
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    str_writer_append(&writer, "     MIN      MAX      AVG\r\n");
     for (size_t i = 0; i < CELLBOARD_COUNT; i++) {
-        sprintf(out + strlen(out), "%d    %.2fV    %.2fV    %.2fV\r\n",
-            i + 1,
-            CONVERT_VALUE_TO_VOLTAGE(cell_volts.min[i]),
-            CONVERT_VALUE_TO_VOLTAGE(cell_volts.max[i]),
-            CONVERT_VALUE_TO_VOLTAGE(cell_volts.avg[i]));
+        str_writer_append_uint(&writer, i + 1, 0);
+        str_writer_append(&writer, "    ");
+        str_writer_append_fixed(&writer, cell_volts.min[i], 4, 2, 0);
+        str_writer_append(&writer, "V    ");
+        str_writer_append_fixed(&writer, cell_volts.max[i], 4, 2, 0);
+        str_writer_append(&writer, "V    ");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_VOLTAGE(cell_volts.avg[i]), 2, 0);
+        str_writer_append(&writer, "V\r\n");
     }
-    sprintf(out + strlen(out), "\r\n");
-    /*
-    voltage_t * cells = cell_voltage_get_cells();
 
+    // Single cells, the maximum is highlighted in red and the minimum in cyan
+    voltage_t * cells = cell_voltage_get_cells();
     voltage_t max = cell_voltage_get_max();
     voltage_t min = cell_voltage_get_min();
-
-    float cell_v, total_power = 0.0f, segment_sum = 0.0f;
-    for (uint8_t i = 0; i < PACK_CELL_COUNT; i++) {
-        cell_v = (float)cells[i] / 10000;
-        if (i % LTC6813_CELL_COUNT == 0) {
-            if (i != 0) {
-                sprintf(out + strlen(out), "Segment total: %.2fV", segment_sum);
-                segment_sum = 0;
-            }
-            sprintf(out + strlen(out), "\r\n%-3d", i / LTC6813_CELL_COUNT);
-        } else if (i % (LTC6813_CELL_COUNT / 3) == 0 && i > 0) {
-            sprintf(out + strlen(out), "\r\n%-3s", "");
+    for (size_t i = 0; i < PACK_CELL_COUNT; i++) {
+        if (i % CELLBOARD_CELL_COUNT == 0) {
+            str_writer_append(&writer, "\r\n");
+            str_writer_append_uint(&writer, i / CELLBOARD_CELL_COUNT, 0);
+            str_writer_append(&writer, i / CELLBOARD_CELL_COUNT < 10 ? "  " : " ");
+        } else if (i % (CELLBOARD_CELL_COUNT / 3) == 0) {
+            str_writer_append(&writer, "\r\n   ");
         }
-        segment_sum += cell_v;
-
-        bool is_cell_selected = (cells[i / CELLBOARD_CELL_COUNT] & (1 << i % CELLBOARD_CELL_COUNT));
 
-        if (!bal_is_balancing()) {
-            if (cells[i] == max)
-                sprintf(out + strlen(out), RED_BG("[%3u %-.3fV]") " ", i, cell_v);
-            else if (cells[i] == min)
-                sprintf(out + strlen(out), CYAN_BG("[%3u %-.3fV]") " ", i, cell_v);
-            else
-                sprintf(out + strlen(out), "[%3u %-.3fV] ", i, cell_v);
-        } else {
-            if (cells[i] == max) {
-                if (is_cell_selected) {
-                    total_power += cell_v * cell_v;
-                    sprintf(
-                        out + strlen(out),
-                        RED_BG_ON_YELLOW_FG("[%3u %-.3fV %.2fW]") " ",
-                        i,
-                        cell_v,
-                        DISCHARGE_DUTY_CYCLE * cell_v * cell_v / DISCHARGE_R);
-                } else
-                    sprintf(out + strlen(out), RED_BG("[%3u %-.3fV 0.00W]") " ", i, cell_v);
-            } else if (is_cell_selected) {
-                total_power += cell_v * cell_v;
-                sprintf(
-                    out + strlen(out),
-                    YELLOW_BG("[%3u %-.3fV %.2fW]") " ",
-                    i,
-                    cell_v,
-                    DISCHARGE_DUTY_CYCLE * cell_v * cell_v / DISCHARGE_R);
-            } else if (cells[i] == min)
-                sprintf(out + strlen(out), CYAN_BG("[%3u %-.3fV 0.00W]") " ", i, cell_v);
-            else
-                sprintf(out + strlen(out), "[%3u %-.3fV 0.00W] ", i, cell_v);
-        }
+        if (cells[i] == max)
+            str_writer_append(&writer, "\033[0;41m");
+        else if (cells[i] == min)
+            str_writer_append(&writer, "\033[0;46m");
+        str_writer_append(&writer, "[");
+        str_writer_append_uint(&writer, i, 3);
+        str_writer_append(&writer, " ");
+        str_writer_append_fixed(&writer, cells[i], 4, 3, 0);
+        str_writer_append(&writer, "V]");
+        if (cells[i] == max || cells[i] == min)
+            str_writer_append(&writer, NORMAL_COLOR);
+        str_writer_append(&writer, " ");
     }
-    sprintf(out + strlen(out), "Segment total: %.2fV", segment_sum);
-    total_power /= DISCHARGE_R;
-
-    if (!bal_is_balancing()) {
-        cell_v           = max / 10000;
-        float max_soc    = 0.0862 * cell_v * cell_v * cell_v - 1.4260 * cell_v * cell_v + 6.0088 * cell_v - 6.551;
-        cell_v           = (min + bal_get_threshold() - 10) / 10000;
-        float target_soc = 0.0862 * cell_v * cell_v * cell_v - 1.4260 * cell_v * cell_v + 6.0088 * cell_v - 6.551;
-
-        float ETA = ((target_soc - max_soc) * CELL_CAPACITY * 4) / (max / 10000 / DISCHARGE_R);
-
-        sprintf(out + strlen(out), "\r\nETA: %.1fh\r\n", ETA / DISCHARGE_DUTY_CYCLE);
-        sprintf(out + strlen(out), "Pwr: %3.1fW\r\n", total_power * DISCHARGE_DUTY_CYCLE);
-    } else
-        sprintf(out + strlen(out), "\r\n");
-    */
+    str_writer_append(&writer, "\r\n");
 }
 
 void _cli_temps(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (strcmp(argv[1], "") == 0) {
         float min = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_min());
         float max = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_max());
         float avg = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_average());
-        sprintf(
-            out,
-            "average.....%.2f °C\r\nmax.........%.2f "
-            "C\r\nmin.........%.2f °C\r\n"
-            "delta.......%.2f °C\r\n",
-            avg,
-            max,
-            min,
-            max - min);
+        str_writer_append(&writer, "average.....");
+        str_writer_append_float(&writer, avg, 2, 0);
+        str_writer_append(&writer, " °C\r\nmax.........");
+        str_writer_append_float(&writer, max, 2, 0);
+        str_writer_append(&writer, " °C\r\nmin.........");
+        str_writer_append_float(&writer, min, 2, 0);
+        str_writer_append(&writer, " °C\r\ndelta.......");
+        str_writer_append_float(&writer, max - min, 2, 0);
+        str_writer_append(&writer, " °C\r\n");
     } else if (strcmp(argv[1], "all") == 0) {
         _cli_temps_all(argc, &argv[1], out);
     } else {
-        sprintf(
-            out,
-            "Unknown parameter: %s\r\n"
+        str_writer_append(&writer, "Unknown parameter: ");
+        str_writer_append(&writer, argv[1]);
+        str_writer_append(
+            &writer,
+            "\r\n"
             "valid parameters:\r\n"
-            "- all: returns temperature for all cells\r\n",
-            argv[1]);
+            "- all: returns temperature for all cells\r\n");
     }
 }
 /*
@@ -359,81 +424,92 @@ void _cli_temps_all(uint16_t argc, char **argv, char *out) {
 }
 */
 void _cli_temps_all(uint16_t argc, char **argv, char *out) {
-    sprintf(out, "     MIN         MAX         AVG\r\n");
-    for (size_t i = 0; i < CELLBOARD_COUNT; i++) {
-        sprintf(out + strlen(out), "%d   %6.2f°C    %6.2f°C    %6.2f°C\r\n",
-            i,
-            CONVERT_VALUE_TO_TEMPERATURE(cell_temps.min[i]),
-            CONVERT_VALUE_TO_TEMPERATURE(cell_temps.max[i]),
-            CONVERT_VALUE_TO_TEMPERATURE(cell_temps.avg[i]));
-    }
-    sprintf(out + strlen(out), "\r\n");/*
-    out[0]                  = '\0';
-    temperature_t *temp_all = temperature_get_all();
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
 
-    for (uint8_t i = 0; i < PACK_TEMP_COUNT; i++) {
-
-        if (i % TEMP_SENSOR_COUNT == 0)
-            sprintf(out + strlen(out), "\r\n\r\n%-3d", i / TEMP_SENSOR_COUNT);
-        else if (i % (TEMP_SENSOR_COUNT / 4) == 0 && i > 0)
-            sprintf(out + strlen(out), "\r\n%-3s", "");
-
-        sprintf(out + strlen(out), "[%3u %2u °C] ", i, (uint8_t)(temp_all[i] / 2.55 - 20));
+    str_writer_append(&writer, "     MIN         MAX         AVG\r\n");
+    for (size_t i = 0; i < CELLBOARD_COUNT; i++) {
+        str_writer_append_uint(&writer, i, 0);
+        str_writer_append(&writer, "   ");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_TEMPERATURE(cell_temps.min[i]), 2, 6);
+        str_writer_append(&writer, "°C    ");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_TEMPERATURE(cell_temps.max[i]), 2, 6);
+        str_writer_append(&writer, "°C    ");
+        str_writer_append_float(&writer, CONVERT_VALUE_TO_TEMPERATURE(cell_temps.avg[i]), 2, 6);
+        str_writer_append(&writer, "°C\r\n");
     }
-
-    sprintf(out + strlen(out), "\r\n");
-    */
+    str_writer_append(&writer, "\r\n");
 }
 
 void _cli_status(uint16_t argc, char **argv, char *out) {
 #define n_items 5
 
-    char thresh[5] = {'\0'};
-    itoa((float)bal_get_threshold() / 10, thresh, 10);
-
     char er_count[3] = {'\0'};
     // itoa(error_get_running(), er_count, 10);
 
-    char handcart_connected[13] = { '\0' };
-    if (is_handcart_connected)
-        strncpy(handcart_connected, "connected", strlen("connected") + 1);
-    else
-        strncpy(handcart_connected, "disconnected", strlen("disconnected") + 1);
-
     const char *values[n_items][2] = {
         {"BMS state", bms_state_names[fsm_get_state()]},
         {"Error count", er_count},
         {"CAN forwarding", can_is_forwarding() ? "true" : "false"},
         {"Balancing state", bal_state_names[bal_is_balancing()]},
-        {"Handcart status", handcart_connected}
+        {"Handcart status", is_handcart_connected ? "connected" : "disconnected"}
     };
     //{"BMS state", (char *)fsm_bms.state_names[fsm_bms.current_state]}, {"error
     // count", er_count}, {"balancing", bal}, {"balancing threshold", thresh}};
 
-    out[0] = '\0';
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
     for (uint8_t i = 0; i < n_items; i++) {
-        sprintf(
-            out + strlen(out),
-            "%s%s%s\r\n",
-            values[i][0],
-            "........................" + strlen(values[i][0]),
-            values[i][1]);
+        str_writer_append(&writer, values[i][0]);
+        str_writer_append_repeat(&writer, '.', 24 - strlen(values[i][0]));
+        str_writer_append(&writer, values[i][1]);
+        str_writer_append(&writer, "\r\n");
     }
+
+    measures_cycles_t cycles = measures_get_cycles_50ms();
+    str_writer_append(&writer, "50 ms cycles");
+    str_writer_append_repeat(&writer, '.', 24 - strlen("50 ms cycles"));
+    str_writer_append_uint(&writer, cycles.last, 0);
+    str_writer_append(&writer, " (max ");
+    str_writer_append_uint(&writer, cycles.max, 0);
+    str_writer_append(&writer, ")\r\n");
+
+    internal_voltage_stats_t adc_stats = internal_voltage_get_stats();
+    str_writer_append(&writer, "Internal ADC samples");
+    str_writer_append_repeat(&writer, '.', 24 - strlen("Internal ADC samples"));
+    str_writer_append_uint(&writer, adc_stats.samples, 0);
+    str_writer_append(&writer, " (errors ");
+    str_writer_append_uint(&writer, adc_stats.errors, 0);
+    str_writer_append(&writer, ", overruns ");
+    str_writer_append_uint(&writer, adc_stats.overruns, 0);
+    str_writer_append(&writer, ")\r\n");
 }
 
 // TODO: Balancing actions
 uint16_t bal_threshold = BAL_THRESHOLD_DEFAULT;
 void _cli_balance(uint16_t argc, char **argv, char *out) {
-    strcpy(out, "Work in progress...\n\0");
-    
-    if (strcmp(argv[1], "on") == 0) {
+    const char * usage =
+        "valid parameters:\r\n"
+        "- on\r\n"
+        "- off\r\n"
+        "- thr <millivolts>\r\n"
+        "- status\r\n"
+        "- charge\r\n"
+        "- test <board> <cell0 cell1 ... cellN>\r\n";
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    if (argc < 2) {
+        str_writer_append(&writer, "Invalid number of parameters.\r\n\n");
+        str_writer_append(&writer, usage);
+    } else if (strcmp(argv[1], "on") == 0) {
         // if (argc > 2)
         //     bal.target = atoi(argv[2]);
         bal_change_status_request(true, bal_threshold);
-        sprintf(out, "enabling balancing\r\n");
+        str_writer_append(&writer, "enabling balancing\r\n");
     } else if (strcmp(argv[1], "off") == 0) {
         bal_change_status_request(false, bal_threshold);
-        sprintf(out, "disabling balancing\r\n");
+        str_writer_append(&writer, "disabling balancing\r\n");
     } else if (strcmp(argv[1], "thr") == 0) {
         if (argv[2] != NULL) {
             bal_threshold = (voltage_t)atol(argv[2]) * 10;   
@@ -441,164 +517,166 @@ void _cli_balance(uint16_t argc, char **argv, char *out) {
                 bal_threshold = BAL_THRESHOLD_DEFAULT;
             }
         }
-        sprintf(out, "balancing threshold is %.2f mV\r\n", bal_threshold / 10.f);
-    } else if (strcmp(argv[1], "test") == 0) {
-        /*
-        CAN_TxHeaderTypeDef tx_header;
-        uint8_t buffer[CAN_MAX_PAYLOAD_LENGTH];
-        uint8_t board;
-        uint32_t cells = 0;
-
-        tx_header.ExtId = 0;
-        tx_header.IDE   = CAN_ID_STD;
-        tx_header.RTR   = CAN_RTR_DATA;
-        tx_header.StdId = BMS_SET_BALANCING_STATUS_FRAME_ID;
-
-        board = atoi(argv[2]);
-
-        if (argc < 4) {
-            sprintf(out, "wrong number of parameters\r\n");
-            return;
+        str_writer_append(&writer, "balancing threshold is ");
+        str_writer_append_fixed(&writer, bal_threshold, 1, 2, 0);
+        str_writer_append(&writer, " mV\r\n");
+    } else if (strcmp(argv[1], "status") == 0) {
+        int32_t eta = bal_get_eta();
+        str_writer_append(&writer, "state: ");
+        str_writer_append(&writer, bal_state_names[bal_is_balancing()]);
+        str_writer_append(&writer, "\r\nthreshold: ");
+        str_writer_append_fixed(&writer, bal_get_threshold(), 1, 2, 0);
+        str_writer_append(&writer, " mV\r\nspread: ");
+        str_writer_append_fixed(&writer, bal_get_spread(), 1, 2, 0);
+        str_writer_append(&writer, " mV\r\nrate: ");
+        str_writer_append_float(&writer, bal_get_convergence_rate() * 60.f / 10.f, 3, 0);
+        str_writer_append(&writer, " mV/min\r\n");
+        if (eta == BAL_CONVERGENCE_ETA_UNKNOWN) {
+            str_writer_append(&writer, "ETA: unknown\r\n");
+        } else {
+            str_writer_append(&writer, "ETA: ");
+            str_writer_append_float(&writer, eta / 60.f, 1, 0);
+            str_writer_append(&writer, " min\r\n");
         }
-
-        sprintf(out, "testing cells [");
-
-        uint8_t c;
-        for (uint8_t i = 3; i < argc; ++i) {
-            c = atoi(argv[i]);
-            cells |= 1 << c;
-            sprintf(out + strlen(out), "%u,", c);
+        str_writer_append(&writer, "removed charge: ");
+        str_writer_append_float(&writer, bal_get_total_charge(), 1, 0);
+        str_writer_append(&writer, " mAh\r\n");
+    } else if (strcmp(argv[1], "charge") == 0) {
+        for (size_t i = 0; i < PACK_CELL_COUNT; ++i) {
+            if (i % CELLBOARD_CELL_COUNT == 0) {
+                if (i != 0)
+                    str_writer_append(&writer, "\r\n");
+                str_writer_append_uint(&writer, i / CELLBOARD_CELL_COUNT, 0);
+                str_writer_append(&writer, i / CELLBOARD_CELL_COUNT < 10 ? "  " : " ");
+            } else if (i % (CELLBOARD_CELL_COUNT / 3) == 0) {
+                str_writer_append(&writer, "\r\n   ");
+            }
+            str_writer_append(&writer, "[");
+            str_writer_append_uint(&writer, i, 3);
+            str_writer_append(&writer, " ");
+            str_writer_append_float(&writer, bal_get_cell_charge(i), 1, 6);
+            str_writer_append(&writer, "mAh] ");
         }
-
-
-        tx_header.DLC = bms_balancing_pack(buffer, &raw, BMS_BALANCING_BYTE_SIZE);
-        can_send(&BMS_CAN, buffer, &tx_header);
-
-        sprintf(out + strlen(out) - 1, "]\r\non board %d\r\n", board);
-        */
-    } else if (argc < 2) {
-        sprintf(
-            out,
-            "Invalid number of parameters.\r\n\n"
-            "valid parameters:\r\n"
-            "- on\r\n"
-            "- off\r\n"
-            "- thr <millivolts>\r\n"
-            "- test <board> <cell0 cell1 ... cellN>\r\n");
+        str_writer_append(&writer, "\r\ntotal: ");
+        str_writer_append_float(&writer, bal_get_total_charge(), 1, 0);
+        str_writer_append(&writer, " mAh\r\n");
+    } else if (strcmp(argv[1], "test") == 0) {
+        str_writer_append(&writer, "Work in progress...\n");
     } else {
-        sprintf(
-            out,
-            "Unknown parameter: %s\r\n\n"
-            "valid parameters:\r\n"
-            "- on\r\n"
-            "- off\r\n"
-            "- thr <millivolts>\r\n"
-            "- test <board> <cell0 cell1 ... cellN>\r\n",
-            argv[0]);
+        str_writer_append(&writer, "Unknown parameter: ");
+        str_writer_append(&writer, argv[0]);
+        str_writer_append(&writer, "\r\n\n");
+        str_writer_append(&writer, usage);
     }
 }
 void _cli_soc(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (strcmp(argv[1], "reset") == 0) {
         soc_reset_soc();
-        sprintf(out, "Resetting energy meter\r\n");
+        str_writer_append(&writer, "Resetting energy meter\r\n");
     } else {
-        sprintf(
-            out,
-            "SoC: %.2f %%\r\n"
-            "Energy: %.1f Wh\r\n"
-            "Energy total: %.1f Wh\r\n",
-            soc_get_soc(),
-            soc_get_energy_last_charge(),
-            soc_get_energy_total());
+        str_writer_append(&writer, "SoC: ");
+        str_writer_append_float(&writer, soc_get_soc(), 2, 0);
+        str_writer_append(&writer, " %\r\nEnergy: ");
+        str_writer_append_float(&writer, soc_get_energy_last_charge(), 1, 0);
+        str_writer_append(&writer, " Wh\r\nEnergy total: ");
+        str_writer_append_float(&writer, soc_get_energy_total(), 1, 0);
+        str_writer_append(&writer, " Wh\r\n");
     }
 }
 
 void _cli_errors(uint16_t argc, char **argv, char *out) {
-    *out = 0;
     size_t running = 0;// error_get_running();
     size_t expired  = get_expired_errors();
 
-    sprintf(out, "Running: %u\r\nExpired: %u\r\n", running, expired);
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+    str_writer_append(&writer, "Running: ");
+    str_writer_append_uint(&writer, running, 0);
+    str_writer_append(&writer, "\r\nExpired: ");
+    str_writer_append_uint(&writer, expired, 0);
+    str_writer_append(&writer, "\r\n");
 
     // TODO: Print each error informations
-    /*
-    volatile uint32_t now = HAL_GetTick();
-    for (uint16_t i = 0; i < count; i++) {
-        sprintf(
-            out + strlen(out),
-            "\r\nid..........%i (%s)\r\n"
-            "timestamp...T+%lu (%lums ago)\r\n"
-            "offset......%u\r\n"
-            "state.......%s\r\n",
-            errors[i].id,
-            error_names[errors[i].id],
-            errors[i].timestamp,
-            now - errors[i].timestamp,
-            errors[i].offset,
-            errors[i].state == STATE_WARNING ? "warning" : "fatal");
-    }
-    */
 }
 
 void _cli_ts(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (strcmp(argv[1], "on") == 0) {
         set_ts_request.is_new = true;
         set_ts_request.next_state = STATE_WAIT_AIRN_CLOSE;
-        sprintf(out, "triggered TS ON event\r\n");
+        str_writer_append(&writer, "triggered TS ON event\r\n");
     } else if (strcmp(argv[1], "off") == 0) {
         set_ts_request.is_new = true;
         set_ts_request.next_state = STATE_IDLE;
-        sprintf(out, "triggered TS OFF event\r\n");
-    } else if (argc < 2) {
-        sprintf(
-            out,
-            "Invalid number of parameters.\r\n\n"
-            "valid parameters:\r\n"
-            "- on\r\n"
-            "- off\r\n");
+        str_writer_append(&writer, "triggered TS OFF event\r\n");
     } else {
-        sprintf(
-            out,
-            "Unknown parameter: %s\r\n\n"
+        if (argc < 2) {
+            str_writer_append(&writer, "Invalid number of parameters.\r\n\n");
+        } else {
+            str_writer_append(&writer, "Unknown parameter: ");
+            str_writer_append(&writer, argv[1]);
+            str_writer_append(&writer, "\r\n\n");
+        }
+        str_writer_append(
+            &writer,
             "valid parameters:\r\n"
             "- on\r\n"
-            "- off\r\n",
-            argv[1]);
+            "- off\r\n");
     }
 }
 
 void _cli_current(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (argc == 1) {
-        sprintf(
-            out,
-            "Hall 50A:\t%.1fA\r\n"
-            "Hall 300A:\t%.1fA\r\n"
-            "Shunt:\t\t%.1fA\r\n",
-            current_get_current_from_sensor(CURRENT_SENSOR_50),
-            current_get_current_from_sensor(CURRENT_SENSOR_300),
-            current_get_current_from_sensor(CURRENT_SENSOR_SHUNT));
+        str_writer_append(&writer, "Hall 50A:\t");
+        str_writer_append_float(&writer, current_get_current_from_sensor(CURRENT_SENSOR_50), 1, 0);
+        str_writer_append(&writer, "A\r\nHall 300A:\t");
+        str_writer_append_float(&writer, current_get_current_from_sensor(CURRENT_SENSOR_300), 1, 0);
+        str_writer_append(&writer, "A\r\nShunt:\t\t");
+        str_writer_append_float(&writer, current_get_current_from_sensor(CURRENT_SENSOR_SHUNT), 1, 0);
+        str_writer_append(&writer, "A\r\n");
     } else if (strcmp(argv[1], "zero") == 0) {
         current_zero();
-        sprintf(out, "Current zeroed\r\n");
-    } else if (argc < 2) {
-        sprintf(
-            out,
-            "Invalid number of parameters.\r\n\n"
-            "valid parameters:\r\n"
-            "- zero: zeroes the hall-sensor measurement\r\n");
+        str_writer_append(&writer, "Current zeroed\r\n");
     } else {
-        sprintf(
-            out,
-            "Unknown parameter: %s\r\n\n"
+        if (argc < 2) {
+            str_writer_append(&writer, "Invalid number of parameters.\r\n\n");
+        } else {
+            str_writer_append(&writer, "Unknown parameter: ");
+            str_writer_append(&writer, argv[1]);
+            str_writer_append(&writer, "\r\n\n");
+        }
+        str_writer_append(
+            &writer,
             "valid parameters:\r\n"
-            "- zero: zeroes the hall-sensor measurement\r\n",
-            argv[1]);
+            "- zero: zeroes the hall-sensor measurement\r\n");
     }
 }
 
 void _cli_dmesg(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    if (argc > 1 && strcmp(argv[1], "stats") == 0) {
+        str_writer_append(&writer, "pending: ");
+        str_writer_append_uint(&writer, tx_ring_get_pending(&cli_tx_ring), 0);
+        str_writer_append(&writer, " bytes\r\ndropped: ");
+        str_writer_append_uint(&writer, cli_tx_ring.dropped, 0);
+        str_writer_append(&writer, " messages (");
+        str_writer_append_uint(&writer, cli_tx_ring.dropped_bytes, 0);
+        str_writer_append(&writer, " bytes)\r\n");
+        return;
+    }
     dmesg_ena = !dmesg_ena;
-    sprintf(out, "dmesg output is %s\r\n", dmesg_ena ? "enabled" : "disabled");
+    str_writer_append(&writer, "dmesg output is ");
+    str_writer_append(&writer, dmesg_ena ? "enabled\r\n" : "disabled\r\n");
 }
 
 void _cli_reset(uint16_t argc, char **argv, char *out) {
@@ -606,8 +684,10 @@ void _cli_reset(uint16_t argc, char **argv, char *out) {
 }
 
 void _cli_taba(uint16_t argc, char **argv, char *out) {
-    sprintf(
-        out,
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+    str_writer_append(
+        &writer,
         " #######    #    ######     #    ######     #    ####### ####### ######  \r\n"
         "    #      # #   #     #   # #   #     #   # #      #    #       #     # \r\n"
         "    #     #   #  #     #  #   #  #     #  #   #     #    #       #     # \r\n"
@@ -618,30 +698,54 @@ void _cli_taba(uint16_t argc, char **argv, char *out) {
 }
 
 void _cli_help(uint16_t argc, char **argv, char *out) {
-    sprintf(out, "command list:\r\n");
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    str_writer_append(&writer, "command list:\r\n");
     for (uint8_t i = 0; i < N_COMMANDS - 3; i++) {
-        sprintf(out + strlen(out), "- %s\r\n", cli_bms.cmds.names[i]);
+        str_writer_append(&writer, "- ");
+        str_writer_append(&writer, cli_bms.cmds.names[i]);
+        str_writer_append(&writer, "\r\n");
     }
 }
 
 void _cli_imd(uint16_t argc, char **argv, char *out) {
-    sprintf(
-        out,
-        "fault:        %u\r\n"
-        "IMD status:   %s\r\n"
-        "details:      %ld\r\n"
-        "duty cycle:   %.2f%%\r\n"
-        "frequency:    %uHz\r\n"
-        "period:       %ums\r\n",
-        imd_is_fault(),
-        imd_state_names[imd_get_state()],
-        imd_get_details(),
-        imd_get_duty_cycle_percentage(),
-        imd_get_freq(),
-        imd_get_period());
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    str_writer_append(&writer, "fault:        ");
+    str_writer_append_uint(&writer, imd_is_fault(), 0);
+    str_writer_append(&writer, "\r\nIMD status:   ");
+    str_writer_append(&writer, imd_state_names[imd_get_state()]);
+    str_writer_append(&writer, "\r\nconfidence:   ");
+    str_writer_append_uint(&writer, imd_get_confidence(), 0);
+    str_writer_append(&writer, "%\r\ndetails:      ");
+    str_writer_append_int(&writer, imd_get_details(), 0);
+    str_writer_append(&writer, "\r\nresistance:   ");
+    int32_t resistance = imd_get_resistance();
+    if (resistance < 0)
+        str_writer_append(&writer, "n/a");
+    else {
+        str_writer_append_int(&writer, resistance, 0);
+        str_writer_append(&writer, "kOhm (min ");
+        str_writer_append_int(&writer, imd_decoder.resistance_min, 0);
+        str_writer_append(&writer, "kOhm, trend ");
+        str_writer_append_float(&writer, imd_decoder_get_trend(&imd_decoder), 1, 0);
+        str_writer_append(&writer, "kOhm/min)");
+    }
+    str_writer_append(&writer, "\r\nduty cycle:   ");
+    str_writer_append_float(&writer, imd_get_duty_cycle_percentage(), 2, 0);
+    str_writer_append(&writer, "%\r\nfrequency:    ");
+    str_writer_append_uint(&writer, imd_get_freq(), 0);
+    str_writer_append(&writer, "Hz\r\nperiod:       ");
+    str_writer_append_uint(&writer, imd_get_period(), 0);
+    str_writer_append(&writer, "ms\r\n");
 }
 
 void _cli_can_forward(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (argc == 3) {
         CAN_HandleTypeDef *can;
         if (!strcmp(argv[1], "bms")) {
@@ -649,60 +753,191 @@ void _cli_can_forward(uint16_t argc, char **argv, char *out) {
         } else if (!strcmp(argv[1], "primary")) {
             can = &CAR_CAN;
         } else {
-            sprintf(
-                out,
-                "Unknown parameter: %s\r\n\n"
+            str_writer_append(&writer, "Unknown parameter: ");
+            str_writer_append(&writer, argv[1]);
+            str_writer_append(
+                &writer,
+                "\r\n\n"
                 "valid parameters:\r\n"
                 "- bms: bms internal network\r\n"
-                "- primary: car primary network\r\n",
-                argv[1]);
+                "- primary: car primary network\r\n");
             return;
         }
         char *divider_index                     = strchr(argv[2], '#');
         uint8_t payload[CAN_MAX_PAYLOAD_LENGTH] = {0};
 
-        if (divider_index == NULL) {
-            sprintf(out, "Errore di formattazione: ID#PAYLOAD\n\rPAYLOAD is hex encoded and is MSB...LSB\r\n");
+        if (divider_index == NULL || strlen(divider_index + 1) % 2 != 0) {
+            str_writer_append(&writer, "Errore di formattazione: ID#PAYLOAD\n\rPAYLOAD is hex encoded and is MSB...LSB\r\n");
             return;
         }
         *divider_index = '\0';
 
-        if (strlen(divider_index + 1) % 2 != 0) {
-            sprintf(out, "Errore di formattazione: ID#PAYLOAD\n\rPAYLOAD is hex encoded and is MSB...LSB\r\n");
-            return;
-        }
-
         CAN_TxHeaderTypeDef header = {
             .StdId = strtoul(argv[2], NULL, 16), .DLC = strlen(divider_index + 1) / 2, .ExtId = 0, .RTR = 0, .IDE = 0};
         *((uint64_t *)payload) = (uint64_t)strtoull(divider_index + 1, NULL, 16);
         can_send(can, payload, &header);
-        *out = '\0';
     } else {
-        sprintf(
-            out,
+        str_writer_append(
+            &writer,
             "Invalid command format\r\n\n"
             "valid format:\r\n"
             "can_forward <network> <id>#<payload>\r\n");
     }
 }
 
+/** @brief Maximum number of capture samples printed by a single command */
+#define CLI_FEEDBACK_CAPTURE_LINES 100
+
+const char * feedback_capture_state_names[] = {
+    [FEEDBACK_CAPTURE_STATE_IDLE]      = "idle",
+    [FEEDBACK_CAPTURE_STATE_ARMED]     = "armed",
+    [FEEDBACK_CAPTURE_STATE_TRIGGERED] = "triggered",
+    [FEEDBACK_CAPTURE_STATE_DONE]      = "done"
+};
+const char * feedback_capture_trigger_names[] = {
+    [FEEDBACK_CAPTURE_TRIGGER_MANUAL]      = "manual",
+    [FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR] = "fatal",
+    [FEEDBACK_CAPTURE_TRIGGER_TRANSITION]  = "transition"
+};
+
+void _cli_feedbacks_capture(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    if (argc < 3) {
+        str_writer_append(
+            &writer,
+            "Invalid number of parameters.\r\n\n"
+            "valid parameters:\r\n"
+            "- arm <mask|all> [manual|fatal|transition] [pre] [post]\r\n"
+            "- trigger\r\n"
+            "- stop\r\n"
+            "- status\r\n"
+            "- dump [offset]\r\n"
+            "- can\r\n");
+    } else if (strcmp(argv[2], "arm") == 0) {
+        if (argc < 4) {
+            str_writer_append(&writer, "missing feedbacks mask\r\n");
+            return;
+        }
+        feedback_t mask = strcmp(argv[3], "all") == 0 ? FEEDBACK_ALL : (feedback_t)strtoul(argv[3], NULL, 0);
+        FEEDBACK_CAPTURE_TRIGGER trigger = FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR;
+        if (argc > 4) {
+            for (trigger = 0; trigger < FEEDBACK_CAPTURE_TRIGGER_N; ++trigger)
+                if (strcmp(argv[4], feedback_capture_trigger_names[trigger]) == 0)
+                    break;
+            if (trigger == FEEDBACK_CAPTURE_TRIGGER_N) {
+                str_writer_append(&writer, "Unknown trigger: ");
+                str_writer_append(&writer, argv[4]);
+                str_writer_append(&writer, "\r\nvalid triggers: manual, fatal, transition\r\n");
+                return;
+            }
+        }
+        size_t pre = argc > 5 ? strtoul(argv[5], NULL, 10) : FEEDBACK_CAPTURE_DEFAULT_PRE;
+        size_t post = argc > 6 ? strtoul(argv[6], NULL, 10) : FEEDBACK_CAPTURE_DEFAULT_POST;
+
+        if (feedback_capture_arm(&feedback_capture, mask & FEEDBACK_ALL, trigger, pre, post)) {
+            str_writer_append(&writer, "capture armed on ");
+            str_writer_append(&writer, feedback_capture_trigger_names[trigger]);
+            str_writer_append(&writer, " trigger\r\n");
+        } else {
+            str_writer_append(&writer, "invalid capture parameters, pre + post must not exceed ");
+            str_writer_append_uint(&writer, FEEDBACK_CAPTURE_SIZE, 0);
+            str_writer_append(&writer, " samples\r\n");
+        }
+    } else if (strcmp(argv[2], "trigger") == 0) {
+        feedback_capture_trigger(&feedback_capture, FEEDBACK_CAPTURE_TRIGGER_MANUAL);
+        str_writer_append(&writer, "capture ");
+        str_writer_append(&writer, feedback_capture_state_names[feedback_capture.state]);
+        str_writer_append(&writer, "\r\n");
+    } else if (strcmp(argv[2], "stop") == 0) {
+        feedback_capture_init(&feedback_capture);
+        str_writer_append(&writer, "capture stopped\r\n");
+    } else if (strcmp(argv[2], "status") == 0) {
+        str_writer_append(&writer, "state: ");
+        str_writer_append(&writer, feedback_capture_state_names[feedback_capture.state]);
+        str_writer_append(&writer, "\r\ntrigger: ");
+        str_writer_append(&writer, feedback_capture_trigger_names[feedback_capture.trigger]);
+        str_writer_append(&writer, "\r\nmask: 0x");
+        str_writer_append_hex(&writer, feedback_capture.mask, 5);
+        str_writer_append(&writer, "\r\nsamples: ");
+        str_writer_append_uint(&writer, feedback_capture_get_count(&feedback_capture), 0);
+        str_writer_append(&writer, " (");
+        str_writer_append_uint(&writer, feedback_capture_get_trigger_offset(&feedback_capture), 0);
+        str_writer_append(&writer, " before the trigger)\r\n");
+    } else if (strcmp(argv[2], "dump") == 0) {
+        size_t count = feedback_capture_get_count(&feedback_capture);
+        if (count == 0) {
+            str_writer_append(&writer, "capture not complete\r\n");
+            return;
+        }
+        size_t offset = argc > 3 ? strtoul(argv[3], NULL, 10) : 0;
+        size_t trigger = feedback_capture_get_trigger_offset(&feedback_capture);
+        feedback_capture_sample_t sample;
+
+        for (size_t i = offset; i < count && i < offset + CLI_FEEDBACK_CAPTURE_LINES; ++i) {
+            feedback_capture_get_sample(&feedback_capture, i, &sample);
+            str_writer_append_uint(&writer, i, 3);
+            str_writer_append(&writer, " ");
+            str_writer_append_uint(&writer, sample.time, 5);
+            str_writer_append(&writer, " ");
+            str_writer_append_padded(&writer, feedback_names[sample.index], 35);
+            str_writer_append(&writer, " ");
+            str_writer_append_uint(&writer, sample.value, 4);
+            str_writer_append(&writer, " ");
+            str_writer_append_float(&writer, feedback_get_voltage_from_raw(sample.index, sample.value), 3, 0);
+            str_writer_append(&writer, i == trigger ? "V <- trigger\r\n" : "V\r\n");
+        }
+        if (offset + CLI_FEEDBACK_CAPTURE_LINES < count) {
+            str_writer_append(&writer, "more samples with: feedbacks capture dump ");
+            str_writer_append_uint(&writer, offset + CLI_FEEDBACK_CAPTURE_LINES, 0);
+            str_writer_append(&writer, "\r\n");
+        }
+    } else if (strcmp(argv[2], "can") == 0) {
+        if (feedback_capture_get_count(&feedback_capture) == 0) {
+            str_writer_append(&writer, "capture not complete\r\n");
+            return;
+        }
+        feedback_dump_start();
+        str_writer_append(&writer, "sending ");
+        str_writer_append_uint(&writer, feedback_capture_get_count(&feedback_capture), 0);
+        str_writer_append(&writer, " samples via CAN\r\n");
+    } else {
+        str_writer_append(&writer, "Unknown parameter: ");
+        str_writer_append(&writer, argv[2]);
+        str_writer_append(&writer, "\r\n");
+    }
+}
+
 void _cli_feedbacks(uint16_t argc, char **argv, char *out) {
+    if (argc > 1 && strcmp(argv[1], "capture") == 0) {
+        _cli_feedbacks_capture(argc, argv, out);
+        return;
+    }
+
+    const char * state_names[] = {
+        [FEEDBACK_STATE_L] = "0",
+        [FEEDBACK_STATE_ERROR] = "E",
+        [FEEDBACK_STATE_H] = "1"
+    };
     feedback_feed_t f[FEEDBACK_N];
     feedback_get_all_states(f);
-    *out = '\0';
+
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
     for (uint8_t i = 0; i < FEEDBACK_N; ++i) {
-        sprintf(
-            out + strlen(out),
-            "%02d - %-40s: %s, %.4f, %s\n\r",
-            i,
-            feedback_names[i],
-            f[i].real_state == FEEDBACK_STATE_H   ? "1"
-            : f[i].real_state == FEEDBACK_STATE_L ? "0"
-                                             : "E",
-            f[i].voltage,
-            f[i].cur_state == FEEDBACK_STATE_H   ? "1"
-            : f[i].cur_state == FEEDBACK_STATE_L ? "0"
-                                             : "E");
+        if (i < 10)
+            str_writer_append(&writer, "0");
+        str_writer_append_uint(&writer, i, 0);
+        str_writer_append(&writer, " - ");
+        str_writer_append_padded(&writer, feedback_names[i], 40);
+        str_writer_append(&writer, ": ");
+        str_writer_append(&writer, state_names[f[i].real_state]);
+        str_writer_append(&writer, ", ");
+        str_writer_append_float(&writer, f[i].voltage, 4, 0);
+        str_writer_append(&writer, ", ");
+        str_writer_append(&writer, state_names[f[i].cur_state]);
+        str_writer_append(&writer, "\n\r");
     }
 }
 
@@ -714,19 +949,25 @@ void _cli_sborat(uint16_t argc, char **argv, char *out) {
 char watch_buf[BUF_SIZE]      = {'\0'};
 uint8_t cli_watch_flush_tx    = 0;
 uint8_t cli_watch_execute_cmd = 0;
+uint32_t cli_watch_dropped    = 0;
 
 void _cli_sigterm(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (HTIM_CLI.State == HAL_TIM_STATE_BUSY) {
         HAL_TIM_Base_Stop_IT(&HTIM_CLI);
         *watch_buf = '\0';
-        sprintf(out, "\r\n");
+        str_writer_append(&writer, "\r\n");
     } else {
-        sprintf(out, "^C\r\n");
+        str_writer_append(&writer, "^C\r\n");
     }
 }
 
 void _cli_watch(uint16_t argc, char **argv, char *out) {
-    *watch_buf = '\0';
+    str_writer_t writer;
+    str_writer_init(&writer, watch_buf, BUF_SIZE);
+
     if (!strcmp(argv[1], "stop")) {
         HAL_TIM_Base_Stop_IT(&HTIM_CLI);
     } else {
@@ -734,16 +975,19 @@ void _cli_watch(uint16_t argc, char **argv, char *out) {
         if (interval == 0)
             interval = 500;
         for (uint8_t i = 2; i < argc; ++i) {
-            sprintf(watch_buf + strlen(watch_buf), "%s ", argv[i]);
+            if (i > 2)
+                str_writer_append(&writer, " ");
+            str_writer_append(&writer, argv[i]);
         }
-        cli_watch_execute_cmd            = 1;
-        watch_buf[strlen(watch_buf) - 1] = '\0';
+        cli_watch_execute_cmd = 1;
+        cli_watch_dropped     = 0;
         __HAL_TIM_SetAutoreload(&HTIM_CLI, TIM_MS_TO_TICKS(&HTIM_CLI, interval));
         __HAL_TIM_CLEAR_IT(&HTIM_CLI, TIM_IT_UPDATE);
         HAL_TIM_Base_Start_IT(&HTIM_CLI);
     }
 
-    sprintf(out, "\033[2J\033H");
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+    str_writer_append(&writer, "\033[2J\033H");
 }
 
 void _cli_timer_handler(TIM_HandleTypeDef *htim) {
@@ -752,69 +996,83 @@ void _cli_timer_handler(TIM_HandleTypeDef *htim) {
     cli_watch_flush_tx = 1;
 }
 
-char tx_buf[4096]   = {'\0'};
-char print_buf[256] = {'\0'};
-char *save_ptr      = NULL;
+#define CLI_WATCH_TRUNCATED "\033[K\r\n[output truncated]\033[K\r\n"
+#define CLI_WATCH_FOOTER    "\r\nPress CTRL+C to stop\r\n\033[J"
+
+char tx_buf[CLI_OUT_SIZE] = {'\0'};
+// A frame bigger than the TX ring would be dropped as a whole
+char print_buf[TX_RING_SIZE] = {'\0'};
 void cli_watch_flush_handler() {
     char *argv[BUF_SIZE] = {NULL};
     uint16_t argc;
     char *to_print;
+    char *save_ptr;
+    str_writer_t writer;
 
-    if (cli_watch_flush_tx == 0)
+    if (cli_watch_flush_tx == 0 || cli_watch_execute_cmd == 0)
         return;
 
-    if (cli_watch_execute_cmd == 1) {
-        sprintf(
-            tx_buf,
-            "\033[HExecuting %s every %.0fms\033[K\r\n[%.2f]\033[K\r\n",
-            watch_buf,
-            TIM_TICKS_TO_MS(&HTIM_CLI, __HAL_TIM_GetAutoreload(&HTIM_CLI)),
-            HAL_GetTick() / 1000.0);
-
-        argc = _cli_get_args(watch_buf, argv);
+    // Keep the room for the end of the frame while the output of the command is added
+    str_writer_init(&writer, print_buf, sizeof(print_buf) - (sizeof(CLI_WATCH_TRUNCATED) - 1) - (sizeof(CLI_WATCH_FOOTER) - 1));
+    str_writer_append(&writer, "\033[HExecuting ");
+    str_writer_append(&writer, watch_buf);
+    str_writer_append(&writer, " every ");
+    str_writer_append_float(&writer, TIM_TICKS_TO_MS(&HTIM_CLI, __HAL_TIM_GetAutoreload(&HTIM_CLI)), 0, 0);
+    str_writer_append(&writer, "ms\033[K\r\n[");
+    str_writer_append_fixed(&writer, HAL_GetTick(), 3, 2, 0);
+    str_writer_append(&writer, "]");
+    if (cli_watch_dropped > 0) {
+        str_writer_append(&writer, " ");
+        str_writer_append_uint(&writer, cli_watch_dropped, 0);
+        str_writer_append(&writer, " frames dropped, the serial is too slow for the interval");
+    }
+    str_writer_append(&writer, "\033[K\r\n");
 
-        // Check which command corresponds with the buffer
-        for (uint16_t i = 0; i < N_COMMANDS; i++) {
-            //size_t len = strlen(cli->cmds.names[i]);
+    argc = _cli_get_args(watch_buf, argv);
 
-            if (strcmp(argv[0], command_names[i]) == 0) {
-                commands[i](argc, argv, tx_buf + strlen(tx_buf));
-                break;
-            }
+    // Check which command corresponds with the buffer
+    for (uint16_t i = 0; i < N_COMMANDS; i++) {
+        //size_t len = strlen(cli->cmds.names[i]);
 
-            if (i == N_COMMANDS - 1) {
-                sprintf(tx_buf, "Command not found\r\n");
-                *watch_buf = '\0';
-                HAL_TIM_Base_Stop_IT(&HTIM_CLI);
-                HAL_UART_Transmit(&CLI_UART, (uint8_t *)tx_buf, strlen(tx_buf), 100);
-                return;
-            }
+        if (strcmp(argv[0], command_names[i]) == 0) {
+            commands[i](argc, argv, tx_buf);
+            break;
         }
 
-        sprintf(tx_buf + strlen(tx_buf), "\r\nPress CTRL+C to stop\r\n\033[J");
-
-        // restore watch_buf after splitting it in _cli_get_args
-        for (uint16_t i = 0; i < argc - 1; ++i) {
-            watch_buf[strlen(watch_buf)] = ' ';
+        if (i == N_COMMANDS - 1) {
+            *watch_buf = '\0';
+            HAL_TIM_Base_Stop_IT(&HTIM_CLI);
+            cli_bms_print("Command not found\r\n", 19);
+            cli_watch_execute_cmd = 0;
+            cli_watch_flush_tx = 0;
+            return;
         }
-        to_print = strtok_r(tx_buf, "\r\n", &save_ptr);
-
-        snprintf(print_buf, sizeof(print_buf), "%s\r\n", to_print);
+    }
 
-        HAL_UART_Transmit_IT(&CLI_UART, (uint8_t *)print_buf, strlen(print_buf));
-        cli_watch_execute_cmd = 0;
-    } else {
-        if (CLI_UART.gState != HAL_UART_STATE_BUSY_TX) {
-            to_print = strtok_r(NULL, "\r\n", &save_ptr);
+    // restore watch_buf after splitting it in _cli_get_args
+    for (uint16_t i = 0; i < argc - 1; ++i) {
+        watch_buf[strlen(watch_buf)] = ' ';
+    }
 
-            if (to_print != NULL) {
-                snprintf(print_buf, sizeof(print_buf), "%s\033[K\r\n", to_print);
-                HAL_UART_Transmit_IT(&CLI_UART, (uint8_t *)print_buf, strlen(print_buf));
-            } else {
-                cli_watch_flush_tx = 0;
-            }
-        }
+    // Clear the rest of each line and queue the whole output at once, the DMA sends it in background
+    to_print = strtok_r(tx_buf, "\r\n", &save_ptr);
+    while (to_print != NULL) {
+        str_writer_append(&writer, to_print);
+        str_writer_append(&writer, "\033[K\r\n");
+        to_print = strtok_r(NULL, "\r\n", &save_ptr);
     }
+    // Give back the room kept for the end of the frame
+    bool truncated = writer.truncated;
+    writer.size = sizeof(print_buf);
+    writer.truncated = false;
+    if (truncated)
+        str_writer_append(&writer, CLI_WATCH_TRUNCATED);
+    str_writer_append(&writer, CLI_WATCH_FOOTER);
+
+    if (!cli_bms_print(print_buf, writer.length))
+        ++cli_watch_dropped;
+    cli_watch_execute_cmd = 0;
+    cli_watch_flush_tx = 0;
 }
 
 uint8_t * bms_get_cellboard_distribution() {
@@ -825,25 +1083,30 @@ void bms_set_cellboard_distribution(uint8_t distribution[static 6]) {
     config_write(&cellboard_distribution);
 }
 void _cli_cellboard_distribution(uint16_t argc, char **argv, char *out) {
-    *out = '\0';
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (argc == 1) {
         uint8_t *distr = bms_get_cellboard_distribution();
         for (uint8_t i = 0; i < CELLBOARD_COUNT; ++i) {
-            sprintf(out + strlen(out), "%u ", distr[i]);
+            str_writer_append_uint(&writer, distr[i], 0);
+            str_writer_append(&writer, " ");
         }
-        sprintf(out + strlen(out), "\r\n");
+        str_writer_append(&writer, "\r\n");
     } else if (argc == 7) {
         uint8_t distr[CELLBOARD_COUNT];
         for (uint8_t i = 1; i < argc; ++i) {
             uint8_t pos = atoi(argv[i]);
             if (pos < 0 || pos > 5) {
-                sprintf(out + strlen(out), "Index out of range: %u\r\n", pos);
+                str_writer_append(&writer, "Index out of range: ");
+                str_writer_append_uint(&writer, pos, 0);
+                str_writer_append(&writer, "\r\n");
                 return;
             }
 
             for (uint8_t j = 0; j < i - 1; ++j) {
                 if (pos == distr[j]) {
-                    sprintf(out + strlen(out), "Non puoi ripetere la stessa cella piu' di una volta\r\n");
+                    str_writer_append(&writer, "Non puoi ripetere la stessa cella piu' di una volta\r\n");
                     return;
                 }
             }
@@ -852,10 +1115,10 @@ void _cli_cellboard_distribution(uint16_t argc, char **argv, char *out) {
         }
 
         bms_set_cellboard_distribution(distr);
-        sprintf(out + strlen(out), "Distribuzione delle cellboard aggiornata con successo\r\n");
+        str_writer_append(&writer, "Distribuzione delle cellboard aggiornata con successo\r\n");
     } else {
-        sprintf(
-            out,
+        str_writer_append(
+            &writer,
             "Invalid sintax\r\n"
             "Available commands are:\r\n"
             "\t-<empty>: show the current cell distribution\r\n"
@@ -864,41 +1127,115 @@ void _cli_cellboard_distribution(uint16_t argc, char **argv, char *out) {
 }
 
 void _cli_fans(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (argc == 2) {
         if (strcmp(argv[1], "auto") == 0) {
             fans_set_override(false);
-            sprintf(out, "Fans speed set to auto\r\n");
+            str_writer_append(&writer, "Fans speed set to auto\r\n");
         }
         else if (strcmp(argv[1], "off") == 0) {
             fans_set_override(true);
             fans_set_speed(0);
-            sprintf(out, "Fans turned off\r\n");
+            str_writer_append(&writer, "Fans turned off\r\n");
+        }
+        else if (strcmp(argv[1], "status") == 0) {
+            str_writer_append(&writer, fans_is_overrided() ? "mode:         override\r\n" : "mode:         auto\r\n");
+            str_writer_append(&writer, "speed:        ");
+            str_writer_append_float(&writer, fans_get_speed() * 100.f, 1, 0);
+            str_writer_append(&writer, "%\r\ntarget:       ");
+            str_writer_append_float(&writer, fans_control.target, 1, 0);
+            str_writer_append(&writer, "C\r\nlosses:       ");
+            str_writer_append_float(&writer, fans_control.losses, 0, 0);
+            str_writer_append(&writer, "W\r\nfeed-forward: ");
+            str_writer_append_float(&writer, fans_control.feed_forward * 100.f, 1, 0);
+            str_writer_append(&writer, "%\r\nintegral:     ");
+            str_writer_append_float(&writer, fans_control.integral * 100.f, 1, 0);
+            str_writer_append(&writer, "%\r\n");
         } else {
             uint8_t perc = atoi(argv[1]);
             if (perc <= 100) {
                 fans_set_override(true);
                 fans_set_speed(perc / 100.0);
-                sprintf(out, "Fans speed set to %d\r\n", perc);
+                str_writer_append(&writer, "Fans speed set to ");
+                str_writer_append_uint(&writer, perc, 0);
+                str_writer_append(&writer, "\r\n");
             } else {
-                sprintf(out, "Invalid perc value: %d\r\nIt must be between 0 and 100", perc);
+                str_writer_append(&writer, "Invalid perc value: ");
+                str_writer_append_uint(&writer, perc, 0);
+                str_writer_append(&writer, "\r\nIt must be between 0 and 100");
             }
         }
     } else {
-        sprintf(out, "Invalid sintax.\r\n Use this way: fans <perc>\r\n");
+        str_writer_append(&writer, "Invalid sintax.\r\n Use this way: fans <perc>|auto|off|status\r\n");
+    }
+}
+
+void _cli_telemetry(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
+    if (argc < 2) {
+        str_writer_append(
+            &writer,
+            "Invalid number of parameters.\r\n\n"
+            "valid parameters:\r\n"
+            "- <rate>: stream 1-");
+        str_writer_append_uint(&writer, TELEMETRY_MAX_RATE, 0);
+        str_writer_append(
+            &writer,
+            " binary snapshots per second\r\n"
+            "- off: stop the stream\r\n"
+            "- status\r\n");
+    } else if (strcmp(argv[1], "off") == 0) {
+        telemetry_period = 0;
+        str_writer_append(&writer, "telemetry stream stopped\r\n");
+    } else if (strcmp(argv[1], "status") == 0) {
+        if (telemetry_period == 0) {
+            str_writer_append(&writer, "telemetry stream: off\r\n");
+        } else {
+            str_writer_append(&writer, "telemetry stream: ");
+            str_writer_append_uint(&writer, 1000U / telemetry_period, 0);
+            str_writer_append(&writer, " snapshots/s\r\n");
+        }
+        str_writer_append(&writer, "snapshot size: ");
+        str_writer_append_uint(&writer, TELEMETRY_STREAM_SIZE, 0);
+        str_writer_append(&writer, " bytes\r\ndropped: ");
+        str_writer_append_uint(&writer, cli_tx_ring.dropped, 0);
+        str_writer_append(&writer, " messages\r\n");
+    } else {
+        uint32_t rate = atoi(argv[1]);
+        if (rate >= 1 && rate <= TELEMETRY_MAX_RATE) {
+            telemetry_period = 1000U / rate;
+            telemetry_last = HAL_GetTick();
+            str_writer_append(&writer, "streaming ");
+            str_writer_append_uint(&writer, rate, 0);
+            str_writer_append(&writer, " snapshots/s, decode them with scripts/telemetry_decode.py\r\n");
+        } else {
+            str_writer_append(&writer, "Invalid rate: ");
+            str_writer_append(&writer, argv[1]);
+            str_writer_append(&writer, "\r\nIt must be between 1 and ");
+            str_writer_append_uint(&writer, TELEMETRY_MAX_RATE, 0);
+            str_writer_append(&writer, "\r\n");
+        }
     }
 }
 
 void _cli_pack(uint16_t argc, char **argv, char *out) {
+    str_writer_t writer;
+    str_writer_init(&writer, out, CLI_OUT_SIZE);
+
     if (argc == 1) {
-        sprintf(out,
-            "AIR- status:      %s\r\n"
-            "AIR+ status:      %s\r\n"
-            "Precharge status: %s\r\n"
-            "Fault status:     %s\r\n",
-            (pack_get_airn_off() == AIRN_ON_VALUE ? "closed" : "open"),
-            (pack_get_airp_off() == AIRP_ON_VALUE ? "closed" : "open"),
-            (pack_get_precharge() == PRECHARGE_ON_VALUE ? "on" : "off"),
-            (pack_get_fault() == BMS_FAULT_ON_VALUE ? "on" : "off"));
+        str_writer_append(&writer, "AIR- status:      ");
+        str_writer_append(&writer, pack_get_airn_off() == AIRN_ON_VALUE ? "closed" : "open");
+        str_writer_append(&writer, "\r\nAIR+ status:      ");
+        str_writer_append(&writer, pack_get_airp_off() == AIRP_ON_VALUE ? "closed" : "open");
+        str_writer_append(&writer, "\r\nPrecharge status: ");
+        str_writer_append(&writer, pack_get_precharge() == PRECHARGE_ON_VALUE ? "on" : "off");
+        str_writer_append(&writer, "\r\nFault status:     ");
+        str_writer_append(&writer, pack_get_fault() == BMS_FAULT_ON_VALUE ? "on" : "off");
+        str_writer_append(&writer, "\r\n");
     }
     else if (argc == 3) {
         uint8_t value;
@@ -932,7 +1269,10 @@ void _cli_pack(uint16_t argc, char **argv, char *out) {
             pack_set_fault(value);
         }
 
-        sprintf(out, "%s set %s\r\n", argv[1], argv[2]);
+        str_writer_append(&writer, argv[1]);
+        str_writer_append(&writer, " set ");
+        str_writer_append(&writer, argv[2]);
+        str_writer_append(&writer, "\r\n");
     } else if (argc == 2) {
     }
 }
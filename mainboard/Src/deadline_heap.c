@@ -0,0 +1,119 @@
+/**
+ * @file deadline_heap.c
+ * @brief Min-heap of the deadlines of a set of periodic events
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "deadline_heap.h"
+
+#include <string.h>
+
+/** @brief Compare two times taking into account the wrap around */
+bool _deadline_heap_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+/** @brief Deadline of the entry at the given position of the heap */
+uint32_t _deadline_heap_at(deadline_heap_t * heap, size_t pos) {
+    return heap->entries[heap->heap[pos]].deadline;
+}
+
+void _deadline_heap_swap(deadline_heap_t * heap, size_t a, size_t b) {
+    uint8_t tmp = heap->heap[a];
+    heap->heap[a] = heap->heap[b];
+    heap->heap[b] = tmp;
+}
+
+void _deadline_heap_sift_up(deadline_heap_t * heap, size_t pos) {
+    while (pos > 0) {
+        size_t parent = (pos - 1) / 2;
+        if (!_deadline_heap_before(_deadline_heap_at(heap, pos), _deadline_heap_at(heap, parent)))
+            break;
+        _deadline_heap_swap(heap, pos, parent);
+        pos = parent;
+    }
+}
+
+void _deadline_heap_sift_down(deadline_heap_t * heap, size_t pos) {
+    for (;;) {
+        size_t smallest = pos;
+        size_t left = 2 * pos + 1;
+        size_t right = left + 1;
+        if (left < heap->count && _deadline_heap_before(_deadline_heap_at(heap, left), _deadline_heap_at(heap, smallest)))
+            smallest = left;
+        if (right < heap->count && _deadline_heap_before(_deadline_heap_at(heap, right), _deadline_heap_at(heap, smallest)))
+            smallest = right;
+        if (smallest == pos)
+            break;
+        _deadline_heap_swap(heap, pos, smallest);
+        pos = smallest;
+    }
+}
+
+void deadline_heap_init(deadline_heap_t * heap) {
+    memset(heap, 0, sizeof(*heap));
+}
+
+int32_t deadline_heap_add(deadline_heap_t * heap, uint32_t timeout, uint32_t now) {
+    if (heap->count >= DEADLINE_HEAP_CAPACITY)
+        return -1;
+
+    size_t index = heap->count;
+    deadline_heap_entry_t * entry = &heap->entries[index];
+    entry->timeout = timeout;
+    entry->last_reset = now;
+    entry->deadline = now + timeout;
+    entry->misses = 0;
+
+    heap->heap[heap->count++] = (uint8_t)index;
+    _deadline_heap_sift_up(heap, index);
+    return (int32_t)index;
+}
+
+void deadline_heap_reset(deadline_heap_t * heap, size_t index, uint32_t now) {
+    if (index >= heap->count)
+        return;
+    heap->entries[index].last_reset = now;
+    heap->entries[index].misses = 0;
+}
+
+int32_t deadline_heap_check(deadline_heap_t * heap, uint32_t now) {
+    while (heap->count > 0) {
+        deadline_heap_entry_t * entry = &heap->entries[heap->heap[0]];
+        if (_deadline_heap_before(now, entry->deadline))
+            return -1;
+
+        uint32_t deadline = entry->last_reset + entry->timeout;
+        if (_deadline_heap_before(now, deadline)) {
+            // Reset after the deadline was stored, move it to its real place
+            entry->deadline = deadline;
+            _deadline_heap_sift_down(heap, 0);
+            continue;
+        }
+
+        // Expired, check it again after another timeout
+        int32_t index = heap->heap[0];
+        if (entry->misses < UINT16_MAX)
+            ++entry->misses;
+        entry->deadline = now + entry->timeout;
+        _deadline_heap_sift_down(heap, 0);
+        return index;
+    }
+    return -1;
+}
+
+bool deadline_heap_is_expired(deadline_heap_t * heap, size_t index) {
+    return index < heap->count && heap->entries[index].misses > 0;
+}
+
+uint16_t deadline_heap_get_misses(deadline_heap_t * heap, size_t index) {
+    return index < heap->count ? heap->entries[index].misses : 0U;
+}
+
+uint32_t deadline_heap_time_left(deadline_heap_t * heap, uint32_t now) {
+    if (heap->count == 0)
+        return UINT32_MAX;
+    uint32_t deadline = _deadline_heap_at(heap, 0);
+    return _deadline_heap_before(now, deadline) ? deadline - now : 0U;
+}
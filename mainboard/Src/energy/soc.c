@@ -46,7 +46,7 @@ void soc_init() {
 void soc_sample_energy(uint32_t timestamp) {
     soc_params params = *(soc_params *)config_get(&soc_config);
 
-    float vbat = internal_voltage_get_bat() * 1.8f / 4095;
+    float vbat = CONVERT_VALUE_TO_INTERNAL_ADC_VOLTAGE(internal_voltage_get_bat());
 
     // Sample current values for SoC calculation
     energy_sample_energy(&energy_total, (current_get_current() * vbat) / 10.0f, timestamp);
@@ -75,7 +75,7 @@ void soc_reset_soc() {
 
 float soc_get_soc() {
     // Compute state of charge based on nominal energy
-    return energy_get_wh(energy_last_charge) / (PACK_ENERGY_NOMINAL / 10.0) * 100;
+    return energy_get_wh(energy_last_charge) / (PACK_ENERGY_NOMINAL / 10.f) * 100.f;
 }
 
 float soc_get_energy_total() {
@@ -18,9 +18,11 @@
 #include <string.h>
 
 bool override_fans_speed = false;
+fans_control_t fans_control;
 
 void fans_init() {
     override_fans_speed = false;
+    fans_control_init(&fans_control, FANS_CONTROL_TARGET_TEMP);
 
     // Enable CH3N (disabled by default)
     TIM_CCxChannelCmd(HTIM_PWM.Instance, TIM_CHANNEL_3, TIM_CCxN_ENABLE);
@@ -33,6 +35,11 @@ bool fans_is_overrided() {
     return override_fans_speed;
 }
 void fans_set_override(bool override) {
+    // Restart the controller from the current speed when going back to auto
+    if (override_fans_speed && !override) {
+        fans_control_init(&fans_control, FANS_CONTROL_TARGET_TEMP);
+        fans_control.speed = fans_get_speed();
+    }
     override_fans_speed = override;
 }
 float fans_get_speed() {
@@ -45,17 +52,16 @@ float fans_get_speed() {
     return (float)cmp / (float)arr;
 }
 void fans_set_speed(float power) {
-    if (power > 1.f || power < 0.f)
-        return;
+    power = MAX(0.f, MIN(power, 1.f));
     pwm_set_duty_cicle(&HTIM_PWM, PWM_FANS_CHANNEL, power);
 }
-float fans_curve(float temp) {
-    if (temp <= CELL_MIN_TEMPERATURE) return 0.f;
-    if (temp >= CELL_MAX_TEMPERATURE) return 1.f;
-
-    if (temp < 30.f) return 0.f;
-    if (temp > 45.f) return 1.f;
-    return 1.5f * (temp - 30.f) / 25.f + 0.1f;
+void fans_sample_current(float current) {
+    fans_control_sample_current(&fans_control, current);
+}
+void fans_routine(float max_temp, float dt) {
+    if (override_fans_speed)
+        return;
+    fans_set_speed(fans_control_update(&fans_control, max_temp, dt));
 }
 
 
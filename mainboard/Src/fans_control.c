@@ -0,0 +1,76 @@
+/**
+ * @file fans_control.c
+ * @brief Closed-loop control of the speed of the fans
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "fans_control.h"
+
+#include <string.h>
+
+float _fans_control_clamp(float value, float min, float max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+void fans_control_init(fans_control_t * control, float target) {
+    memset(control, 0, sizeof(*control));
+    control->target = target;
+}
+
+void fans_control_sample_current(fans_control_t * control, float current) {
+    control->current_sq += current * current;
+    ++control->samples;
+}
+
+float fans_control_feed_forward(float losses, float target) {
+    float delta = target - FANS_CONTROL_AMBIENT_TEMP;
+    if (losses <= 0.f)
+        return 0.f;
+    if (delta <= 0.f)
+        return 1.f;
+    // At steady state losses = (G_off + G_fans * speed) * (target - ambient)
+    float speed = (losses / delta - FANS_CONTROL_CONDUCTANCE_OFF) / FANS_CONTROL_CONDUCTANCE_FANS;
+    return _fans_control_clamp(speed, 0.f, 1.f);
+}
+
+float fans_control_update(fans_control_t * control, float temp, float dt) {
+    if (control->samples > 0) {
+        float losses = control->current_sq / control->samples * FANS_CONTROL_PACK_RESISTANCE;
+        control->losses += (losses - control->losses) * dt / (FANS_CONTROL_LOSSES_TIME_CONSTANT + dt);
+        control->current_sq = 0.f;
+        control->samples = 0;
+    }
+    control->feed_forward = fans_control_feed_forward(control->losses, control->target);
+
+    float error = temp - control->target;
+    float integral = _fans_control_clamp(control->integral + FANS_CONTROL_KI * error * dt, -1.f, 1.f);
+    float output = control->feed_forward + FANS_CONTROL_KP * error + integral;
+
+    // Limit the output and its rate of change, the ramp starts from the minimum speed
+    bool running = control->speed >= FANS_CONTROL_MIN_SPEED;
+    float request = _fans_control_clamp(output, 0.f, 1.f);
+    float speed = request;
+    if (error >= FANS_CONTROL_EMERGENCY_DELTA)
+        speed = 1.f;
+    else if (running)
+        speed = _fans_control_clamp(speed, control->speed - FANS_CONTROL_RAMP_DOWN * dt, control->speed + FANS_CONTROL_RAMP_UP * dt);
+    else
+        speed = _fans_control_clamp(speed, 0.f, FANS_CONTROL_MIN_SPEED + FANS_CONTROL_RAMP_UP * dt);
+
+    // The fans stall below the minimum speed: start them only when it is reached
+    // and stop them only when the request drops well below it
+    if (speed < FANS_CONTROL_MIN_SPEED)
+        speed = (running && request >= FANS_CONTROL_MIN_SPEED / 2.f) ? FANS_CONTROL_MIN_SPEED : 0.f;
+
+    // Anti-windup: keep the integral only if it does not push further past the limits.
+    // Below the target with the fans off there is nothing to correct, above it the
+    // integral is needed to reach the minimum speed
+    bool limited_up = error > 0.f && output > speed && speed > 0.f;
+    bool limited_down = error < 0.f && (output < speed || speed == 0.f);
+    if (!limited_up && !limited_down)
+        control->integral = integral;
+
+    control->speed = speed;
+    return speed;
+}
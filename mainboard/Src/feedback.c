@@ -10,6 +10,7 @@
 
 #include "feedback.h"
 
+#include <stdint.h>
 #include <string.h>
 
 #include "error_simple.h"
@@ -41,11 +42,13 @@
 #define FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_L 1.7f // 1.3f // V
 #define FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_H 3.4f // 1.8f // 1.7f // V
 
-#define MUX_INTERVAL_MS 0.1 // ms
+#define FEEDBACK_MUX_SETTLING_MS 0.1f // ms
+#define FEEDBACK_SWEEP_IDLE_MS 3.f    // ms
+#define FEEDBACK_MUX_CHANNEL ADC_CHANNEL_4
 #define DMA_DATA_SIZE 5
 
 // Dma data indices
-#define DMA_DATA_MUX_FB 3
+#define DMA_DATA_MUX_FB 3 // Not used, the multiplexer is converted as an injected channel
 #define DMA_DATA_SD_OUT 4
 #define DMA_DATA_SD_IN  2
 #define DMA_DATA_SD_BMS 1
@@ -58,17 +61,42 @@
 #define FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(VALUE) ((uint16_t)((VALUE) * 4095 / FEEDBACK_MUX_VREF))
 #define FEEDBACK_CONVERT_VOLTAGE_TO_ADC_SD(VALUE) ((uint16_t)((VALUE) * 4095 / FEEDBACK_SD_VREF))
 
-#define FEEDBACK_UPDATE_THRESHOLD_MS (MUX_INTERVAL_MS * (FEEDBACK_MUX_N + 2))
-
 #define FEEDBACK_QUEUE_SIZE 5
+#define FEEDBACK_HISTORY_BITS 2
+#define FEEDBACK_HISTORY_MASK ((1U << FEEDBACK_HISTORY_BITS) - 1U)
+#define FEEDBACK_HISTORY_FULL_MASK ((1U << (FEEDBACK_HISTORY_BITS * FEEDBACK_QUEUE_SIZE)) - 1U)
+#define FEEDBACK_STATE_N 3
+
+/** @brief Thresholds used to classify a single feedback sample (ADC value) */
+typedef struct {
+    uint16_t low;  // Samples below or equal to this value are logic low
+    uint16_t high; // Samples above or equal to this value are logic high
+    bool window;   // If true the sample is valid (logic high) only between the two thresholds
+} feedback_threshold_t;
+
+/** @brief Thresholds of each feedback with and without the handcart connected */
+feedback_threshold_t feedback_thresholds[2][FEEDBACK_N];
 
 struct {
-    uint16_t voltages[FEEDBACK_N][FEEDBACK_QUEUE_SIZE];
-    uint8_t index[FEEDBACK_N];
-    bool has_converted;
+    uint16_t last[FEEDBACK_N];                      // Last sample of each feedback
+    uint16_t history[FEEDBACK_N];                   // State of the last FEEDBACK_QUEUE_SIZE samples
+    uint8_t count[FEEDBACK_N][FEEDBACK_STATE_N];    // Number of samples of each state in the history
+    volatile feedback_t low;                        // Feedbacks whose majority of samples is low
+    volatile feedback_t high;                       // Feedbacks whose majority of samples is high
+    volatile feedback_t error;                      // Feedbacks without a clear majority or out of range
+    volatile uint32_t seq;                          // Incremented every time the bitmasks are updated
 } feedbacks;
 
+/** @brief Time to wait after the multiplexer is switched before converting each of its channels (ms) */
+float feedback_mux_settling_ms[FEEDBACK_MUX_N];
+
 uint8_t fb_index;
+bool fb_converting;
+volatile bool fb_sd_pending; // The shutdown feedbacks have been converted via DMA and wait to be classified
+uint32_t fb_sd_tick;         // Time of the DMA conversion (ms)
+
+feedback_capture_t feedback_capture;
+size_t fb_dump_offset;
 static uint16_t dma_data[DMA_DATA_SIZE] = { 0 };
 
 /** @brief Set the multiplexer index */
@@ -78,34 +106,48 @@ void _feedback_set_mux_index(uint8_t index) {
     HAL_GPIO_WritePin(MUX_A2_GPIO_Port, MUX_A2_Pin, (index & 0b00000100));
     HAL_GPIO_WritePin(MUX_A3_GPIO_Port, MUX_A3_Pin, (index & 0b00001000));
 }
-void _feedback_handle_tim_elapsed_irq() {
-    if (feedbacks.has_converted) {
-        _feedback_set_mux_index(fb_index);
-        feedbacks.has_converted = false;
-        HAL_ADC_Start_DMA(&ADC_MUX, (uint32_t *)dma_data, DMA_DATA_SIZE);
+
+/** @brief Convert the voltage thresholds to ADC values for both the profiles */
+void _feedback_init_thresholds() {
+    for (size_t handcart = 0; handcart < 2; ++handcart) {
+        for (size_t i = 0; i < FEEDBACK_N; ++i) {
+            feedback_threshold_t * th = &feedback_thresholds[handcart][i];
+            th->window = false;
+            if (i < FEEDBACK_MUX_N) {
+                th->low = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_L);
+                th->high = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_H);
+            }
+            else {
+                th->low = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_L);
+                th->high = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_H);
+            }
+        }
+
+        feedback_threshold_t * check_mux = &feedback_thresholds[handcart][FEEDBACK_CHECK_MUX_POS];
+        check_mux->window = true;
+        if (handcart) {
+            check_mux->low = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_L);
+            check_mux->high = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_H);
+
+            feedback_threshold_t * imd_fault = &feedback_thresholds[handcart][FEEDBACK_IMD_FAULT_POS];
+            imd_fault->low = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_L);
+            imd_fault->high = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_H);
+        }
+        else {
+            check_mux->low = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_L);
+            check_mux->high = FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_H);
+        }
     }
 }
-void _feedback_handle_adc_cnv_cmpl_irq() {
-    if (!feedbacks.has_converted) {
-        size_t j = feedbacks.index[fb_index];
-
-        // Save DMA data
-        feedbacks.voltages[fb_index][j] = dma_data[DMA_DATA_MUX_FB];
-        feedbacks.voltages[FEEDBACK_SD_IN_POS][feedbacks.index[FEEDBACK_SD_IN_POS]]   = dma_data[DMA_DATA_SD_IN];
-        feedbacks.voltages[FEEDBACK_SD_OUT_POS][feedbacks.index[FEEDBACK_SD_OUT_POS]] = dma_data[DMA_DATA_SD_OUT];
-        feedbacks.voltages[FEEDBACK_SD_BMS_POS][feedbacks.index[FEEDBACK_SD_BMS_POS]] = dma_data[DMA_DATA_SD_BMS];
-        feedbacks.voltages[FEEDBACK_SD_IMD_POS][feedbacks.index[FEEDBACK_SD_IMD_POS]] = dma_data[DMA_DATA_SD_IMD];
-
-        // Update queue indices
-        feedbacks.index[fb_index] = (feedbacks.index[fb_index] + 1) % FEEDBACK_QUEUE_SIZE;
-        feedbacks.index[FEEDBACK_SD_IN_POS]  = (feedbacks.index[FEEDBACK_SD_IN_POS]  + 1) % FEEDBACK_QUEUE_SIZE;
-        feedbacks.index[FEEDBACK_SD_OUT_POS] = (feedbacks.index[FEEDBACK_SD_OUT_POS] + 1) % FEEDBACK_QUEUE_SIZE;
-        feedbacks.index[FEEDBACK_SD_BMS_POS] = (feedbacks.index[FEEDBACK_SD_BMS_POS] + 1) % FEEDBACK_QUEUE_SIZE;
-        feedbacks.index[FEEDBACK_SD_IMD_POS] = (feedbacks.index[FEEDBACK_SD_IMD_POS] + 1) % FEEDBACK_QUEUE_SIZE;
-
-        fb_index = (fb_index + 1) % FEEDBACK_MUX_N;
-        feedbacks.has_converted = true;
-    }
+
+FEEDBACK_STATE _feedback_classify(const feedback_threshold_t * th, uint16_t value) {
+    if (th->window)
+        return (value <= th->low || value >= th->high) ? FEEDBACK_STATE_ERROR : FEEDBACK_STATE_H;
+    if (value <= th->low)
+        return FEEDBACK_STATE_L;
+    if (value >= th->high)
+        return FEEDBACK_STATE_H;
+    return FEEDBACK_STATE_ERROR;
 }
 
 FEEDBACK_STATE _feedback_get_majority(size_t low, size_t high, size_t error) {
@@ -116,324 +158,284 @@ FEEDBACK_STATE _feedback_get_majority(size_t low, size_t high, size_t error) {
     return FEEDBACK_STATE_ERROR;
 }
 
-void feedback_init() {
-    // Start feedbacks timer
+/**
+ * @brief Classify a new sample of a feedback and update its state
+ * @details The counters of the states are updated incrementally by removing
+ * the oldest sample of the history, so the majority costs the same regardless
+ * of the queue size
+ *
+ * @param index The index of the feedback
+ * @param value The sample (ADC value)
+ */
+void _feedback_update(size_t index, uint16_t value) {
+    const feedback_threshold_t * th = &feedback_thresholds[is_handcart_connected ? 1 : 0][index];
+    FEEDBACK_STATE state = _feedback_classify(th, value);
+
+    uint16_t history = feedbacks.history[index];
+    FEEDBACK_STATE oldest = (history >> (FEEDBACK_HISTORY_BITS * (FEEDBACK_QUEUE_SIZE - 1))) & FEEDBACK_HISTORY_MASK;
+    --feedbacks.count[index][oldest];
+    ++feedbacks.count[index][state];
+    feedbacks.history[index] = ((history << FEEDBACK_HISTORY_BITS) | state) & FEEDBACK_HISTORY_FULL_MASK;
+    feedbacks.last[index] = value;
+
+    uint8_t * count = feedbacks.count[index];
+    FEEDBACK_STATE majority = _feedback_get_majority(
+        count[FEEDBACK_STATE_L],
+        count[FEEDBACK_STATE_H],
+        count[FEEDBACK_STATE_ERROR]);
+
+    feedback_t bit = (feedback_t)1 << index;
+    feedback_t low = feedbacks.low & ~bit;
+    feedback_t high = feedbacks.high & ~bit;
+    feedback_t error = feedbacks.error & ~bit;
+    if (majority == FEEDBACK_STATE_L)
+        low |= bit;
+    else if (majority == FEEDBACK_STATE_H)
+        high |= bit;
+    else
+        error |= bit;
+    feedbacks.low = low;
+    feedbacks.high = high;
+    feedbacks.error = error;
+}
+
+/**
+ * @brief Get a consistent copy of the feedbacks bitmasks
+ * @details The bitmasks are only written inside the injected conversion
+ * interrupt, if it fires while they are being read the sequence number
+ * changes and the copy is repeated
+ */
+void _feedback_get_masks(feedback_t * low, feedback_t * high, feedback_t * error) {
+    uint32_t seq;
+    do {
+        seq = feedbacks.seq;
+        *low = feedbacks.low;
+        *high = feedbacks.high;
+        *error = feedbacks.error;
+    } while (seq != feedbacks.seq);
+}
+
+/** @brief Classify the shutdown feedbacks converted via DMA */
+void _feedback_update_sd() {
+    feedback_capture_add(&feedback_capture, FEEDBACK_SD_IN_POS, dma_data[DMA_DATA_SD_IN], fb_sd_tick);
+    feedback_capture_add(&feedback_capture, FEEDBACK_SD_OUT_POS, dma_data[DMA_DATA_SD_OUT], fb_sd_tick);
+    feedback_capture_add(&feedback_capture, FEEDBACK_SD_BMS_POS, dma_data[DMA_DATA_SD_BMS], fb_sd_tick);
+    feedback_capture_add(&feedback_capture, FEEDBACK_SD_IMD_POS, dma_data[DMA_DATA_SD_IMD], fb_sd_tick);
+
+    _feedback_update(FEEDBACK_SD_IN_POS, dma_data[DMA_DATA_SD_IN]);
+    _feedback_update(FEEDBACK_SD_OUT_POS, dma_data[DMA_DATA_SD_OUT]);
+    _feedback_update(FEEDBACK_SD_BMS_POS, dma_data[DMA_DATA_SD_BMS]);
+    _feedback_update(FEEDBACK_SD_IMD_POS, dma_data[DMA_DATA_SD_IMD]);
+}
+
+/**
+ * @brief Start the feedbacks timer, when it elapses the current multiplexer
+ * channel is converted
+ *
+ * @param ms The time to wait (ms)
+ */
+void _feedback_start_timer(float ms) {
+    __HAL_TIM_SET_COUNTER(&HTIM_MUX, 0);
+    __HAL_TIM_SET_AUTORELOAD(&HTIM_MUX, TIM_MS_TO_TICKS(&HTIM_MUX, ms));
     __HAL_TIM_CLEAR_IT(&HTIM_MUX, TIM_IT_UPDATE);
-    __HAL_TIM_SET_AUTORELOAD(&HTIM_MUX, TIM_MS_TO_TICKS(&HTIM_MUX, MUX_INTERVAL_MS));
     HAL_TIM_Base_Start_IT(&HTIM_MUX);
+}
 
-    // Start microseconds timer
-    // HAL_TIM_Base_Start(&HTIM_US);
+/*
+ * A sweep of the feedbacks works as follows:
+ * 1. The multiplexer is switched and the timer waits for the channel to settle
+ * 2. The timer interrupt starts a single injected conversion of the multiplexer output
+ * 3. The injected conversion interrupt saves the sample and goes back to 1. with the next channel
+ * 4. After the last channel the regular group converts the shutdown feedbacks via DMA
+ *    and the timer waits FEEDBACK_SWEEP_IDLE_MS before the next sweep
+ * So a complete sweep takes 2 * FEEDBACK_MUX_N + 1 interrupts.
+ * The DMA interrupt only marks the shutdown feedbacks as converted, they are
+ * classified by the next injected conversion interrupt, so the states and the
+ * capture are written by a single interrupt and never updated concurrently
+ */
+void _feedback_handle_tim_elapsed_irq() {
+    HAL_TIM_Base_Stop_IT(&HTIM_MUX);
+    if (!fb_converting) {
+        fb_converting = true;
+        HAL_ADCEx_InjectedStart_IT(&ADC_MUX);
+    }
+}
+void _feedback_handle_adc_inj_cnv_cmpl_irq() {
+    if (!fb_converting)
+        return;
+    fb_converting = false;
+
+    // The buffer is not overwritten before the DMA is started again below
+    if (fb_sd_pending) {
+        fb_sd_pending = false;
+        _feedback_update_sd();
+    }
+
+    uint16_t value = HAL_ADCEx_InjectedGetValue(&ADC_MUX, ADC_INJECTED_RANK_1);
+    feedback_capture_add(&feedback_capture, fb_index, value, HAL_GetTick());
+    _feedback_update(fb_index, value);
+    ++feedbacks.seq;
 
+    fb_index = (fb_index + 1) % FEEDBACK_MUX_N;
+    _feedback_set_mux_index(fb_index);
+
+    if (fb_index == 0) {
+        HAL_ADC_Start_DMA(&ADC_MUX, (uint32_t *)dma_data, DMA_DATA_SIZE);
+        __HAL_DMA_DISABLE_IT(ADC_MUX.DMA_Handle, DMA_IT_HT);
+        _feedback_start_timer(MAX(FEEDBACK_SWEEP_IDLE_MS, feedback_mux_settling_ms[0]));
+    }
+    else
+        _feedback_start_timer(feedback_mux_settling_ms[fb_index]);
+}
+void _feedback_handle_adc_cnv_cmpl_irq() {
+    fb_sd_tick = HAL_GetTick();
+    fb_sd_pending = true;
+}
+
+/**
+ * @brief Set the debug flags of the feedbacks that are not in the expected state
+ *
+ * @param wrong The bitmask of the wrong feedbacks
+ */
+void _feedback_set_debug(feedback_t wrong) {
+    if (wrong & FEEDBACK_IMPLAUSIBILITY_DETECTED)
+        conv_debug.feedbacks_implausibility_detected = 1;
+    if (wrong & FEEDBACK_IMD_COCKPIT)
+        conv_debug.feedbacks_imd_cockpit = 1;
+    if (wrong & FEEDBACK_TSAL_GREEN_FAULT_LATCHED)
+        conv_debug.feedbacks_tsal_green_fault_latched = 1;
+    if (wrong & FEEDBACK_BMS_COCKPIT)
+        conv_debug.feedbacks_bms_cockpit = 1;
+    if (wrong & FEEDBACK_EXT_LATCHED)
+        conv_debug.feedbacks_ext_latched = 1;
+    if (wrong & FEEDBACK_TSAL_GREEN)
+        conv_debug.feedbacks_tsal_green = 1;
+    if (wrong & FEEDBACK_TS_OVER_60V_STATUS)
+        conv_debug.feedbacks_ts_over_60v_status = 1;
+    if (wrong & FEEDBACK_AIRN_STATUS)
+        conv_debug.feedbacks_airn_status = 1;
+    if (wrong & FEEDBACK_AIRP_STATUS)
+        conv_debug.feedbacks_airp_status = 1;
+    if (wrong & FEEDBACK_AIRP_GATE)
+        conv_debug.feedbacks_airp_gate = 1;
+    if (wrong & FEEDBACK_AIRN_GATE)
+        conv_debug.feedbacks_airn_gate = 1;
+    if (wrong & FEEDBACK_PRECHARGE_STATUS)
+        conv_debug.feedbacks_precharge_status = 1;
+    if (wrong & FEEDBACK_TSP_OVER_60V_STATUS)
+        conv_debug.feedbacks_tsp_over_60v_status = 1;
+    if (wrong & FEEDBACK_IMD_FAULT)
+        conv_debug.feedbacks_imd_fault = 1;
+    if (wrong & FEEDBACK_CHECK_MUX)
+        conv_debug.feedbacks_check_mux = 1;
+    if (wrong & FEEDBACK_SD_END)
+        conv_debug.feedbacks_sd_end = 1;
+    if (wrong & FEEDBACK_SD_OUT)
+        conv_debug.feedbacks_sd_out = 1;
+    if (wrong & FEEDBACK_SD_IN)
+        conv_debug.feedbacks_sd_in = 1;
+    if (wrong & FEEDBACK_SD_BMS)
+        conv_debug.feedbacks_sd_bms = 1;
+    if (wrong & FEEDBACK_SD_IMD)
+        conv_debug.feedbacks_sd_imd = 1;
+}
+
+void feedback_init() {
+    _feedback_init_thresholds();
+    feedback_capture_init(&feedback_capture);
+    fb_dump_offset = SIZE_MAX;
+
+    // Fill the history as if every feedback had been sampled at 0V
+    feedbacks.low = FEEDBACK_ALL;
+    feedbacks.high = 0;
+    feedbacks.error = 0;
     for (size_t i = 0; i < FEEDBACK_N; i++) {
-        memset(feedbacks.voltages[i], 0, FEEDBACK_QUEUE_SIZE * sizeof(uint16_t));
-        feedbacks.index[i] = 0;
+        feedbacks.history[i] = 0;
+        memset(feedbacks.count[i], 0, FEEDBACK_STATE_N * sizeof(uint8_t));
+        feedbacks.count[i][FEEDBACK_STATE_L] = FEEDBACK_QUEUE_SIZE;
+        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++)
+            _feedback_update(i, 0);
     }
-    feedbacks.has_converted = true;
+    feedbacks.seq = 0;
+
+    for (size_t i = 0; i < FEEDBACK_MUX_N; i++)
+        feedback_mux_settling_ms[i] = FEEDBACK_MUX_SETTLING_MS;
+
+    // Convert the multiplexer output as a single injected channel
+    ADC_InjectionConfTypeDef config = { 0 };
+    config.InjectedChannel = FEEDBACK_MUX_CHANNEL;
+    config.InjectedRank = 1;
+    config.InjectedNbrOfConversion = 1;
+    config.InjectedSamplingTime = ADC_SAMPLETIME_480CYCLES;
+    config.ExternalTrigInjecConvEdge = ADC_EXTERNALTRIGINJECCONVEDGE_NONE;
+    config.ExternalTrigInjecConv = ADC_INJECTED_SOFTWARE_START;
+    config.AutoInjectedConv = DISABLE;
+    config.InjectedDiscontinuousConvMode = DISABLE;
+    config.InjectedOffset = 0;
+    if (HAL_ADCEx_InjectedConfigChannel(&ADC_MUX, &config) != HAL_OK)
+        error_simple_set(ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY, FEEDBACK_CHECK_MUX_POS);
+
+    // Start the first sweep
+    fb_index = 0;
+    fb_converting = false;
+    fb_sd_pending = false;
+    _feedback_set_mux_index(fb_index);
+    _feedback_start_timer(feedback_mux_settling_ms[fb_index]);
 }
 
 float feedback_get_voltage(size_t index) {
+    if (index >= FEEDBACK_N)
+        return 0.f;
+    return feedback_get_voltage_from_raw(index, feedbacks.last[index]);
+}
+
+float feedback_get_voltage_from_raw(size_t index, uint16_t value) {
     if (index < FEEDBACK_MUX_N)
-        return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks.voltages[index][feedbacks.index[index]]);
+        return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(value);
     else if (index < FEEDBACK_N)
-        return FEEDBACK_CONVERT_ADC_SD_TO_VOLTAGE(feedbacks.voltages[index][feedbacks.index[index]]);
+        return FEEDBACK_CONVERT_ADC_SD_TO_VOLTAGE(value);
     return 0.f;
 }
 
-// TODO: Check all feedbacks and do not return false immediately
 bool feedback_is_ok(feedback_t mask, feedback_t value) {
-    for (size_t i = 0; i < FEEDBACK_N; i++) {
-        size_t low = 0, high = 0, error = 0;
-        feedback_t feedback = 1 << i;
-
-        // Skip feedbacks not in mask
-        if ((mask & feedback) == 0)
-            continue;
-
-        feedback_t fb_val = feedback & value;
-
-        // Check handcart
-        if (is_handcart_connected && i == FEEDBACK_IMD_FAULT_POS) {
-            for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-                // Check IMD fault for handcart
-                if (feedbacks.voltages[i][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_L))
-                    low++;
-                else if (feedbacks.voltages[i][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_H))
-                    high++;
-                else
-                    error++;
-            }
+    feedback_t low, high, error;
+    _feedback_get_masks(&low, &high, &error);
+
+    // The multiplexer check is always expected to be high
+    value |= FEEDBACK_CHECK_MUX;
+    feedback_t wrong = mask & ~((value & high) | (~value & low));
+
+    if (mask & FEEDBACK_CHECK_MUX) {
+        // TODO: Check for low state
+        if (wrong & FEEDBACK_CHECK_MUX) {
+            error_simple_set(ERROR_GROUP_ERROR_FEEDBACK, FEEDBACK_CHECK_MUX_POS);
+            conv_debug.feedbacks_check_mux = 1;
         }
-        else if (is_handcart_connected && i == FEEDBACK_CHECK_MUX_POS) {
-            for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-                // Check multiplexer VDC for handcart
-                if (feedbacks.voltages[i][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_H))
-                    error++;
-                else if (feedbacks.voltages[i][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_L))
-                    error++;
-                else
-                    high++;
-            }
-
-            FEEDBACK_STATE state = _feedback_get_majority(low, high, error);
-
-            // TODO: Check for low state
-            if (state == FEEDBACK_STATE_H)
-                error_simple_reset(ERROR_GROUP_ERROR_FEEDBACK, i);
-            else {
-                error_simple_set(ERROR_GROUP_ERROR_FEEDBACK, i);
-                conv_debug.feedbacks_check_mux = 1;
-                return false;
-            }
-            continue;
-        }
-        else if (i == FEEDBACK_CHECK_MUX_POS) {
-            for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-                // Check multiplexer VDC
-                if (feedbacks.voltages[i][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_H))
-                    error++;
-                else if(feedbacks.voltages[i][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_L))
-                    error++;
-                else
-                    high++;
-            }
-
-            FEEDBACK_STATE state = _feedback_get_majority(low, high, error);
-
-            // TODO: Check for low state
-            if (state == FEEDBACK_STATE_H)
-                error_simple_reset(ERROR_GROUP_ERROR_FEEDBACK, i);
-            else {
-                error_simple_set(ERROR_GROUP_ERROR_FEEDBACK, i);
-                conv_debug.feedbacks_check_mux = 1;
-                return false;
-            }
-            continue;
-        }
-        else if (i < FEEDBACK_MUX_N) {
-            for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-                if (feedbacks.voltages[i][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_L))
-                    low++;
-                else if (feedbacks.voltages[i][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_H))
-                    high++;
-                else
-                    error++;
-            }
-        }
-        else if (i < FEEDBACK_N) {
-            for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-                if (feedbacks.voltages[i][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_L))
-                    low++;
-                else if(feedbacks.voltages[i][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_H))
-                    high++;
-                else
-                    error++;
-            }
-        }
-        else {
-            error_simple_set(ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY, i);
-            return false;
-        }
-
-        FEEDBACK_STATE state = _feedback_get_majority(low, high, error);
-
-        // Check for errors
-        if (state == FEEDBACK_STATE_ERROR || (fb_val && state == FEEDBACK_STATE_L) || (!fb_val && state == FEEDBACK_STATE_H)) {
-            // error_simple_set(ERROR_GROUP_ERROR_FEEDBACK, i);
-            if (fsm_get_state() == STATE_TS_ON) {
-                switch (i) {
-                    case FEEDBACK_IMPLAUSIBILITY_DETECTED:
-                        conv_debug.feedbacks_implausibility_detected = 1;
-                        break;
-                    case FEEDBACK_IMD_COCKPIT:
-                        conv_debug.feedbacks_imd_cockpit = 1;
-                        break;
-                    case FEEDBACK_TSAL_GREEN_FAULT_LATCHED:
-                        conv_debug.feedbacks_tsal_green_fault_latched = 1;
-                        break;
-                    case FEEDBACK_BMS_COCKPIT:
-                        conv_debug.feedbacks_bms_cockpit = 1;
-                        break;
-                    case FEEDBACK_EXT_LATCHED:
-                        conv_debug.feedbacks_ext_latched = 1;
-                        break;
-                    case FEEDBACK_TSAL_GREEN:
-                        conv_debug.feedbacks_tsal_green = 1;
-                        break;
-                    case FEEDBACK_TS_OVER_60V_STATUS:
-                        conv_debug.feedbacks_ts_over_60v_status = 1;
-                        break;
-                    case FEEDBACK_AIRN_STATUS:
-                        conv_debug.feedbacks_airn_status = 1;
-                        break;
-                    case FEEDBACK_AIRP_STATUS:
-                        conv_debug.feedbacks_airp_status = 1;
-                        break;
-                    case FEEDBACK_AIRP_GATE:
-                        conv_debug.feedbacks_airp_gate = 1;
-                        break;
-                    case FEEDBACK_AIRN_GATE:
-                        conv_debug.feedbacks_airn_gate = 1;
-                        break;
-                    case FEEDBACK_PRECHARGE_STATUS:
-                        conv_debug.feedbacks_precharge_status = 1;
-                        break;
-                    case FEEDBACK_TSP_OVER_60V_STATUS:
-                        conv_debug.feedbacks_tsp_over_60v_status = 1;
-                        break;
-                    case FEEDBACK_IMD_FAULT:
-                        conv_debug.feedbacks_imd_fault = 1;
-                        break;
-                    case FEEDBACK_CHECK_MUX:
-                        conv_debug.feedbacks_check_mux = 1;
-                        break;
-                    case FEEDBACK_SD_END:
-                        conv_debug.feedbacks_sd_end = 1;
-                        break;
-                    case FEEDBACK_SD_OUT:
-                        conv_debug.feedbacks_sd_out = 1;
-                        break;
-                    case FEEDBACK_SD_IN:
-                        conv_debug.feedbacks_sd_in = 1;
-                        break;
-                    case FEEDBACK_SD_BMS:
-                        conv_debug.feedbacks_sd_bms = 1;
-                        break;
-                    case FEEDBACK_SD_IMD:
-                        conv_debug.feedbacks_sd_imd = 1;
-                        break;
-
-                    default:
-                        break;
-                }
-            }
-            return false;
-        }
-        // else
-        // error_simple_reset(ERROR_GROUP_ERROR_FEEDBACK, i);
-        error_simple_reset(ERROR_GROUP_ERROR_FEEDBACK_CIRCUITRY, i);
+        else
+            error_simple_reset(ERROR_GROUP_ERROR_FEEDBACK, FEEDBACK_CHECK_MUX_POS);
     }
-
-    return true;
+    if (wrong != 0 && fsm_get_state() == STATE_TS_ON)
+        _feedback_set_debug(wrong);
+    return wrong == 0;
 }
 
 feedback_feed_t feedback_get_state(size_t index) {
-    size_t queue_index = feedbacks.index[index];
-    size_t low = 0, high = 0, error = 0;
-
     feedback_feed_t feed = { 0 };
-    // Set voltage
-    feed.voltage = (index < FEEDBACK_MUX_N) ?
-        FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks.voltages[index][queue_index]) :
-        FEEDBACK_CONVERT_ADC_SD_TO_VOLTAGE(feedbacks.voltages[index][queue_index]);
-    
-    // Check handcart
-    if (is_handcart_connected && index == FEEDBACK_IMD_FAULT_POS) {
-        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-            // Check IMD fault for handcart
-            if (feedbacks.voltages[index][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_L)) {
-                low++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_L;
-            }
-            else if (feedbacks.voltages[index][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_H)) {
-                high++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_H;
-            }
-            else {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-        }
-    }
-    else if (is_handcart_connected && index == FEEDBACK_CHECK_MUX_POS) {
-        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-            // Check multiplexer VDC for handcart
-            if (feedbacks.voltages[index][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_H)) {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-            else if (feedbacks.voltages[index][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_L)) {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-            else {
-                high++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_H;
-            }
-        }
-
-        feed.real_state = _feedback_get_majority(low, high, error);
+    if (index >= FEEDBACK_N)
         return feed;
-    }
-    else if (index == FEEDBACK_CHECK_MUX_POS) {
-        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-            // Check multiplexer VDC
-            if (feedbacks.voltages[index][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_H)) {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-            else if(feedbacks.voltages[index][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_CHECK_MUX_THRESHOLD_L)) {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-            else {
-                high++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_H;
-            }
-        }
-        
-        feed.real_state = _feedback_get_majority(low, high, error);
-        return feed;
-    }
-    else if (index < FEEDBACK_MUX_N) {
-        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-            if (feedbacks.voltages[index][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_L)) {
-                low++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_L;
-            }
-            else if (feedbacks.voltages[index][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_MUX_ANALOG_THRESHOLD_H)) {
-                high++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_H;
-            }
-            else {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-        }
-    }
-    else if (index < FEEDBACK_N) {
-        for (size_t j = 0; j < FEEDBACK_QUEUE_SIZE; j++) {
-            if (feedbacks.voltages[index][j] <= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_L)) {
-                low++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_L;
-            }
-            else if(feedbacks.voltages[index][j] >= FEEDBACK_CONVERT_VOLTAGE_TO_ADC_MUX(FEEDBACK_SD_ANALOG_THRESHOLD_H)) {
-                high++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_H;
-            }
-            else {
-                error++;
-                if (j == queue_index)
-                    feed.cur_state = FEEDBACK_STATE_ERROR;
-            }
-        }
-    }
 
-    feed.real_state = _feedback_get_majority(low, high, error);
+    feedback_t low, high, error;
+    _feedback_get_masks(&low, &high, &error);
+
+    feedback_t bit = (feedback_t)1 << index;
+    feed.voltage = feedback_get_voltage(index);
+    feed.cur_state = feedbacks.history[index] & FEEDBACK_HISTORY_MASK;
+    if (high & bit)
+        feed.real_state = FEEDBACK_STATE_H;
+    else if (low & bit)
+        feed.real_state = FEEDBACK_STATE_L;
+    else
+        feed.real_state = FEEDBACK_STATE_ERROR;
     return feed;
 }
 void feedback_get_all_states(feedback_feed_t out_value[FEEDBACK_N]) {
@@ -441,20 +443,15 @@ void feedback_get_all_states(feedback_feed_t out_value[FEEDBACK_N]) {
         out_value[i] = feedback_get_state(i);
 }
 
-// bool _is_adc_value_low(uint8_t index) {
-//     if (index == FEEDBACK_CHECK_MUX_POS) {
-//         if (is_handcart_connected)
-//             return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks[index]) < FEEDBACK_CHECK_MUX_HANDCART_THRESHOLD_L;
-//         return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks[index]) < FEEDBACK_CHECK_MUX_THRESHOLD_L;
-//     }
-//     if (index == FEEDBACK_IMD_FAULT_POS && is_handcart_connected)
-//         return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks[index]) < FEEDBACK_IMD_FAULT_HANDCART_THRESHOLD_L;
-//     if (index == FEEDBACK_SD_END_POS)
-//         return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks[index]) < 0.5f;
-//     if (index == FEEDBACK_SD_IN_POS || index == FEEDBACK_SD_OUT_POS)
-//         return FEEDBACK_CONVERT_ADC_SD_TO_VOLTAGE(feedbacks[index]) < 0.5f;
-// 
-//     if (index < FEEDBACK_MUX_N)
-//         return FEEDBACK_CONVERT_ADC_MUX_TO_VOLTAGE(feedbacks[index]) < FEEDBACK_MUX_ANALOG_THRESHOLD_L;
-//     return FEEDBACK_CONVERT_ADC_SD_TO_VOLTAGE(feedbacks[index]) < FEEDBACK_SD_ANALOG_THRESHOLD_L;
-// }
+void feedback_dump_start() {
+    fb_dump_offset = 0;
+}
+bool feedback_dump_is_pending() {
+    return fb_dump_offset < feedback_capture_get_count(&feedback_capture);
+}
+bool feedback_dump_next(size_t * offset, feedback_capture_sample_t * sample) {
+    if (!feedback_capture_get_sample(&feedback_capture, fb_dump_offset, sample))
+        return false;
+    *offset = fb_dump_offset++;
+    return true;
+}
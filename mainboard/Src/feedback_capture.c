@@ -0,0 +1,97 @@
+/**
+ * @file feedback_capture.c
+ * @brief Capture of the raw feedback samples around an event
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "feedback_capture.h"
+
+#include <string.h>
+
+void feedback_capture_init(feedback_capture_t * capture) {
+    if (capture == NULL)
+        return;
+    memset(capture, 0, sizeof(feedback_capture_t));
+    capture->state = FEEDBACK_CAPTURE_STATE_IDLE;
+}
+
+bool feedback_capture_arm(feedback_capture_t * capture,
+    uint32_t mask,
+    FEEDBACK_CAPTURE_TRIGGER trigger,
+    size_t pre,
+    size_t post) {
+    if (capture == NULL || mask == 0 || trigger >= FEEDBACK_CAPTURE_TRIGGER_N)
+        return false;
+    if (post == 0 || pre + post > FEEDBACK_CAPTURE_SIZE)
+        return false;
+
+    // Stop the recording before changing the parameters
+    capture->state = FEEDBACK_CAPTURE_STATE_IDLE;
+    capture->trigger = trigger;
+    capture->mask = mask;
+    capture->pre = pre;
+    capture->post = post;
+    capture->head = 0;
+    capture->count = 0;
+    capture->trigger_pre = 0;
+    capture->trigger_post = 0;
+    capture->state = FEEDBACK_CAPTURE_STATE_ARMED;
+    return true;
+}
+
+void feedback_capture_trigger(feedback_capture_t * capture, FEEDBACK_CAPTURE_TRIGGER event) {
+    if (capture == NULL || capture->state != FEEDBACK_CAPTURE_STATE_ARMED)
+        return;
+    if (event != FEEDBACK_CAPTURE_TRIGGER_MANUAL && event != capture->trigger)
+        return;
+
+    capture->trigger_pre = capture->count < capture->pre ? capture->count : capture->pre;
+    capture->trigger_post = 0;
+    capture->state = FEEDBACK_CAPTURE_STATE_TRIGGERED;
+}
+
+void feedback_capture_add(feedback_capture_t * capture, size_t index, uint16_t value, uint32_t time) {
+    if (capture == NULL)
+        return;
+
+    FEEDBACK_CAPTURE_STATE state = capture->state;
+    if (state != FEEDBACK_CAPTURE_STATE_ARMED && state != FEEDBACK_CAPTURE_STATE_TRIGGERED)
+        return;
+    if ((capture->mask & ((uint32_t)1 << index)) == 0)
+        return;
+
+    feedback_capture_sample_t * sample = &capture->samples[capture->head];
+    sample->time = (uint16_t)time;
+    sample->value = value;
+    sample->index = (uint8_t)index;
+    capture->head = (capture->head + 1) % FEEDBACK_CAPTURE_SIZE;
+    if (capture->count < FEEDBACK_CAPTURE_SIZE)
+        ++capture->count;
+
+    if (state == FEEDBACK_CAPTURE_STATE_TRIGGERED && ++capture->trigger_post >= capture->post)
+        capture->state = FEEDBACK_CAPTURE_STATE_DONE;
+}
+
+size_t feedback_capture_get_count(const feedback_capture_t * capture) {
+    if (capture == NULL || capture->state != FEEDBACK_CAPTURE_STATE_DONE)
+        return 0;
+    return capture->trigger_pre + capture->trigger_post;
+}
+
+size_t feedback_capture_get_trigger_offset(const feedback_capture_t * capture) {
+    if (capture == NULL || capture->state != FEEDBACK_CAPTURE_STATE_DONE)
+        return 0;
+    return capture->trigger_pre;
+}
+
+bool feedback_capture_get_sample(const feedback_capture_t * capture, size_t offset, feedback_capture_sample_t * out) {
+    size_t count = feedback_capture_get_count(capture);
+    if (out == NULL || offset >= count)
+        return false;
+
+    // The last sample written is the last post-trigger one
+    size_t index = (capture->head + FEEDBACK_CAPTURE_SIZE - count + offset) % FEEDBACK_CAPTURE_SIZE;
+    *out = capture->samples[index];
+    return true;
+}
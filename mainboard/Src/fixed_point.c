@@ -0,0 +1,42 @@
+/**
+ * @file fixed_point.c
+ * @brief Fixed-point types of the measurement chain
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "fixed_point.h"
+
+/** @brief Shift right rounding to the nearest, ties towards +inf, and saturate */
+int32_t _fixed_round_shift(int64_t value, uint8_t shift) {
+    if (shift > 0)
+        value = (value + ((int64_t)1 << (shift - 1))) >> shift;
+    if (value > INT32_MAX)
+        return INT32_MAX;
+    if (value < INT32_MIN)
+        return INT32_MIN;
+    return (int32_t)value;
+}
+
+int32_t fixed_mul(int32_t a, int32_t b, uint8_t shift) {
+    return _fixed_round_shift((int64_t)a * b, shift);
+}
+
+fixed_voltage_t fixed_voltage_from_adc(uint32_t sum, uint32_t count, uint32_t full_scale, fixed_voltage_t vref) {
+    uint64_t den = (uint64_t)full_scale * count;
+    if (den == 0 || vref.q < 0)
+        return (fixed_voltage_t){ 0 };
+    uint64_t volt = ((uint64_t)sum * (uint32_t)vref.q + den / 2U) / den;
+    return (fixed_voltage_t){ volt > INT32_MAX ? INT32_MAX : (int32_t)volt };
+}
+
+fixed_current_t fixed_current_from_voltage(fixed_voltage_t volt, fixed_voltage_t offset, fixed_gain_t gain) {
+    int64_t product = ((int64_t)volt.q - offset.q) * gain.q;
+    return (fixed_current_t){ _fixed_round_shift(product, FIXED_VOLTAGE_FRAC + FIXED_GAIN_FRAC - FIXED_CURRENT_FRAC) };
+}
+
+fixed_current_t fixed_current_filter(fixed_current_t prev, fixed_current_t value, fixed_gain_t alpha) {
+    // value + alpha * (prev - value), with a single rounding
+    int64_t sum = (int64_t)value.q * ((int64_t)1 << FIXED_GAIN_FRAC) + ((int64_t)prev.q - value.q) * alpha.q;
+    return (fixed_current_t){ _fixed_round_shift(sum, FIXED_GAIN_FRAC) };
+}
@@ -0,0 +1,295 @@
+/**
+ * @file flash_fanout.c
+ * @brief Flash every cellboard at once through the mainboard
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "flash_fanout.h"
+
+#include <string.h>
+
+// XCP packet identifiers and commands used by the OpenBLT bootloader
+#define FLASH_FANOUT_XCP_PID_RES 0xFFU
+#define FLASH_FANOUT_XCP_PID_ERR 0xFEU
+#define FLASH_FANOUT_XCP_ERR_GENERIC 0x31U
+#define FLASH_FANOUT_XCP_CMD_CONNECT 0xFFU
+#define FLASH_FANOUT_XCP_CMD_SET_MTA 0xF6U
+#define FLASH_FANOUT_XCP_CMD_PROGRAM_CLEAR 0xD1U
+#define FLASH_FANOUT_XCP_CMD_PROGRAM 0xD0U
+#define FLASH_FANOUT_XCP_CMD_PROGRAM_RESET 0xCFU
+#define FLASH_FANOUT_XCP_CMD_PROGRAM_MAX 0xC9U
+
+#define FLASH_FANOUT_SET_MTA_LENGTH 8U
+
+void _flash_fanout_slot_write(flash_fanout_slot_t * slot, const uint8_t * data, uint8_t length) {
+    if (length > FLASH_FANOUT_DATA_SIZE)
+        length = FLASH_FANOUT_DATA_SIZE;
+    memcpy(slot->data, data, length);
+    slot->length = length;
+    __atomic_store_n(&slot->seq, (uint8_t)(slot->seq + 1U), __ATOMIC_RELEASE);
+}
+
+/** @brief Copy the content of a slot if it has been written since the last read */
+bool _flash_fanout_slot_read(flash_fanout_slot_t * slot, uint8_t * seen, uint8_t * data, uint8_t * length) {
+    for (;;) {
+        uint8_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == *seen)
+            return false;
+        *length = slot->length;
+        memcpy(data, slot->data, *length);
+        // Copy again if the slot has been overwritten in the meantime
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) == seq) {
+            *seen = seq;
+            return true;
+        }
+    }
+}
+
+uint32_t _flash_fanout_get_u32(const uint8_t * src) {
+    return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/** @brief Get the time given to a board to answer the current command */
+uint32_t _flash_fanout_timeout(flash_fanout_t * fanout) {
+    switch (fanout->command[0]) {
+        case FLASH_FANOUT_XCP_CMD_CONNECT:
+            return FLASH_FANOUT_CONNECT_TIMEOUT_MS;
+        case FLASH_FANOUT_XCP_CMD_PROGRAM_CLEAR:
+            return FLASH_FANOUT_ERASE_TIMEOUT_MS;
+        case FLASH_FANOUT_XCP_CMD_PROGRAM:
+            // An empty program command ends the programming, which writes the last blocks
+            return fanout->command[1] == 0 ? FLASH_FANOUT_ERASE_TIMEOUT_MS : FLASH_FANOUT_TIMEOUT_MS;
+        default:
+            return FLASH_FANOUT_TIMEOUT_MS;
+    }
+}
+
+uint8_t _flash_fanout_max_retries(flash_fanout_t * fanout) {
+    return fanout->command[0] == FLASH_FANOUT_XCP_CMD_CONNECT ? FLASH_FANOUT_CONNECT_RETRIES : FLASH_FANOUT_RETRIES;
+}
+
+/** @brief Check if the current command moves the address of the bootloader forward */
+bool _flash_fanout_moves_mta(flash_fanout_t * fanout) {
+    return fanout->command[0] == FLASH_FANOUT_XCP_CMD_PROGRAM_MAX ||
+        (fanout->command[0] == FLASH_FANOUT_XCP_CMD_PROGRAM && fanout->command[1] > 0);
+}
+
+/** @brief Update the address of a board after it has acknowledged the current command */
+void _flash_fanout_apply_mta(flash_fanout_t * fanout, flash_fanout_board_t * board) {
+    switch (fanout->command[0]) {
+        case FLASH_FANOUT_XCP_CMD_SET_MTA:
+            if (fanout->command_length >= FLASH_FANOUT_SET_MTA_LENGTH) {
+                board->mta = _flash_fanout_get_u32(fanout->command + 4);
+                board->mta_valid = true;
+            }
+            break;
+        case FLASH_FANOUT_XCP_CMD_PROGRAM:
+            board->mta += fanout->command[1];
+            break;
+        case FLASH_FANOUT_XCP_CMD_PROGRAM_MAX:
+            board->mta += FLASH_FANOUT_DATA_SIZE - 1U;
+            break;
+    }
+}
+
+void _flash_fanout_start(flash_fanout_t * fanout, const uint8_t * data, uint8_t length, uint32_t now) {
+    if (!fanout->active) {
+        // New session
+        fanout->active = true;
+        fanout->failed = 0U;
+        fanout->retransmissions = 0U;
+        fanout->commands = 0U;
+        for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i)
+            fanout->boards[i].mta_valid = false;
+    }
+
+    memcpy(fanout->command, data, length);
+    fanout->command_length = length;
+    fanout->pending = true;
+    fanout->answer_ready = false;
+    fanout->last_request = now;
+
+    for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+        flash_fanout_board_t * board = &fanout->boards[i];
+        board->state = (fanout->mask & ((uint32_t)1U << i)) ? FLASH_FANOUT_BOARD_SEND : FLASH_FANOUT_BOARD_IDLE;
+        board->retries = 0U;
+        board->answer_length = 0U;
+    }
+}
+
+void _flash_fanout_answer(flash_fanout_t * fanout, flash_fanout_board_t * board, const uint8_t * data, uint8_t length) {
+    bool positive = length > 0 && data[0] == FLASH_FANOUT_XCP_PID_RES;
+
+    if (board->state == FLASH_FANOUT_BOARD_WAIT) {
+        memcpy(board->answer, data, length);
+        board->answer_length = length;
+        board->state = positive ? FLASH_FANOUT_BOARD_DONE : FLASH_FANOUT_BOARD_FAILED;
+        if (positive)
+            _flash_fanout_apply_mta(fanout, board);
+    }
+    else if (board->state == FLASH_FANOUT_BOARD_WAIT_MTA) {
+        // The address is restored, send the command again
+        if (positive)
+            board->state = FLASH_FANOUT_BOARD_SEND;
+        else {
+            memcpy(board->answer, data, length);
+            board->answer_length = length;
+            board->state = FLASH_FANOUT_BOARD_FAILED;
+        }
+    }
+    // Otherwise it is a late answer to a command which has been sent again
+}
+
+void _flash_fanout_check_timeout(flash_fanout_t * fanout, flash_fanout_board_t * board, uint32_t now) {
+    if (board->state != FLASH_FANOUT_BOARD_WAIT && board->state != FLASH_FANOUT_BOARD_WAIT_MTA)
+        return;
+    if (now - board->sent_time < _flash_fanout_timeout(fanout))
+        return;
+
+    if (board->retries >= _flash_fanout_max_retries(fanout)) {
+        board->state = FLASH_FANOUT_BOARD_FAILED;
+        return;
+    }
+    ++board->retries;
+    ++fanout->retransmissions;
+
+    // The command could have been executed with only its answer lost
+    if (board->state == FLASH_FANOUT_BOARD_WAIT_MTA || (board->mta_valid && _flash_fanout_moves_mta(fanout)))
+        board->state = FLASH_FANOUT_BOARD_SEND_MTA;
+    else
+        board->state = FLASH_FANOUT_BOARD_SEND;
+}
+
+/** @brief Build the answer for the host once every board is done */
+void _flash_fanout_complete(flash_fanout_t * fanout) {
+    flash_fanout_board_t * reference = NULL;
+    flash_fanout_board_t * failed = NULL;
+    bool mismatch = false;
+
+    for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+        flash_fanout_board_t * board = &fanout->boards[i];
+        if (board->state == FLASH_FANOUT_BOARD_FAILED) {
+            fanout->failed |= (uint32_t)1U << i;
+            if (failed == NULL)
+                failed = board;
+        }
+        else if (board->state == FLASH_FANOUT_BOARD_DONE) {
+            if (reference == NULL)
+                reference = board;
+            else if (board->answer_length != reference->answer_length ||
+                memcmp(board->answer, reference->answer, board->answer_length) != 0)
+                mismatch = true;
+        }
+    }
+
+    if (failed != NULL && failed->answer_length > 0) {
+        // Forward the error of the bootloader
+        memcpy(fanout->answer, failed->answer, failed->answer_length);
+        fanout->answer_length = failed->answer_length;
+    }
+    else if (failed != NULL || reference == NULL || mismatch) {
+        fanout->answer[0] = FLASH_FANOUT_XCP_PID_ERR;
+        fanout->answer[1] = FLASH_FANOUT_XCP_ERR_GENERIC;
+        fanout->answer_length = 2U;
+    }
+    else {
+        memcpy(fanout->answer, reference->answer, reference->answer_length);
+        fanout->answer_length = reference->answer_length;
+        ++fanout->commands;
+    }
+
+    fanout->pending = false;
+    fanout->answer_ready = true;
+    if (fanout->command[0] == FLASH_FANOUT_XCP_CMD_PROGRAM_RESET)
+        fanout->active = false;
+}
+
+void flash_fanout_init(flash_fanout_t * fanout, uint32_t mask) {
+    memset(fanout, 0, sizeof(*fanout));
+    fanout->mask = mask & FLASH_FANOUT_ALL_BOARDS;
+}
+
+void flash_fanout_request(flash_fanout_t * fanout, const uint8_t * data, uint8_t length) {
+    _flash_fanout_slot_write(&fanout->request, data, length);
+}
+
+void flash_fanout_receive(flash_fanout_t * fanout, size_t board, const uint8_t * data, uint8_t length) {
+    if (board >= FLASH_FANOUT_BOARD_COUNT)
+        return;
+    _flash_fanout_slot_write(&fanout->boards[board].rx, data, length);
+}
+
+void flash_fanout_update(flash_fanout_t * fanout, uint32_t now) {
+    uint8_t data[FLASH_FANOUT_DATA_SIZE];
+    uint8_t length;
+
+    if (_flash_fanout_slot_read(&fanout->request, &fanout->request_seq, data, &length) && length > 0)
+        _flash_fanout_start(fanout, data, length, now);
+
+    for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+        flash_fanout_board_t * board = &fanout->boards[i];
+        if (_flash_fanout_slot_read(&board->rx, &board->rx_seq, data, &length))
+            _flash_fanout_answer(fanout, board, data, length);
+        _flash_fanout_check_timeout(fanout, board, now);
+    }
+
+    if (fanout->pending) {
+        bool done = true;
+        for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT && done; ++i) {
+            flash_fanout_board_state_t state = fanout->boards[i].state;
+            done = state == FLASH_FANOUT_BOARD_IDLE || state == FLASH_FANOUT_BOARD_DONE || state == FLASH_FANOUT_BOARD_FAILED;
+        }
+        if (done)
+            _flash_fanout_complete(fanout);
+    }
+    else if (fanout->active && now - fanout->last_request >= FLASH_FANOUT_SESSION_TIMEOUT_MS)
+        fanout->active = false;
+}
+
+int32_t flash_fanout_next(flash_fanout_t * fanout, uint32_t now, uint8_t * data, uint8_t * length) {
+    for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+        flash_fanout_board_t * board = &fanout->boards[i];
+
+        if (board->state == FLASH_FANOUT_BOARD_SEND_MTA) {
+            memset(data, 0, FLASH_FANOUT_SET_MTA_LENGTH);
+            data[0] = FLASH_FANOUT_XCP_CMD_SET_MTA;
+            data[4] = board->mta & 0xFF;
+            data[5] = (board->mta >> 8) & 0xFF;
+            data[6] = (board->mta >> 16) & 0xFF;
+            data[7] = (board->mta >> 24) & 0xFF;
+            *length = FLASH_FANOUT_SET_MTA_LENGTH;
+            board->state = FLASH_FANOUT_BOARD_WAIT_MTA;
+            board->sent_time = now;
+            return (int32_t)i;
+        }
+        if (board->state == FLASH_FANOUT_BOARD_SEND) {
+            memcpy(data, fanout->command, fanout->command_length);
+            *length = fanout->command_length;
+            board->state = FLASH_FANOUT_BOARD_WAIT;
+            board->sent_time = now;
+
+            // The bootloader starts the new firmware without answering
+            if (fanout->command[0] == FLASH_FANOUT_XCP_CMD_PROGRAM_RESET) {
+                board->answer[0] = FLASH_FANOUT_XCP_PID_RES;
+                board->answer_length = 1U;
+                board->state = FLASH_FANOUT_BOARD_DONE;
+            }
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+bool flash_fanout_get_answer(flash_fanout_t * fanout, uint8_t * data, uint8_t * length) {
+    if (!fanout->answer_ready)
+        return false;
+    memcpy(data, fanout->answer, fanout->answer_length);
+    *length = fanout->answer_length;
+    fanout->answer_ready = false;
+    return true;
+}
+
+bool flash_fanout_is_active(flash_fanout_t * fanout) {
+    return fanout->active;
+}
@@ -1,32 +1,43 @@
 #include "imd.h"
 
-#include <math.h>
-
 #include "feedback.h"
 #include "timer_utils.h"
 
-uint32_t periodTicks = 0, dutyCycleTicks = 0;
+imd_decoder_t imd_decoder;
+
 uint32_t icValRising = 0, icValFalling = 0;
+bool risingValid = false, fallingValid = false;
+uint32_t ticksPerMs = 1;
+
+uint32_t _imd_ticks_to_us(uint32_t ticks) {
+    return (uint32_t)((uint64_t)ticks * 1000U / ticksPerMs);
+}
 
 void imd_init() {
+    imd_decoder_init(&imd_decoder);
+    ticksPerMs = TIM_MS_TO_TICKS(&HTIM_IMD, 1);
+    if (ticksPerMs == 0)
+        ticksPerMs = 1;
+
     __HAL_TIM_CLEAR_FLAG(&HTIM_IMD, TIM_IT_CC4);  //clears existing interrupts on channel 4
     HAL_TIM_IC_Start_IT(&HTIM_IMD, TIM_CHANNEL_4);
 }
 
 float imd_get_duty_cycle_percentage() {
-    return imd_get_duty_cycle() * 100;
+    return imd_decoder_get_duty(&imd_decoder, HAL_GetTick()) / 100.f;
 }
 
 float imd_get_duty_cycle() {
-    return periodTicks == 0 ? 0 : ((float)dutyCycleTicks / periodTicks);
+    return imd_decoder_get_duty(&imd_decoder, HAL_GetTick()) / 10000.f;
 }
 
 uint8_t imd_get_freq() {
-    return periodTicks == 0 ? 0 : roundf(1000.0 / TIM_TICKS_TO_MS(&HTIM_IMD, periodTicks));
+    uint32_t period = imd_decoder_get_period(&imd_decoder, HAL_GetTick());
+    return period == 0 ? 0 : (1000000U + period / 2U) / period;
 }
 
 uint8_t imd_get_period() {
-    return roundf(TIM_TICKS_TO_MS(&HTIM_IMD, periodTicks));
+    return (imd_decoder_get_period(&imd_decoder, HAL_GetTick()) + 500U) / 1000U;
 }
 
 uint8_t imd_is_fault() {
@@ -34,48 +45,32 @@ uint8_t imd_is_fault() {
 }
 
 IMD_STATE imd_get_state() {
-    uint32_t freq = imd_get_freq();
-
-    if (freq == 0)
-        return IMD_SC;
-    if (freq == 10)
-        return IMD_NORMAL;
-    if (freq == 20)
-        return IMD_UNDER_VOLTAGE;
-    if (freq == 30)
-        return IMD_START_MEASURE;
-    if (freq == 40)
-        return IMD_DEVICE_ERROR;
-    if (freq == 50)
-        return IMD_EARTH_FAULT;
-
-    return -1;
+    return imd_decoder_get_state(&imd_decoder, HAL_GetTick());
+}
+
+uint8_t imd_get_confidence() {
+    return imd_decoder_get_confidence(&imd_decoder, HAL_GetTick());
 }
 
 int32_t imd_get_details() {
-    float duty = imd_get_duty_cycle_percentage();
-    switch (imd_get_state()) {
+    uint32_t now = HAL_GetTick();
+    uint16_t duty = imd_decoder_get_duty(&imd_decoder, now);
+    switch (imd_decoder_get_state(&imd_decoder, now)) {
         case IMD_SC:
-            return !HAL_GPIO_ReadPin(
-                IMD_PWM_GPIO_Port,
-                IMD_PWM_Pin);  //assume that if isRisingEdge == 0 then the pin value is 1, otherwise 0
+            return duty == 0;  // 1 if the signal is stuck low
         case IMD_NORMAL:
-        case IMD_UNDER_VOLTAGE:  //never reached
-            return ((90 / (duty - 5)) - 1) * 1200;
+        case IMD_UNDER_VOLTAGE:
+            return imd_decoder_get_resistance(&imd_decoder, now);
         case IMD_START_MEASURE:
-            if (duty < 15)
+            if (duty < 1500)
                 return 1;
-            else if (duty > 85)
+            else if (duty > 8500)
                 return 0;
             else
                 return -1;
         case IMD_DEVICE_ERROR:
-            if (duty < 55 && duty > 45)
-                return 1;
-            else
-                return -1;
         case IMD_EARTH_FAULT:
-            if (duty < 55 && duty > 45)
+            if (duty < 5500 && duty > 4500)
                 return 1;
             else
                 return -1;
@@ -84,19 +79,37 @@ int32_t imd_get_details() {
     }
 }
 
+int32_t imd_get_resistance() {
+    return imd_decoder_get_resistance(&imd_decoder, HAL_GetTick());
+}
+
+void imd_trend_routine() {
+    imd_decoder_trend_sample(&imd_decoder, HAL_GetTick());
+}
+
 void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim) {
     if (htim->Instance == HTIM_IMD.Instance) {
         if (htim->Channel == HAL_TIM_ACTIVE_CHANNEL_4) {
-            if (HAL_GPIO_ReadPin(IMD_PWM_GPIO_Port, IMD_PWM_Pin)) {
-                uint32_t icValue = HAL_TIM_ReadCapturedValue(&HTIM_IMD, TIM_CHANNEL_4);
+            uint32_t now = HAL_GetTick();
+            uint32_t icValue = HAL_TIM_ReadCapturedValue(&HTIM_IMD, TIM_CHANNEL_4);
 
-                periodTicks = icValue - icValRising;
+            // The input register gives the level right after the edge without waiting
+            if (HAL_GPIO_ReadPin(IMD_PWM_GPIO_Port, IMD_PWM_Pin)) {
+                imd_decoder_edge(&imd_decoder, true, now);
+                if (risingValid) {
+                    uint32_t period = _imd_ticks_to_us(icValue - icValRising);
+                    uint32_t high = fallingValid ? _imd_ticks_to_us(icValFalling - icValRising) : 0;
+                    imd_decoder_add_capture(&imd_decoder, period, high);
+                }
 
                 icValRising = icValue;
+                risingValid = true;
+                fallingValid = false;
             } else {
-                icValFalling = HAL_TIM_ReadCapturedValue(&HTIM_IMD, TIM_CHANNEL_4);
+                imd_decoder_edge(&imd_decoder, false, now);
 
-                dutyCycleTicks = icValFalling - icValRising;
+                icValFalling = icValue;
+                fallingValid = risingValid;
             }
         }
     }
@@ -0,0 +1,192 @@
+/**
+ * @file imd_decoder.c
+ * @brief Decoder of the PWM status signal of the IMD
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "imd_decoder.h"
+
+#include <string.h>
+
+/** @brief Nominal period of each state (us), 0 for the states without a signal */
+static const uint32_t imd_decoder_periods[IMD_STATES_N] = {
+    [IMD_SC]            = 0,
+    [IMD_NORMAL]        = 100000,  // 10 Hz
+    [IMD_UNDER_VOLTAGE] = 50000,   // 20 Hz
+    [IMD_START_MEASURE] = 33333,   // 30 Hz
+    [IMD_DEVICE_ERROR]  = 25000,   // 40 Hz
+    [IMD_EARTH_FAULT]   = 20000    // 50 Hz
+};
+
+/**
+ * @brief Check if the signal is not decoded
+ * @details The signal is stuck when no edge is received for too long and
+ * during the first periods, before a state gets the majority
+ */
+bool _imd_decoder_is_stuck(imd_decoder_t * decoder, uint32_t now) {
+    return decoder->state == IMD_SC || now - decoder->last_edge > IMD_DECODER_TIMEOUT_MS;
+}
+
+/** @brief Sort a small array with insertion sort and return its median */
+uint32_t _imd_decoder_median(uint32_t * values, size_t count) {
+    for (size_t i = 1; i < count; ++i) {
+        uint32_t value = values[i];
+        size_t j = i;
+        for (; j > 0 && values[j - 1] > value; --j)
+            values[j] = values[j - 1];
+        values[j] = value;
+    }
+    return values[(count - 1) / 2];
+}
+
+/** @brief Update the state, the confidence and the medians from the captures in the window */
+void _imd_decoder_update(imd_decoder_t * decoder) {
+    uint8_t votes[IMD_STATES_N + 1] = { 0 };
+    for (size_t i = 0; i < decoder->count; ++i)
+        ++votes[decoder->captures[i].state];
+
+    for (IMD_STATE state = IMD_SC + 1; state < IMD_STATES_N; ++state) {
+        if (votes[state] >= IMD_DECODER_MAJORITY) {
+            decoder->state = state;
+            break;
+        }
+    }
+
+    IMD_STATE state = decoder->state;
+    decoder->confidence = (uint8_t)(votes[state] * 100U / IMD_DECODER_WINDOW);
+    if (votes[state] == 0)
+        return;
+
+    uint32_t periods[IMD_DECODER_WINDOW];
+    uint32_t duties[IMD_DECODER_WINDOW];
+    size_t count = 0;
+    for (size_t i = 0; i < decoder->count; ++i) {
+        if (decoder->captures[i].state == state) {
+            periods[count] = decoder->captures[i].period;
+            duties[count++] = decoder->captures[i].duty;
+        }
+    }
+    decoder->period = _imd_decoder_median(periods, count);
+    decoder->duty = (uint16_t)_imd_decoder_median(duties, count);
+}
+
+/** @brief Convert the duty cycle to the insulation resistance as specified by the IR155 datasheet */
+int32_t _imd_decoder_resistance(uint16_t duty) {
+    // R = 90% * 1200 kOhm / (duty - 5%) - 1200 kOhm
+    if (duty <= 500U)
+        return IMD_DECODER_RESISTANCE_MAX;
+    if (duty >= 9500U)
+        return 0;
+    int32_t resistance = (int32_t)(10800000U / (duty - 500U)) - 1200;
+    return resistance > IMD_DECODER_RESISTANCE_MAX ? IMD_DECODER_RESISTANCE_MAX : resistance;
+}
+
+void imd_decoder_init(imd_decoder_t * decoder) {
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->state = IMD_SC;
+    decoder->resistance_min = -1;
+}
+
+void imd_decoder_edge(imd_decoder_t * decoder, bool level, uint32_t now) {
+    // Start from scratch if the signal was lost
+    if (now - decoder->last_edge > IMD_DECODER_TIMEOUT_MS) {
+        decoder->head = 0;
+        decoder->count = 0;
+        decoder->state = IMD_SC;
+        decoder->confidence = 0;
+    }
+    decoder->last_edge = now;
+    decoder->level = level;
+}
+
+void imd_decoder_add_capture(imd_decoder_t * decoder, uint32_t period, uint32_t high) {
+    imd_decoder_capture_t * capture = &decoder->captures[decoder->head];
+    capture->period = period;
+    capture->state = imd_decoder_classify(period);
+    // A period without a falling edge has no meaningful duty cycle
+    capture->duty = (period == 0 || high >= period) ? 0 : (uint16_t)((uint64_t)high * 10000U / period);
+    if (capture->duty == 0)
+        capture->state = IMD_STATES_N;
+
+    decoder->head = (decoder->head + 1) % IMD_DECODER_WINDOW;
+    if (decoder->count < IMD_DECODER_WINDOW)
+        ++decoder->count;
+    _imd_decoder_update(decoder);
+}
+
+IMD_STATE imd_decoder_classify(uint32_t period) {
+    for (IMD_STATE state = IMD_SC + 1; state < IMD_STATES_N; ++state) {
+        uint32_t band = imd_decoder_periods[state] * IMD_DECODER_TOLERANCE / 100U;
+        if (period >= imd_decoder_periods[state] - band && period <= imd_decoder_periods[state] + band)
+            return state;
+    }
+    return IMD_STATES_N;
+}
+
+IMD_STATE imd_decoder_get_state(imd_decoder_t * decoder, uint32_t now) {
+    return _imd_decoder_is_stuck(decoder, now) ? IMD_SC : decoder->state;
+}
+
+uint8_t imd_decoder_get_confidence(imd_decoder_t * decoder, uint32_t now) {
+    return now - decoder->last_edge > IMD_DECODER_TIMEOUT_MS ? 100U : decoder->confidence;
+}
+
+uint32_t imd_decoder_get_period(imd_decoder_t * decoder, uint32_t now) {
+    return _imd_decoder_is_stuck(decoder, now) ? 0U : decoder->period;
+}
+
+uint16_t imd_decoder_get_duty(imd_decoder_t * decoder, uint32_t now) {
+    if (_imd_decoder_is_stuck(decoder, now))
+        return decoder->level ? 10000U : 0U;
+    return decoder->duty;
+}
+
+int32_t imd_decoder_get_resistance(imd_decoder_t * decoder, uint32_t now) {
+    IMD_STATE state = imd_decoder_get_state(decoder, now);
+    if (state != IMD_NORMAL && state != IMD_UNDER_VOLTAGE)
+        return -1;
+    return _imd_decoder_resistance(decoder->duty);
+}
+
+void imd_decoder_trend_sample(imd_decoder_t * decoder, uint32_t now) {
+    int32_t resistance = imd_decoder_get_resistance(decoder, now);
+    if (resistance < 0) {
+        decoder->trend_head = 0;
+        decoder->trend_count = 0;
+        return;
+    }
+
+    decoder->trend_times[decoder->trend_head] = now;
+    decoder->trend_values[decoder->trend_head] = resistance;
+    decoder->trend_head = (decoder->trend_head + 1) % IMD_DECODER_TREND_SAMPLES;
+    if (decoder->trend_count < IMD_DECODER_TREND_SAMPLES)
+        ++decoder->trend_count;
+
+    if (decoder->resistance_min < 0 || resistance < decoder->resistance_min)
+        decoder->resistance_min = resistance;
+}
+
+float imd_decoder_get_trend(imd_decoder_t * decoder) {
+    size_t count = decoder->trend_count;
+    if (count < 2)
+        return 0.f;
+
+    // Times relative to the oldest sample to keep the sums small
+    size_t oldest = (decoder->trend_head + IMD_DECODER_TREND_SAMPLES - count) % IMD_DECODER_TREND_SAMPLES;
+    uint32_t start = decoder->trend_times[oldest];
+    float sum_t = 0.f, sum_r = 0.f, sum_tt = 0.f, sum_tr = 0.f;
+    for (size_t i = 0; i < count; ++i) {
+        size_t index = (oldest + i) % IMD_DECODER_TREND_SAMPLES;
+        float t = (decoder->trend_times[index] - start) / 60000.f;  // min
+        float r = (float)decoder->trend_values[index];
+        sum_t += t;
+        sum_r += r;
+        sum_tt += t * t;
+        sum_tr += t * r;
+    }
+    float den = count * sum_tt - sum_t * sum_t;
+    if (den <= 0.f)
+        return 0.f;
+    return (count * sum_tr - sum_t * sum_r) / den;
+}
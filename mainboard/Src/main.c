@@ -176,6 +176,9 @@ int main(void)
         // if (HAL_GetTick() > 1500 && !HAL_GPIO_ReadPin(BMS_FAULT_GPIO_Port, BMS_FAULT_Pin))
         //     HAL_GPIO_WritePin(BMS_FAULT_GPIO_Port, BMS_FAULT_Pin, BMS_FAULT_OFF_VALUE);
         cli_loop(&cli_bms);
+        cli_bms_flush();
+        cli_bms_telemetry_routine();
+        can_flash_routine();
         error_simple_routine();
         
         // Start measurement checks after an initial delay
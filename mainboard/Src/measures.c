@@ -22,9 +22,13 @@
 #include "pack/current.h"
 #include "energy/soc.h"
 #include "watchdog.h"
+#include "bal.h"
 #include "fans_buzzer.h"
+#include "feedback.h"
+#include "imd.h"
 #include "timer_utils.h"
 #include "error_simple.h"
+#include "../../fenice_network.h"
 
 #define MEASURE_CHECK_DELAY 1000 // ms
 #define _MEASURE_CHECK_INTERVAL(interval) (((counter) % (interval)) == 0) // Check if a given interval is passed
@@ -32,6 +36,8 @@
 uint32_t counter = 0; // Each timer interrupt it increments by 1
 uint32_t timestamp = 0;
 bool flags_checked = false;
+measures_cycles_t cycles_50ms = { 0 };
+cell_voltage_snapshot_t measures_snapshot; // Copy of the last snapshot, it is not touched by the CAN interrupt
 
 void measures_init() {
     counter = 0;
@@ -42,7 +48,17 @@ void measures_init() {
     __HAL_TIM_CLEAR_IT(&HTIM_MEASURES, TIM_IT_CC1);
     HAL_TIM_OC_Start_IT(&HTIM_MEASURES, TIM_CHANNEL_1);
 
+    // Set the timer of the internal ADC
+    __HAL_TIM_SET_COMPARE(&HTIM_MEASURES, TIM_CHANNEL_2, TIM_MS_TO_TICKS(&HTIM_MEASURES, INTERNAL_VOLTAGE_SAMPLE_INTERVAL_MS));
+    __HAL_TIM_CLEAR_IT(&HTIM_MEASURES, TIM_IT_CC2);
+    HAL_TIM_OC_Start_IT(&HTIM_MEASURES, TIM_CHANNEL_2);
+
     timestamp = HAL_GetTick();
+
+    // Enable the cycle counter of the core
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 void measures_check_flags() {
@@ -50,13 +66,22 @@ void measures_check_flags() {
     if (flags_checked)
         return;
     flags_checked = true;
+
+    // Check the CAN timeouts at every tick
+    watchdog_routine();
     
     // 10 ms interval
     if (_MEASURE_CHECK_INTERVAL(MEASURE_INTERVAL_10MS)) {
         can_car_send(PRIMARY_HV_STATUS_FRAME_ID);
+
+        // Send a burst of samples of the feedback capture, one for each mailbox
+        for (size_t i = 0; i < FEEDBACK_CAPTURE_CAN_BURST && feedback_dump_is_pending(); ++i)
+            can_bms_send(BMS_FEEDBACK_CAPTURE_FRAME_ID);
     }
     // 50 ms interval
     if (_MEASURE_CHECK_INTERVAL(MEASURE_INTERVAL_50MS)) {
+        uint32_t start = DWT->CYCCNT;
+
         // Send info via CAN
         can_car_send(PRIMARY_HV_CURRENT_FRAME_ID);
         can_car_send(PRIMARY_HV_POWER_FRAME_ID);
@@ -66,15 +91,33 @@ void measures_check_flags() {
         can_car_send(PRIMARY_HV_ERRORS_FRAME_ID);
         can_car_send(PRIMARY_HV_FEEDBACK_STATUS_FRAME_ID);
 
-        // Measure SOC
+        // Measure SOC, the internal voltages are read by the measures timer
         if (internal_voltage_measure() == HAL_OK)
-            current_read(CONVERT_VALUE_TO_INTERNAL_ADC_VOLTAGE(internal_voltage_get_shunt()));
+            current_read(internal_voltage_get_shunt());
+        fans_sample_current(current_get_current());
         soc_sample_energy(HAL_GetTick());
 
+        // Look for the cells drifting away from the pack in the last snapshot
+        // and compare it with the internal voltages read in the same cycle
+        if (cell_voltage_get_new_snapshot(&measures_snapshot)) {
+            cell_anomaly_update(&cell_anomaly,
+                measures_snapshot.timestamp,
+                measures_snapshot.current,
+                bal_is_balancing(),
+                measures_snapshot.voltages);
+            internal_voltage_check_errors(&measures_snapshot);
+        }
+
+        // Sample all the cells at the same instant of the current
+        can_bms_send(BMS_SNAPSHOT_TRIGGER_FRAME_ID);
+
         // Check errors
         if (HAL_GetTick() - timestamp >= MEASURE_CHECK_DELAY)
             cell_voltage_check_errors();
         current_check_errors();
+
+        cycles_50ms.last = DWT->CYCCNT - start;
+        cycles_50ms.max = MAX(cycles_50ms.max, cycles_50ms.last);
     }
     // 100 ms interval
     if (_MEASURE_CHECK_INTERVAL(MEASURE_INTERVAL_100MS)) {
@@ -115,19 +158,29 @@ void measures_check_flags() {
     }
     // 1 s interval
     if (_MEASURE_CHECK_INTERVAL(MEASURE_INTERVAL_1S)) {
-        // Run fans based on temperature
-        if (!fans_is_overrided()) {
-            float max_temp = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_max());
-            fans_set_speed(fans_curve(max_temp));
-        }
+        if (bal_is_balancing())
+            can_bms_send(BMS_BALANCING_CONVERGENCE_FRAME_ID);
+
+        // Track the insulation resistance
+        imd_trend_routine();
+        can_bms_send(BMS_IMD_TREND_FRAME_ID);
+
+        // Rank the cells drifting away from the pack
+        can_bms_send(BMS_CELL_ANOMALY_FRAME_ID);
+
+        // Run fans based on temperature and losses
+        fans_routine(CONVERT_VALUE_TO_TEMPERATURE(temperature_get_max()), 1.f);
     }
     // 5 s interval
     if (_MEASURE_CHECK_INTERVAL(MEASURE_INTERVAL_5S)) {
-        watchdog_routine();
         soc_save_to_eeprom();
     }
 }
 
+measures_cycles_t measures_get_cycles_50ms() {
+    return cycles_50ms;
+}
+
 void _measures_handle_tim_oc_irq(TIM_HandleTypeDef * htim) {
     uint32_t cnt = __HAL_TIM_GetCounter(htim);
 
@@ -139,6 +192,10 @@ void _measures_handle_tim_oc_irq(TIM_HandleTypeDef * htim) {
             ++counter;
             flags_checked = false;
             break;
+        case HAL_TIM_ACTIVE_CHANNEL_2:
+            __HAL_TIM_SET_COMPARE(htim, TIM_CHANNEL_2, (cnt + TIM_MS_TO_TICKS(htim, INTERNAL_VOLTAGE_SAMPLE_INTERVAL_MS)));
+            _internal_voltage_handle_tim_oc_irq();
+            break;
         default:
             break;
     }
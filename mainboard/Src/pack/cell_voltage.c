@@ -19,12 +19,29 @@
 #include "bms_fsm.h"
 #include "error_simple.h"
 
+// Every cellboard sends its voltages in groups of CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE cells
+#define CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE 3
+#define CELL_VOLTAGE_SNAPSHOT_GROUPS_MASK ((1U << (CELLBOARD_CELL_COUNT / CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE)) - 1U)
+
 cell_voltage cell_volts;
+cell_anomaly_t cell_anomaly;
+
+cell_voltage_snapshot_t snapshot_pending; // Snapshot which is being received
+cell_voltage_snapshot_t snapshot;         // Last snapshot received completely
+uint8_t snapshot_groups[CELLBOARD_COUNT]; // Bitmask of the groups of cells received
+volatile bool is_snapshot_valid;
+volatile bool is_snapshot_new; // The last snapshot has not been read by cell_voltage_get_new_snapshot
 
 void cell_voltage_init() {
     memset(cell_volts.min, CELL_MAX_VOLTAGE, CELLBOARD_COUNT * sizeof(voltage_t));
     memset(cell_volts.max, 0, CELLBOARD_COUNT * sizeof(voltage_t));
     memset(cell_volts.avg, 0, CELLBOARD_COUNT * sizeof(float));
+    memset(cell_volts.cells, 0, PACK_CELL_COUNT * sizeof(voltage_t));
+
+    memset(snapshot_groups, 0, CELLBOARD_COUNT * sizeof(uint8_t));
+    is_snapshot_valid = false;
+    is_snapshot_new = false;
+    cell_anomaly_init(&cell_anomaly);
 }
 HAL_StatusTypeDef cell_voltage_set_cells(size_t cellboard_id,
     voltage_t min,
@@ -38,6 +55,93 @@ HAL_StatusTypeDef cell_voltage_set_cells(size_t cellboard_id,
     return HAL_OK;
 }
 
+HAL_StatusTypeDef cell_voltage_set_cell_values(size_t cellboard_id,
+    size_t start_index,
+    voltage_t * volts,
+    size_t count) {
+    if (cellboard_id >= CELLBOARD_COUNT || start_index + count > CELLBOARD_CELL_COUNT)
+        return HAL_ERROR;
+
+    memcpy(cell_volts.cells + cellboard_id * CELLBOARD_CELL_COUNT + start_index, volts, count * sizeof(voltage_t));
+    return HAL_OK;
+}
+voltage_t cell_voltage_get_cell(size_t index) {
+    if (index >= PACK_CELL_COUNT)
+        return 0;
+    return cell_volts.cells[index];
+}
+voltage_t * cell_voltage_get_cells() {
+    return cell_volts.cells;
+}
+
+void cell_voltage_snapshot_start(uint8_t seq, uint32_t timestamp, current_t current, uint16_t bat, uint16_t tsp) {
+    // The pending snapshot is filled by the CAN interrupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    snapshot_pending.seq = seq;
+    snapshot_pending.timestamp = timestamp;
+    snapshot_pending.current = current;
+    snapshot_pending.bat = bat;
+    snapshot_pending.tsp = tsp;
+    memset(snapshot_groups, 0, CELLBOARD_COUNT * sizeof(uint8_t));
+    __set_PRIMASK(primask);
+}
+HAL_StatusTypeDef cell_voltage_snapshot_set_cells(size_t cellboard_id,
+    size_t start_index,
+    uint8_t seq,
+    voltage_t * volts,
+    size_t count) {
+    if (seq != snapshot_pending.seq ||
+        count != CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE ||
+        start_index % CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE != 0)
+        return HAL_ERROR;
+    if (cell_voltage_set_cell_values(cellboard_id, start_index, volts, count) != HAL_OK)
+        return HAL_ERROR;
+
+    memcpy(snapshot_pending.voltages + cellboard_id * CELLBOARD_CELL_COUNT + start_index, volts, count * sizeof(voltage_t));
+    snapshot_groups[cellboard_id] |= 1U << (start_index / CELL_VOLTAGE_SNAPSHOT_GROUP_SIZE);
+
+    // Check if the snapshot is complete
+    for (size_t i = 0; i < CELLBOARD_COUNT; ++i) {
+        if (snapshot_groups[i] != CELL_VOLTAGE_SNAPSHOT_GROUPS_MASK)
+            return HAL_OK;
+    }
+    snapshot = snapshot_pending;
+    is_snapshot_valid = true;
+    is_snapshot_new = true;
+
+    // Avoid completing the same snapshot twice
+    memset(snapshot_groups, 0, CELLBOARD_COUNT * sizeof(uint8_t));
+    ++snapshot_pending.seq;
+    return HAL_OK;
+}
+bool cell_voltage_get_snapshot(cell_voltage_snapshot_t * out) {
+    if (out == NULL)
+        return false;
+
+    // The CAN interrupt may complete a new snapshot while it is copied
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    bool valid = is_snapshot_valid;
+    if (valid) {
+        *out = snapshot;
+        is_snapshot_new = false;
+    }
+    __set_PRIMASK(primask);
+    return valid;
+}
+bool cell_voltage_get_new_snapshot(cell_voltage_snapshot_t * out) {
+    if (!is_snapshot_new)
+        return false;
+    return cell_voltage_get_snapshot(out);
+}
+uint32_t cell_voltage_snapshot_get_sum(const cell_voltage_snapshot_t * snapshot) {
+    uint32_t sum = 0U;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+        sum += snapshot->voltages[i];
+    return sum;
+}
+
 voltage_t cell_voltage_get_max() {
     voltage_t max = 0;
     for (size_t i = 0; i < CELLBOARD_COUNT; i++)
@@ -51,7 +155,14 @@ voltage_t cell_voltage_get_min() {
     return min;
 }
 float cell_voltage_get_sum() {
-    return cell_voltage_get_avg() * PACK_CELL_COUNT;
+    if (!is_snapshot_valid)
+        return cell_voltage_get_avg() * PACK_CELL_COUNT;
+
+    // Sum in integers so that no value is lost in the rounding
+    uint32_t sum = 0U;
+    for (size_t i = 0; i < PACK_CELL_COUNT; ++i)
+        sum += cell_volts.cells[i];
+    return sum;
 }
 float cell_voltage_get_avg() {
     float avg = 0;
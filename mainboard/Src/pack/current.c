@@ -10,112 +10,93 @@
  */
 #include "pack/current.h"
 
-#include <math.h>
 #include <stdbool.h>
 
 #include "stm32f4xx_hal.h"
 #include "mainboard_config.h"
 #include "error_simple.h"
+#include "fixed_point.h"
+#include "peripherals/max22530.h"
 
-#define MEASURE_SAMPLE_SIZE 128
+uint16_t adc_50[CURRENT_SAMPLE_COUNT]  = { 0 };
+uint16_t adc_300[CURRENT_SAMPLE_COUNT] = { 0 };
 
-#define CURRENT_SENSITIVITY_LOW 40e-3f // V / A
-#define CURRENT_SENSITIVITY_HIGH 6.67e-3f // V / A
-
-#define CURRENT_DIVIDER_RATIO_INVERSE ((330.f + 169.f) / 330.f)
-
-uint16_t adc_50[MEASURE_SAMPLE_SIZE]  = { 0 };
-uint16_t adc_300[MEASURE_SAMPLE_SIZE] = { 0 };
-
-current_t prev_current = 0.f, filtered_current = 0.f;
+/**
+ * @brief The measurement chain runs in fixed-point, the currents are converted
+ * to float only for the rest of the firmware
+ */
+fixed_current_t filtered_current = { 0 };
+fixed_current_t current_fixed[CURRENT_SENSOR_NUM] = { { 0 } };
 current_t current[CURRENT_SENSOR_NUM] = { 0.f };
 
-current_t V0L = 0, V0H = 0;  // Voltage offset (Vout(0A))
-current_t volt_300 = 0; // Voltage value of the Hall effect sensor
-
-current_t _current_convert_low(float volt) {
-    return (CURRENT_DIVIDER_RATIO_INVERSE / CURRENT_SENSITIVITY_LOW) * (volt - V0L);
-}
-
-current_t _current_convert_high(float volt) {
-    return (CURRENT_DIVIDER_RATIO_INVERSE / CURRENT_SENSITIVITY_HIGH) * (volt - V0H);
-}
-
-#define CURRENT_SHUNT_VREF_OFFSET 0.454f // 0.9f
-#define CURRENT_SHUNT_OP_GAIN 75.f
-#define CURRENT_SHUNT_RESISTANCE 1e-4f
-
-current_t _current_convert_shunt(float volt) {
-    return (volt - CURRENT_SHUNT_VREF_OFFSET) / (CURRENT_SHUNT_OP_GAIN * CURRENT_SHUNT_RESISTANCE);
-}
+fixed_voltage_t V0L = { 0 }, V0H = { 0 };  // Voltage offset (Vout(0A))
+fixed_voltage_t volt_300 = { 0 }; // Voltage value of the Hall effect sensor
 
 void current_start_measure() {
-    HAL_ADC_Start_DMA(&ADC_HALL50, (uint32_t *)adc_50, MEASURE_SAMPLE_SIZE);
-    HAL_ADC_Start_DMA(&ADC_HALL300, (uint32_t *)adc_300, MEASURE_SAMPLE_SIZE);
+    HAL_ADC_Start_DMA(&ADC_HALL50, (uint32_t *)adc_50, CURRENT_SAMPLE_COUNT);
+    HAL_ADC_Start_DMA(&ADC_HALL300, (uint32_t *)adc_300, CURRENT_SAMPLE_COUNT);
 }
 
+/** @brief Check the over-currents of a sensor */
+void _current_check_limits(fixed_current_t value) {
+    if (value.q < FIXED_CURRENT_CONST(CURRENT_MIN_THRESHOLD).q || value.q > FIXED_CURRENT_CONST(CURRENT_MAX_THRESHOLD).q) {
+        error_simple_set(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
+    } else {
+        error_simple_reset(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
+    }
+}
 
-uint32_t current_read(float shunt_adc_val) {
+uint32_t current_read(uint16_t shunt_adc_val) {
     uint32_t time = HAL_GetTick();
-    float avg_50 = 0;
-    float avg_300 = 0;
-    for (size_t i = 0; i < MEASURE_SAMPLE_SIZE; i++) {
-        avg_50 += adc_50[i];
-        avg_300 += adc_300[i];
+    uint32_t sum_50 = 0;
+    uint32_t sum_300 = 0;
+    for (size_t i = 0; i < CURRENT_SAMPLE_COUNT; i++) {
+        sum_50 += adc_50[i];
+        sum_300 += adc_300[i];
     }
 
     // Convert Hall-low (50A)
-    float volt = avg_50 * 3.3f / 4095.f / MEASURE_SAMPLE_SIZE;
-    current[CURRENT_SENSOR_50] = _current_convert_low(volt);
+    fixed_voltage_t volt = fixed_voltage_from_adc(sum_50, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF));
+    current_fixed[CURRENT_SENSOR_50] = fixed_current_from_voltage(volt, V0L, CURRENT_GAIN_LOW);
 
     // Convert Hall-high (300A)
-    volt_300 = avg_300 * 3.3f / 4095.f / MEASURE_SAMPLE_SIZE;
-    current[CURRENT_SENSOR_300] = _current_convert_high(volt_300);
+    volt_300 = fixed_voltage_from_adc(sum_300, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF));
+    current_fixed[CURRENT_SENSOR_300] = fixed_current_from_voltage(volt_300, V0H, CURRENT_GAIN_HIGH);
 
     // Convert Shunt
-    current[CURRENT_SENSOR_SHUNT] = _current_convert_shunt(shunt_adc_val);
+    volt = fixed_voltage_from_adc(shunt_adc_val, 1, MAX22530_FULL_SCALE, FIXED_VOLTAGE_CONST(MAX22530_VREF));
+    current_fixed[CURRENT_SENSOR_SHUNT] = fixed_current_from_voltage(volt, FIXED_VOLTAGE_CONST(CURRENT_SHUNT_VREF_OFFSET), CURRENT_GAIN_SHUNT);
+
+    for (size_t i = 0; i < CURRENT_SENSOR_NUM; ++i)
+        current[i] = fixed_current_to_float(current_fixed[i]);
+
+    // Return current read from the correct sensor
+    fixed_current_t value = current_fixed[CURRENT_SENSOR_300];
+    if (fixed_current_abs(current_fixed[CURRENT_SENSOR_50]).q < FIXED_CURRENT_CONST(CURRENT_LOW_RANGE).q &&
+        fixed_current_abs(current_fixed[CURRENT_SENSOR_300]).q < FIXED_CURRENT_CONST(CURRENT_LOW_RANGE).q)
+        value = current_fixed[CURRENT_SENSOR_50];
 
     // Filter current
-    current_t hall_50 = fabsf(current[CURRENT_SENSOR_50]);
-    current_t hall_300 = fabsf(current[CURRENT_SENSOR_300]);
-
-    // Return current read from the correct
-    if (hall_50 < 34 && hall_300 < 34)
-        filtered_current = current[CURRENT_SENSOR_50];
-    else
-        filtered_current = current[CURRENT_SENSOR_300];
-    // Filter current
-    const float alpha = 0.4f;
-    prev_current = filtered_current = alpha * prev_current + (1.f - alpha) * filtered_current;
+    filtered_current = fixed_current_filter(filtered_current, value, FIXED_GAIN_CONST(CURRENT_FILTER_ALPHA));
 
     // Check for over-currents
-    if (current_get_current() < CURRENT_MIN_THRESHOLD) {
-        error_simple_set(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    } else {
-        error_simple_reset(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    }
-
-    if (current_get_current() > CURRENT_MAX_THRESHOLD) {
-        error_simple_set(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    } else {
-        error_simple_reset(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    }
+    _current_check_limits(filtered_current);
     return time;
 }
 
 void current_zero() {
-    uint32_t avg_50  = 0;
-    uint32_t avg_300 = 0;
-    for (size_t i = 0; i < MEASURE_SAMPLE_SIZE; ++i) {
-        avg_50 += adc_50[i];
-        avg_300 += adc_300[i];
+    uint32_t sum_50  = 0;
+    uint32_t sum_300 = 0;
+    for (size_t i = 0; i < CURRENT_SAMPLE_COUNT; ++i) {
+        sum_50 += adc_50[i];
+        sum_300 += adc_300[i];
     }
-    V0L = avg_50 * (3.3f / 4095 / MEASURE_SAMPLE_SIZE);
-    V0H = avg_300 * (3.3f / 4095 / MEASURE_SAMPLE_SIZE);
+    V0L = fixed_voltage_from_adc(sum_50, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF));
+    V0H = fixed_voltage_from_adc(sum_300, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF));
 }
 
 current_t current_get_current() {
-    return filtered_current;
+    return fixed_current_to_float(filtered_current);
 }
 current_t * current_get_current_sensors() {
     return current;
@@ -128,21 +109,10 @@ current_t current_get_current_from_sensor(uint8_t sensor) {
 }
 
 void current_check_errors() {
-    current_t hall_300 = current[CURRENT_SENSOR_300];
-    if (hall_300 < CURRENT_MIN_THRESHOLD) {
-        error_simple_set(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    } else {
-        error_simple_reset(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    }
-
-    if (hall_300 > CURRENT_MAX_THRESHOLD) {
-        error_simple_set(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    } else {
-        error_simple_reset(ERROR_GROUP_ERROR_OVER_CURRENT, 0);
-    }
+    _current_check_limits(current_fixed[CURRENT_SENSOR_300]);
     
     // Hall effect sensor disconnected
-    if (volt_300 < CURRENT_SENSOR_DISCONNECTED_THRESHOLD) {
+    if (volt_300.q < FIXED_VOLTAGE_CONST(CURRENT_SENSOR_DISCONNECTED_THRESHOLD).q) {
         error_simple_set(ERROR_GROUP_ERROR_CONNECTOR_DISCONNECTED, 1);
     } else {
         error_simple_reset(ERROR_GROUP_ERROR_CONNECTOR_DISCONNECTED, 1);
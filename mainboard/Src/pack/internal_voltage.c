@@ -11,23 +11,20 @@
 #include "pack/internal_voltage.h"
 
 #include <math.h>
+#include <string.h>
 
 #include "mainboard_config.h"
 #include "main.h"
 #include "cell_voltage.h"
 #include "error_simple.h"
-
-/** @brief Internal voltages of the mainboard */
-struct internal_voltage {
-    uint16_t tsp;   // TS+ voltage
-    uint16_t bat;   // Battery voltage
-    uint16_t shunt; // Shunter voltage
-    uint16_t tsn;   // TS- voltage
-};
+#include "bms_fsm.h"
 
 // This module is a singleton
-struct internal_voltage internal_voltages;
+internal_voltage_sample_t internal_voltages; // Last sample, written by the SPI interrupt
+volatile bool is_internal_adc_busy;          // A burst is being transferred
+internal_voltage_stats_t internal_voltage_stats;
 MAX22530_HandleTypeDef internal_adc;
+voltage_crosscheck_t internal_voltage_crosscheck;
 
 
 void internal_voltage_init() {
@@ -35,34 +32,34 @@ void internal_voltage_init() {
     max22530_init(&internal_adc, &SPI_ADC, ADC_CS_GPIO_Port, ADC_CS_Pin);
 
     // Init voltages
-    internal_voltages.tsp   = 0;
-    internal_voltages.tsn   = 0;
-    internal_voltages.shunt = 0;
-    internal_voltages.bat   = 0;
+    memset(&internal_voltages, 0, sizeof(internal_voltages));
+    memset(&internal_voltage_stats, 0, sizeof(internal_voltage_stats));
+    is_internal_adc_busy = false;
+
+    voltage_crosscheck_init(&internal_voltage_crosscheck);
 }
 
 HAL_StatusTypeDef internal_voltage_measure() {
-    // Read voltages from the adc
-    uint16_t volts[MAX22530_CHANNEL_COUNT] = { 0 };
-    HAL_StatusTypeDef status = max22530_read_all_channels(&internal_adc, volts);
-
-    if (status != HAL_OK)
-        return status;
-    
-    internal_voltages.tsp   = volts[MAX22530_VTS_CHANNEL - 1];
-    internal_voltages.tsn   = volts[MAX22530_TSN_CHANNEL - 1];
-    internal_voltages.shunt = volts[MAX22530_SHUNT_CHANNEL - 1];
-    internal_voltages.bat   = volts[MAX22530_VBATT_CHANNEL - 1];
-
-    // Check if difference between readings from the ADC and cellboards is greater than 10V
-    // if (fabsf(CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltages.bat) - CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_sum())) > INTERNAL_VOLTAGE_MAX_DELTA) {
-    //     error_simple_set(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, 0);
-    // } else {
-    //     error_simple_reset(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, 0);
-    // }
+    if (internal_voltage_stats.samples == 0U)
+        return HAL_ERROR;
+    if (HAL_GetTick() - internal_voltages.timestamp > INTERNAL_VOLTAGE_TIMEOUT_MS)
+        return HAL_TIMEOUT;
     return HAL_OK;
 }
 
+internal_voltage_stats_t internal_voltage_get_stats() {
+    return internal_voltage_stats;
+}
+
+internal_voltage_sample_t internal_voltage_get_sample() {
+    // The sample is written by the SPI interrupt
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    internal_voltage_sample_t sample = internal_voltages;
+    __set_PRIMASK(primask);
+    return sample;
+}
+
 uint16_t internal_voltage_get_tsp() {
     return internal_voltages.tsp;
 }
@@ -77,7 +74,7 @@ uint16_t internal_voltage_get_bat() {
 }
 
 bool internal_voltage_is_precharge_complete() {
-    float tsp = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltages.tsp);
+    float tsp = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_tsp());
     float target;
     if (is_handcart_connected)
         // target = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltages.bat) * INTERNAL_VOLTAGE_PRECHARGE_HANDCART_THRESHOLD;
@@ -88,3 +85,60 @@ bool internal_voltage_is_precharge_complete() {
     
     return tsp >= target;
 }
+
+void internal_voltage_check_errors(const cell_voltage_snapshot_t * snapshot) {
+    if (snapshot == NULL)
+        return;
+
+    voltage_crosscheck_sample_t sample = {
+        .cell_sum = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_snapshot_get_sum(snapshot)),
+        .bat = (float)CONVERT_VALUE_TO_INTERNAL_VOLTAGE(snapshot->bat),
+        .tsp = (float)CONVERT_VALUE_TO_INTERNAL_VOLTAGE(snapshot->tsp),
+        .current = snapshot->current,
+        .ts_connected = fsm_get_state() == STATE_TS_ON
+    };
+    uint8_t result = voltage_crosscheck_update(&internal_voltage_crosscheck, &sample);
+    if (result & VOLTAGE_CROSSCHECK_SKIPPED)
+        return;
+
+    if (result & VOLTAGE_CROSSCHECK_BAT_MISMATCH)
+        error_simple_set(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, INTERNAL_VOLTAGE_MISMATCH_BAT);
+    else
+        error_simple_reset(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, INTERNAL_VOLTAGE_MISMATCH_BAT);
+
+    if (result & VOLTAGE_CROSSCHECK_TS_MISMATCH)
+        error_simple_set(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, INTERNAL_VOLTAGE_MISMATCH_TS);
+    else
+        error_simple_reset(ERROR_GROUP_ERROR_INT_VOLTAGE_MISMATCH, INTERNAL_VOLTAGE_MISMATCH_TS);
+}
+
+void _internal_voltage_handle_tim_oc_irq() {
+    // The previous burst is still running, the samples are requested too fast
+    if (is_internal_adc_busy) {
+        ++internal_voltage_stats.overruns;
+        return;
+    }
+    is_internal_adc_busy = true;
+    if (max22530_burst_start(&internal_adc, INTERNAL_VOLTAGE_FILTERED) != HAL_OK) {
+        is_internal_adc_busy = false;
+        ++internal_voltage_stats.errors;
+    }
+}
+void _internal_voltage_handle_spi_txrx_cplt() {
+    uint16_t volts[MAX22530_CHANNEL_COUNT] = { 0 };
+    max22530_burst_complete(&internal_adc, volts);
+
+    internal_voltages.tsp       = volts[MAX22530_VTS_CHANNEL - 1];
+    internal_voltages.tsn       = volts[MAX22530_TSN_CHANNEL - 1];
+    internal_voltages.shunt     = volts[MAX22530_SHUNT_CHANNEL - 1];
+    internal_voltages.bat       = volts[MAX22530_VBATT_CHANNEL - 1];
+    internal_voltages.timestamp = HAL_GetTick();
+
+    ++internal_voltage_stats.samples;
+    is_internal_adc_busy = false;
+}
+void _internal_voltage_handle_spi_error() {
+    max22530_burst_abort(&internal_adc);
+    ++internal_voltage_stats.errors;
+    is_internal_adc_busy = false;
+}
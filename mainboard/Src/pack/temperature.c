@@ -24,16 +24,18 @@ void temperature_init() {
     memset(cell_temps.min, CONVERT_TEMPERATURE_TO_VALUE(CELL_MAX_TEMPERATURE), CELLBOARD_COUNT * sizeof(temperature_t));
     memset(cell_temps.max, 0, CELLBOARD_COUNT * sizeof(temperature_t));
     memset(cell_temps.avg, 0, CELLBOARD_COUNT * sizeof(float));
+    memset(cell_temps.excluded, 0, CELLBOARD_COUNT * sizeof(uint64_t));
+    memset(cell_temps.unhealthy, 0, CELLBOARD_COUNT * sizeof(uint8_t));
 }
 void temperature_check_errors() {
-    float max_temp = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_max());
-    if (max_temp > CELL_MAX_TEMPERATURE)
+    fixed_temperature_t max_temp = CONVERT_VALUE_TO_FIXED_TEMPERATURE(temperature_get_max());
+    if (max_temp.q > FIXED_TEMPERATURE_CONST(CELL_MAX_TEMPERATURE).q)
         error_simple_set(ERROR_GROUP_ERROR_CELL_OVER_TEMPERATURE, 0);
     else
         error_simple_reset(ERROR_GROUP_ERROR_CELL_OVER_TEMPERATURE, 0);
 
-    float min_temp = CONVERT_VALUE_TO_TEMPERATURE(temperature_get_min());
-    if (min_temp < -15.f)
+    fixed_temperature_t min_temp = CONVERT_VALUE_TO_FIXED_TEMPERATURE(temperature_get_min());
+    if (min_temp.q < FIXED_TEMPERATURE_CONST(-15).q)
         error_simple_set(ERROR_GROUP_ERROR_CELL_UNDER_TEMPERATURE, 0);
     else
         error_simple_reset(ERROR_GROUP_ERROR_CELL_UNDER_TEMPERATURE, 0);
@@ -78,3 +80,36 @@ HAL_StatusTypeDef temperature_set_cells(size_t cellboard_id,
 
     return HAL_OK;
 }
+HAL_StatusTypeDef temperature_set_excluded(size_t cellboard_id,
+    size_t start_index,
+    uint64_t excluded,
+    size_t count,
+    uint8_t unhealthy) {
+    if (cellboard_id >= CELLBOARD_COUNT || start_index >= TEMP_SENSOR_COUNT)
+        return HAL_ERROR;
+    count = MIN(count, TEMP_SENSOR_COUNT - start_index);
+
+    uint64_t mask = (count >= 64U) ? UINT64_MAX : ((1ULL << count) - 1U);
+    cell_temps.excluded[cellboard_id] &= ~(mask << start_index);
+    cell_temps.excluded[cellboard_id] |= (excluded & mask) << start_index;
+    cell_temps.unhealthy[cellboard_id] = unhealthy;
+
+    return HAL_OK;
+}
+uint8_t temperature_get_unhealthy(size_t cellboard_id) {
+    return cellboard_id < CELLBOARD_COUNT ? cell_temps.unhealthy[cellboard_id] : 0U;
+}
+bool temperature_is_interpolable(size_t cellboard_id) {
+    if (cellboard_id >= CELLBOARD_COUNT)
+        return false;
+    for (size_t strip = 0; strip < CELLBOARD_TEMP_STRIP_COUNT; ++strip) {
+        size_t included = 0;
+        for (size_t sens = 0; sens < CELLBOARD_TEMP_STRIP_SENSOR_COUNT; ++sens) {
+            if ((cell_temps.excluded[cellboard_id] & TEMP_SENSOR(strip * CELLBOARD_TEMP_STRIP_SENSOR_COUNT + sens)) == 0U)
+                ++included;
+        }
+        if (included < CELLBOARD_TEMP_STRIP_MIN_INCLUDED)
+            return false;
+    }
+    return true;
+}
@@ -31,6 +31,9 @@
 #include "soc.h"
 #include "imd.h"
 #include "error_simple.h"
+#include "flash_fanout.h"
+#include "str_writer.h"
+#include "../../fenice_network.h"
 
 #ifdef TEMP_GROUP_ERROR_ENABLE
 uint16_t temp_errors[CELLBOARD_COUNT];
@@ -40,11 +43,40 @@ uint32_t time_since_last_comm[CELLBOARD_COUNT];
 bool can_forward;
 uint8_t flash_cellboard_id;
 float debug_signal;
+uint8_t snapshot_seq;
+flash_fanout_t flash_fanout;
 
 primary_hv_debug_signals_converted_t conv_debug;
 
 static time_t build_epoch;
 
+/** @brief Send the progress of the parallel flashing to the car */
+void _can_send_flash_status() {
+    CAN_TxHeaderTypeDef tx_header = {
+        .DLC = BMS_FLASH_STATUS_BYTE_SIZE,
+        .ExtId = 0,
+        .IDE = CAN_ID_STD,
+        .RTR = CAN_RTR_DATA,
+        .StdId = BMS_FLASH_STATUS_FRAME_ID,
+        .TransmitGlobalTime = DISABLE
+    };
+    uint8_t buffer[CAN_MAX_PAYLOAD_LENGTH] = { 0 };
+    uint8_t boards = 0;
+    for (uint32_t mask = flash_fanout.mask; mask != 0; mask &= mask - 1)
+        ++boards;
+    bms_flash_status_t raw_status = {
+        .active = flash_fanout_is_active(&flash_fanout),
+        .boards = boards,
+        .retransmissions = (uint8_t)MIN(flash_fanout.retransmissions, UINT8_MAX),
+        .failed = flash_fanout.failed,
+        .commands = (uint16_t)flash_fanout.commands
+    };
+
+    if (bms_flash_status_pack(buffer, &raw_status, BMS_FLASH_STATUS_BYTE_SIZE) < 0)
+        return;
+    can_send(&CAR_CAN, buffer, &tx_header);
+}
+
 /**
  * @brief Wait until the CAN has at least one free mailbox
  * 
@@ -62,6 +94,44 @@ HAL_StatusTypeDef _can_wait(CAN_HandleTypeDef * hcan, uint32_t timeout) {
     return HAL_OK;
 }
 
+/**
+ * @brief Forward a group of cells voltages to the car
+ * 
+ * @param cellboard_id The index of the cellboard where the values are read from
+ * @param start_index The index of the first cell inside the cellboard
+ * @param voltage0 The voltage of the first cell (V)
+ * @param voltage1 The voltage of the second cell (V)
+ * @param voltage2 The voltage of the third cell (V)
+ */
+void _can_forward_cells_voltage(uint8_t cellboard_id, uint8_t start_index, float voltage0, float voltage1, float voltage2) {
+    CAN_TxHeaderTypeDef tx_header = {
+        .DLC = 0,
+        .ExtId = 0,
+        .IDE = CAN_ID_STD,
+        .RTR = CAN_RTR_DATA,
+        .StdId = PRIMARY_HV_CELLS_VOLTAGE_FRAME_ID,
+        .TransmitGlobalTime = DISABLE
+    };
+    uint8_t buffer[CAN_MAX_PAYLOAD_LENGTH] = { 0 };
+    primary_hv_cells_voltage_t raw_fwd_volts = { 0 };
+    primary_hv_cells_voltage_converted_t conv_fwd_volts = { 0 };
+
+    // Set start_index of the received cells between all cells of the pack
+    conv_fwd_volts.start_index = cellboard_id * CELLBOARD_CELL_COUNT + start_index;
+    conv_fwd_volts.voltage_0 = voltage0;
+    conv_fwd_volts.voltage_1 = voltage1;
+    conv_fwd_volts.voltage_2 = voltage2;
+
+    primary_hv_cells_voltage_conversion_to_raw_struct(&raw_fwd_volts, &conv_fwd_volts);
+
+    int data_len = primary_hv_cells_voltage_pack(buffer, &raw_fwd_volts, PRIMARY_HV_CELLS_VOLTAGE_BYTE_SIZE);
+    if (data_len < 0)
+        return;
+    tx_header.DLC = data_len;
+
+    can_send(&CAR_CAN, buffer, &tx_header);
+}
+
 bool can_is_forwarding() {
     return can_forward;
 }
@@ -87,6 +157,8 @@ void can_bms_init() {
         .SlaveStartFilterBank = CAN_SLAVE_START_FILTER_BANK
     };
 
+    flash_fanout_init(&flash_fanout, FLASH_FANOUT_ALL_BOARDS);
+
     // Enable filters and start CAN
     HAL_CAN_ConfigFilter(&BMS_CAN, &filter);
     HAL_CAN_ActivateNotification(&BMS_CAN, CAN_IT_ERROR | CAN_IT_RX_FIFO0_MSG_PENDING);
@@ -156,8 +228,9 @@ HAL_StatusTypeDef can_car_send(uint16_t id) {
         primary_hv_total_voltage_t raw_volts = { 0 };
         primary_hv_total_voltage_converted_t conv_volts = { 0 };
 
-        conv_volts.bus = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_tsp());
-        conv_volts.pack = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(internal_voltage_get_bat());
+        internal_voltage_sample_t sample = internal_voltage_get_sample();
+        conv_volts.bus = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(sample.tsp);
+        conv_volts.pack = CONVERT_VALUE_TO_INTERNAL_VOLTAGE(sample.bat);
         conv_volts.sum_cell = CONVERT_VALUE_TO_VOLTAGE(cell_voltage_get_sum());
 
         primary_hv_total_voltage_conversion_to_raw_struct(&raw_volts, &conv_volts);
@@ -619,6 +692,132 @@ HAL_StatusTypeDef can_bms_send(uint16_t id) {
         }        
         return errors == 0 ? HAL_OK : HAL_ERROR;
     }
+    else if (id == BMS_BALANCING_PLAN_FRAME_ID) {
+        const bal_plan_t * plan = bal_get_plan();
+
+        size_t errors = 0;
+        for (size_t board = 0; board < CELLBOARD_COUNT; ++board) {
+            for (size_t group = 0; group < BMS_BALANCING_PLAN_GROUP_COUNT; ++group) {
+                bms_balancing_plan_t raw_plan = {
+                    .cellboard_id = board,
+                    .group = group,
+                    .start = bal_is_plan_start(),
+                    .seq = bal_get_plan_seq()
+                };
+                memcpy(raw_plan.durations,
+                    plan->boards[board].durations + group * BMS_BALANCING_PLAN_CELL_COUNT,
+                    BMS_BALANCING_PLAN_CELL_COUNT);
+
+                int data_len = bms_balancing_plan_pack(buffer, &raw_plan, BMS_BALANCING_PLAN_BYTE_SIZE);
+                if (data_len < 0)
+                    return HAL_ERROR;
+                tx_header.DLC = data_len;
+
+                if (can_send(&BMS_CAN, buffer, &tx_header) != HAL_OK)
+                    ++errors;
+            }
+        }
+        return errors == 0 ? HAL_OK : HAL_ERROR;
+    }
+    else if (id == BMS_BALANCING_CONVERGENCE_FRAME_ID) {
+        int32_t eta = bal_get_eta();
+        float rate = bal_get_convergence_rate() * 100.f; // uV/s
+        bms_balancing_convergence_t raw_conv = {
+            .spread = bal_get_spread(),
+            .rate = (int16_t)MAX(INT16_MIN, MIN(rate, INT16_MAX)),
+            .eta = eta == BAL_CONVERGENCE_ETA_UNKNOWN ?
+                BMS_BALANCING_CONVERGENCE_ETA_UNKNOWN :
+                (uint16_t)MIN(eta / 60, BMS_BALANCING_CONVERGENCE_ETA_UNKNOWN - 1),
+            .charge = (uint16_t)MIN(bal_get_total_charge(), UINT16_MAX)
+        };
+
+        int data_len = bms_balancing_convergence_pack(buffer, &raw_conv, BMS_BALANCING_CONVERGENCE_BYTE_SIZE);
+        if (data_len < 0)
+            return HAL_ERROR;
+        tx_header.DLC = data_len;
+    }
+    else if (id == BMS_IMD_TREND_FRAME_ID) {
+        int32_t resistance = imd_get_resistance();
+        float rate = imd_decoder_get_trend(&imd_decoder);
+        bms_imd_trend_t raw_imd = {
+            .state = imd_get_state(),
+            .confidence = imd_get_confidence(),
+            .resistance = resistance < 0 ?
+                BMS_IMD_TREND_RESISTANCE_UNKNOWN :
+                (uint16_t)MIN(resistance, BMS_IMD_TREND_RESISTANCE_UNKNOWN - 1),
+            .rate = (int16_t)MAX(INT16_MIN, MIN(rate, INT16_MAX)),
+            .resistance_min = imd_decoder.resistance_min < 0 ?
+                BMS_IMD_TREND_RESISTANCE_UNKNOWN :
+                (uint16_t)MIN(imd_decoder.resistance_min, BMS_IMD_TREND_RESISTANCE_UNKNOWN - 1)
+        };
+
+        int data_len = bms_imd_trend_pack(buffer, &raw_imd, BMS_IMD_TREND_BYTE_SIZE);
+        if (data_len < 0)
+            return HAL_ERROR;
+        tx_header.DLC = data_len;
+    }
+    else if (id == BMS_CELL_ANOMALY_FRAME_ID) {
+        cell_anomaly_suspect_t suspects[CELL_ANOMALY_SUSPECT_COUNT];
+        size_t count = cell_anomaly_get_suspects(&cell_anomaly, suspects, CELL_ANOMALY_SUSPECT_COUNT);
+
+        size_t errors = 0;
+        for (size_t rank = 0; rank < count; ++rank) {
+            bms_cell_anomaly_t raw_anomaly = {
+                .rank = rank,
+                .cell = suspects[rank].cell,
+                .flags = suspects[rank].flags,
+                .score = (uint8_t)MIN(suspects[rank].score * 100.f, UINT8_MAX),
+                .z = (int8_t)MAX(INT8_MIN, MIN(suspects[rank].z * 10.f, INT8_MAX)),
+                .resistance = (int16_t)MAX(INT16_MIN, MIN(suspects[rank].resistance, INT16_MAX)),
+                .drift = (int8_t)MAX(INT8_MIN, MIN(suspects[rank].drift, INT8_MAX))
+            };
+
+            int data_len = bms_cell_anomaly_pack(buffer, &raw_anomaly, BMS_CELL_ANOMALY_BYTE_SIZE);
+            if (data_len < 0)
+                return HAL_ERROR;
+            tx_header.DLC = data_len;
+
+            if (can_send(&BMS_CAN, buffer, &tx_header) != HAL_OK)
+                ++errors;
+        }
+        return errors == 0 ? HAL_OK : HAL_ERROR;
+    }
+    else if (id == BMS_FEEDBACK_CAPTURE_FRAME_ID) {
+        size_t offset;
+        feedback_capture_sample_t sample;
+        if (!feedback_dump_next(&offset, &sample))
+            return HAL_ERROR;
+
+        bms_feedback_capture_t raw_capture = {
+            .offset = (uint16_t)offset,
+            .index = sample.index,
+            .trigger = offset == feedback_capture_get_trigger_offset(&feedback_capture),
+            .last = offset + 1 == feedback_capture_get_count(&feedback_capture),
+            .value = sample.value,
+            .time = sample.time
+        };
+
+        int data_len = bms_feedback_capture_pack(buffer, &raw_capture, BMS_FEEDBACK_CAPTURE_BYTE_SIZE);
+        if (data_len < 0)
+            return HAL_ERROR;
+        tx_header.DLC = data_len;
+    }
+    else if (id == BMS_SNAPSHOT_TRIGGER_FRAME_ID) {
+        bms_snapshot_trigger_t raw_trigger = { .seq = ++snapshot_seq };
+
+        int data_len = bms_snapshot_trigger_pack(buffer, &raw_trigger, BMS_SNAPSHOT_TRIGGER_BYTE_SIZE);
+        if (data_len < 0)
+            return HAL_ERROR;
+        tx_header.DLC = data_len;
+
+        // The snapshot has to be ready before any cellboard can answer
+        internal_voltage_sample_t sample = internal_voltage_get_sample();
+        cell_voltage_snapshot_start(raw_trigger.seq,
+            HAL_GetTick(),
+            current_get_current(),
+            sample.bat,
+            sample.tsp);
+    }
     else if (id == BMS_JMP_TO_BLT_FRAME_ID) {
         bms_jmp_to_blt_t raw_jmp = { 0 };
         bms_jmp_to_blt_converted_t conv_jmp = { 0 };
@@ -659,7 +858,14 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef * hcan) {
         error_simple_reset(ERROR_GROUP_ERROR_CAN, hcan->Instance != BMS_CAN.Instance);
 
         // Forward data to the cellboards
-        if (rx_header.StdId >= BMS_FLASH_CELLBOARD_0_TX_FRAME_ID && rx_header.StdId <= BMS_FLASH_CELLBOARD_5_RX_FRAME_ID) {
+        if (BMS_FLASH_CELLBOARD_IS_FRAME_ID(rx_header.StdId, CELLBOARD_COUNT)) {
+            // During a parallel flashing the answers are collected by can_flash_routine
+            if (flash_fanout_is_active(&flash_fanout)) {
+                size_t index = BMS_FLASH_CELLBOARD_INDEX(rx_header.StdId);
+                if (rx_header.StdId == BMS_FLASH_CELLBOARD_TX_FRAME_ID(index))
+                    flash_fanout_receive(&flash_fanout, index, rx_data, rx_header.DLC);
+                return;
+            }
             CAN_TxHeaderTypeDef tx_header = {
                 .DLC = rx_header.DLC,
                 .ExtId = 0,
@@ -684,33 +890,95 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef * hcan) {
             // Reset time since last communication
             time_since_last_comm[conv_volts.cellboard_id] = HAL_GetTick();
 
-            // Forward data
-            CAN_TxHeaderTypeDef tx_header = {
-                .DLC = 0,
-                .ExtId = 0,
-                .IDE = CAN_ID_STD,
-                .RTR = CAN_RTR_DATA,
-                .StdId = PRIMARY_HV_CELLS_VOLTAGE_FRAME_ID,
-                .TransmitGlobalTime = DISABLE
+            voltage_t volts[] = {
+                CONVERT_VOLTAGE_TO_VALUE(conv_volts.voltage0),
+                CONVERT_VOLTAGE_TO_VALUE(conv_volts.voltage1),
+                CONVERT_VOLTAGE_TO_VALUE(conv_volts.voltage2)
             };
-            uint8_t buffer[CAN_MAX_PAYLOAD_LENGTH] = { 0 };
-            primary_hv_cells_voltage_t raw_fwd_volts = { 0 };
-            primary_hv_cells_voltage_converted_t conv_fwd_volts = { 0 };
+            cell_voltage_set_cell_values(conv_volts.cellboard_id, conv_volts.start_index, volts, 3);
 
-            // Set start_index of the received cells between all cells of the pack
-            conv_fwd_volts.start_index = conv_volts.cellboard_id * CELLBOARD_CELL_COUNT + conv_volts.start_index;
-            conv_fwd_volts.voltage_0 = conv_volts.voltage0;
-            conv_fwd_volts.voltage_1 = conv_volts.voltage1;
-            conv_fwd_volts.voltage_2 = conv_volts.voltage2;
+            // Forward data
+            _can_forward_cells_voltage(
+                conv_volts.cellboard_id,
+                conv_volts.start_index,
+                conv_volts.voltage0,
+                conv_volts.voltage1,
+                conv_volts.voltage2);
+        }
+        else if (rx_header.StdId == BMS_SNAPSHOT_VOLTAGES_FRAME_ID) {
+            bms_snapshot_voltages_t raw_volts = { 0 };
+
+            if (bms_snapshot_voltages_unpack(&raw_volts, rx_data, rx_header.DLC) < 0 ||
+                raw_volts.cellboard_id >= CELLBOARD_COUNT) {
+                error_simple_set(ERROR_GROUP_ERROR_CAN, hcan->Instance != BMS_CAN.Instance);
+                return;
+            }
 
-            primary_hv_cells_voltage_conversion_to_raw_struct(&raw_fwd_volts, &conv_fwd_volts);
+            // Reset time since last communication
+            time_since_last_comm[raw_volts.cellboard_id] = HAL_GetTick();
+
+            // Values of an old snapshot are still valid as the last cells voltages
+            if (cell_voltage_snapshot_set_cells(
+                raw_volts.cellboard_id,
+                raw_volts.start_index,
+                raw_volts.seq,
+                raw_volts.voltages,
+                BMS_SNAPSHOT_VOLTAGES_CELL_COUNT) != HAL_OK) {
+                cell_voltage_set_cell_values(
+                    raw_volts.cellboard_id,
+                    raw_volts.start_index,
+                    raw_volts.voltages,
+                    BMS_SNAPSHOT_VOLTAGES_CELL_COUNT);
+            }
 
-            int data_len = primary_hv_cells_voltage_pack(buffer, &raw_fwd_volts, PRIMARY_HV_CELLS_VOLTAGE_BYTE_SIZE);
-            if (data_len < 0)
+            // Forward data
+            _can_forward_cells_voltage(
+                raw_volts.cellboard_id,
+                raw_volts.start_index,
+                CONVERT_VALUE_TO_VOLTAGE(raw_volts.voltages[0]),
+                CONVERT_VALUE_TO_VOLTAGE(raw_volts.voltages[1]),
+                CONVERT_VALUE_TO_VOLTAGE(raw_volts.voltages[2]));
+        }
+        else if (rx_header.StdId == BMS_BALANCING_CHARGE_FRAME_ID) {
+            bms_balancing_charge_t raw_charge = { 0 };
+
+            if (bms_balancing_charge_unpack(&raw_charge, rx_data, rx_header.DLC) < 0 ||
+                raw_charge.cellboard_id >= CELLBOARD_COUNT) {
+                error_simple_set(ERROR_GROUP_ERROR_CAN, hcan->Instance != BMS_CAN.Instance);
                 return;
-            tx_header.DLC = data_len;
+            }
+            bal_set_cells_charge(
+                raw_charge.cellboard_id,
+                raw_charge.start_index,
+                raw_charge.charges,
+                BMS_BALANCING_CHARGE_CELL_COUNT);
+        }
+        else if (rx_header.StdId == BMS_TEMP_EXCLUDED_FRAME_ID) {
+            bms_temp_excluded_t raw_excluded = { 0 };
 
-            can_send(&CAR_CAN, buffer, &tx_header);
+            if (bms_temp_excluded_unpack(&raw_excluded, rx_data, rx_header.DLC) < 0 ||
+                raw_excluded.cellboard_id >= CELLBOARD_COUNT) {
+                error_simple_set(ERROR_GROUP_ERROR_CAN, hcan->Instance != BMS_CAN.Instance);
+                return;
+            }
+            // Warn when the cellboard finds or recovers an unhealthy sensor
+            if (raw_excluded.unhealthy != temperature_get_unhealthy(raw_excluded.cellboard_id)) {
+                char msg[60];
+                str_writer_t writer;
+                str_writer_init(&writer, msg, sizeof(msg));
+                str_writer_append(&writer, "Cellboard ");
+                str_writer_append_uint(&writer, raw_excluded.cellboard_id, 0);
+                str_writer_append(&writer, ": ");
+                str_writer_append_uint(&writer, raw_excluded.unhealthy, 0);
+                str_writer_append(&writer, " unhealthy temperature sensors");
+                cli_bms_debug(msg, writer.length);
+            }
+            temperature_set_excluded(
+                raw_excluded.cellboard_id,
+                raw_excluded.group * BMS_TEMP_EXCLUDED_SENSOR_COUNT,
+                raw_excluded.excluded,
+                BMS_TEMP_EXCLUDED_SENSOR_COUNT,
+                raw_excluded.unhealthy);
         }
         else if (rx_header.StdId == BMS_VOLTAGES_INFO_FRAME_ID) {
             bms_voltages_info_t raw_volts = { 0 };
@@ -865,7 +1133,8 @@ void HAL_CAN_RxFifo0MsgPendingCallback(CAN_HandleTypeDef * hcan) {
                 conv_status.errors_temp_comm_3 |
                 conv_status.errors_temp_comm_4 |
                 conv_status.errors_temp_comm_5;
-            if (error_status != 0) {
+            // The unhealthy temperature sensors are interpolated, it is an error only when a strip has too few left
+            if (error_status != 0 || !temperature_is_interpolable(conv_status.cellboard_id)) {
                 error_simple_set(ERROR_GROUP_ERROR_CELLBOARD_INTERNAL, conv_status.cellboard_id);
             } else {
                 error_simple_reset(ERROR_GROUP_ERROR_CELLBOARD_INTERNAL, conv_status.cellboard_id);
@@ -981,7 +1250,14 @@ void HAL_CAN_RxFifo1MsgPendingCallback(CAN_HandleTypeDef *hcan) {
     if (hcan->Instance == CAR_CAN.Instance) {
         error_simple_reset(ERROR_GROUP_ERROR_CAN, hcan->Instance != BMS_CAN.Instance);
 
-        if (rx_header.StdId >= BMS_FLASH_CELLBOARD_0_TX_FRAME_ID && rx_header.StdId <= BMS_FLASH_CELLBOARD_5_RX_FRAME_ID) {
+        if (rx_header.StdId == BMS_FLASH_BROADCAST_RX_FRAME_ID) {
+            // The cellboards can be flashed only while the pack is not used
+            bms_state_t state = fsm_get_state();
+            if ((state == STATE_INIT || state == STATE_IDLE || state == STATE_FATAL_ERROR) && !bal_is_balancing())
+                flash_fanout_request(&flash_fanout, rx_data, rx_header.DLC);
+            return;
+        }
+        else if (BMS_FLASH_CELLBOARD_IS_FRAME_ID(rx_header.StdId, CELLBOARD_COUNT)) {
             CAN_TxHeaderTypeDef tx_header = {
                 .DLC = rx_header.DLC,
                 .ExtId = 0,
@@ -1135,6 +1411,55 @@ void CAN_change_bitrate(CAN_HandleTypeDef *hcan, CAN_Bitrate bitrate) {
         can_car_init();
 }
 
+void can_flash_routine() {
+    uint32_t now = HAL_GetTick();
+    bool was_active = flash_fanout_is_active(&flash_fanout);
+    uint32_t failed = flash_fanout.failed;
+
+    flash_fanout_update(&flash_fanout, now);
+    bool active = flash_fanout_is_active(&flash_fanout);
+    if (!active && !was_active)
+        return;
+
+    if (active && !was_active) {
+        // Reset every cellboard into its bootloader and stop the other messages
+        for (flash_cellboard_id = 0; flash_cellboard_id < CELLBOARD_COUNT; ++flash_cellboard_id)
+            can_bms_send(BMS_JMP_TO_BLT_FRAME_ID);
+        can_forward = true;
+    }
+
+    CAN_TxHeaderTypeDef tx_header = {
+        .DLC = 0,
+        .ExtId = 0,
+        .IDE = CAN_ID_STD,
+        .RTR = CAN_RTR_DATA,
+        .StdId = 0,
+        .TransmitGlobalTime = DISABLE
+    };
+    uint8_t buffer[CAN_MAX_PAYLOAD_LENGTH] = { 0 };
+    uint8_t length = 0;
+
+    // Copy the command to the bootloaders without waiting for the mailboxes
+    int32_t board;
+    while (HAL_CAN_GetTxMailboxesFreeLevel(&BMS_CAN) > 0 &&
+        (board = flash_fanout_next(&flash_fanout, now, buffer, &length)) >= 0) {
+        tx_header.StdId = BMS_FLASH_CELLBOARD_RX_FRAME_ID(board);
+        tx_header.DLC = length;
+        can_send(&BMS_CAN, buffer, &tx_header);
+    }
+
+    if (flash_fanout_get_answer(&flash_fanout, buffer, &length)) {
+        tx_header.StdId = BMS_FLASH_BROADCAST_TX_FRAME_ID;
+        tx_header.DLC = length;
+        can_send(&CAR_CAN, buffer, &tx_header);
+    }
+
+    if (active != was_active || flash_fanout.failed != failed)
+        _can_send_flash_status();
+    if (!active)
+        can_forward = false;
+}
+
 void can_cellboards_check() {
     for (size_t i = 0; i < CELLBOARD_COUNT; i++) {
         if (time_since_last_comm[i] > 0) {
@@ -80,6 +80,29 @@ int16_t _max22530_cmd_read(MAX22530_HandleTypeDef * handler, uint8_t address) {
     uint16_t data = cmd[2] | ((uint16_t)cmd[1] << 8);
     return data;
 }
+/**
+ * @brief Fill the command of a burst read
+ * 
+ * @param cmd The command of MAX22530_BURST_SIZE bytes
+ * @param filtered If true the data are read from the filtered ADC
+ */
+void _max22530_burst_encode(uint8_t cmd[MAX22530_BURST_SIZE], bool filtered) {
+    // Fill unused data with 0xFF
+    for (size_t i = 0; i < MAX22530_BURST_SIZE; i++)
+        cmd[i] = 0xFF;
+    
+    cmd[0] = ((MAX22530_CH1 + (filtered != 0) * MAX22530_FILTERED_OFFSET) << 2) | MAX22530_BURST;
+}
+/**
+ * @brief Get the channels data from the answer of a burst read
+ * 
+ * @param cmd The answer of MAX22530_BURST_SIZE bytes
+ * @param data Array where the data is stored
+ */
+void _max22530_burst_decode(const uint8_t cmd[MAX22530_BURST_SIZE], uint16_t data[MAX22530_CHANNEL_COUNT]) {
+    for (size_t i = 0; i < MAX22530_CHANNEL_COUNT; i++)
+        data[i] = cmd[i * 2 + 2] | (((uint16_t)cmd[i * 2 + 1] & 0x0F) << 8);
+}
 /**
  * @brief Read channels data from the address of the MAX22530
  * 
@@ -92,26 +115,17 @@ HAL_StatusTypeDef _max22530_cmd_burst(MAX22530_HandleTypeDef * handler, uint16_t
     if (handler == NULL || data == NULL)
         return HAL_ERROR;
     
-    const size_t cmd_size = 11;
-    uint8_t cmd[cmd_size];
-
-    // Fill unused data with 0xFF
-    for (size_t i = 0; i < cmd_size; i++)
-        cmd[i] = 0xFF;
-    
-    cmd[0] = ((MAX22530_CH1 + (filtered != 0) * MAX22530_FILTERED_OFFSET) << 2) | MAX22530_BURST;
+    uint8_t cmd[MAX22530_BURST_SIZE];
+    _max22530_burst_encode(cmd, filtered);
     
     HAL_StatusTypeDef status;
-    if ((status = _max22530_cmd_send(handler, cmd, cmd_size)) != HAL_OK)
+    if ((status = _max22530_cmd_send(handler, cmd, MAX22530_BURST_SIZE)) != HAL_OK)
         return status;
 
-    for (size_t i = 0; i < MAX22530_CHANNEL_COUNT; i++)
-        data[i] = cmd[i * 2 + 2] | (((uint16_t)cmd[i * 2 + 1] & 0x0F) << 8);
-
+    _max22530_burst_decode(cmd, data);
     return HAL_OK;
 }
 
-
 int8_t max22530_get_id(MAX22530_HandleTypeDef * handler) {
     uint16_t data = _max22530_cmd_read(handler, MAX22530_ID_REG);
     if (data < 0)
@@ -174,3 +188,28 @@ HAL_StatusTypeDef max22530_read_all_channels(MAX22530_HandleTypeDef * handler, u
         volts[i] = data[i];
     return HAL_OK;
 }
+HAL_StatusTypeDef max22530_burst_start(MAX22530_HandleTypeDef * handler, bool filtered) {
+    if (handler == NULL)
+        return HAL_ERROR;
+
+    _max22530_burst_encode(handler->burst_tx, filtered);
+
+    _MAX22530_CS_ENABLE(handler);
+    HAL_StatusTypeDef status = HAL_SPI_TransmitReceive_DMA(handler->spi, handler->burst_tx, handler->burst_rx, MAX22530_BURST_SIZE);
+    if (status != HAL_OK)
+        _MAX22530_CS_DISABLE(handler);
+    return status;
+}
+HAL_StatusTypeDef max22530_burst_complete(MAX22530_HandleTypeDef * handler, uint16_t volts[MAX22530_CHANNEL_COUNT]) {
+    if (handler == NULL || volts == NULL)
+        return HAL_ERROR;
+
+    _MAX22530_CS_DISABLE(handler);
+    _max22530_burst_decode(handler->burst_rx, volts);
+    return HAL_OK;
+}
+void max22530_burst_abort(MAX22530_HandleTypeDef * handler) {
+    if (handler == NULL)
+        return;
+    _MAX22530_CS_DISABLE(handler);
+}
@@ -0,0 +1,160 @@
+/**
+ * @file str_writer.c
+ * @brief Bounded text writer used to build the output of the CLI
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "str_writer.h"
+
+#include <string.h>
+
+static const uint32_t str_writer_pow10[STR_WRITER_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+/**
+ * @brief Append the digits of a number with its sign and padding
+ *
+ * @param writer The writer
+ * @param negative True if the minus sign has to be printed
+ * @param integer The integer part
+ * @param fraction The decimal part
+ * @param decimals The number of decimal digits
+ * @param width The minimum number of characters
+ */
+void _str_writer_append_number(str_writer_t * writer,
+    bool negative,
+    uint32_t integer,
+    uint32_t fraction,
+    uint8_t decimals,
+    uint8_t width) {
+    // Longest number: sign, 10 digits, point and the decimal digits
+    char digits[12 + STR_WRITER_MAX_DECIMALS];
+    size_t start = sizeof(digits);
+
+    for (uint8_t i = 0; i < decimals; ++i) {
+        digits[--start] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    if (decimals > 0)
+        digits[--start] = '.';
+    do {
+        digits[--start] = '0' + integer % 10;
+        integer /= 10;
+    } while (integer > 0);
+    if (negative)
+        digits[--start] = '-';
+
+    size_t length = sizeof(digits) - start;
+    if (width > length)
+        str_writer_append_repeat(writer, ' ', width - length);
+    str_writer_append_n(writer, digits + start, length);
+}
+
+void str_writer_init(str_writer_t * writer, char * buf, size_t size) {
+    writer->buf = buf;
+    writer->size = size;
+    writer->length = 0;
+    writer->truncated = size == 0;
+    if (size > 0)
+        buf[0] = '\0';
+}
+
+void str_writer_append_n(str_writer_t * writer, const char * str, size_t length) {
+    if (writer->truncated)
+        return;
+    size_t available = writer->size - writer->length - 1;
+    if (length > available) {
+        length = available;
+        writer->truncated = true;
+    }
+    memcpy(writer->buf + writer->length, str, length);
+    writer->length += length;
+    writer->buf[writer->length] = '\0';
+}
+
+void str_writer_append(str_writer_t * writer, const char * str) {
+    str_writer_append_n(writer, str, strlen(str));
+}
+
+void str_writer_append_repeat(str_writer_t * writer, char c, size_t count) {
+    if (writer->truncated)
+        return;
+    size_t available = writer->size - writer->length - 1;
+    if (count > available) {
+        count = available;
+        writer->truncated = true;
+    }
+    memset(writer->buf + writer->length, c, count);
+    writer->length += count;
+    writer->buf[writer->length] = '\0';
+}
+
+void str_writer_append_padded(str_writer_t * writer, const char * str, size_t width) {
+    size_t length = strlen(str);
+    str_writer_append_n(writer, str, length);
+    if (width > length)
+        str_writer_append_repeat(writer, ' ', width - length);
+}
+
+void str_writer_append_uint(str_writer_t * writer, uint32_t value, uint8_t width) {
+    _str_writer_append_number(writer, false, value, 0, 0, width);
+}
+
+void str_writer_append_int(str_writer_t * writer, int32_t value, uint8_t width) {
+    uint32_t magnitude = value < 0 ? -(uint32_t)value : (uint32_t)value;
+    _str_writer_append_number(writer, value < 0, magnitude, 0, 0, width);
+}
+
+void str_writer_append_hex(str_writer_t * writer, uint32_t value, uint8_t digits) {
+    char hex[8];
+    size_t start = sizeof(hex);
+    do {
+        hex[--start] = "0123456789ABCDEF"[value & 0xF];
+        value >>= 4;
+    } while (value > 0);
+    if (digits > sizeof(hex) - start)
+        str_writer_append_repeat(writer, '0', digits - (sizeof(hex) - start));
+    str_writer_append_n(writer, hex + start, sizeof(hex) - start);
+}
+
+void str_writer_append_fixed(str_writer_t * writer, int32_t value, uint8_t scale, uint8_t decimals, uint8_t width) {
+    if (scale > STR_WRITER_MAX_DECIMALS)
+        scale = STR_WRITER_MAX_DECIMALS;
+    if (decimals > STR_WRITER_MAX_DECIMALS)
+        decimals = STR_WRITER_MAX_DECIMALS;
+
+    bool negative = value < 0;
+    uint64_t magnitude = negative ? -(int64_t)value : value;
+
+    // Bring the value to the requested number of decimals, rounding half away from zero
+    if (decimals < scale) {
+        uint32_t divisor = str_writer_pow10[scale - decimals];
+        magnitude = (magnitude + divisor / 2) / divisor;
+    } else {
+        magnitude *= str_writer_pow10[decimals - scale];
+    }
+
+    uint32_t integer = (uint32_t)(magnitude / str_writer_pow10[decimals]);
+    uint32_t fraction = (uint32_t)(magnitude % str_writer_pow10[decimals]);
+    _str_writer_append_number(writer, negative && magnitude > 0, integer, fraction, decimals, width);
+}
+
+void str_writer_append_float(str_writer_t * writer, float value, uint8_t decimals, uint8_t width) {
+    if (decimals > STR_WRITER_MAX_DECIMALS)
+        decimals = STR_WRITER_MAX_DECIMALS;
+    if (value != value) {
+        str_writer_append(writer, "nan");
+        return;
+    }
+
+    float scaled = value * str_writer_pow10[decimals];
+    scaled += scaled < 0 ? -0.5f : 0.5f;
+    int32_t fixed;
+    if (scaled >= 2147483520.0f)
+        fixed = INT32_MAX;
+    else if (scaled <= -2147483520.0f)
+        fixed = -INT32_MAX;
+    else
+        fixed = (int32_t)scaled;
+    str_writer_append_fixed(writer, fixed, decimals, decimals, width);
+}
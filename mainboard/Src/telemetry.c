@@ -0,0 +1,137 @@
+/**
+ * @file telemetry.c
+ * @brief Binary telemetry frames sent over the CLI UART
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "telemetry.h"
+
+#include <string.h>
+
+/** @brief CRC16 CCITT lookup table, 4 bits at a time */
+static const uint16_t telemetry_crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+    0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+/** @brief Copy a value in little endian */
+uint8_t * _telemetry_put(uint8_t * out, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+        *(out++) = (uint8_t)(value >> (8U * i));
+    return out;
+}
+
+uint16_t telemetry_crc16(const uint8_t * data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; ++i) {
+        crc = (crc << 4) ^ telemetry_crc_table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ telemetry_crc_table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+size_t telemetry_cobs_encode(const uint8_t * data, size_t length, uint8_t * out) {
+    size_t code_index = 0;
+    size_t out_index = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < length; ++i) {
+        if (data[i] != 0) {
+            out[out_index++] = data[i];
+            ++code;
+        }
+        // Close the block at every zero or when it reaches the maximum length
+        if (data[i] == 0 || code == 0xFF) {
+            out[code_index] = code;
+            code_index = out_index++;
+            code = 1;
+        }
+    }
+    out[code_index] = code;
+    return out_index;
+}
+
+size_t telemetry_cobs_decode(const uint8_t * data, size_t length, uint8_t * out) {
+    size_t out_index = 0;
+
+    for (size_t i = 0; i < length; ) {
+        uint8_t code = data[i++];
+        if (code == 0 || i + code - 1 > length)
+            return 0;
+        for (uint8_t j = 1; j < code; ++j) {
+            if (data[i] == 0)
+                return 0;
+            out[out_index++] = data[i++];
+        }
+        // A block shorter than the maximum is followed by a zero, except the last one
+        if (code != 0xFF && i < length)
+            out[out_index++] = 0;
+    }
+    return out_index;
+}
+
+size_t telemetry_frame_encode(TELEMETRY_FRAME type, uint8_t seq, const uint8_t * payload, size_t length, uint8_t * out) {
+    uint8_t raw[TELEMETRY_RAW_SIZE(TELEMETRY_MAX_PAYLOAD)];
+    if (length > TELEMETRY_MAX_PAYLOAD || (payload == NULL && length > 0) || out == NULL)
+        return 0;
+
+    raw[0] = (uint8_t)type;
+    raw[1] = seq;
+    if (length > 0)
+        memcpy(raw + 2, payload, length);
+    uint16_t crc = telemetry_crc16(raw, length + 2);
+    _telemetry_put(raw + length + 2, crc, 2);
+
+    // The leading delimiter ends any text sent before the frame
+    out[0] = 0;
+    size_t size = telemetry_cobs_encode(raw, TELEMETRY_RAW_SIZE(length), out + 1) + 1;
+    out[size++] = 0;
+    return size;
+}
+
+int32_t telemetry_frame_decode(const uint8_t * data, size_t length, uint8_t * type, uint8_t * seq, uint8_t * payload) {
+    uint8_t raw[TELEMETRY_RAW_SIZE(TELEMETRY_MAX_PAYLOAD)];
+    if (data == NULL || length > TELEMETRY_ENCODED_SIZE(TELEMETRY_MAX_PAYLOAD))
+        return -1;
+
+    size_t size = telemetry_cobs_decode(data, length, raw);
+    if (size < TELEMETRY_RAW_SIZE(0) || size > sizeof(raw))
+        return -1;
+
+    uint16_t crc = raw[size - 2] | ((uint16_t)raw[size - 1] << 8);
+    if (telemetry_crc16(raw, size - 2) != crc)
+        return -1;
+
+    *type = raw[0];
+    *seq = raw[1];
+    memcpy(payload, raw + 2, size - 4);
+    return (int32_t)(size - 4);
+}
+
+size_t telemetry_snapshot_serialize(const telemetry_snapshot_t * snapshot, uint8_t * out) {
+    uint8_t * ptr = out;
+    ptr = _telemetry_put(ptr, snapshot->timestamp, 4);
+    ptr = _telemetry_put(ptr, snapshot->state, 1);
+    ptr = _telemetry_put(ptr, (uint32_t)snapshot->current, 4);
+    ptr = _telemetry_put(ptr, snapshot->feedback_high, 4);
+    ptr = _telemetry_put(ptr, snapshot->feedback_error, 4);
+    ptr = _telemetry_put(ptr, CELLBOARD_COUNT, 1);
+    ptr = _telemetry_put(ptr, CELLBOARD_CELL_COUNT, 1);
+    return (size_t)(ptr - out);
+}
+
+size_t telemetry_cellboard_serialize(const telemetry_snapshot_t * snapshot, size_t cellboard, uint8_t * out) {
+    if (cellboard >= CELLBOARD_COUNT)
+        return 0;
+    uint8_t * ptr = out;
+    ptr = _telemetry_put(ptr, snapshot->timestamp, 4);
+    ptr = _telemetry_put(ptr, (uint32_t)cellboard, 1);
+    ptr = _telemetry_put(ptr, snapshot->temp_min[cellboard], 1);
+    ptr = _telemetry_put(ptr, snapshot->temp_max[cellboard], 1);
+    ptr = _telemetry_put(ptr, snapshot->temp_avg[cellboard], 1);
+    const voltage_t * voltages = snapshot->voltages + cellboard * CELLBOARD_CELL_COUNT;
+    for (size_t i = 0; i < CELLBOARD_CELL_COUNT; ++i)
+        ptr = _telemetry_put(ptr, voltages[i], 2);
+    return (size_t)(ptr - out);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file tx_ring.c
+ * @brief Lock-free ring buffer for the outgoing serial data
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "tx_ring.h"
+
+#include <string.h>
+
+#define TX_RING_INDEX_MASK ((1U << TX_RING_INDEX_BITS) - 1U)
+#define TX_RING_COMMIT_SHIFT TX_RING_INDEX_BITS
+#define TX_RING_WRITERS_SHIFT (2U * TX_RING_INDEX_BITS)
+
+#define TX_RING_GET_RESERVE(STATE) ((STATE) & TX_RING_INDEX_MASK)
+#define TX_RING_GET_COMMIT(STATE) (((STATE) >> TX_RING_COMMIT_SHIFT) & TX_RING_INDEX_MASK)
+#define TX_RING_GET_WRITERS(STATE) ((STATE) >> TX_RING_WRITERS_SHIFT)
+#define TX_RING_STATE(RESERVE, COMMIT, WRITERS) \
+    (((RESERVE) & TX_RING_INDEX_MASK) | \
+    (((COMMIT) & TX_RING_INDEX_MASK) << TX_RING_COMMIT_SHIFT) | \
+    ((uint32_t)(WRITERS) << TX_RING_WRITERS_SHIFT))
+
+#if (TX_RING_SIZE & (TX_RING_SIZE - 1U)) != 0
+#error "TX_RING_SIZE must be a power of two"
+#endif
+#if TX_RING_SIZE >= (1U << TX_RING_INDEX_BITS)
+#error "TX_RING_INDEX_BITS is too small for TX_RING_SIZE"
+#endif
+
+/** @brief Count a dropped message */
+void _tx_ring_drop(tx_ring_t * ring, size_t length) {
+    __atomic_add_fetch(&ring->dropped, 1U, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ring->dropped_bytes, (uint32_t)length, __ATOMIC_RELAXED);
+}
+
+void tx_ring_init(tx_ring_t * ring) {
+    if (ring == NULL)
+        return;
+    ring->state = TX_RING_STATE(0U, 0U, 0U);
+    ring->tail = 0U;
+    ring->dropped = 0U;
+    ring->dropped_bytes = 0U;
+}
+
+bool tx_ring_write(tx_ring_t * ring, const char * data, size_t length) {
+    if (ring == NULL || data == NULL)
+        return false;
+    if (length == 0)
+        return true;
+    if (length > TX_RING_SIZE) {
+        _tx_ring_drop(ring, length);
+        return false;
+    }
+
+    // Reserve the space for the message
+    uint32_t state = __atomic_load_n(&ring->state, __ATOMIC_ACQUIRE);
+    uint32_t new_state;
+    uint32_t start;
+    do {
+        start = TX_RING_GET_RESERVE(state);
+        uint32_t used = (start - ring->tail) & TX_RING_INDEX_MASK;
+        uint32_t writers = TX_RING_GET_WRITERS(state);
+        if (used + length > TX_RING_SIZE || writers >= TX_RING_MAX_WRITERS) {
+            _tx_ring_drop(ring, length);
+            return false;
+        }
+        new_state = TX_RING_STATE(start + length, TX_RING_GET_COMMIT(state), writers + 1U);
+    } while (!__atomic_compare_exchange_n(&ring->state, &state, new_state, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+
+    // Copy the message, it may wrap around the end of the buffer
+    size_t offset = start & (TX_RING_SIZE - 1U);
+    size_t first = TX_RING_SIZE - offset;
+    if (first > length)
+        first = length;
+    memcpy(ring->data + offset, data, first);
+    memcpy(ring->data, data + first, length - first);
+
+    // Publish the data if this is the last writer
+    state = __atomic_load_n(&ring->state, __ATOMIC_ACQUIRE);
+    do {
+        uint32_t writers = TX_RING_GET_WRITERS(state) - 1U;
+        uint32_t commit = writers == 0 ? TX_RING_GET_RESERVE(state) : TX_RING_GET_COMMIT(state);
+        new_state = TX_RING_STATE(TX_RING_GET_RESERVE(state), commit, writers);
+    } while (!__atomic_compare_exchange_n(&ring->state, &state, new_state, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+    return true;
+}
+
+size_t tx_ring_peek(tx_ring_t * ring, char ** data) {
+    if (ring == NULL || data == NULL)
+        return 0;
+
+    uint32_t commit = TX_RING_GET_COMMIT(__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE));
+    uint32_t tail = ring->tail;
+    size_t pending = (commit - tail) & TX_RING_INDEX_MASK;
+    size_t offset = tail & (TX_RING_SIZE - 1U);
+    size_t contiguous = TX_RING_SIZE - offset;
+
+    *data = ring->data + offset;
+    return pending < contiguous ? pending : contiguous;
+}
+
+void tx_ring_consume(tx_ring_t * ring, size_t length) {
+    if (ring == NULL)
+        return;
+    ring->tail = (ring->tail + length) & TX_RING_INDEX_MASK;
+}
+
+size_t tx_ring_get_pending(tx_ring_t * ring) {
+    if (ring == NULL)
+        return 0;
+    uint32_t commit = TX_RING_GET_COMMIT(__atomic_load_n(&ring->state, __ATOMIC_ACQUIRE));
+    return (commit - ring->tail) & TX_RING_INDEX_MASK;
+}
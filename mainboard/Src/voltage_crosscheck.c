@@ -0,0 +1,72 @@
+/**
+ * @file voltage_crosscheck.c
+ * @brief Plausibility check between the cell voltages and the internal ADC
+ *
+ * @date Oct 19, 2026
+ */
+
+#include "voltage_crosscheck.h"
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../../fenice_config.h"
+
+void voltage_crosscheck_init(voltage_crosscheck_t * check) {
+    if (check == NULL)
+        return;
+    memset(check, 0, sizeof(voltage_crosscheck_t));
+}
+
+/** @brief Tolerance of a comparison at a given voltage and current */
+float _voltage_crosscheck_tolerance(float voltage, float current, float noise) {
+    float tolerance = VOLTAGE_CROSSCHECK_TOLERANCE +
+        VOLTAGE_CROSSCHECK_TOLERANCE_GAIN * fabsf(voltage) +
+        VOLTAGE_CROSSCHECK_TOLERANCE_RESISTANCE * fabsf(current) +
+        VOLTAGE_CROSSCHECK_TOLERANCE_SIGMA * sqrtf(noise);
+    return MIN(tolerance, VOLTAGE_CROSSCHECK_TOLERANCE_MAX);
+}
+
+uint8_t voltage_crosscheck_update(voltage_crosscheck_t * check, const voltage_crosscheck_sample_t * sample) {
+    if (check == NULL || sample == NULL)
+        return VOLTAGE_CROSSCHECK_SKIPPED;
+
+    // The measures are taken a few ms apart, skip them while the current changes quickly
+    const bool steady = check->has_previous &&
+        fabsf(sample->current - check->previous_current) <= VOLTAGE_CROSSCHECK_MAX_STEP;
+    check->previous_current = sample->current;
+    check->has_previous = true;
+    if (!steady)
+        return VOLTAGE_CROSSCHECK_SKIPPED;
+
+    uint8_t result = VOLTAGE_CROSSCHECK_OK;
+
+    // Cell sum against VBATT
+    const float expected_bat = sample->cell_sum - sample->current * VOLTAGE_CROSSCHECK_PACK_RESISTANCE + check->offset;
+    check->bat_residual = sample->bat - expected_bat;
+    check->bat_tolerance = _voltage_crosscheck_tolerance(sample->cell_sum, sample->current, check->noise);
+    if (fabsf(check->bat_residual) > check->bat_tolerance) {
+        result |= VOLTAGE_CROSSCHECK_BAT_MISMATCH;
+    }
+    else if (fabsf(sample->current) <= VOLTAGE_CROSSCHECK_LEARN_CURRENT) {
+        // Learn only from plausible samples with a small drop, so a fault is never learned
+        check->offset += VOLTAGE_CROSSCHECK_OFFSET_ALPHA * check->bat_residual;
+        check->offset = MAX(-VOLTAGE_CROSSCHECK_MAX_OFFSET, MIN(check->offset, VOLTAGE_CROSSCHECK_MAX_OFFSET));
+        check->noise += VOLTAGE_CROSSCHECK_NOISE_ALPHA * (check->bat_residual * check->bat_residual - check->noise);
+    }
+
+    // VBATT against TS+, only when they are connected
+    if (sample->ts_connected) {
+        const float expected_ts = sample->bat - sample->current * VOLTAGE_CROSSCHECK_TS_RESISTANCE;
+        check->ts_residual = sample->tsp - expected_ts;
+        check->ts_tolerance = _voltage_crosscheck_tolerance(sample->bat, sample->current, check->noise);
+        if (fabsf(check->ts_residual) > check->ts_tolerance)
+            result |= VOLTAGE_CROSSCHECK_TS_MISMATCH;
+    } else {
+        check->ts_residual = 0.f;
+        check->ts_tolerance = 0.f;
+    }
+
+    return result;
+}
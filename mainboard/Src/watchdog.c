@@ -1,15 +1,14 @@
 /**
  * @file watchdog.c
  * @brief Functions and structure to handle watchdog timeouts
- * 
+ *
  * @date Jul 06, 2023
- * 
+ *
  * @author Antonio Gelain [antonio.gelain@studenti.unitn.it]
  */
 #include "watchdog.h"
 
 #include <stddef.h>
-#include <string.h> // Used for memset in primary and bms watchdogs
 
 #include "primary_network.h"
 #include "primary_watchdog.h"
@@ -17,15 +16,21 @@
 #include "bms_watchdog.h"
 #include "bms_fsm.h"
 #include "cli_bms.h"
+#include "deadline_heap.h"
+#include "str_writer.h"
 
 #define PRIMARY_WATCHDOG_IDS_SIZE 1
 #define BMS_WATCHDOG_IDS_SIZE 1
 
-primary_watchdog car_watchdog = { 0 };
-bms_watchdog cell_watchdog = { 0 };
+#if PRIMARY_WATCHDOG_IDS_SIZE + BMS_WATCHDOG_IDS_SIZE > DEADLINE_HEAP_CAPACITY
+#error "Too many IDs monitored by the watchdog"
+#endif
 
-bool car_watchdog_timed_out = false;
-bool cell_watchdog_timed_out = false;
+/**
+ * @brief Deadlines of the monitored IDs
+ * @details The primary IDs are the first entries of the heap, followed by the bms ones
+ */
+deadline_heap_t watchdog_heap;
 
 /** @brief Primary IDs monitored by the watchdog */
 const uint16_t watchdog_primary_ids[PRIMARY_WATCHDOG_IDS_SIZE] = {
@@ -38,19 +43,79 @@ const uint16_t watchdog_bms_ids[BMS_WATCHDOG_IDS_SIZE] = {
     BMS_BOARD_STATUS_FRAME_ID
 };
 
+/** @brief Get the timeout of a message from its interval in the network definition */
+uint32_t _watchdog_timeout(int interval) {
+    return WATCHDOG_TIMEOUT_MS(interval);
+}
+
+/** @brief Handle the first expiration of a monitored ID */
+void _watchdog_expired(size_t index) {
+    bool primary = index < PRIMARY_WATCHDOG_IDS_SIZE;
+    uint16_t id = primary ? watchdog_primary_ids[index] : watchdog_bms_ids[index - PRIMARY_WATCHDOG_IDS_SIZE];
+
+#ifndef WATCHDOG_IGNORE
+#ifdef WATCHDOG_IGNORE_PRIMARY
+    if (primary)
+        return;
+#endif // WATCHDOG_IGNORE_PRIMARY
+#ifdef WATCHDOG_IGNORE_BMS
+    if (!primary)
+        return;
+#endif // WATCHDOG_IGNORE_BMS
+
+    // Report only the first timeout, then keep the TS off until the message is back
+    if (deadline_heap_get_misses(&watchdog_heap, index) == 1) {
+        char msg[50];
+        str_writer_t writer;
+        str_writer_init(&writer, msg, sizeof(msg));
+        str_writer_append(&writer, primary ? "Car watchdog id: " : "Cell watchdog id: ");
+        str_writer_append_uint(&writer, id, 0);
+        str_writer_append(&writer, "\n");
+        cli_bms_debug(msg, writer.length);
+    }
+
+    // Set error
+    // error_simple_set(ERROR_CAN, primary ? 0 : 1, HAL_GetTick());
+
+    // Send TS off request
+    set_ts_request.is_new = true;
+    set_ts_request.next_state = STATE_IDLE;
+#else
+    (void)primary;
+    (void)id;
+#endif // WATCHDOG_IGNORE
+}
+
 void watchdog_init() {
+    uint32_t now = HAL_GetTick();
+    deadline_heap_init(&watchdog_heap);
+
     for (size_t i = 0; i < PRIMARY_WATCHDOG_IDS_SIZE; i++) {
         uint16_t id = watchdog_primary_ids[i];
-        CANLIB_BITSET_ARRAY(car_watchdog.activated, primary_watchdog_index_from_id(id));
+        deadline_heap_add(&watchdog_heap, _watchdog_timeout(primary_watchdog_interval_from_id(id)), now);
     }
     for (size_t i = 0; i < BMS_WATCHDOG_IDS_SIZE; i++) {
         uint16_t id = watchdog_bms_ids[i];
-        CANLIB_BITSET_ARRAY(cell_watchdog.activated, bms_watchdog_index_from_id(id));
+        deadline_heap_add(&watchdog_heap, _watchdog_timeout(bms_watchdog_interval_from_id(id)), now);
     }
 }
 
 bool is_watchdog_timed_out() {
-    return car_watchdog_timed_out || cell_watchdog_timed_out;
+#ifndef WATCHDOG_IGNORE
+#ifndef WATCHDOG_IGNORE_PRIMARY
+    for (size_t i = 0; i < PRIMARY_WATCHDOG_IDS_SIZE; i++) {
+        if (deadline_heap_is_expired(&watchdog_heap, i))
+            return true;
+    }
+#endif // WATCHDOG_IGNORE_PRIMARY
+#ifndef WATCHDOG_IGNORE_BMS
+    for (size_t i = 0; i < BMS_WATCHDOG_IDS_SIZE; i++) {
+        if (deadline_heap_is_expired(&watchdog_heap, PRIMARY_WATCHDOG_IDS_SIZE + i))
+            return true;
+    }
+#endif // WATCHDOG_IGNORE_BMS
+#endif // WATCHDOG_IGNORE
+    return false;
 }
 
 void watchdog_reset(uint16_t id) {
@@ -58,64 +123,30 @@ void watchdog_reset(uint16_t id) {
         // Reset errors
         // error_reset(ERROR_CAN, 0);
 
-        // Reset primary watchdog
-        primary_watchdog_reset(&car_watchdog, id, HAL_GetTick());
-        car_watchdog_timed_out = false;
+        for (size_t i = 0; i < PRIMARY_WATCHDOG_IDS_SIZE; i++) {
+            if (watchdog_primary_ids[i] == id) {
+                deadline_heap_reset(&watchdog_heap, i, HAL_GetTick());
+                return;
+            }
+        }
     }
     else if (bms_id_is_message(id)) {
         // Reset errors
         // error_reset(ERROR_CAN, 1);
 
-        // Reset bms watchdog
-        bms_watchdog_reset(&cell_watchdog, id, HAL_GetTick());
-        cell_watchdog_timed_out = false;
+        for (size_t i = 0; i < BMS_WATCHDOG_IDS_SIZE; i++) {
+            if (watchdog_bms_ids[i] == id) {
+                deadline_heap_reset(&watchdog_heap, PRIMARY_WATCHDOG_IDS_SIZE + i, HAL_GetTick());
+                return;
+            }
+        }
     }
 }
 
 void watchdog_routine() {
-    primary_watchdog_timeout(&car_watchdog, HAL_GetTick());
-    bms_watchdog_timeout(&cell_watchdog, HAL_GetTick());
-
-#if !defined(WATCHDOG_IGNORE_PRIMARY) && !defined(WATCHDOG_IGNORE)
-    for (size_t i = 0; i < PRIMARY_WATCHDOG_IDS_SIZE; i++) {
-        // Check if the primary watchdog has timed out
-        uint16_t id = watchdog_primary_ids[i];
-        bool timed_out = CANLIB_BITTEST_ARRAY(car_watchdog.timeout, primary_watchdog_index_from_id(id));
-        if (timed_out) {
-            char msg[50] = { 0 };
-            sprintf(msg, "Car watchdog id: %d\n", id);
-            cli_bms_debug(msg, strlen(msg));
-
-            car_watchdog_timed_out = true;
-
-            // Set error
-            // error_simple_set(ERROR_CAN, 0, HAL_GetTick());
-
-            // Send TS off request
-            set_ts_request.is_new = true;
-            set_ts_request.next_state = STATE_IDLE;
-        }
-    }
-#endif // WATCHDOG_IGNORE_PRIMARY && WATCHDOG_IGNORE
-
-#if !defined(WATCHDOG_IGNORE_BMS) && !defined(WATCHDOG_IGNORE)
-    for (size_t i = 0; i < BMS_WATCHDOG_IDS_SIZE; i++) {
-        // Check if the bms watchdog has timed out
-        uint16_t id = watchdog_bms_ids[i];
-        bool timed_out = CANLIB_BITTEST_ARRAY(cell_watchdog.timeout, bms_watchdog_index_from_id(id));
-        if (timed_out) {
-            char msg[50] = { 0 };
-            sprintf(msg, "Cell watchdog id: %d\n", id);
-            cli_bms_debug(msg, strlen(msg));
-
-            cell_watchdog_timed_out = true;
-            // Set error
-            // error_simple_set(ERROR_CAN, 1, HAL_GetTick());
-
-            // Send TS off request
-            set_ts_request.is_new = true;
-            set_ts_request.next_state = STATE_IDLE;
-        }
-    }
-#endif // WATCHDOG_IGNORE_BMS && WATCHDOG_IGNORE
+    // Only the earliest deadline is checked unless something has expired
+    int32_t index;
+    uint32_t now = HAL_GetTick();
+    while ((index = deadline_heap_check(&watchdog_heap, now)) >= 0)
+        _watchdog_expired(index);
 }
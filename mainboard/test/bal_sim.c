@@ -0,0 +1,247 @@
+#include "bal_sim.h"
+
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#define BAL_SIM_STEP_MS BAL_TIME_ON
+#define BAL_SIM_OUTLIER_COUNT 5
+#define BAL_SIM_CLUSTER_LENGTH 6
+
+const char *bal_sim_strategy_names[BAL_SIM_STRATEGY_COUNT] = {
+	[BAL_SIM_STRATEGY_THRESHOLD] = "threshold",
+	[BAL_SIM_STRATEGY_NEIGHBORS] = "neighbors",
+	[BAL_SIM_STRATEGY_PLANNER] = "planner"};
+
+const char *bal_sim_profile_names[BAL_SIM_PROFILE_COUNT] = {
+	[BAL_SIM_PROFILE_UNIFORM] = "uniform",
+	[BAL_SIM_PROFILE_WEAK_BOARD] = "weak_board",
+	[BAL_SIM_PROFILE_OUTLIERS] = "outliers",
+	[BAL_SIM_PROFILE_GRADIENT] = "gradient",
+	[BAL_SIM_PROFILE_CLUSTER] = "cluster"};
+
+static uint32_t _bal_sim_rand(uint32_t *state) {
+	// xorshift32, the same seed always gives the same pack
+	*state ^= *state << 13;
+	*state ^= *state >> 17;
+	*state ^= *state << 5;
+	return *state;
+}
+
+/**
+ * @brief Get a random value in [0, range]
+ */
+static voltage_t _bal_sim_rand_range(uint32_t *state, voltage_t range) {
+	return range == 0 ? 0 : _bal_sim_rand(state) % (range + 1U);
+}
+
+/**
+ * @brief Get the CPU cycle counter, or a time in ns if not available
+ */
+static uint64_t _bal_sim_get_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+void bal_sim_init_volts(bal_sim_t *sim, const voltage_t volts[PACK_CELL_COUNT]) {
+	memset(sim, 0, sizeof(bal_sim_t));
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		sim->volts[i] = volts[i] / 10000.f;
+	for (size_t i = 0; i < CELLBOARD_COUNT; i++)
+		sim->temps[i] = BAL_SIM_AMBIENT_TEMP;
+	sim->peak_temp = BAL_SIM_AMBIENT_TEMP;
+}
+
+void bal_sim_init(bal_sim_t *sim, uint32_t seed, voltage_t center, voltage_t spread) {
+	uint32_t state = seed != 0 ? seed : 1;
+	voltage_t volts[PACK_CELL_COUNT];
+
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		volts[i] = center - spread / 2 + _bal_sim_rand_range(&state, spread);
+	bal_sim_init_volts(sim, volts);
+}
+
+void bal_sim_init_profile(bal_sim_t *sim, bal_sim_profile_t profile, uint32_t seed, voltage_t spread) {
+	uint32_t state = seed != 0 ? seed : 1;
+	voltage_t volts[PACK_CELL_COUNT];
+
+	// Every profile has a small noise on top of its shape
+	voltage_t noise = spread / 8;
+	voltage_t base = BAL_SIM_CENTER_VOLTAGE - spread / 2;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		volts[i] = base + _bal_sim_rand_range(&state, noise);
+
+	switch (profile) {
+		case BAL_SIM_PROFILE_UNIFORM:
+			for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+				volts[i] = base + _bal_sim_rand_range(&state, spread);
+			break;
+		case BAL_SIM_PROFILE_WEAK_BOARD: {
+			size_t board = _bal_sim_rand(&state) % CELLBOARD_COUNT;
+			for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i++)
+				volts[board * CELLBOARD_CELL_COUNT + i] += spread - noise;
+			break;
+		}
+		case BAL_SIM_PROFILE_OUTLIERS:
+			for (size_t i = 0; i < BAL_SIM_OUTLIER_COUNT; i++)
+				volts[_bal_sim_rand(&state) % PACK_CELL_COUNT] = base + spread;
+			break;
+		case BAL_SIM_PROFILE_GRADIENT:
+			for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+				volts[i] += (voltage_t)((uint32_t)(spread - noise) * i / (PACK_CELL_COUNT - 1));
+			break;
+		case BAL_SIM_PROFILE_CLUSTER:
+			for (size_t board = 0; board < CELLBOARD_COUNT; board++) {
+				size_t start = _bal_sim_rand(&state) % (CELLBOARD_CELL_COUNT - BAL_SIM_CLUSTER_LENGTH + 1);
+				for (size_t i = 0; i < BAL_SIM_CLUSTER_LENGTH; i++)
+					volts[board * CELLBOARD_CELL_COUNT + start + i] += spread - noise;
+			}
+			break;
+		default:
+			break;
+	}
+	bal_sim_init_volts(sim, volts);
+}
+
+void bal_sim_get_volts(const bal_sim_t *sim, voltage_t volts[PACK_CELL_COUNT]) {
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		volts[i] = (voltage_t)(sim->volts[i] * 10000.f + 0.5f);
+}
+
+voltage_t bal_sim_get_spread(const bal_sim_t *sim) {
+	voltage_t volts[PACK_CELL_COUNT];
+	bal_sim_get_volts(sim, volts);
+
+	voltage_t min = UINT16_MAX, max = 0;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++) {
+		min = MIN(min, volts[i]);
+		max = MAX(max, volts[i]);
+	}
+	return max - min;
+}
+
+/**
+ * @brief Advance the simulation by one step discharging the given cells
+ */
+static void _bal_sim_step(bal_sim_t *sim, const uint32_t cells[CELLBOARD_COUNT]) {
+	const float dt = BAL_SIM_STEP_MS / 1000.f;
+
+	for (size_t board = 0; board < CELLBOARD_COUNT; board++) {
+		float power = 0;
+		for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i++) {
+			if ((cells[board] & (1U << i)) == 0)
+				continue;
+			float *volt = &sim->volts[board * CELLBOARD_CELL_COUNT + i];
+			float current = *volt / DISCHARGE_R;
+
+			power += *volt * current;
+			*volt -= current * dt / 3600.f * BAL_PLANNER_CELL_VOLTAGE_SLOPE;
+		}
+		sim->energy += power * dt;
+
+		float *temp = &sim->temps[board];
+		*temp += dt * (power - (*temp - BAL_SIM_AMBIENT_TEMP) / BAL_SIM_BOARD_THERMAL_RESISTANCE) / BAL_SIM_BOARD_THERMAL_CAPACITY;
+		sim->peak_temp = MAX(sim->peak_temp, *temp);
+	}
+	sim->time += dt;
+}
+
+/**
+ * @brief Decide which cells to discharge in the next cycle
+ *
+ * @return size_t The number of cells to discharge
+ */
+static size_t _bal_sim_decide(bal_sim_t *sim, bal_sim_strategy_t strategy, voltage_t threshold, uint32_t remaining[PACK_CELL_COUNT]) {
+	voltage_t volts[PACK_CELL_COUNT];
+	bal_sim_get_volts(sim, volts);
+
+	voltage_t target = CELL_MAX_VOLTAGE;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		target = MIN(target, volts[i]);
+
+	size_t count = 0;
+	if (strategy == BAL_SIM_STRATEGY_PLANNER) {
+		bal_plan_t plan;
+		count = bal_planner_compute(volts, sim->temps, target, threshold, &plan);
+		for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+			remaining[i] = plan.boards[i / CELLBOARD_CELL_COUNT].durations[i % CELLBOARD_CELL_COUNT] * 1000U;
+	} else if (strategy == BAL_SIM_STRATEGY_NEIGHBORS) {
+		for (size_t board = 0; board < CELLBOARD_COUNT; board++) {
+			uint32_t weights[CELLBOARD_CELL_COUNT];
+			for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i++) {
+				voltage_t volt = volts[board * CELLBOARD_CELL_COUNT + i];
+				weights[i] = volt > target + threshold ? (uint32_t)(volt - (target + threshold)) : 0U;
+			}
+			uint32_t cells = bal_planner_exclude_neighbors(weights, CELLBOARD_CELL_COUNT);
+			for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i++) {
+				remaining[board * CELLBOARD_CELL_COUNT + i] = (cells & (1U << i)) ? UINT32_MAX : 0U;
+				count += (cells & (1U << i)) != 0;
+			}
+		}
+	} else {
+		for (size_t i = 0; i < PACK_CELL_COUNT; i++) {
+			remaining[i] = volts[i] > target + threshold ? UINT32_MAX : 0U;
+			count += remaining[i] > 0;
+		}
+	}
+	return count;
+}
+
+float bal_sim_run(bal_sim_t *sim, bal_sim_strategy_t strategy, voltage_t threshold, float max_time) {
+	uint32_t remaining[PACK_CELL_COUNT];
+
+	while (sim->time < max_time) {
+		uint64_t start = _bal_sim_get_cycles();
+		size_t count = _bal_sim_decide(sim, strategy, threshold, remaining);
+		sim->decision_cycles += _bal_sim_get_cycles() - start;
+
+		if (count == 0)
+			return sim->time;
+		sim->cycles++;
+
+		// Discharge with the same on/off pattern of the cellboards
+		bool is_on = true;
+		for (uint32_t t = 0; t < BAL_CYCLE_LENGTH; t += BAL_SIM_STEP_MS) {
+			uint32_t cells[CELLBOARD_COUNT] = {0};
+			if (is_on) {
+				for (size_t i = 0; i < PACK_CELL_COUNT; i++) {
+					if (remaining[i] == 0)
+						continue;
+					cells[i / CELLBOARD_CELL_COUNT] |= 1U << (i % CELLBOARD_CELL_COUNT);
+					if (remaining[i] != UINT32_MAX)
+						remaining[i] = remaining[i] > BAL_SIM_STEP_MS ? remaining[i] - BAL_SIM_STEP_MS : 0U;
+				}
+			}
+			_bal_sim_step(sim, cells);
+			is_on = !is_on;
+		}
+
+		// Cooldown
+		uint32_t cells[CELLBOARD_COUNT] = {0};
+		for (uint32_t t = 0; t < BAL_COOLDOWN_DELAY; t += BAL_SIM_STEP_MS)
+			_bal_sim_step(sim, cells);
+	}
+	return -1.f;
+}
+
+void bal_sim_csv_header(FILE *out) {
+	fprintf(out, "profile,seed,strategy,time_to_balance_s,energy_j,peak_temp_c,cycles,cycles_per_decision\n");
+}
+
+void bal_sim_csv_row(FILE *out, bal_sim_profile_t profile, uint32_t seed, bal_sim_strategy_t strategy, const bal_sim_t *sim, float time) {
+	// Also the last decision, which found nothing to discharge, is counted
+	fprintf(out, "%s,%" PRIu32 ",%s,%.0f,%.1f,%.2f,%" PRIu32 ",%.0f\n",
+		bal_sim_profile_names[profile],
+		seed,
+		bal_sim_strategy_names[strategy],
+		time,
+		sim->energy,
+		sim->peak_temp,
+		sim->cycles,
+		(double)sim->decision_cycles / (sim->cycles + 1));
+}
@@ -0,0 +1,70 @@
+#ifndef BAL_SIM_H
+#define BAL_SIM_H
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "bal_planner.h"
+
+#define BAL_SIM_AMBIENT_TEMP 25.f              // °C
+#define BAL_SIM_BOARD_THERMAL_RESISTANCE 4.f   // K/W
+#define BAL_SIM_BOARD_THERMAL_CAPACITY 30.f    // J/K
+#define BAL_SIM_CENTER_VOLTAGE 38000           // mV * 10
+
+/**
+ * @brief Balancing strategies that can be simulated
+ * @details THRESHOLD is the scheme used by the cellboards when no plan is
+ * received: every cell above target + threshold is discharged for a whole cycle.
+ * NEIGHBORS discharges for a whole cycle the non adjacent cells selected by
+ * the dynamic programming used in bal_exclude_neighbors.
+ * PLANNER uses the discharge times computed by the mainboard planner
+ */
+typedef enum {
+	BAL_SIM_STRATEGY_THRESHOLD,
+	BAL_SIM_STRATEGY_NEIGHBORS,
+	BAL_SIM_STRATEGY_PLANNER,
+	BAL_SIM_STRATEGY_COUNT
+} bal_sim_strategy_t;
+
+/**
+ * @brief Shapes of the initial imbalance of the pack
+ * @details UNIFORM: every cell is spread uniformly around the center.
+ * WEAK_BOARD: a whole cellboard is higher than the rest of the pack.
+ * OUTLIERS: few random cells are much higher than the others.
+ * GRADIENT: the voltage grows linearly along the pack.
+ * CLUSTER: each cellboard has a run of adjacent high cells, the worst case
+ * when neighbours cannot be discharged together
+ */
+typedef enum {
+	BAL_SIM_PROFILE_UNIFORM,
+	BAL_SIM_PROFILE_WEAK_BOARD,
+	BAL_SIM_PROFILE_OUTLIERS,
+	BAL_SIM_PROFILE_GRADIENT,
+	BAL_SIM_PROFILE_CLUSTER,
+	BAL_SIM_PROFILE_COUNT
+} bal_sim_profile_t;
+
+typedef struct {
+	float volts[PACK_CELL_COUNT];  // V
+	float temps[CELLBOARD_COUNT];  // °C
+	float time;                    // s
+	float energy;                  // Energy dissipated by the resistors (J)
+	float peak_temp;               // Peak temperature of the resistors of a board (°C)
+	uint32_t cycles;               // Number of balancing cycles
+	uint64_t decision_cycles;      // CPU cycles spent choosing the cells (ns if no cycle counter is available)
+} bal_sim_t;
+
+extern const char *bal_sim_strategy_names[BAL_SIM_STRATEGY_COUNT];
+extern const char *bal_sim_profile_names[BAL_SIM_PROFILE_COUNT];
+
+void bal_sim_init(bal_sim_t *sim, uint32_t seed, voltage_t center, voltage_t spread);
+void bal_sim_init_profile(bal_sim_t *sim, bal_sim_profile_t profile, uint32_t seed, voltage_t spread);
+void bal_sim_init_volts(bal_sim_t *sim, const voltage_t volts[PACK_CELL_COUNT]);
+void bal_sim_get_volts(const bal_sim_t *sim, voltage_t volts[PACK_CELL_COUNT]);
+voltage_t bal_sim_get_spread(const bal_sim_t *sim);
+float bal_sim_run(bal_sim_t *sim, bal_sim_strategy_t strategy, voltage_t threshold, float max_time);
+
+void bal_sim_csv_header(FILE *out);
+void bal_sim_csv_row(FILE *out, bal_sim_profile_t profile, uint32_t seed, bal_sim_strategy_t strategy, const bal_sim_t *sim, float time);
+
+#endif
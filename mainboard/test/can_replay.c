@@ -0,0 +1,182 @@
+#include "can_replay.h"
+
+#include <ctype.h>
+#include <string.h>
+
+static int _can_replay_hex(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	c = (char)tolower((unsigned char)c);
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+static void _can_replay_record(can_replay_t *replay, const can_replay_event_t *event) {
+	if (replay->target.event != NULL)
+		replay->target.event(replay->target.context, event);
+}
+
+/** @brief Move the simulated tick forward, calling the routine at every period in between */
+static void _can_replay_run_until(can_replay_t *replay, uint32_t time) {
+	while (replay->next_routine <= time) {
+		if (replay->realtime && replay->target.sleep != NULL)
+			replay->target.sleep(replay->target.context, replay->next_routine - replay->now);
+		replay->now = replay->next_routine;
+		replay->next_routine += replay->period;
+		replay->target.routine(replay->target.context, replay->now);
+	}
+	if (time > replay->now) {
+		if (replay->realtime && replay->target.sleep != NULL)
+			replay->target.sleep(replay->target.context, time - replay->now);
+		replay->now = time;
+	}
+}
+
+void can_replay_init(can_replay_t *replay, const can_replay_target_t *target, const char *bms_interface, const char *car_interface, uint32_t period, bool realtime) {
+	memset(replay, 0, sizeof(*replay));
+	replay->target = *target;
+	strncpy(replay->interfaces[CAN_REPLAY_BUS_BMS], bms_interface, CAN_REPLAY_INTERFACE_SIZE - 1);
+	strncpy(replay->interfaces[CAN_REPLAY_BUS_CAR], car_interface, CAN_REPLAY_INTERFACE_SIZE - 1);
+	replay->period = period > 0 ? period : 1;
+	replay->realtime = realtime;
+}
+
+/**
+ * @brief	Parse a line written by candump -l: "(1436509052.249713) can0 123#DEADBEEF"
+ * @details	Extended IDs have 8 digits, remote frames are written as "123#R"
+ * and error frames have CAN_REPLAY_ERROR_FLAG set in their ID.
+ * The bus of the frame is not set since it depends on the interface
+ *
+ * @return	0 if the line is a frame, -1 otherwise
+ */
+int can_replay_parse(const char *line, can_replay_frame_t *frame, char interface[CAN_REPLAY_INTERFACE_SIZE]) {
+	unsigned long long seconds, micros;
+	char token[CAN_REPLAY_LINE_SIZE];
+	if (sscanf(line, " (%llu.%6llu) %15s %255s", &seconds, &micros, interface, token) != 4)
+		return -1;
+
+	memset(frame, 0, sizeof(*frame));
+	frame->timestamp = seconds * 1000000ULL + micros;
+
+	const char *c = token;
+	size_t digits = 0;
+	for (; _can_replay_hex(*c) >= 0; ++c, ++digits)
+		frame->id = (frame->id << 4) | (uint32_t)_can_replay_hex(*c);
+	if (*c != '#' || (digits != 3 && digits != 8))
+		return -1;
+	++c;
+
+	frame->extended = digits == 8;
+	frame->error = frame->extended && (frame->id & CAN_REPLAY_ERROR_FLAG) != 0;
+	if (*c == 'R' || *c == 'r') {
+		frame->remote = true;
+		return 0;
+	}
+	while (*c != '\0') {
+		int high = _can_replay_hex(c[0]);
+		int low = high >= 0 ? _can_replay_hex(c[1]) : -1;
+		if (low < 0 || frame->length >= CAN_REPLAY_DATA_SIZE)
+			return -1;
+		frame->data[frame->length++] = (uint8_t)((high << 4) | low);
+		c += 2;
+	}
+	return 0;
+}
+
+/**
+ * @brief	Give a line of the log to the firmware
+ *
+ * @return	true if the line was a frame of one of the replayed interfaces
+ */
+bool can_replay_line(can_replay_t *replay, const char *line) {
+	can_replay_frame_t frame;
+	char interface[CAN_REPLAY_INTERFACE_SIZE];
+	if (can_replay_parse(line, &frame, interface) < 0) {
+		++replay->ignored;
+		return false;
+	}
+
+	size_t bus = 0;
+	while (bus < CAN_REPLAY_BUS_COUNT && strcmp(interface, replay->interfaces[bus]) != 0)
+		++bus;
+	if (bus == CAN_REPLAY_BUS_COUNT) {
+		++replay->ignored;
+		return false;
+	}
+	frame.bus = (can_replay_bus_t)bus;
+
+	if (!replay->started) {
+		replay->started = true;
+		replay->start = frame.timestamp;
+		replay->target.routine(replay->target.context, 0);
+		replay->next_routine = replay->period;
+	}
+
+	// Logs merged from two interfaces can go slightly back in time
+	if (frame.timestamp > replay->start)
+		_can_replay_run_until(replay, (uint32_t)((frame.timestamp - replay->start) / 1000U));
+
+	++replay->frames[bus];
+	replay->target.receive(replay->target.context, &frame);
+	return true;
+}
+
+/** @return	the number of frames given to the firmware */
+size_t can_replay_file(can_replay_t *replay, FILE *log) {
+	char line[CAN_REPLAY_LINE_SIZE];
+	size_t count = 0;
+	while (fgets(line, sizeof(line), log) != NULL) {
+		if (can_replay_line(replay, line))
+			++count;
+	}
+	return count;
+}
+
+/** @brief Keep running the firmware after the end of the log, to see the timeouts */
+void can_replay_advance(can_replay_t *replay, uint32_t ms) {
+	_can_replay_run_until(replay, replay->now + ms);
+}
+
+/** @brief Record a frame sent by the firmware, in place of HAL_CAN_AddTxMessage */
+void can_replay_transmit(can_replay_t *replay, can_replay_bus_t bus, uint32_t id, const uint8_t *data, uint8_t length) {
+	can_replay_event_t event = {
+		.time = replay->now,
+		.type = CAN_REPLAY_EVENT_TX,
+		.bus = bus,
+		.id = id,
+		.length = length < CAN_REPLAY_DATA_SIZE ? length : CAN_REPLAY_DATA_SIZE};
+	memcpy(event.data, data, event.length);
+	++replay->tx[bus];
+	_can_replay_record(replay, &event);
+}
+
+/** @brief Record a change of state of the firmware */
+void can_replay_transition(can_replay_t *replay, int from, int to) {
+	can_replay_event_t event = {
+		.time = replay->now,
+		.type = CAN_REPLAY_EVENT_TRANSITION,
+		.from = from,
+		.to = to};
+	++replay->transitions;
+	_can_replay_record(replay, &event);
+}
+
+/**
+ * @brief	Print an event with the timestamps of the log
+ * @details	The frames are written like candump -l, so the output can be
+ * replayed or decoded with the same tools, and the transitions as "fsm from -> to"
+ */
+void can_replay_print_event(FILE *out, const can_replay_t *replay, const can_replay_event_t *event) {
+	uint64_t timestamp = replay->start + (uint64_t)event->time * 1000U;
+	fprintf(out, "(%llu.%06llu) ", (unsigned long long)(timestamp / 1000000U), (unsigned long long)(timestamp % 1000000U));
+
+	if (event->type == CAN_REPLAY_EVENT_TRANSITION) {
+		fprintf(out, "fsm %d -> %d\n", event->from, event->to);
+		return;
+	}
+	fprintf(out, "%s %03" PRIX32 "#", replay->interfaces[event->bus], event->id);
+	for (uint8_t i = 0; i < event->length; ++i)
+		fprintf(out, "%02X", event->data[i]);
+	fprintf(out, "\n");
+}
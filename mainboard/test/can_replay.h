@@ -0,0 +1,101 @@
+#ifndef CAN_REPLAY_H
+#define CAN_REPLAY_H
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define CAN_REPLAY_DATA_SIZE 8U
+#define CAN_REPLAY_INTERFACE_SIZE 16U
+#define CAN_REPLAY_LINE_SIZE 256U
+
+/** @brief Flag of the error frames in the IDs of the log, like CAN_ERR_FLAG of SocketCAN */
+#define CAN_REPLAY_ERROR_FLAG 0x20000000U
+
+/** @brief Buses of the mainboard, the FIFO 0 receives from BMS_CAN and the FIFO 1 from CAR_CAN */
+typedef enum {
+	CAN_REPLAY_BUS_BMS,
+	CAN_REPLAY_BUS_CAR,
+	CAN_REPLAY_BUS_COUNT
+} can_replay_bus_t;
+
+typedef struct {
+	uint64_t timestamp; // us, as written in the log
+	can_replay_bus_t bus;
+	uint32_t id;
+	bool extended;
+	bool remote;
+	bool error;         // Error frame, the firmware sees a failed reception
+	uint8_t length;
+	uint8_t data[CAN_REPLAY_DATA_SIZE];
+} can_replay_frame_t;
+
+typedef enum {
+	CAN_REPLAY_EVENT_TX,
+	CAN_REPLAY_EVENT_TRANSITION
+} can_replay_event_type_t;
+
+/** @brief Something done by the firmware, timestamped with the simulated tick */
+typedef struct {
+	uint32_t time; // ms since the first frame of the log
+	can_replay_event_type_t type;
+	can_replay_bus_t bus;
+	uint32_t id;
+	uint8_t length;
+	uint8_t data[CAN_REPLAY_DATA_SIZE];
+	int from;
+	int to;
+} can_replay_event_t;
+
+/**
+ * @brief Firmware fed by the replay
+ * @details receive is called in place of the CAN RX interrupts, routine
+ * every period ms of simulated time like the timer of the measures, event
+ * with everything recorded by can_replay_transmit and can_replay_transition
+ * (it can be NULL) and sleep only when replaying in real time
+ */
+typedef struct {
+	void (*receive)(void *context, const can_replay_frame_t *frame);
+	void (*routine)(void *context, uint32_t now);
+	void (*event)(void *context, const can_replay_event_t *event);
+	void (*sleep)(void *context, uint32_t ms);
+	void *context;
+} can_replay_target_t;
+
+/**
+ * @brief Replay of a candump log
+ * @details Every frame is given to the target at the time written in the log,
+ * relative to the first frame, and the routine of the target is called at
+ * every period in between. The simulated tick jumps from a call to the next
+ * one, so hours of logs are processed in seconds, unless realtime is set and
+ * the target waits for the same time between the calls
+ */
+typedef struct {
+	can_replay_target_t target;
+	char interfaces[CAN_REPLAY_BUS_COUNT][CAN_REPLAY_INTERFACE_SIZE];
+	uint32_t period;
+	bool realtime;
+
+	bool started;
+	uint64_t start;        // us, timestamp of the first frame
+	uint32_t now;          // ms, the HAL tick seen by the firmware
+	uint32_t next_routine; // ms
+
+	uint32_t frames[CAN_REPLAY_BUS_COUNT];
+	uint32_t tx[CAN_REPLAY_BUS_COUNT];
+	uint32_t transitions;
+	uint32_t ignored;      // Lines which are not frames of a replayed interface
+} can_replay_t;
+
+void can_replay_init(can_replay_t *replay, const can_replay_target_t *target, const char *bms_interface, const char *car_interface, uint32_t period, bool realtime);
+int can_replay_parse(const char *line, can_replay_frame_t *frame, char interface[CAN_REPLAY_INTERFACE_SIZE]);
+bool can_replay_line(can_replay_t *replay, const char *line);
+size_t can_replay_file(can_replay_t *replay, FILE *log);
+void can_replay_advance(can_replay_t *replay, uint32_t ms);
+
+void can_replay_transmit(can_replay_t *replay, can_replay_bus_t bus, uint32_t id, const uint8_t *data, uint8_t length);
+void can_replay_transition(can_replay_t *replay, int from, int to);
+void can_replay_print_event(FILE *out, const can_replay_t *replay, const can_replay_event_t *event);
+
+#endif
@@ -0,0 +1,163 @@
+#include "can_replay_stubs.h"
+
+#include <string.h>
+
+#include "can.h"
+#include "mainboard_config.h"
+#include "bal.h"
+#include "cli_bms.h"
+#include "pack/cell_voltage.h"
+#include "pack/current.h"
+#include "pack/internal_voltage.h"
+#include "pack/temperature.h"
+#include "fans_buzzer.h"
+#include "feedback.h"
+#include "imd.h"
+
+static can_replay_t *stubs_replay;
+static const can_replay_frame_t *stubs_rx;
+static bms_state_t stubs_state;
+
+CAN_HandleTypeDef hcan1 = { .Instance = CAN1 };
+CAN_HandleTypeDef hcan2 = { .Instance = CAN2 };
+
+bms_fsm_transition_request set_ts_request;
+bool is_handcart_connected;
+cell_anomaly_t cell_anomaly;
+feedback_capture_t feedback_capture;
+imd_decoder_t imd_decoder;
+
+void can_replay_stubs_init(can_replay_t *replay) {
+	stubs_replay = replay;
+	stubs_rx = NULL;
+	stubs_state = STATE_IDLE;
+	set_ts_request.is_new = false;
+	set_ts_request.next_state = STATE_IDLE;
+}
+
+void can_replay_stubs_receive(const can_replay_frame_t *frame) {
+	stubs_rx = frame;
+	if (frame->bus == CAN_REPLAY_BUS_BMS)
+		HAL_CAN_RxFifo0MsgPendingCallback(&BMS_CAN);
+	else
+		HAL_CAN_RxFifo1MsgPendingCallback(&CAR_CAN);
+	stubs_rx = NULL;
+}
+
+void can_replay_stubs_set_state(bms_state_t state) {
+	stubs_state = state;
+}
+
+/*
+ * HAL
+ */
+
+uint32_t HAL_GetTick(void) {
+	return stubs_replay != NULL ? stubs_replay->now : 0U;
+}
+
+HAL_StatusTypeDef HAL_CAN_GetRxMessage(CAN_HandleTypeDef *hcan, uint32_t RxFifo, CAN_RxHeaderTypeDef *pHeader, uint8_t aData[]) {
+	// Error frames are seen as failed receptions
+	if (stubs_rx == NULL || stubs_rx->error)
+		return HAL_ERROR;
+
+	memset(pHeader, 0, sizeof(*pHeader));
+	pHeader->IDE = stubs_rx->extended ? CAN_ID_EXT : CAN_ID_STD;
+	pHeader->RTR = stubs_rx->remote ? CAN_RTR_REMOTE : CAN_RTR_DATA;
+	if (stubs_rx->extended)
+		pHeader->ExtId = stubs_rx->id;
+	else
+		pHeader->StdId = stubs_rx->id;
+	pHeader->DLC = stubs_rx->length;
+	pHeader->Timestamp = HAL_GetTick();
+	memcpy(aData, stubs_rx->data, stubs_rx->length);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_CAN_AddTxMessage(CAN_HandleTypeDef *hcan, CAN_TxHeaderTypeDef *pHeader, uint8_t aData[], uint32_t *pTxMailbox) {
+	if (stubs_replay == NULL)
+		return HAL_ERROR;
+	can_replay_bus_t bus = hcan->Instance == BMS_CAN.Instance ? CAN_REPLAY_BUS_BMS : CAN_REPLAY_BUS_CAR;
+	uint32_t id = pHeader->IDE == CAN_ID_EXT ? pHeader->ExtId : pHeader->StdId;
+	can_replay_transmit(stubs_replay, bus, id, aData, (uint8_t)pHeader->DLC);
+	*pTxMailbox = CAN_TX_MAILBOX0;
+	return HAL_OK;
+}
+
+uint32_t HAL_CAN_GetTxMailboxesFreeLevel(CAN_HandleTypeDef *hcan) {
+	return 3U;
+}
+
+HAL_StatusTypeDef HAL_CAN_Init(CAN_HandleTypeDef *hcan) { return HAL_OK; }
+HAL_StatusTypeDef HAL_CAN_DeInit(CAN_HandleTypeDef *hcan) { return HAL_OK; }
+HAL_StatusTypeDef HAL_CAN_ConfigFilter(CAN_HandleTypeDef *hcan, CAN_FilterTypeDef *sFilterConfig) { return HAL_OK; }
+HAL_StatusTypeDef HAL_CAN_Start(CAN_HandleTypeDef *hcan) { return HAL_OK; }
+HAL_StatusTypeDef HAL_CAN_ActivateNotification(CAN_HandleTypeDef *hcan, uint32_t ActiveITs) { return HAL_OK; }
+void HAL_NVIC_SystemReset(void) { }
+void Error_Handler(void) { }
+
+/*
+ * FSM
+ */
+
+bms_state_t fsm_get_state() { return stubs_state; }
+
+/*
+ * Modules of the mainboard, not replayed
+ */
+
+void cli_bms_debug(char *text, size_t length) { }
+
+void bal_change_status_request(bool status, voltage_t threshold) { }
+bool bal_is_balancing(void) { return false; }
+BalRequest bal_get_request(void) { return (BalRequest){ 0 }; }
+void bal_update_status(uint8_t cellboard, bool status) { }
+const bal_plan_t *bal_get_plan(void) { return NULL; }
+uint8_t bal_get_plan_seq(void) { return 0U; }
+bool bal_is_plan_start(void) { return false; }
+void bal_set_cells_charge(uint8_t cellboard, size_t start_index, const uint16_t charges[], size_t count) { }
+float bal_get_total_charge(void) { return 0.f; }
+voltage_t bal_get_spread(void) { return 0U; }
+float bal_get_convergence_rate(void) { return 0.f; }
+int32_t bal_get_eta(void) { return -1; }
+
+HAL_StatusTypeDef cell_voltage_set_cells(size_t cellboard_id, voltage_t min, voltage_t max, float avg) { return HAL_OK; }
+HAL_StatusTypeDef cell_voltage_set_cell_values(size_t cellboard_id, size_t start_index, voltage_t *volts, size_t count) { return HAL_OK; }
+void cell_voltage_snapshot_start(uint8_t seq, uint32_t timestamp, current_t current, uint16_t bat, uint16_t tsp) { }
+HAL_StatusTypeDef cell_voltage_snapshot_set_cells(size_t cellboard_id, size_t start_index, uint8_t seq, voltage_t *volts, size_t count) { return HAL_OK; }
+voltage_t cell_voltage_get_max() { return 0U; }
+voltage_t cell_voltage_get_min() { return 0U; }
+float cell_voltage_get_sum() { return 0.f; }
+float cell_voltage_get_avg() { return 0.f; }
+
+current_t current_get_current() { return 0; }
+
+internal_voltage_sample_t internal_voltage_get_sample() { return (internal_voltage_sample_t){ 0 }; }
+uint16_t internal_voltage_get_tsp() { return 0U; }
+uint16_t internal_voltage_get_bat() { return 0U; }
+
+HAL_StatusTypeDef temperature_set_cells(size_t cellboard_id, temperature_t min, temperature_t max, float avg) { return HAL_OK; }
+HAL_StatusTypeDef temperature_set_excluded(size_t cellboard_id, size_t start_index, uint64_t excluded, size_t count, uint8_t unhealthy) { return HAL_OK; }
+uint8_t temperature_get_unhealthy(size_t cellboard_id) { return 0U; }
+bool temperature_is_interpolable(size_t cellboard_id) { return true; }
+temperature_t temperature_get_max() { return 0U; }
+temperature_t temperature_get_min() { return 0U; }
+float temperature_get_average() { return 0.f; }
+
+bool fans_is_overrided() { return false; }
+void fans_set_override(bool override) { }
+float fans_get_speed() { return 0.f; }
+void fans_set_speed(float power_percentage) { }
+
+float feedback_get_voltage(size_t index) { return 0.f; }
+void feedback_get_all_states(feedback_feed_t out_value[FEEDBACK_N]) { memset(out_value, 0, FEEDBACK_N * sizeof(feedback_feed_t)); }
+bool feedback_dump_next(size_t *offset, feedback_capture_sample_t *sample) { return false; }
+
+uint8_t imd_get_freq() { return 0U; }
+uint8_t imd_get_period() { return 0U; }
+float imd_get_duty_cycle_percentage() { return 0.f; }
+uint8_t imd_is_fault() { return 0U; }
+IMD_STATE imd_get_state() { return (IMD_STATE)0; }
+uint8_t imd_get_confidence() { return 0U; }
+int32_t imd_get_details() { return 0; }
+int32_t imd_get_resistance() { return -1; }
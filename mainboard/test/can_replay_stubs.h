@@ -0,0 +1,26 @@
+#ifndef CAN_REPLAY_STUBS_H
+#define CAN_REPLAY_STUBS_H
+
+#include "can_replay.h"
+#include "bms_fsm.h"
+
+/**
+ * @brief Stand-ins of the HAL and of the mainboard modules that are not
+ * replayed, so that can_comm.c, watchdog.c and error_simple.c run unchanged
+ * @details The CAN peripherals are backed by the replay: HAL_CAN_GetRxMessage
+ * returns the frame being replayed, HAL_CAN_AddTxMessage records the frames
+ * sent and HAL_GetTick returns the simulated tick. The FSM is not linked:
+ * fsm_get_state returns the state set with can_replay_stubs_set_state and
+ * set_ts_request is left to the test. The other modules return zeros
+ */
+
+/** @brief Back the HAL with a replay and clear the state of the stubs */
+void can_replay_stubs_init(can_replay_t *replay);
+
+/** @brief Give a frame to the RX interrupt of its bus, FIFO 0 for BMS_CAN and FIFO 1 for CAR_CAN */
+void can_replay_stubs_receive(const can_replay_frame_t *frame);
+
+/** @brief Set the state returned by fsm_get_state */
+void can_replay_stubs_set_state(bms_state_t state);
+
+#endif // CAN_REPLAY_STUBS_H
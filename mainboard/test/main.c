@@ -7,7 +7,7 @@
 
 int main(int argc, char *argv[]) {
     MunitSuite main_suite[] = {
-        test_bal_suite, test_energy_suite, {NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, MUNIT_SUITE_OPTION_NONE}};
+        test_bal_suite, test_energy_suite, test_bal_planner_suite, test_bal_convergence_suite, test_feedback_capture_suite, test_tx_ring_suite, test_telemetry_suite, test_str_writer_suite, test_imd_decoder_suite, test_deadline_heap_suite, test_fans_control_suite, test_flash_fanout_suite, test_can_replay_suite, test_fixed_point_suite, test_error_simple_suite, test_cell_anomaly_suite, test_voltage_crosscheck_suite, {NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, MUNIT_SUITE_OPTION_NONE}};
     MunitSuite mainsuite = {
         "",
         NULL,
@@ -1,107 +1,106 @@
 #include "test_bal.h"
 
-#include <bal.h>
+#include <bal_planner.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-#include "test_volt_data.h"
+#include "bal_sim.h"
 
-struct data {
-	uint16_t threshold;
-	uint16_t voltages[PACK_CELL_COUNT];
-};
+#define BAL_TEST_THRESHOLD 50  // mV * 10
+#define BAL_TEST_SPREAD 400    // mV * 10
+#define BAL_TEST_MAX_TIME (48.f * 3600.f)
+#define BAL_BENCH_SEED_COUNT 3
 
-#define BAL_TEST_DELTA 10
-#define COUNT_MAX 50
+static const uint32_t bal_bench_seeds[BAL_BENCH_SEED_COUNT] = {0x5EED, 0xBA1A, 0xCE11};
 
-void* bal_setup_balanced(const MunitParameter params[], void* user_data) {
-	struct data* tmp = malloc(sizeof(struct data));
-	tmp->threshold = BAL_TEST_DELTA;
-	volt_gen_random(tmp->voltages, tmp->threshold, munit_rand_int_range(CELL_MIN_VOLTAGE + tmp->threshold / 2, CELL_MAX_VOLTAGE - tmp->threshold / 2));
+static voltage_t sim_min(const bal_sim_t *sim) {
+	voltage_t volts[PACK_CELL_COUNT];
+	bal_sim_get_volts(sim, volts);
 
-	return tmp;
-}
-
-void* bal_setup_unbalanced(const MunitParameter params[], void* user_data) {
-	struct data* tmp = malloc(sizeof(struct data));
-	tmp->threshold = BAL_TEST_DELTA;
-	volt_gen_random(tmp->voltages, tmp->threshold * 2, munit_rand_int_range(CELL_MIN_VOLTAGE + tmp->threshold, CELL_MAX_VOLTAGE - tmp->threshold));
-
-	return tmp;
-}
-
-void tear_down(void* fixture) {
-	free(fixture);
+	voltage_t min = UINT16_MAX;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		min = MIN(min, volts[i]);
+	return min;
 }
 
 /**
- * @brief Fakes a balancing cycle by randomly decreasing cell voltages.
+ * @brief	a balanced pack is never discharged
  */
-uint16_t balance(struct data* data, uint16_t max_count) {
-	bms_BalancingCells cells[LTC6813_COUNT] = {0};
-	// set a maximum count to prevent killer loops
-	while (max_count > 0 && bal_get_cells_to_discharge(data->voltages, PACK_CELL_COUNT, data->threshold, cells, LTC6813_COUNT) > 0) {
-		max_count--;
-
-		for (uint16_t i = 0; i < PACK_CELL_COUNT; i++) {
-			if (CANLIB_BITTEST(cells[i / LTC6813_CELL_COUNT], (i % LTC6813_CELL_COUNT))) {
-				data->voltages[i] -= munit_rand_int_range(1, 3);
-			}
-		}
-	}
+MunitResult test_balanced(const MunitParameter params[], void *user_data_or_fixture) {
+	for (bal_sim_strategy_t strategy = 0; strategy < BAL_SIM_STRATEGY_COUNT; strategy++) {
+		bal_sim_t sim;
+		bal_sim_init(&sim, munit_rand_uint32(), BAL_SIM_CENTER_VOLTAGE, BAL_TEST_THRESHOLD);
+
+		float time = bal_sim_run(&sim, strategy, BAL_TEST_THRESHOLD, BAL_TEST_MAX_TIME);
 
-	return max_count;
+		munit_assert_float(time, ==, 0.f);
+		munit_assert_float(sim.energy, ==, 0.f);
+		munit_assert_uint32(sim.cycles, ==, 0);
+	}
+	return MUNIT_OK;
 }
 
 /**
- * @brief	tests balancing with a balanced dataset
+ * @brief	every strategy balances an unbalanced pack without touching the lowest cell
  */
-MunitResult test_balanced(const MunitParameter params[], void* user_data_or_fixture) {
-	struct data* data = (struct data*)user_data_or_fixture;
+MunitResult test_unbalanced(const MunitParameter params[], void *user_data_or_fixture) {
+	for (bal_sim_strategy_t strategy = 0; strategy < BAL_SIM_STRATEGY_COUNT; strategy++) {
+		bal_sim_t sim;
+		bal_sim_init_profile(&sim, BAL_SIM_PROFILE_UNIFORM, munit_rand_uint32(), BAL_TEST_SPREAD);
+		voltage_t min = sim_min(&sim);
 
-	uint16_t min = volt_min(data->voltages);
-	uint16_t max = volt_max(data->voltages);
+		float time = bal_sim_run(&sim, strategy, BAL_TEST_THRESHOLD, BAL_TEST_MAX_TIME);
 
-	uint16_t count = balance(data, COUNT_MAX);
+		// have we exceeded the maximum time?
+		munit_assert_float(time, >, 0.f);
 
-	uint16_t new_min = volt_min(data->voltages);
-	uint16_t new_max = volt_max(data->voltages);
-
-	munit_assert_uint16(count, ==, COUNT_MAX);
-	munit_assert_uint16(max, ==, new_max);
-	munit_assert_uint16(min, ==, new_min);
+		// check that cells are actually balanced
+		munit_assert_uint16(bal_sim_get_spread(&sim), <=, BAL_TEST_THRESHOLD);
 
+		// minimum voltage shouldn't have changed
+		munit_assert_uint16(sim_min(&sim), ==, min);
+	}
 	return MUNIT_OK;
 }
 
 /**
- * @brief	tests balancing with an unbalanced dataset
+ * @brief	runs every strategy on every imbalance profile and writes the results as CSV
+ * @details	the results are written to the file in the BAL_BENCH_OUTPUT environment variable,
+ * the test is skipped if it is not set (run it with make bench)
  */
-MunitResult test_unbalanced(const MunitParameter params[], void* user_data_or_fixture) {
-	struct data* data = (struct data*)user_data_or_fixture;
-
-	uint16_t min = volt_min(data->voltages);
-
-	uint16_t count = balance(data, COUNT_MAX);
-
-	uint16_t new_min = volt_min(data->voltages);
-	uint16_t new_max = volt_max(data->voltages);
-
-	// have we exceeded the maximum number of cycles?
-	munit_assert_uint16(count, >, 0);
-
-	// check that cells are actually balanced
-	munit_assert_uint16(new_max - new_min, <=, data->threshold);
-
-	// minimum voltage should'n have changed
-	munit_assert_uint16(min, ==, new_min);
+MunitResult test_benchmark(const MunitParameter params[], void *user_data_or_fixture) {
+	const char *path = getenv("BAL_BENCH_OUTPUT");
+	if (path == NULL)
+		return MUNIT_SKIP;
+	FILE *out = fopen(path, "w");
+	munit_assert_not_null(out);
+
+	bal_sim_csv_header(out);
+	for (bal_sim_profile_t profile = 0; profile < BAL_SIM_PROFILE_COUNT; profile++) {
+		for (size_t seed = 0; seed < BAL_BENCH_SEED_COUNT; seed++) {
+			for (bal_sim_strategy_t strategy = 0; strategy < BAL_SIM_STRATEGY_COUNT; strategy++) {
+				bal_sim_t sim;
+				bal_sim_init_profile(&sim, profile, bal_bench_seeds[seed], BAL_TEST_SPREAD);
+
+				float time = bal_sim_run(&sim, strategy, BAL_TEST_THRESHOLD, BAL_TEST_MAX_TIME);
+				bal_sim_csv_row(out, profile, bal_bench_seeds[seed], strategy, &sim, time);
+
+				munit_logf(MUNIT_LOG_INFO, "%s/%s: %.0f s %.0f J %.2f degC",
+					bal_sim_profile_names[profile], bal_sim_strategy_names[strategy], time, sim.energy, sim.peak_temp);
+				munit_assert_float(time, >=, 0.f);
+			}
+		}
+	}
+	fclose(out);
 
 	return MUNIT_OK;
 }
 
 MunitTest test_bal_tests[] = {
-	{(char*)"/balanced", test_balanced, bal_setup_balanced, tear_down, MUNIT_TEST_OPTION_NONE, NULL},
-	{(char*)"/unbalanced", test_unbalanced, bal_setup_unbalanced, tear_down, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/balanced", test_balanced, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/unbalanced", test_unbalanced, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/benchmark", test_benchmark, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
 
-	{NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, MUNIT_SUITE_OPTION_NONE}};
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
 
 MunitSuite test_bal_suite = {"/balancing", test_bal_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
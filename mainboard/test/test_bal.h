@@ -3,7 +3,8 @@
 
 #include <munit.h>
 
-void* test_bal_setup(const MunitParameter params[], void* user_data);
-MunitResult test_bal_insert(const MunitParameter params[], void* user_data_or_fixture);
+MunitResult test_balanced(const MunitParameter params[], void* user_data_or_fixture);
+MunitResult test_unbalanced(const MunitParameter params[], void* user_data_or_fixture);
+MunitResult test_benchmark(const MunitParameter params[], void* user_data_or_fixture);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,51 @@
+#include "test_bal_convergence.h"
+
+#include <bal_convergence.h>
+
+/**
+ * @brief	the rate of a linearly decreasing spread is its slope
+ */
+MunitResult test_convergence_rate(const MunitParameter params[], void *user_data_or_fixture) {
+	bal_convergence_t conv;
+	bal_convergence_init(&conv);
+
+	munit_assert_float(bal_convergence_get_rate(&conv), ==, 0.f);
+	munit_assert_int32(bal_convergence_get_eta(&conv, 50), ==, BAL_CONVERGENCE_ETA_UNKNOWN);
+
+	// 1 mV every 10 s, more samples than the history can hold
+	for (uint32_t i = 0; i < BAL_CONVERGENCE_SAMPLES * 2; i++)
+		bal_convergence_add(&conv, i * BAL_CONVERGENCE_INTERVAL, 1000 - i * 10);
+
+	munit_assert_uint16(bal_convergence_get_spread(&conv), ==, 1000 - (BAL_CONVERGENCE_SAMPLES * 2 - 1) * 10);
+	munit_assert_double_equal(bal_convergence_get_rate(&conv), -1.0, 3);
+
+	// Remaining 630 - 50 mV * 10 at 1 mV * 10 per second
+	munit_assert_int32(bal_convergence_get_eta(&conv, 50), ==, 1000 - (BAL_CONVERGENCE_SAMPLES * 2 - 1) * 10 - 50);
+	munit_assert_int32(bal_convergence_get_eta(&conv, 1000), ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	no estimate is given while the spread is not decreasing
+ */
+MunitResult test_convergence_diverging(const MunitParameter params[], void *user_data_or_fixture) {
+	bal_convergence_t conv;
+	bal_convergence_init(&conv);
+
+	for (uint32_t i = 0; i < BAL_CONVERGENCE_SAMPLES; i++)
+		bal_convergence_add(&conv, i * BAL_CONVERGENCE_INTERVAL, 500 + (i % 2) * 20 + i);
+
+	munit_assert_float(bal_convergence_get_rate(&conv), >, 0.f);
+	munit_assert_int32(bal_convergence_get_eta(&conv, 50), ==, BAL_CONVERGENCE_ETA_UNKNOWN);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_bal_convergence_tests[] = {
+	{(char *)"/rate", test_convergence_rate, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/diverging", test_convergence_diverging, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_bal_convergence_suite = {"/balancing_convergence", test_bal_convergence_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_BAL_CONVERGENCE_H
+#define TEST_BAL_CONVERGENCE_H
+
+#include <munit.h>
+
+#endif
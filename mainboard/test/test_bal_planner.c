@@ -0,0 +1,106 @@
+#include "test_bal_planner.h"
+
+#include <bal_planner.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bal_sim.h"
+
+#define PLANNER_TEST_THRESHOLD 50  // mV * 10
+#define PLANNER_TEST_MAX_TIME (48.f * 3600.f)
+
+static void fill_temps(float temps[CELLBOARD_COUNT], float temp) {
+	for (size_t i = 0; i < CELLBOARD_COUNT; i++)
+		temps[i] = temp;
+}
+
+/**
+ * @brief	the planner never discharges two adjacent cells of the same cellboard
+ */
+MunitResult test_planner_neighbors(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_t volts[PACK_CELL_COUNT];
+	float temps[CELLBOARD_COUNT];
+	bal_plan_t plan;
+
+	fill_temps(temps, BAL_SIM_AMBIENT_TEMP);
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		volts[i] = 36000 + munit_rand_int_range(0, 1000);
+	volts[0] = 35000;
+
+	size_t count = bal_planner_compute(volts, temps, 0, PLANNER_TEST_THRESHOLD, &plan);
+	munit_assert_size(count, >, 0);
+	munit_assert_uint16(plan.target, ==, 35000);
+
+	for (size_t board = 0; board < CELLBOARD_COUNT; board++) {
+		uint32_t cells = plan.boards[board].cells;
+		munit_assert_uint32(cells & (cells >> 1), ==, 0);
+
+		for (size_t i = 0; i < CELLBOARD_CELL_COUNT; i++) {
+			if (cells & (1U << i))
+				munit_assert_uint8(plan.boards[board].durations[i], >, 0);
+			else
+				munit_assert_uint8(plan.boards[board].durations[i], ==, 0);
+		}
+	}
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	hot cellboards discharge fewer cells and stop at the thermal limit
+ */
+MunitResult test_planner_thermal(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_t volts[PACK_CELL_COUNT];
+	float temps[CELLBOARD_COUNT];
+	bal_plan_t plan;
+
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		volts[i] = 37000;
+	volts[0] = 35000;
+
+	fill_temps(temps, BAL_SIM_AMBIENT_TEMP);
+	temps[1] = (BAL_PLANNER_TEMP_DERATE + BAL_PLANNER_TEMP_LIMIT) / 2.f;
+	temps[2] = BAL_PLANNER_TEMP_LIMIT;
+	bal_planner_compute(volts, temps, 0, PLANNER_TEST_THRESHOLD, &plan);
+
+	size_t counts[CELLBOARD_COUNT] = {0};
+	for (size_t board = 0; board < CELLBOARD_COUNT; board++) {
+		for (uint32_t cells = plan.boards[board].cells; cells != 0; cells &= cells - 1)
+			counts[board]++;
+		munit_assert_size(counts[board], <=, bal_planner_thermal_budget(temps[board]));
+	}
+	munit_assert_size(counts[3], ==, BAL_PLANNER_MAX_ACTIVE_CELLS);
+	munit_assert_size(counts[1], <, counts[3]);
+	munit_assert_size(counts[2], ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	compares the time needed to balance the pack with the threshold scheme
+ */
+MunitResult test_planner_time_to_balance(const MunitParameter params[], void *user_data_or_fixture) {
+	bal_sim_t threshold_sim, planner_sim;
+	bal_sim_init(&threshold_sim, 0x5EED, 38000, 400);
+	bal_sim_init(&planner_sim, 0x5EED, 38000, 400);
+
+	float threshold_time = bal_sim_run(&threshold_sim, BAL_SIM_STRATEGY_THRESHOLD, PLANNER_TEST_THRESHOLD, PLANNER_TEST_MAX_TIME);
+	float planner_time = bal_sim_run(&planner_sim, BAL_SIM_STRATEGY_PLANNER, PLANNER_TEST_THRESHOLD, PLANNER_TEST_MAX_TIME);
+
+	munit_logf(MUNIT_LOG_INFO, "threshold: %.0f s %.2f degC, planner: %.0f s %.2f degC",
+		threshold_time, threshold_sim.peak_temp, planner_time, planner_sim.peak_temp);
+
+	munit_assert_float(planner_time, >=, 0.f);
+	munit_assert_uint16(bal_sim_get_spread(&planner_sim), <=, PLANNER_TEST_THRESHOLD);
+	munit_assert_float(planner_sim.peak_temp, <=, BAL_PLANNER_TEMP_LIMIT);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_bal_planner_tests[] = {
+	{(char *)"/neighbors", test_planner_neighbors, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/thermal", test_planner_thermal, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/time_to_balance", test_planner_time_to_balance, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_bal_planner_suite = {"/balancing_planner", test_bal_planner_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
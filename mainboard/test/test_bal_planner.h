@@ -0,0 +1,6 @@
+#ifndef TEST_BAL_PLANNER_H
+#define TEST_BAL_PLANNER_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,368 @@
+#include "test_can_replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <can_replay.h>
+#include <can_replay_stubs.h>
+#include <can_comm.h>
+#include <error/error_simple.h>
+#include <watchdog.h>
+#include <primary_network.h>
+#include <primary_watchdog.h>
+#include <bms_network.h>
+#include <bms_watchdog.h>
+
+#define REPLAY_BMS_INTERFACE "can0"
+#define REPLAY_CAR_INTERFACE "can1"
+/** @brief Period of the routine, like MEASURE_BASE_INTERVAL_MS (ms) */
+#define REPLAY_PERIOD_MS 5U
+/** @brief Interval of the status sent to the car, like MEASURE_INTERVAL_10MS in measures.c (ms) */
+#define REPLAY_HV_STATUS_INTERVAL_MS 10U
+
+/** @brief Timeouts of the watchdog, computed like watchdog_init from the intervals of the network (ms) */
+#define REPLAY_ECU_STATUS_TIMEOUT_MS WATCHDOG_TIMEOUT_MS(primary_watchdog_interval_from_id(PRIMARY_ECU_STATUS_FRAME_ID))
+#define REPLAY_BOARD_STATUS_TIMEOUT_MS WATCHDOG_TIMEOUT_MS(bms_watchdog_interval_from_id(BMS_BOARD_STATUS_FRAME_ID))
+
+#define REPLAY_TRANSITION_CAPACITY 16U
+
+/**
+ * @brief	Mainboard fed by the replay
+ * @details	The frames go through the CAN interrupts of can_comm.c and the
+ * routine runs watchdog.c and error_simple.c like measures.c and main do, see
+ * can_replay_stubs.h for what is not linked. The FSM is reduced to taking the
+ * TS requests in set_ts_request, the precharge states are skipped
+ */
+typedef struct {
+	can_replay_t replay;
+
+	can_replay_event_t transitions[REPLAY_TRANSITION_CAPACITY];
+	size_t transition_count;
+	size_t hv_status_count;
+	uint8_t hv_status[CAN_REPLAY_DATA_SIZE];
+	uint8_t hv_status_length;
+	FILE *out;
+	uint32_t sleep_ms;
+} replay_bms_t;
+
+static replay_bms_t bms;
+
+void _replay_bms_receive(void *context, const can_replay_frame_t *frame) {
+	can_replay_stubs_receive(frame);
+}
+
+void _replay_bms_routine(void *context, uint32_t now) {
+	replay_bms_t *model = context;
+
+	watchdog_routine();
+	error_simple_routine();
+
+	// Take the request like the state functions of bms_fsm.c
+	if (set_ts_request.is_new) {
+		set_ts_request.is_new = false;
+		bms_state_t state = fsm_get_state();
+		if (set_ts_request.next_state != state) {
+			can_replay_transition(&model->replay, state, set_ts_request.next_state);
+			can_replay_stubs_set_state(set_ts_request.next_state);
+		}
+	}
+
+	if (now % REPLAY_HV_STATUS_INTERVAL_MS == 0)
+		can_car_send(PRIMARY_HV_STATUS_FRAME_ID);
+}
+
+void _replay_bms_event(void *context, const can_replay_event_t *event) {
+	replay_bms_t *model = context;
+	if (event->type == CAN_REPLAY_EVENT_TRANSITION && model->transition_count < REPLAY_TRANSITION_CAPACITY)
+		model->transitions[model->transition_count++] = *event;
+	if (event->type == CAN_REPLAY_EVENT_TX && event->bus == CAN_REPLAY_BUS_CAR && event->id == PRIMARY_HV_STATUS_FRAME_ID) {
+		++model->hv_status_count;
+		model->hv_status_length = event->length;
+		memcpy(model->hv_status, event->data, event->length);
+	}
+	if (model->out != NULL)
+		can_replay_print_event(model->out, &model->replay, event);
+}
+
+void _replay_bms_sleep(void *context, uint32_t ms) {
+	replay_bms_t *model = context;
+	model->sleep_ms += ms;
+	if (model->replay.realtime) {
+		struct timespec time = { .tv_sec = ms / 1000U, .tv_nsec = (long)(ms % 1000U) * 1000000L };
+		nanosleep(&time, NULL);
+	}
+}
+
+void _replay_bms_init(replay_bms_t *model, bool realtime, FILE *out) {
+	can_replay_target_t target = {
+		.receive = _replay_bms_receive,
+		.routine = _replay_bms_routine,
+		.event = _replay_bms_event,
+		.sleep = _replay_bms_sleep,
+		.context = model};
+
+	memset(model, 0, sizeof(*model));
+	can_replay_init(&model->replay, &target, REPLAY_BMS_INTERFACE, REPLAY_CAR_INTERFACE, REPLAY_PERIOD_MS, realtime);
+	model->out = out;
+	can_replay_stubs_init(&model->replay);
+	error_simple_init();
+	watchdog_init();
+}
+
+/** @brief Count the time waited by the replay without waiting for it */
+void _replay_bms_count_sleep(void *context, uint32_t ms) {
+	replay_bms_t *model = context;
+	model->sleep_ms += ms;
+}
+
+/** @brief Write a frame of the log, time in ms from the start of the session */
+void _replay_log_frame(FILE *log, uint32_t time, const char *interface, uint32_t id, const char *data) {
+	uint64_t timestamp = 1697000000000000ULL + (uint64_t)time * 1000U;
+	fprintf(log, "(%llu.%06llu) %s %03X#%s\n",
+		(unsigned long long)(timestamp / 1000000U), (unsigned long long)(timestamp % 1000000U), interface, id, data);
+}
+
+/** @brief Write a request of the ECU to turn the TS on or off */
+void _replay_log_set_status(FILE *log, uint32_t time, bool on) {
+	primary_hv_set_status_ecu_t raw_ts_status = { 0 };
+	primary_hv_set_status_ecu_converted_t conv_ts_status = {
+		.hv_status_set = on ? primary_hv_set_status_ecu_hv_status_set_on : primary_hv_set_status_ecu_hv_status_set_off};
+	uint8_t buffer[CAN_REPLAY_DATA_SIZE];
+	char data[2 * CAN_REPLAY_DATA_SIZE + 1] = { 0 };
+
+	primary_hv_set_status_ecu_conversion_to_raw_struct(&raw_ts_status, &conv_ts_status);
+	int length = primary_hv_set_status_ecu_pack(buffer, &raw_ts_status, PRIMARY_HV_SET_STATUS_ECU_BYTE_SIZE);
+	munit_assert_int(length, >, 0);
+	for (int i = 0; i < length; ++i)
+		sprintf(data + 2 * i, "%02X", buffer[i]);
+	_replay_log_frame(log, time, REPLAY_CAR_INTERFACE, PRIMARY_HV_SET_STATUS_ECU_FRAME_ID, data);
+}
+
+/** @brief Car and cellboards alive every 100 ms from start to end */
+void _replay_log_session(FILE *log, uint32_t start, uint32_t end) {
+	for (uint32_t time = start; time < end; time += 100) {
+		_replay_log_frame(log, time, REPLAY_CAR_INTERFACE, PRIMARY_ECU_STATUS_FRAME_ID, "00");
+		_replay_log_frame(log, time + 1, REPLAY_BMS_INTERFACE, BMS_BOARD_STATUS_FRAME_ID, "0000000000000000");
+	}
+}
+
+/**
+ * @brief	candump lines are parsed with their timestamp, interface and payload
+ */
+MunitResult test_can_replay_parse(const MunitParameter params[], void *user_data_or_fixture) {
+	can_replay_frame_t frame;
+	char interface[CAN_REPLAY_INTERFACE_SIZE];
+
+	munit_assert_int(can_replay_parse("(1436509052.249713) vcan0 044#2A366C2BBA\n", &frame, interface), ==, 0);
+	munit_assert_string_equal(interface, "vcan0");
+	munit_assert_uint64(frame.timestamp, ==, 1436509052249713ULL);
+	munit_assert_uint32(frame.id, ==, 0x044);
+	munit_assert_false(frame.extended);
+	munit_assert_uint8(frame.length, ==, 5);
+	const uint8_t data[] = { 0x2A, 0x36, 0x6C, 0x2B, 0xBA };
+	munit_assert_memory_equal(sizeof(data), frame.data, data);
+
+	munit_assert_int(can_replay_parse("(1436509052.000001) can1 1F334455#", &frame, interface), ==, 0);
+	munit_assert_true(frame.extended);
+	munit_assert_false(frame.error);
+	munit_assert_uint32(frame.id, ==, 0x1F334455);
+	munit_assert_uint8(frame.length, ==, 0);
+
+	munit_assert_int(can_replay_parse("(1.000000) can0 123#R", &frame, interface), ==, 0);
+	munit_assert_true(frame.remote);
+
+	munit_assert_int(can_replay_parse("(1.000000) can0 20000080#0000000000000000", &frame, interface), ==, 0);
+	munit_assert_true(frame.error);
+
+	// Not frames of a classic CAN log
+	munit_assert_int(can_replay_parse("", &frame, interface), ==, -1);
+	munit_assert_int(can_replay_parse("can0  123   [2]  01 02", &frame, interface), ==, -1);
+	munit_assert_int(can_replay_parse("(1.000000) can0 1234#00", &frame, interface), ==, -1);
+	munit_assert_int(can_replay_parse("(1.000000) can0 123#001", &frame, interface), ==, -1);
+	munit_assert_int(can_replay_parse("(1.000000) can0 123#000102030405060708", &frame, interface), ==, -1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the frames are received at their time and the routine runs at every period in between
+ */
+MunitResult test_can_replay_timing(const MunitParameter params[], void *user_data_or_fixture) {
+	FILE *log = tmpfile();
+	munit_assert_not_null(log);
+	_replay_log_frame(log, 0, REPLAY_CAR_INTERFACE, PRIMARY_ECU_STATUS_FRAME_ID, "00");
+	_replay_log_frame(log, 37, REPLAY_BMS_INTERFACE, BMS_BOARD_STATUS_FRAME_ID, "00");
+	_replay_log_frame(log, 37, "can2", 0x123, "00");
+	_replay_log_frame(log, 1000, REPLAY_CAR_INTERFACE, PRIMARY_ECU_STATUS_FRAME_ID, "00");
+	rewind(log);
+
+	_replay_bms_init(&bms, false, NULL);
+	munit_assert_size(can_replay_file(&bms.replay, log), ==, 3);
+	munit_assert_uint32(bms.replay.now, ==, 1000);
+	munit_assert_uint32(bms.replay.frames[CAN_REPLAY_BUS_CAR], ==, 2);
+	munit_assert_uint32(bms.replay.frames[CAN_REPLAY_BUS_BMS], ==, 1);
+	munit_assert_uint32(bms.replay.ignored, ==, 1);
+	// The status is sent every 10 ms from the start of the log, packed like the car sees it
+	munit_assert_size(bms.hv_status_count, ==, 1000 / REPLAY_HV_STATUS_INTERVAL_MS + 1);
+	primary_hv_status_t raw_status = { 0 };
+	primary_hv_status_converted_t conv_status = { .status = primary_hv_status_status_idle };
+	uint8_t expected[CAN_REPLAY_DATA_SIZE];
+	primary_hv_status_conversion_to_raw_struct(&raw_status, &conv_status);
+	int length = primary_hv_status_pack(expected, &raw_status, PRIMARY_HV_STATUS_BYTE_SIZE);
+	munit_assert_int(bms.hv_status_length, ==, length);
+	munit_assert_memory_equal(length, bms.hv_status, expected);
+	munit_assert_uint32(bms.sleep_ms, ==, 0);
+
+	// The same log in real time waits for its whole length
+	rewind(log);
+	_replay_bms_init(&bms, true, NULL);
+	bms.replay.target.sleep = _replay_bms_count_sleep;
+	can_replay_file(&bms.replay, log);
+	munit_assert_uint32(bms.sleep_ms, ==, 1000);
+	can_replay_advance(&bms.replay, 500);
+	munit_assert_uint32(bms.sleep_ms, ==, 1500);
+
+	fclose(log);
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the TS is turned off at every timeout of the car status until it is back
+ */
+MunitResult test_can_replay_watchdog(const MunitParameter params[], void *user_data_or_fixture) {
+	FILE *log = tmpfile();
+	munit_assert_not_null(log);
+	// The log loses the ECU for longer than two timeouts
+	munit_assert_uint32(2 * REPLAY_ECU_STATUS_TIMEOUT_MS + 100, <, 1000);
+	_replay_log_session(log, 0, 550);
+	_replay_log_set_status(log, 550, true);
+	_replay_log_session(log, 600, 2000);
+	// The ECU is lost from 1900 ms to 3000 ms, the cellboards are still there,
+	// the TS is requested again after the first timeout
+	uint32_t request = ((1900 + REPLAY_ECU_STATUS_TIMEOUT_MS) / 100 + 1) * 100 + 50;
+	for (uint32_t time = 2000; time < 3000; time += 100) {
+		_replay_log_frame(log, time + 1, REPLAY_BMS_INTERFACE, BMS_BOARD_STATUS_FRAME_ID, "0000000000000000");
+		if (time + 50 == request)
+			_replay_log_set_status(log, request, true);
+	}
+	_replay_log_session(log, 3000, 4000);
+	_replay_log_set_status(log, 4050, true);
+	rewind(log);
+
+	_replay_bms_init(&bms, false, NULL);
+	can_replay_file(&bms.replay, log);
+	can_replay_advance(&bms.replay, REPLAY_PERIOD_MS);
+
+	munit_assert_size(bms.transition_count, ==, 5);
+	// The requests are handled by the first routine after them
+	munit_assert_int(bms.transitions[0].to, ==, STATE_WAIT_AIRN_CLOSE);
+	munit_assert_uint32(bms.transitions[0].time, ==, 550 + REPLAY_PERIOD_MS);
+	// Last status at 1900 ms, the TS is off within a period after the timeout
+	munit_assert_int(bms.transitions[1].to, ==, STATE_IDLE);
+	munit_assert_uint32(bms.transitions[1].time, >=, 1900 + REPLAY_ECU_STATUS_TIMEOUT_MS);
+	munit_assert_uint32(bms.transitions[1].time, <, 1900 + REPLAY_ECU_STATUS_TIMEOUT_MS + REPLAY_PERIOD_MS);
+	// The request is taken, then the TS is turned off again at the next timeout
+	munit_assert_int(bms.transitions[2].to, ==, STATE_WAIT_AIRN_CLOSE);
+	munit_assert_uint32(bms.transitions[2].time, ==, request + REPLAY_PERIOD_MS);
+	munit_assert_int(bms.transitions[3].to, ==, STATE_IDLE);
+	munit_assert_uint32(bms.transitions[3].time, >=, bms.transitions[1].time + REPLAY_ECU_STATUS_TIMEOUT_MS);
+	munit_assert_uint32(bms.transitions[3].time, <, bms.transitions[1].time + REPLAY_ECU_STATUS_TIMEOUT_MS + REPLAY_PERIOD_MS);
+	// Once the ECU is back the TS stays on
+	munit_assert_int(bms.transitions[4].to, ==, STATE_WAIT_AIRN_CLOSE);
+	munit_assert_uint32(bms.transitions[4].time, ==, 4050 + REPLAY_PERIOD_MS);
+	munit_assert_size(get_expired_errors(), ==, 0);
+
+	fclose(log);
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a single reception error is forgiven, consecutive ones on the same bus expire
+ */
+MunitResult test_can_replay_can_errors(const MunitParameter params[], void *user_data_or_fixture) {
+	FILE *log = tmpfile();
+	munit_assert_not_null(log);
+	_replay_log_session(log, 0, 550);
+	_replay_log_frame(log, 520, REPLAY_CAR_INTERFACE, 0x20000004, "0000000000000000");
+	_replay_log_session(log, 600, 1500);
+	_replay_log_frame(log, 1520, REPLAY_BMS_INTERFACE, 0x20000004, "0000000000000000");
+	_replay_log_frame(log, 1521, REPLAY_BMS_INTERFACE, 0x20000004, "0000000000000000");
+	rewind(log);
+
+	_replay_bms_init(&bms, false, NULL);
+	can_replay_file(&bms.replay, log);
+	munit_assert_size(get_expired_errors(), ==, 0);
+	// Expired by the routine after the second error, the FSM goes to fatal error from there
+	can_replay_advance(&bms.replay, REPLAY_PERIOD_MS);
+	munit_assert_size(get_expired_errors(), ==, 1);
+	munit_assert_int(error_simple_dump[0].group, ==, ERROR_GROUP_ERROR_CAN);
+	munit_assert_size(error_simple_dump[0].instance, ==, 0);
+
+	fclose(log);
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	hours of log are replayed in a fraction of their length
+ */
+MunitResult test_can_replay_hours(const MunitParameter params[], void *user_data_or_fixture) {
+	const uint32_t length = 3U * 60U * 60U * 1000U;
+	FILE *log = tmpfile();
+	munit_assert_not_null(log);
+	_replay_log_session(log, 0, length);
+	rewind(log);
+
+	clock_t start = clock();
+	_replay_bms_init(&bms, false, NULL);
+	munit_assert_size(can_replay_file(&bms.replay, log), ==, 2 * length / 100);
+	double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+	munit_logf(MUNIT_LOG_INFO, "%" PRIu32 " s of log replayed in %.2f s", length / 1000U, elapsed);
+
+	munit_assert_size(bms.transition_count, ==, 0);
+	munit_assert_size(bms.hv_status_count, ==, (length - 100 + 1) / REPLAY_HV_STATUS_INTERVAL_MS + 1);
+
+	fclose(log);
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	replay the log in CAN_REPLAY_LOG, skipped if not set
+ * @details	the frames sent and the transitions are written to the file in the
+ * CAN_REPLAY_OUTPUT environment variable or to the standard output, with
+ * CAN_REPLAY_REALTIME set the log is replayed at its original speed
+ */
+MunitResult test_can_replay_log(const MunitParameter params[], void *user_data_or_fixture) {
+	const char *path = getenv("CAN_REPLAY_LOG");
+	if (path == NULL)
+		return MUNIT_SKIP;
+	FILE *log = fopen(path, "r");
+	munit_assert_not_null(log);
+	const char *output = getenv("CAN_REPLAY_OUTPUT");
+	FILE *out = output != NULL ? fopen(output, "w") : stdout;
+	munit_assert_not_null(out);
+
+	_replay_bms_init(&bms, getenv("CAN_REPLAY_REALTIME") != NULL, out);
+	size_t frames = can_replay_file(&bms.replay, log);
+	can_replay_advance(&bms.replay, 1000);
+	munit_logf(MUNIT_LOG_INFO, "%zu frames in %.1f s: %" PRIu32 " sent, %" PRIu32 " transitions, %zu errors expired",
+		frames, bms.replay.now / 1000.0, bms.replay.tx[CAN_REPLAY_BUS_BMS] + bms.replay.tx[CAN_REPLAY_BUS_CAR],
+		bms.replay.transitions, get_expired_errors());
+
+	fclose(log);
+	if (out != stdout)
+		fclose(out);
+	return MUNIT_OK;
+}
+
+MunitTest test_can_replay_tests[] = {
+	{(char *)"/parse", test_can_replay_parse, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/timing", test_can_replay_timing, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/watchdog", test_can_replay_watchdog, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/can_errors", test_can_replay_can_errors, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/hours", test_can_replay_hours, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/log", test_can_replay_log, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_can_replay_suite = {"/can_replay", test_can_replay_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_CAN_REPLAY_H
+#define TEST_CAN_REPLAY_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,149 @@
+#include "test_cell_anomaly.h"
+
+#include <cell_anomaly.h>
+
+#define TEST_ANOMALY_OCV 38000 // mV * 10
+#define TEST_ANOMALY_R 150     // mV * 10 / A, 15 mOhm
+
+static cell_anomaly_t anomaly;
+static voltage_t voltages[PACK_CELL_COUNT];
+
+/** @brief A small deterministic noise, within +-0.3 mV */
+static int _test_anomaly_noise(size_t cell, uint32_t step) {
+	return (int)((cell * 7U + step * 13U) % 7U) - 3;
+}
+
+/** @brief Voltages of a pack where every cell has the same resistance but one */
+static void _test_anomaly_pack(uint32_t step, float current, size_t weak, int offset, int weak_r) {
+	for (size_t i = 0; i < PACK_CELL_COUNT; ++i) {
+		int r = i == weak ? weak_r : TEST_ANOMALY_R;
+		voltages[i] = (voltage_t)(TEST_ANOMALY_OCV - current * r + _test_anomaly_noise(i, step) + (i == weak ? offset : 0));
+	}
+}
+
+/**
+ * @brief	a cell which sags more than the others under load has the lowest z-score,
+ * while charging too
+ */
+MunitResult test_cell_anomaly_z(const MunitParameter params[], void *user_data_or_fixture) {
+	cell_anomaly_init(&anomaly);
+
+	// 15 mV lower than the others in discharge, 15 mV higher in charge
+	for (uint32_t i = 0; i < 4000; ++i) {
+		float current = (i / 500) % 2 ? -40.f : 100.f;
+		_test_anomaly_pack(i, current, 42, current > 0 ? -150 : 150, TEST_ANOMALY_R);
+		cell_anomaly_update(&anomaly, i * 50, current, false, voltages);
+	}
+
+	cell_anomaly_suspect_t suspects[CELL_ANOMALY_SUSPECT_COUNT];
+	size_t found = cell_anomaly_get_suspects(&anomaly, suspects, CELL_ANOMALY_SUSPECT_COUNT);
+	munit_assert_size(found, >=, 1);
+	munit_assert_size(suspects[0].cell, ==, 42);
+	munit_assert_float(suspects[0].z, <, -CELL_ANOMALY_Z_LIMIT);
+	munit_assert_true(suspects[0].flags & CELL_ANOMALY_FLAG_Z);
+	munit_assert_false(suspects[0].flags & CELL_ANOMALY_FLAG_DRIFT);
+
+	// The rest of the pack is fine
+	for (size_t i = 1; i < found; ++i)
+		munit_assert_float(suspects[i].score, <, 1.f);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the resistance of a cell compared to the pack is found on the current steps
+ */
+MunitResult test_cell_anomaly_resistance(const MunitParameter params[], void *user_data_or_fixture) {
+	cell_anomaly_init(&anomaly);
+
+	// 25 mOhm against 15 mOhm, the current changes every 100 ms
+	for (uint32_t i = 0; i < 200; ++i) {
+		float current = (i / 2) % 2 ? 120.f : 5.f;
+		_test_anomaly_pack(i, current, 7, 0, TEST_ANOMALY_R + 100);
+		cell_anomaly_update(&anomaly, i * 50, current, false, voltages);
+	}
+
+	cell_anomaly_suspect_t cell;
+	cell_anomaly_get_cell(&anomaly, 7, &cell);
+	munit_assert_double_equal(cell.resistance, 100.f * (PACK_CELL_COUNT - 1) / PACK_CELL_COUNT, 0);
+	munit_assert_true(cell.flags & CELL_ANOMALY_FLAG_RESISTANCE);
+	cell_anomaly_get_cell(&anomaly, 8, &cell);
+	munit_assert_float(cell.resistance, <, 5.f);
+	munit_assert_uint8(cell.flags, ==, 0);
+
+	// Slow variations of the current are not used
+	cell_anomaly_init(&anomaly);
+	for (uint32_t i = 0; i < 200; ++i) {
+		float current = (i / 2) % 2 ? 120.f : 5.f;
+		_test_anomaly_pack(i, current, 7, 0, TEST_ANOMALY_R + 100);
+		cell_anomaly_update(&anomaly, i * (CELL_ANOMALY_STEP_TIME + 1), current, false, voltages);
+	}
+	cell_anomaly_get_cell(&anomaly, 7, &cell);
+	munit_assert_float(cell.resistance, ==, 0.f);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a cell discharging faster than the others is found at rest, but not while balancing
+ */
+MunitResult test_cell_anomaly_drift(const MunitParameter params[], void *user_data_or_fixture) {
+	for (int balancing = 0; balancing < 2; ++balancing) {
+		cell_anomaly_init(&anomaly);
+
+		// 2 mV/h, a snapshot every second for an hour
+		for (uint32_t s = 0; s <= 3600; ++s) {
+			_test_anomaly_pack(s, 0.f, 100, -(int)(s * 20 / 3600), TEST_ANOMALY_R);
+			cell_anomaly_update(&anomaly, s * 1000, 0.f, balancing, voltages);
+		}
+
+		cell_anomaly_suspect_t cell;
+		cell_anomaly_get_cell(&anomaly, 100 % PACK_CELL_COUNT, &cell);
+		if (balancing) {
+			munit_assert_float(cell.drift, ==, 0.f);
+			munit_assert_uint8(cell.flags, ==, 0);
+		} else {
+			munit_assert_double_equal(cell.drift, -20.f, 0);
+			munit_assert_uint8(cell.flags, ==, CELL_ANOMALY_FLAG_DRIFT);
+		}
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the suspects are sorted by score and limited in number
+ */
+MunitResult test_cell_anomaly_rank(const MunitParameter params[], void *user_data_or_fixture) {
+	cell_anomaly_suspect_t suspects[CELL_ANOMALY_SUSPECT_COUNT];
+	cell_anomaly_init(&anomaly);
+	munit_assert_size(cell_anomaly_get_suspects(&anomaly, suspects, CELL_ANOMALY_SUSPECT_COUNT), ==, 0);
+
+	const float resistances[] = { 10.f, 80.f, 30.f, 60.f, 20.f };
+	const size_t cells[] = { 3, 20, 51, 77, 90 };
+	for (size_t i = 0; i < 5; ++i)
+		anomaly.resistance[cells[i] % PACK_CELL_COUNT] = resistances[i];
+	// A strong cell is not a suspect
+	anomaly.z[5] = 5.f;
+
+	munit_assert_size(cell_anomaly_get_suspects(&anomaly, suspects, CELL_ANOMALY_SUSPECT_COUNT), ==, 3);
+	munit_assert_size(suspects[0].cell, ==, 20);
+	munit_assert_size(suspects[1].cell, ==, 77);
+	munit_assert_size(suspects[2].cell, ==, 51);
+	munit_assert_uint8(suspects[0].flags, ==, CELL_ANOMALY_FLAG_RESISTANCE);
+	munit_assert_uint8(suspects[2].flags, ==, 0);
+	munit_assert_size(cell_anomaly_get_suspects(&anomaly, suspects, 1), ==, 1);
+	munit_assert_size(suspects[0].cell, ==, 20);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_cell_anomaly_tests[] = {
+	{(char *)"/z", test_cell_anomaly_z, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/resistance", test_cell_anomaly_resistance, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/drift", test_cell_anomaly_drift, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/rank", test_cell_anomaly_rank, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_cell_anomaly_suite = {"/cell_anomaly", test_cell_anomaly_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
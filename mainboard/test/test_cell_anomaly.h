@@ -0,0 +1,6 @@
+#ifndef TEST_CELL_ANOMALY_H
+#define TEST_CELL_ANOMALY_H
+
+#include <munit.h>
+
+#endif
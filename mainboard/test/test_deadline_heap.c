@@ -0,0 +1,85 @@
+#include "test_deadline_heap.h"
+
+#include <deadline_heap.h>
+
+static deadline_heap_t heap;
+
+/**
+ * @brief	the entries expire in order of deadline and only when not reset
+ */
+MunitResult test_deadline_expiry(const MunitParameter params[], void *user_data_or_fixture) {
+	deadline_heap_init(&heap);
+	munit_assert_int32(deadline_heap_check(&heap, 0), ==, -1);
+	munit_assert_uint32(deadline_heap_time_left(&heap, 0), ==, UINT32_MAX);
+
+	munit_assert_int32(deadline_heap_add(&heap, 300, 0), ==, 0);
+	munit_assert_int32(deadline_heap_add(&heap, 100, 0), ==, 1);
+	munit_assert_int32(deadline_heap_add(&heap, 200, 0), ==, 2);
+	munit_assert_uint32(deadline_heap_time_left(&heap, 50), ==, 50);
+
+	// Entry 1 is reset in time, entry 2 is not
+	for (uint32_t now = 0; now < 200; now += 5) {
+		deadline_heap_reset(&heap, 1, now);
+		munit_assert_int32(deadline_heap_check(&heap, now), ==, -1);
+	}
+	munit_assert_int32(deadline_heap_check(&heap, 200), ==, 2);
+	munit_assert_int32(deadline_heap_check(&heap, 250), ==, -1);
+	munit_assert_true(deadline_heap_is_expired(&heap, 2));
+	munit_assert_false(deadline_heap_is_expired(&heap, 1));
+	munit_assert_uint16(deadline_heap_get_misses(&heap, 2), ==, 1);
+
+	// Both 0 and 2 expire, 2 for the second time
+	deadline_heap_reset(&heap, 1, 400);
+	int32_t first = deadline_heap_check(&heap, 450);
+	int32_t second = deadline_heap_check(&heap, 450);
+	munit_assert_int32(first, ==, 0);
+	munit_assert_int32(second, ==, 2);
+	munit_assert_int32(deadline_heap_check(&heap, 450), ==, -1);
+	munit_assert_uint16(deadline_heap_get_misses(&heap, 2), ==, 2);
+
+	// A reset clears the expiration
+	deadline_heap_reset(&heap, 2, 460);
+	deadline_heap_reset(&heap, 1, 590);
+	munit_assert_false(deadline_heap_is_expired(&heap, 2));
+	munit_assert_int32(deadline_heap_check(&heap, 600), ==, -1);
+	munit_assert_int32(deadline_heap_check(&heap, 661), ==, 2);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the deadlines are compared across the wrap around of the time
+ */
+MunitResult test_deadline_wrap(const MunitParameter params[], void *user_data_or_fixture) {
+	uint32_t start = UINT32_MAX - 50;
+	deadline_heap_init(&heap);
+	deadline_heap_add(&heap, 100, start);
+	deadline_heap_add(&heap, 20, start);
+
+	munit_assert_int32(deadline_heap_check(&heap, start + 10), ==, -1);
+	munit_assert_int32(deadline_heap_check(&heap, start + 20), ==, 1);
+	munit_assert_int32(deadline_heap_check(&heap, start + 60), ==, 1);
+	munit_assert_int32(deadline_heap_check(&heap, start + 70), ==, -1);
+	munit_assert_int32(deadline_heap_check(&heap, start + 100), ==, 1);
+	munit_assert_int32(deadline_heap_check(&heap, start + 100), ==, 0);
+	munit_assert_uint16(deadline_heap_get_misses(&heap, 1), ==, 3);
+
+	// Fill the heap
+	deadline_heap_init(&heap);
+	for (uint32_t i = 0; i < DEADLINE_HEAP_CAPACITY; ++i)
+		munit_assert_int32(deadline_heap_add(&heap, 1000 - i * 10, 0), ==, (int32_t)i);
+	munit_assert_int32(deadline_heap_add(&heap, 10, 0), ==, -1);
+	for (int32_t i = DEADLINE_HEAP_CAPACITY - 1; i >= 0; --i)
+		munit_assert_int32(deadline_heap_check(&heap, 1000), ==, i);
+	munit_assert_int32(deadline_heap_check(&heap, 1000), ==, -1);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_deadline_heap_tests[] = {
+	{(char *)"/expiry", test_deadline_expiry, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/wrap", test_deadline_wrap, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_deadline_heap_suite = {"/deadline_heap", test_deadline_heap_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_DEADLINE_HEAP_H
+#define TEST_DEADLINE_HEAP_H
+
+#include <munit.h>
+
+#endif
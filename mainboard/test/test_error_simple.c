@@ -0,0 +1,67 @@
+#include "test_error_simple.h"
+
+#include <error_simple.h>
+
+#define _TEST_ERROR_SIMPLE_INSTANCES(group, instances) [group] = (instances),
+static const size_t instances[N_ERROR_GROUPS] = { ERROR_SIMPLE_GROUPS(_TEST_ERROR_SIMPLE_INSTANCES) };
+
+/**
+ * @brief	the instances of every group are contiguous and the layout follows the pack description
+ */
+MunitResult test_error_simple_layout(const MunitParameter params[], void *user_data_or_fixture) {
+	size_t expected = 0;
+	for (size_t group = 0; group < N_ERROR_GROUPS; ++group) {
+		for (size_t instance = 0; instance < instances[group]; ++instance, ++expected) {
+			munit_assert_size(_error_simple_from_group_and_instance_to_index(group, instance), ==, expected);
+
+			error_simple_groups_t from_index;
+			munit_assert_size(_error_simple_from_index_to_group_and_instance(expected, &from_index), ==, instance);
+			munit_assert_int(from_index, ==, group);
+		}
+	}
+	munit_assert_size(ERROR_SIMPLE_STATE_SIZE, ==, expected);
+
+	munit_assert_size(ERROR_GROUP_ERROR_CELLBOARD_COMM_N_INSTANCES, ==, CELLBOARD_COUNT);
+	munit_assert_size(ERROR_GROUP_ERROR_CELLBOARD_INTERNAL_N_INSTANCES, ==, CELLBOARD_COUNT);
+	munit_assert_int(error_simple_set(ERROR_GROUP_ERROR_CELLBOARD_COMM, CELLBOARD_COUNT), ==, -1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the expired errors are dumped with their group and instance
+ */
+MunitResult test_error_simple_expire(const MunitParameter params[], void *user_data_or_fixture) {
+	error_simple_init();
+	for (size_t i = 0; i < ERROR_SIMPLE_COUNTER_THRESHOLD; ++i) {
+		munit_assert_int(error_simple_routine(), ==, 0);
+		error_simple_set(ERROR_GROUP_ERROR_CELL_UNDER_VOLTAGE, 0);
+		error_simple_set(ERROR_GROUP_ERROR_CELLBOARD_INTERNAL, CELLBOARD_COUNT - 1);
+	}
+	munit_assert_int(error_simple_routine(), ==, 2);
+	munit_assert_int(error_simple_dump[0].group, ==, ERROR_GROUP_ERROR_CELL_UNDER_VOLTAGE);
+	munit_assert_size(error_simple_dump[0].instance, ==, 0);
+	munit_assert_int(error_simple_dump[1].group, ==, ERROR_GROUP_ERROR_CELLBOARD_INTERNAL);
+	munit_assert_size(error_simple_dump[1].instance, ==, CELLBOARD_COUNT - 1);
+
+	// The dump never overflows
+	error_simple_init();
+	for (size_t group = 0; group < N_ERROR_GROUPS; ++group) {
+		for (size_t instance = 0; instance < instances[group]; ++instance) {
+			for (size_t i = 0; i < ERROR_SIMPLE_COUNTER_THRESHOLD; ++i)
+				error_simple_set(group, instance);
+		}
+	}
+	munit_assert_size(error_simple_routine(), ==, ERROR_SIMPLE_STATE_SIZE < ERROR_SIMPLE_DUMP_SIZE ? ERROR_SIMPLE_STATE_SIZE : ERROR_SIMPLE_DUMP_SIZE);
+	error_simple_init();
+
+	return MUNIT_OK;
+}
+
+MunitTest test_error_simple_tests[] = {
+	{(char *)"/layout", test_error_simple_layout, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/expire", test_error_simple_expire, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_error_simple_suite = {"/error_simple", test_error_simple_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
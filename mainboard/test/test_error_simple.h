@@ -0,0 +1,6 @@
+#ifndef TEST_ERROR_SIMPLE_H
+#define TEST_ERROR_SIMPLE_H
+
+#include <munit.h>
+
+#endif
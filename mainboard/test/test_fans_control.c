@@ -0,0 +1,144 @@
+#include "test_fans_control.h"
+
+#include <fans_control.h>
+
+// Thermal model of the simulated pack, different from the estimates of the controller
+#define FANS_SIM_CAPACITY 30000.f        // J/K
+#define FANS_SIM_CONDUCTANCE_OFF 4.f     // W/K
+#define FANS_SIM_CONDUCTANCE_FANS 70.f   // W/K
+#define FANS_SIM_RESISTANCE 0.35f        // Ohm
+#define FANS_SIM_STEP 0.05f              // s, current sampling period
+#define FANS_SIM_DURATION 7200           // s
+
+typedef struct {
+	float temp;      // °C
+	float max_temp;  // °C
+	float energy;    // Fans energy, proportional to the cube of the speed (s)
+	float speed;     // Mean speed, the noise grows with it
+	float changes;   // Sum of the speed changes
+	float max_step;  // Largest speed change
+} fans_sim_t;
+
+/**
+ * @brief	current of a lap: 20 s of acceleration and 40 s of cruise, followed by a pause after one hour
+ */
+static float fans_sim_current(float time) {
+	if (time >= 3600.f)
+		return 5.f;
+	return (uint32_t)time % 60 < 20 ? 60.f : 15.f;
+}
+
+/**
+ * @brief	the curve used before the controller (°C to speed)
+ */
+static float fans_sim_curve(float temp) {
+	if (temp < 30.f)
+		return 0.f;
+	if (temp > 45.f)
+		return 1.f;
+	float speed = 1.5f * (temp - 30.f) / 25.f + 0.1f;
+	return speed > 1.f ? 1.f : speed;
+}
+
+/**
+ * @brief	simulate the pack with the controller, or with the curve if control is NULL
+ */
+static void fans_sim_run(fans_sim_t *sim, fans_control_t *control) {
+	float speed = 0.f;
+	*sim = (fans_sim_t){.temp = FANS_CONTROL_AMBIENT_TEMP, .max_temp = FANS_CONTROL_AMBIENT_TEMP};
+
+	for (uint32_t second = 0; second < FANS_SIM_DURATION; ++second) {
+		for (float t = 0.f; t < 1.f; t += FANS_SIM_STEP) {
+			float current = fans_sim_current(second + t);
+			if (control != NULL)
+				fans_control_sample_current(control, current);
+			float conductance = FANS_SIM_CONDUCTANCE_OFF + FANS_SIM_CONDUCTANCE_FANS * speed;
+			float power = current * current * FANS_SIM_RESISTANCE - conductance * (sim->temp - FANS_CONTROL_AMBIENT_TEMP);
+			sim->temp += power * FANS_SIM_STEP / FANS_SIM_CAPACITY;
+		}
+
+		float next = control != NULL ? fans_control_update(control, sim->temp, 1.f) : fans_sim_curve(sim->temp);
+		float step = next > speed ? next - speed : speed - next;
+		sim->changes += step;
+		if (step > sim->max_step)
+			sim->max_step = step;
+		speed = next;
+		sim->energy += speed * speed * speed;
+		sim->speed += speed / FANS_SIM_DURATION;
+		if (sim->temp > sim->max_temp)
+			sim->max_temp = sim->temp;
+	}
+}
+
+/**
+ * @brief	the feed-forward holds the target at steady state according to the model
+ */
+MunitResult test_fans_feed_forward(const MunitParameter params[], void *user_data_or_fixture) {
+	munit_assert_float(fans_control_feed_forward(0.f, 40.f), ==, 0.f);
+	munit_assert_float(fans_control_feed_forward(100.f, 20.f), ==, 1.f);
+	munit_assert_float(fans_control_feed_forward(1e5f, 40.f), ==, 1.f);
+
+	float losses = 600.f;
+	float speed = fans_control_feed_forward(losses, 40.f);
+	float conductance = FANS_CONTROL_CONDUCTANCE_OFF + FANS_CONTROL_CONDUCTANCE_FANS * speed;
+	munit_assert_float(conductance * (40.f - FANS_CONTROL_AMBIENT_TEMP), >, losses - 0.01f);
+	munit_assert_float(conductance * (40.f - FANS_CONTROL_AMBIENT_TEMP), <, losses + 0.01f);
+
+	// The fans do not start below the minimum speed and do not change faster than the ramp
+	fans_control_t control;
+	fans_control_init(&control, 40.f);
+	munit_assert_float(fans_control_update(&control, 38.f, 1.f), ==, 0.f);
+	float prev = 0.f;
+	for (uint32_t i = 0; i < 60; ++i) {
+		float next = fans_control_update(&control, 45.f, 1.f);
+		munit_assert_true(next == 0.f || next >= FANS_CONTROL_MIN_SPEED);
+		munit_assert_float(next - prev, <=, FANS_CONTROL_MIN_SPEED + FANS_CONTROL_RAMP_UP + 1e-5f);
+		prev = next;
+	}
+	munit_assert_float(prev, >, FANS_CONTROL_KP * 5.f);
+
+	// Full speed well above the target, the integral does not wind up meanwhile
+	munit_assert_float(fans_control_update(&control, 40.f + FANS_CONTROL_EMERGENCY_DELTA, 1.f), ==, 1.f);
+	float integral = control.integral;
+	for (uint32_t i = 0; i < 100; ++i)
+		fans_control_update(&control, 40.f + FANS_CONTROL_EMERGENCY_DELTA, 1.f);
+	munit_assert_float(control.integral, ==, integral);
+
+	// The fans slow down as soon as the temperature is below the target
+	fans_control_update(&control, 39.f, 1.f);
+	munit_assert_float(control.speed, <, 1.f);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the controller holds the target with less fan energy than the curve
+ */
+MunitResult test_fans_benchmark(const MunitParameter params[], void *user_data_or_fixture) {
+	fans_sim_t curve, pi;
+	fans_control_t control;
+
+	fans_sim_run(&curve, NULL);
+	fans_control_init(&control, FANS_CONTROL_TARGET_TEMP);
+	fans_sim_run(&pi, &control);
+
+	munit_logf(MUNIT_LOG_INFO, "curve: max %.2f degC, end %.2f degC, energy %.1f, mean speed %.3f, changes %.2f",
+		curve.max_temp, curve.temp, curve.energy, curve.speed, curve.changes);
+	munit_logf(MUNIT_LOG_INFO, "pi: max %.2f degC, end %.2f degC, energy %.1f, mean speed %.3f, changes %.2f",
+		pi.max_temp, pi.temp, pi.energy, pi.speed, pi.changes);
+
+	munit_assert_float(pi.max_temp, <, FANS_CONTROL_TARGET_TEMP + 1.f);
+	munit_assert_float(pi.energy, <, curve.energy);
+	munit_assert_float(pi.speed, <, curve.speed);
+	munit_assert_float(pi.max_step, <=, FANS_CONTROL_MIN_SPEED + FANS_CONTROL_RAMP_UP + 1e-5f);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_fans_control_tests[] = {
+	{(char *)"/feed_forward", test_fans_feed_forward, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/benchmark", test_fans_benchmark, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_fans_control_suite = {"/fans_control", test_fans_control_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
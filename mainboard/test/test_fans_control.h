@@ -0,0 +1,6 @@
+#ifndef TEST_FANS_CONTROL_H
+#define TEST_FANS_CONTROL_H
+
+#include <munit.h>
+
+#endif
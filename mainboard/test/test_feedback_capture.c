@@ -0,0 +1,85 @@
+#include "test_feedback_capture.h"
+
+#include <feedback_capture.h>
+
+static feedback_capture_t capture;
+
+/**
+ * @brief	the capture holds the requested samples around the trigger
+ */
+MunitResult test_capture_window(const MunitParameter params[], void *user_data_or_fixture) {
+	feedback_capture_init(&capture);
+	munit_assert_true(feedback_capture_arm(&capture, 0b101, FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR, 10, 5));
+
+	// Feedback 1 is not in the mask
+	for (uint16_t i = 0; i < 100; i++) {
+		feedback_capture_add(&capture, 0, i, i);
+		feedback_capture_add(&capture, 1, i, i);
+	}
+	munit_assert_int(capture.state, ==, FEEDBACK_CAPTURE_STATE_ARMED);
+
+	// Another event does not fire the trigger
+	feedback_capture_trigger(&capture, FEEDBACK_CAPTURE_TRIGGER_TRANSITION);
+	munit_assert_int(capture.state, ==, FEEDBACK_CAPTURE_STATE_ARMED);
+	feedback_capture_trigger(&capture, FEEDBACK_CAPTURE_TRIGGER_FATAL_ERROR);
+	munit_assert_int(capture.state, ==, FEEDBACK_CAPTURE_STATE_TRIGGERED);
+	munit_assert_size(feedback_capture_get_count(&capture), ==, 0);
+
+	for (uint16_t i = 100; i < 200; i++)
+		feedback_capture_add(&capture, 2, i, i);
+	munit_assert_int(capture.state, ==, FEEDBACK_CAPTURE_STATE_DONE);
+	munit_assert_size(feedback_capture_get_count(&capture), ==, 15);
+	munit_assert_size(feedback_capture_get_trigger_offset(&capture), ==, 10);
+
+	feedback_capture_sample_t sample;
+	munit_assert_true(feedback_capture_get_sample(&capture, 0, &sample));
+	munit_assert_uint16(sample.value, ==, 90);
+	munit_assert_uint8(sample.index, ==, 0);
+	munit_assert_true(feedback_capture_get_sample(&capture, 10, &sample));
+	munit_assert_uint16(sample.value, ==, 100);
+	munit_assert_uint8(sample.index, ==, 2);
+	munit_assert_true(feedback_capture_get_sample(&capture, 14, &sample));
+	munit_assert_uint16(sample.value, ==, 104);
+	munit_assert_false(feedback_capture_get_sample(&capture, 15, &sample));
+
+	// The capture is frozen once complete
+	feedback_capture_add(&capture, 0, 1000, 1000);
+	munit_assert_true(feedback_capture_get_sample(&capture, 14, &sample));
+	munit_assert_uint16(sample.value, ==, 104);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a trigger shortly after arming keeps only the recorded samples
+ */
+MunitResult test_capture_short_pre(const MunitParameter params[], void *user_data_or_fixture) {
+	feedback_capture_init(&capture);
+	munit_assert_false(feedback_capture_arm(&capture, 1, FEEDBACK_CAPTURE_TRIGGER_MANUAL, FEEDBACK_CAPTURE_SIZE, 1));
+	munit_assert_true(feedback_capture_arm(&capture, 1, FEEDBACK_CAPTURE_TRIGGER_TRANSITION, 50, 2));
+
+	feedback_capture_add(&capture, 0, 1, 0);
+	feedback_capture_add(&capture, 0, 2, 0);
+	feedback_capture_trigger(&capture, FEEDBACK_CAPTURE_TRIGGER_MANUAL);
+	feedback_capture_add(&capture, 0, 3, 0);
+	feedback_capture_add(&capture, 0, 4, 0);
+
+	munit_assert_size(feedback_capture_get_count(&capture), ==, 4);
+	munit_assert_size(feedback_capture_get_trigger_offset(&capture), ==, 2);
+
+	feedback_capture_sample_t sample;
+	munit_assert_true(feedback_capture_get_sample(&capture, 0, &sample));
+	munit_assert_uint16(sample.value, ==, 1);
+	munit_assert_true(feedback_capture_get_sample(&capture, 3, &sample));
+	munit_assert_uint16(sample.value, ==, 4);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_feedback_capture_tests[] = {
+	{(char *)"/window", test_capture_window, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/short_pre", test_capture_short_pre, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_feedback_capture_suite = {"/feedback_capture", test_feedback_capture_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
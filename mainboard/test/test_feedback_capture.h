@@ -0,0 +1,6 @@
+#ifndef TEST_FEEDBACK_CAPTURE_H
+#define TEST_FEEDBACK_CAPTURE_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,209 @@
+#include "test_fixed_point.h"
+
+#include <math.h>
+#include <time.h>
+
+#include <fixed_point.h>
+#include <pack/current.h>
+
+#define FIXED_TEST_SUM_MAX (CURRENT_ADC_FULL_SCALE * CURRENT_SAMPLE_COUNT)
+
+/** @brief Round to the nearest, ties towards +inf, like the library */
+static long double _fixed_test_round(long double value) {
+	return floorl(value + 0.5L);
+}
+
+/**
+ * @brief	the voltage of every possible sum of samples is the exact value rounded
+ * @details	the reference is computed in long double from the same constants,
+ * the old float conversion is within its own rounding error
+ */
+MunitResult test_fixed_point_adc(const MunitParameter params[], void *user_data_or_fixture) {
+	const fixed_voltage_t vref = FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF);
+	const long double den = (long double)CURRENT_ADC_FULL_SCALE * CURRENT_SAMPLE_COUNT;
+
+	for (uint32_t sum = 0; sum <= FIXED_TEST_SUM_MAX; ++sum) {
+		fixed_voltage_t volt = fixed_voltage_from_adc(sum, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+		munit_assert_int32(volt.q, ==, (int32_t)_fixed_test_round(sum * (long double)vref.q / den));
+
+		// Within a LSB of the real value and of the float path
+		long double real = sum * (long double)CURRENT_ADC_VREF / den;
+		munit_assert_true(fabsl(volt.q - real * (1UL << FIXED_VOLTAGE_FRAC)) <= 1.L);
+		float old = (float)sum * 3.3f / 4095.f / CURRENT_SAMPLE_COUNT;
+		munit_assert_true(fabsl(fixed_voltage_to_float(volt) - (long double)old) <= 2e-6L);
+	}
+
+	// The shunt is converted from a single sample
+	munit_assert_int32(fixed_voltage_from_adc(4095, 1, 4095, FIXED_VOLTAGE_CONST(1.8)).q, ==, FIXED_VOLTAGE_CONST(1.8).q);
+	munit_assert_int32(fixed_voltage_from_adc(0, 1, 4095, FIXED_VOLTAGE_CONST(1.8)).q, ==, 0);
+	munit_assert_int32(fixed_voltage_from_adc(100, 0, 4095, FIXED_VOLTAGE_CONST(1.8)).q, ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the currents of the Hall effect sensors and of the shunt are the exact values rounded
+ */
+MunitResult test_fixed_point_current(const MunitParameter params[], void *user_data_or_fixture) {
+	const fixed_voltage_t vref = FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF);
+	const fixed_gain_t gains[] = { CURRENT_GAIN_LOW, CURRENT_GAIN_HIGH };
+	const float float_gains[] = {
+		((330.f + 169.f) / 330.f) / 40e-3f,
+		((330.f + 169.f) / 330.f) / 6.67e-3f };
+	const fixed_voltage_t offset = fixed_voltage_from_adc(2048 * CURRENT_SAMPLE_COUNT, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+
+	for (size_t g = 0; g < 2; ++g) {
+		for (uint32_t sum = 0; sum <= FIXED_TEST_SUM_MAX; sum += 7) {
+			fixed_voltage_t volt = fixed_voltage_from_adc(sum, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+			fixed_current_t current = fixed_current_from_voltage(volt, offset, gains[g]);
+
+			// Bit exact with the same constants
+			long double exact = (long double)(volt.q - offset.q) * gains[g].q / (1UL << (FIXED_VOLTAGE_FRAC + FIXED_GAIN_FRAC - FIXED_CURRENT_FRAC));
+			munit_assert_int32(current.q, ==, (int32_t)_fixed_test_round(exact));
+
+			// The float chain it replaces, within its rounding error
+			float old_volt = (float)sum * 3.3f / 4095.f / CURRENT_SAMPLE_COUNT;
+			float old_offset = 2048.f * CURRENT_SAMPLE_COUNT * (3.3f / 4095 / CURRENT_SAMPLE_COUNT);
+			float old = float_gains[g] * (old_volt - old_offset);
+			munit_assert_float(fabsf(fixed_current_to_float(current) - old), <=, 1e-3f);
+		}
+	}
+
+	// Shunt, centered on its reference
+	fixed_voltage_t volt = fixed_voltage_from_adc(2000, 1, 4095, FIXED_VOLTAGE_CONST(1.8));
+	fixed_current_t shunt = fixed_current_from_voltage(volt, FIXED_VOLTAGE_CONST(CURRENT_SHUNT_VREF_OFFSET), CURRENT_GAIN_SHUNT);
+	float old = (2000 * (1.8f / 4095) - 0.454f) / (75.f * 1e-4f);
+	munit_assert_float(fabsf(fixed_current_to_float(shunt) - old), <=, 1e-3f);
+
+	// The thresholds are exact
+	munit_assert_int32(FIXED_CURRENT_CONST(CURRENT_MAX_THRESHOLD).q, ==, 180 << FIXED_CURRENT_FRAC);
+	munit_assert_int32(FIXED_CURRENT_CONST(CURRENT_MIN_THRESHOLD).q, ==, -20 * (1 << FIXED_CURRENT_FRAC));
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	products are rounded to the nearest and saturated
+ */
+MunitResult test_fixed_point_mul(const MunitParameter params[], void *user_data_or_fixture) {
+	munit_assert_int32(fixed_mul(FIXED_CONST(1.5, 16), FIXED_CONST(2, 16), 16), ==, FIXED_CONST(3, 16));
+	munit_assert_int32(fixed_mul(FIXED_CONST(-1.5, 16), FIXED_CONST(2, 16), 16), ==, FIXED_CONST(-3, 16));
+	// Ties go towards +inf
+	munit_assert_int32(fixed_mul(3, 1, 1), ==, 2);
+	munit_assert_int32(fixed_mul(-3, 1, 1), ==, -1);
+	munit_assert_int32(fixed_mul(INT32_MAX, INT32_MAX, 0), ==, INT32_MAX);
+	munit_assert_int32(fixed_mul(INT32_MIN, INT32_MAX, 0), ==, INT32_MIN);
+	munit_assert_int32(FIXED_CONST(-0.25, 2), ==, -1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the filter of the current follows the float one and settles on a constant input
+ */
+MunitResult test_fixed_point_filter(const MunitParameter params[], void *user_data_or_fixture) {
+	const fixed_gain_t alpha = FIXED_GAIN_CONST(CURRENT_FILTER_ALPHA);
+	fixed_current_t filtered = { 0 };
+	float old = 0.f;
+
+	for (size_t i = 0; i < 1000; ++i) {
+		float value = 150.f * sinf(i * 0.05f) + (i % 7) * 0.3f;
+		fixed_current_t input = { (int32_t)lrintf(value * (1 << FIXED_CURRENT_FRAC)) };
+
+		long double exact = input.q + (long double)alpha.q * (filtered.q - input.q) / (1UL << FIXED_GAIN_FRAC);
+		filtered = fixed_current_filter(filtered, input, alpha);
+		munit_assert_int32(filtered.q, ==, (int32_t)_fixed_test_round(exact));
+
+		old = 0.4f * old + (1.f - 0.4f) * fixed_current_to_float(input);
+		munit_assert_float(fabsf(fixed_current_to_float(filtered) - old), <=, 1e-3f);
+	}
+
+	// A constant input is reached exactly
+	for (size_t i = 0; i < 100; ++i)
+		filtered = fixed_current_filter(filtered, FIXED_CURRENT_CONST(-12.5), alpha);
+	munit_assert_int32(filtered.q, ==, FIXED_CURRENT_CONST(-12.5).q);
+
+	return MUNIT_OK;
+}
+
+#define FIXED_TEST_CHAIN_RUNS 200000U
+
+/** @brief The float chain of current_read before the port, from the sums of the samples to the filtered current */
+static float _fixed_test_float_chain(const uint16_t adc_50[], const uint16_t adc_300[], float shunt_volt, float prev) {
+	float avg_50 = 0, avg_300 = 0;
+	for (size_t i = 0; i < CURRENT_SAMPLE_COUNT; i++) {
+		avg_50 += adc_50[i];
+		avg_300 += adc_300[i];
+	}
+	const float offset = 2048.f * (3.3f / 4095 / CURRENT_SAMPLE_COUNT) * CURRENT_SAMPLE_COUNT;
+	float current_50 = (((330.f + 169.f) / 330.f) / 40e-3f) * (avg_50 * 3.3f / 4095.f / CURRENT_SAMPLE_COUNT - offset);
+	float current_300 = (((330.f + 169.f) / 330.f) / 6.67e-3f) * (avg_300 * 3.3f / 4095.f / CURRENT_SAMPLE_COUNT - offset);
+	volatile float shunt = (shunt_volt - 0.454f) / (75.f * 1e-4f);
+	(void)shunt;
+	float value = (fabsf(current_50) < 34 && fabsf(current_300) < 34) ? current_50 : current_300;
+	return 0.4f * prev + (1.f - 0.4f) * value;
+}
+
+/** @brief The same steps of current_read with the fixed-point library */
+static fixed_current_t _fixed_test_fixed_chain(const uint16_t adc_50[], const uint16_t adc_300[], uint16_t shunt_adc, fixed_current_t prev) {
+	uint32_t sum_50 = 0, sum_300 = 0;
+	for (size_t i = 0; i < CURRENT_SAMPLE_COUNT; i++) {
+		sum_50 += adc_50[i];
+		sum_300 += adc_300[i];
+	}
+	const fixed_voltage_t vref = FIXED_VOLTAGE_CONST(CURRENT_ADC_VREF);
+	const fixed_voltage_t offset = fixed_voltage_from_adc(2048 * CURRENT_SAMPLE_COUNT, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+	fixed_voltage_t volt = fixed_voltage_from_adc(sum_50, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+	fixed_current_t current_50 = fixed_current_from_voltage(volt, offset, CURRENT_GAIN_LOW);
+	volt = fixed_voltage_from_adc(sum_300, CURRENT_SAMPLE_COUNT, CURRENT_ADC_FULL_SCALE, vref);
+	fixed_current_t current_300 = fixed_current_from_voltage(volt, offset, CURRENT_GAIN_HIGH);
+	volt = fixed_voltage_from_adc(shunt_adc, 1, 4095, FIXED_VOLTAGE_CONST(1.8));
+	volatile float shunt = fixed_current_to_float(fixed_current_from_voltage(volt, FIXED_VOLTAGE_CONST(CURRENT_SHUNT_VREF_OFFSET), CURRENT_GAIN_SHUNT));
+	(void)shunt;
+	fixed_current_t value = current_300;
+	if (fixed_current_abs(current_50).q < FIXED_CURRENT_CONST(CURRENT_LOW_RANGE).q && fixed_current_abs(current_300).q < FIXED_CURRENT_CONST(CURRENT_LOW_RANGE).q)
+		value = current_50;
+	return fixed_current_filter(prev, value, FIXED_GAIN_CONST(CURRENT_FILTER_ALPHA));
+}
+
+/**
+ * @brief	time of the current chain of a 50 ms cycle, before and after the port
+ * @details	measured on the host, the cycles on the board are shown by the status
+ * command of the CLI; both chains must give the same current
+ */
+MunitResult test_fixed_point_chain_time(const MunitParameter params[], void *user_data_or_fixture) {
+	uint16_t adc_50[CURRENT_SAMPLE_COUNT], adc_300[CURRENT_SAMPLE_COUNT];
+	for (size_t i = 0; i < CURRENT_SAMPLE_COUNT; i++) {
+		adc_50[i] = (uint16_t)(2300 + i % 17);
+		adc_300[i] = (uint16_t)(2100 + i % 5);
+	}
+
+	float old = 0.f;
+	clock_t start = clock();
+	for (uint32_t run = 0; run < FIXED_TEST_CHAIN_RUNS; ++run)
+		old = _fixed_test_float_chain(adc_50, adc_300, 2000 * (1.8f / 4095), old);
+	double float_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	fixed_current_t current = { 0 };
+	start = clock();
+	for (uint32_t run = 0; run < FIXED_TEST_CHAIN_RUNS; ++run)
+		current = _fixed_test_fixed_chain(adc_50, adc_300, 2000, current);
+	double fixed_time = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	munit_logf(MUNIT_LOG_INFO, "float: %.1f ns, fixed-point: %.1f ns for each 50 ms cycle",
+		float_time * 1e9 / FIXED_TEST_CHAIN_RUNS, fixed_time * 1e9 / FIXED_TEST_CHAIN_RUNS);
+	munit_assert_float(fabsf(fixed_current_to_float(current) - old), <=, 1e-3f);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_fixed_point_tests[] = {
+	{(char *)"/adc", test_fixed_point_adc, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/current", test_fixed_point_current, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/mul", test_fixed_point_mul, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/filter", test_fixed_point_filter, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/chain_time", test_fixed_point_chain_time, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_fixed_point_suite = {"/fixed_point", test_fixed_point_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_FIXED_POINT_H
+#define TEST_FIXED_POINT_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,241 @@
+#include "test_flash_fanout.h"
+
+#include <string.h>
+
+#include <flash_fanout.h>
+
+#define SIM_BASE_ADDRESS 0x08004000U
+#define SIM_IMAGE_SIZE 70U
+#define SIM_LATENCY_MS 2U
+
+/** @brief Minimal OpenBLT bootloader */
+typedef struct {
+	uint8_t memory[SIM_IMAGE_SIZE];
+	uint32_t mta;
+	uint32_t commands;
+	bool dead;
+	bool drop_next_command;
+	bool drop_next_answer;
+	bool answer_pending;
+	uint32_t answer_time;
+	uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+	uint8_t answer_length;
+} sim_board_t;
+
+static flash_fanout_t fanout;
+static sim_board_t boards[FLASH_FANOUT_BOARD_COUNT];
+static uint8_t image[SIM_IMAGE_SIZE];
+
+void _sim_board_execute(sim_board_t * board, const uint8_t * data, uint8_t length, uint32_t now) {
+	if (board->dead)
+		return;
+	if (board->drop_next_command) {
+		board->drop_next_command = false;
+		return;
+	}
+	++board->commands;
+
+	board->answer[0] = 0xFF;
+	board->answer_length = 1;
+	switch (data[0]) {
+		case 0xFF: // Connect
+			memset(board->answer, 0, FLASH_FANOUT_DATA_SIZE);
+			board->answer[0] = 0xFF;
+			board->answer[3] = 8;
+			board->answer_length = 8;
+			break;
+		case 0xF6: // Set MTA
+			board->mta = data[4] | (data[5] << 8) | (data[6] << 16) | ((uint32_t)data[7] << 24);
+			break;
+		case 0xC9: // Program max
+		case 0xD0: { // Program
+			uint8_t count = data[0] == 0xC9 ? 7 : data[1];
+			const uint8_t * bytes = data[0] == 0xC9 ? data + 1 : data + 2;
+			for (uint8_t i = 0; i < count; ++i) {
+				uint32_t offset = board->mta + i - SIM_BASE_ADDRESS;
+				if (offset < SIM_IMAGE_SIZE)
+					board->memory[offset] = bytes[i];
+			}
+			board->mta += count;
+			break;
+		}
+	}
+
+	if (board->drop_next_answer) {
+		board->drop_next_answer = false;
+		return;
+	}
+	board->answer_pending = true;
+	board->answer_time = now + SIM_LATENCY_MS;
+}
+
+/** @brief Run the fan-out and the boards until the host receives an answer */
+bool _sim_command(const uint8_t * data, uint8_t length, uint32_t * now, uint8_t * answer, uint8_t * answer_length) {
+	flash_fanout_request(&fanout, data, length);
+	for (uint32_t end = *now + 10000; *now < end; ++*now) {
+		flash_fanout_update(&fanout, *now);
+
+		uint8_t frame[FLASH_FANOUT_DATA_SIZE];
+		uint8_t frame_length;
+		int32_t index;
+		while ((index = flash_fanout_next(&fanout, *now, frame, &frame_length)) >= 0)
+			_sim_board_execute(&boards[index], frame, frame_length, *now);
+
+		for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+			if (boards[i].answer_pending && boards[i].answer_time <= *now) {
+				boards[i].answer_pending = false;
+				flash_fanout_receive(&fanout, i, boards[i].answer, boards[i].answer_length);
+			}
+		}
+
+		if (flash_fanout_get_answer(&fanout, answer, answer_length))
+			return true;
+	}
+	return false;
+}
+
+/** @brief Send a whole image like the host tool and check the answers */
+void _sim_flash(uint32_t * now) {
+	uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+	uint8_t answer_length;
+	uint8_t connect[] = { 0xFF, 0x00 };
+	uint8_t set_mta[] = { 0xF6, 0, 0, 0, SIM_BASE_ADDRESS & 0xFF, (SIM_BASE_ADDRESS >> 8) & 0xFF, (SIM_BASE_ADDRESS >> 16) & 0xFF, SIM_BASE_ADDRESS >> 24 };
+
+	munit_assert_true(_sim_command(connect, sizeof(connect), now, answer, &answer_length));
+	munit_assert_uint8(answer_length, ==, 8);
+	munit_assert_uint8(answer[0], ==, 0xFF);
+	munit_assert_true(_sim_command(set_mta, sizeof(set_mta), now, answer, &answer_length));
+	munit_assert_uint8(answer[0], ==, 0xFF);
+
+	// Program max with 7 bytes, the remainder with program
+	size_t offset = 0;
+	for (; offset + 7 <= SIM_IMAGE_SIZE; offset += 7) {
+		uint8_t program_max[8] = { 0xC9 };
+		memcpy(program_max + 1, image + offset, 7);
+		munit_assert_true(_sim_command(program_max, sizeof(program_max), now, answer, &answer_length));
+		munit_assert_uint8(answer[0], ==, 0xFF);
+	}
+	if (offset < SIM_IMAGE_SIZE) {
+		uint8_t program[8] = { 0xD0, SIM_IMAGE_SIZE - offset };
+		memcpy(program + 2, image + offset, SIM_IMAGE_SIZE - offset);
+		munit_assert_true(_sim_command(program, sizeof(program), now, answer, &answer_length));
+		munit_assert_uint8(answer[0], ==, 0xFF);
+	}
+}
+
+void _sim_init() {
+	memset(boards, 0, sizeof(boards));
+	for (size_t i = 0; i < SIM_IMAGE_SIZE; ++i)
+		image[i] = (uint8_t)(i * 37 + 11);
+	flash_fanout_init(&fanout, FLASH_FANOUT_ALL_BOARDS);
+}
+
+/**
+ * @brief	every board receives every command once and the host gets one answer per command
+ */
+MunitResult test_flash_fanout_parallel(const MunitParameter params[], void *user_data_or_fixture) {
+	uint32_t now = 0;
+	_sim_init();
+
+	_sim_flash(&now);
+	munit_assert_true(flash_fanout_is_active(&fanout));
+	for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i) {
+		munit_assert_memory_equal(SIM_IMAGE_SIZE, boards[i].memory, image);
+		munit_assert_uint32(boards[i].commands, ==, fanout.commands);
+	}
+	munit_assert_uint16(fanout.retransmissions, ==, 0);
+	munit_assert_uint32(fanout.failed, ==, 0);
+
+	// Every command takes the latency of a single board
+	munit_assert_uint32(now, <=, fanout.commands * (SIM_LATENCY_MS + 1));
+
+	// The reset is not answered by the bootloaders and ends the session
+	uint8_t reset[] = { 0xCF };
+	uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+	uint8_t answer_length;
+	munit_assert_true(_sim_command(reset, sizeof(reset), &now, answer, &answer_length));
+	munit_assert_uint8(answer[0], ==, 0xFF);
+	munit_assert_false(flash_fanout_is_active(&fanout));
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	lost commands and answers are sent again without corrupting the image
+ */
+MunitResult test_flash_fanout_retransmit(const MunitParameter params[], void *user_data_or_fixture) {
+	uint32_t now = 0;
+	uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+	uint8_t answer_length;
+	_sim_init();
+
+	// Half of the image, then board 2 executes a command but its answer is lost
+	// and board 4 does not receive the next one
+	uint8_t connect[] = { 0xFF, 0x00 };
+	uint8_t set_mta[] = { 0xF6, 0, 0, 0, SIM_BASE_ADDRESS & 0xFF, (SIM_BASE_ADDRESS >> 8) & 0xFF, (SIM_BASE_ADDRESS >> 16) & 0xFF, SIM_BASE_ADDRESS >> 24 };
+	munit_assert_true(_sim_command(connect, sizeof(connect), &now, answer, &answer_length));
+	munit_assert_true(_sim_command(set_mta, sizeof(set_mta), &now, answer, &answer_length));
+
+	for (size_t offset = 0; offset + 7 <= SIM_IMAGE_SIZE; offset += 7) {
+		if (offset == 21)
+			boards[2].drop_next_answer = true;
+		if (offset == 28)
+			boards[4].drop_next_command = true;
+
+		uint8_t program_max[8] = { 0xC9 };
+		memcpy(program_max + 1, image + offset, 7);
+		munit_assert_true(_sim_command(program_max, sizeof(program_max), &now, answer, &answer_length));
+		munit_assert_uint8(answer[0], ==, 0xFF);
+	}
+
+	for (size_t i = 0; i < FLASH_FANOUT_BOARD_COUNT; ++i)
+		munit_assert_memory_equal(SIM_IMAGE_SIZE, boards[i].memory, image);
+	munit_assert_uint16(fanout.retransmissions, ==, 2);
+	munit_assert_uint32(fanout.failed, ==, 0);
+
+	// Both boards had their address restored before the command was repeated,
+	// board 2 executed it twice
+	munit_assert_uint32(boards[2].commands, ==, fanout.commands + 2);
+	munit_assert_uint32(boards[4].commands, ==, fanout.commands + 1);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a board which does not answer makes the command fail for the host
+ */
+MunitResult test_flash_fanout_failure(const MunitParameter params[], void *user_data_or_fixture) {
+	uint32_t now = 0;
+	uint8_t answer[FLASH_FANOUT_DATA_SIZE];
+	uint8_t answer_length;
+	_sim_init();
+
+	boards[5].dead = true;
+	uint8_t connect[] = { 0xFF, 0x00 };
+	munit_assert_true(_sim_command(connect, sizeof(connect), &now, answer, &answer_length));
+	munit_assert_uint8(answer_length, ==, 2);
+	munit_assert_uint8(answer[0], ==, 0xFE);
+	munit_assert_uint32(fanout.failed, ==, (uint32_t)1U << 5);
+	munit_assert_uint16(fanout.retransmissions, ==, FLASH_FANOUT_CONNECT_RETRIES);
+
+	// The session ends when the host stops sending commands
+	flash_fanout_update(&fanout, now + FLASH_FANOUT_SESSION_TIMEOUT_MS);
+	munit_assert_false(flash_fanout_is_active(&fanout));
+
+	// A new session includes every board again
+	boards[5].dead = false;
+	_sim_flash(&now);
+	munit_assert_uint32(fanout.failed, ==, 0);
+	munit_assert_memory_equal(SIM_IMAGE_SIZE, boards[5].memory, image);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_flash_fanout_tests[] = {
+	{(char *)"/parallel", test_flash_fanout_parallel, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/retransmit", test_flash_fanout_retransmit, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/failure", test_flash_fanout_failure, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_flash_fanout_suite = {"/flash_fanout", test_flash_fanout_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_FLASH_FANOUT_H
+#define TEST_FLASH_FANOUT_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,137 @@
+#include "test_imd_decoder.h"
+
+#include <imd_decoder.h>
+
+static imd_decoder_t decoder;
+static uint32_t now;
+
+/**
+ * @brief	feed a period of the signal to the decoder with the given duty cycle (% * 100)
+ */
+static void feed_period(uint32_t period, uint32_t duty) {
+	uint32_t high = period * duty / 10000;
+	now += high / 1000;
+	imd_decoder_edge(&decoder, false, now);
+	now += (period - high) / 1000;
+	imd_decoder_edge(&decoder, true, now);
+	imd_decoder_add_capture(&decoder, period, high);
+}
+
+/**
+ * @brief	the state changes after the majority of the periods and ignores a glitch
+ */
+MunitResult test_imd_classify(const MunitParameter params[], void *user_data_or_fixture) {
+	munit_assert_int(imd_decoder_classify(100000), ==, IMD_NORMAL);
+	munit_assert_int(imd_decoder_classify(91000), ==, IMD_NORMAL);
+	munit_assert_int(imd_decoder_classify(52000), ==, IMD_UNDER_VOLTAGE);
+	munit_assert_int(imd_decoder_classify(33000), ==, IMD_START_MEASURE);
+	munit_assert_int(imd_decoder_classify(25000), ==, IMD_DEVICE_ERROR);
+	munit_assert_int(imd_decoder_classify(20500), ==, IMD_EARTH_FAULT);
+	munit_assert_int(imd_decoder_classify(75000), ==, IMD_STATES_N);
+	munit_assert_int(imd_decoder_classify(1000), ==, IMD_STATES_N);
+
+	now = 1000;
+	imd_decoder_init(&decoder);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_SC);
+
+	// Start measure at 30 Hz, stable after the majority of the window
+	imd_decoder_edge(&decoder, true, now);
+	for (size_t i = 0; i < IMD_DECODER_MAJORITY - 1; ++i)
+		feed_period(33333, 1000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_SC);
+	feed_period(33333, 1000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_START_MEASURE);
+
+	// Normal at 10 Hz
+	for (size_t i = 0; i < IMD_DECODER_MAJORITY - 1; ++i)
+		feed_period(100000, 5000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_START_MEASURE);
+	feed_period(100000, 5000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_NORMAL);
+	feed_period(100000, 5000);
+	feed_period(100000, 5000);
+	munit_assert_uint8(imd_decoder_get_confidence(&decoder, now), ==, 100);
+
+	// A glitch splits a period in two, the state does not change
+	feed_period(30000, 2000);
+	feed_period(70000, 6000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_NORMAL);
+	munit_assert_uint8(imd_decoder_get_confidence(&decoder, now), ==, 60);
+	munit_assert_uint32(imd_decoder_get_period(&decoder, now), ==, 100000);
+	munit_assert_uint16(imd_decoder_get_duty(&decoder, now), ==, 5000);
+
+	// 50% duty cycle is 1200 kOhm
+	munit_assert_int32(imd_decoder_get_resistance(&decoder, now), ==, 1200);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a signal without edges is a short circuit at the last level
+ */
+MunitResult test_imd_timeout(const MunitParameter params[], void *user_data_or_fixture) {
+	now = 5000;
+	imd_decoder_init(&decoder);
+	imd_decoder_edge(&decoder, true, now);
+	for (size_t i = 0; i < IMD_DECODER_WINDOW; ++i)
+		feed_period(20000, 5000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_EARTH_FAULT);
+	munit_assert_int32(imd_decoder_get_resistance(&decoder, now), ==, -1);
+
+	imd_decoder_edge(&decoder, false, now);
+	now += IMD_DECODER_TIMEOUT_MS + 1;
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_SC);
+	munit_assert_uint16(imd_decoder_get_duty(&decoder, now), ==, 0);
+	munit_assert_uint32(imd_decoder_get_period(&decoder, now), ==, 0);
+	munit_assert_uint8(imd_decoder_get_confidence(&decoder, now), ==, 100);
+
+	// The decoder starts from scratch when the signal is back
+	imd_decoder_edge(&decoder, true, now);
+	feed_period(100000, 5000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_SC);
+	feed_period(100000, 5000);
+	feed_period(100000, 5000);
+	munit_assert_int(imd_decoder_get_state(&decoder, now), ==, IMD_NORMAL);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the trend follows the insulation resistance
+ */
+MunitResult test_imd_trend(const MunitParameter params[], void *user_data_or_fixture) {
+	now = 1000;
+	imd_decoder_init(&decoder);
+	imd_decoder_edge(&decoder, true, now);
+	munit_assert_float(imd_decoder_get_trend(&decoder), ==, 0.f);
+
+	// The resistance drops from 1200 kOhm (50%) to 960 kOhm (55%) in a minute
+	for (uint32_t duty = 5000; duty <= 5500; duty += 100) {
+		for (size_t i = 0; i < IMD_DECODER_WINDOW; ++i)
+			feed_period(100000, duty);
+		imd_decoder_trend_sample(&decoder, now);
+		now += 12000 - IMD_DECODER_WINDOW * 100;
+	}
+	float trend = imd_decoder_get_trend(&decoder);
+	munit_assert_float(trend, <, -200.f);
+	munit_assert_float(trend, >, -300.f);
+	munit_assert_int32(decoder.resistance_min, ==, 960);
+
+	// The samples are cleared when the resistance is not measured
+	for (size_t i = 0; i < IMD_DECODER_WINDOW; ++i)
+		feed_period(25000, 5000);
+	imd_decoder_trend_sample(&decoder, now);
+	munit_assert_float(imd_decoder_get_trend(&decoder), ==, 0.f);
+	munit_assert_int32(decoder.resistance_min, ==, 960);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_imd_decoder_tests[] = {
+	{(char *)"/classify", test_imd_classify, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/timeout", test_imd_timeout, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/trend", test_imd_trend, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_imd_decoder_suite = {"/imd_decoder", test_imd_decoder_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_IMD_DECODER_H
+#define TEST_IMD_DECODER_H
+
+#include <munit.h>
+
+#endif
@@ -0,0 +1,82 @@
+#include "test_str_writer.h"
+
+#include <string.h>
+#include <str_writer.h>
+
+/**
+ * @brief	numbers are formatted like printf would do, except that the ties are
+ * 			rounded away from zero (-0.25 gives -0.3, printf gives -0.2) and that
+ * 			the floats out of range are saturated
+ */
+MunitResult test_str_writer_numbers(const MunitParameter params[], void *user_data_or_fixture) {
+	char buf[128];
+	str_writer_t writer;
+	str_writer_init(&writer, buf, sizeof(buf));
+
+	str_writer_append_uint(&writer, 0, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_uint(&writer, 42, 4);
+	str_writer_append(&writer, "|");
+	str_writer_append_int(&writer, -7, 3);
+	str_writer_append(&writer, "|");
+	str_writer_append_int(&writer, INT32_MIN, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_hex(&writer, 0x1F, 5);
+	munit_assert_string_equal(buf, "0|  42| -7|-2147483648|0001F");
+
+	str_writer_init(&writer, buf, sizeof(buf));
+	str_writer_append_fixed(&writer, 36123, 4, 2, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_fixed(&writer, 36150, 4, 2, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_fixed(&writer, -5, 1, 3, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_fixed(&writer, -4, 2, 1, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_fixed(&writer, 1234, 0, 1, 8);
+	munit_assert_string_equal(buf, "3.61|3.62|-0.500|0.0|  1234.0");
+
+	str_writer_init(&writer, buf, sizeof(buf));
+	str_writer_append_float(&writer, 3.14159f, 3, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_float(&writer, -0.25f, 1, 6);
+	str_writer_append(&writer, "|");
+	str_writer_append_float(&writer, 99.995f, 0, 0);
+	str_writer_append(&writer, "|");
+	str_writer_append_float(&writer, 1e12f, 0, 0);
+	munit_assert_string_equal(buf, "3.142|  -0.3|100|2147483647");
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the output is truncated at the end of the buffer
+ */
+MunitResult test_str_writer_truncate(const MunitParameter params[], void *user_data_or_fixture) {
+	char buf[8];
+	str_writer_t writer;
+	str_writer_init(&writer, buf, sizeof(buf));
+
+	str_writer_append(&writer, "abc");
+	str_writer_append_padded(&writer, "d", 3);
+	munit_assert_false(writer.truncated);
+	munit_assert_size(writer.length, ==, 6);
+
+	str_writer_append_uint(&writer, 12345, 0);
+	munit_assert_true(writer.truncated);
+	munit_assert_string_equal(buf, "abcd  1");
+
+	// Nothing is added once truncated
+	str_writer_append(&writer, "x");
+	munit_assert_string_equal(buf, "abcd  1");
+
+	return MUNIT_OK;
+}
+
+MunitTest test_str_writer_tests[] = {
+	{(char *)"/numbers", test_str_writer_numbers, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/truncate", test_str_writer_truncate, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_str_writer_suite = {"/str_writer", test_str_writer_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
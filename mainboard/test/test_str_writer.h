@@ -0,0 +1,6 @@
+#ifndef TEST_STR_WRITER_H
+#define TEST_STR_WRITER_H
+
+#include <munit.h>
+
+#endif
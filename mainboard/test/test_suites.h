@@ -5,5 +5,20 @@
 
 extern MunitSuite test_bal_suite;
 extern MunitSuite test_energy_suite;
+extern MunitSuite test_bal_planner_suite;
+extern MunitSuite test_bal_convergence_suite;
+extern MunitSuite test_feedback_capture_suite;
+extern MunitSuite test_tx_ring_suite;
+extern MunitSuite test_telemetry_suite;
+extern MunitSuite test_str_writer_suite;
+extern MunitSuite test_imd_decoder_suite;
+extern MunitSuite test_deadline_heap_suite;
+extern MunitSuite test_fans_control_suite;
+extern MunitSuite test_flash_fanout_suite;
+extern MunitSuite test_can_replay_suite;
+extern MunitSuite test_fixed_point_suite;
+extern MunitSuite test_error_simple_suite;
+extern MunitSuite test_cell_anomaly_suite;
+extern MunitSuite test_voltage_crosscheck_suite;
 
 #endif
\ No newline at end of file
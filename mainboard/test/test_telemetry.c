@@ -0,0 +1,122 @@
+#include "test_telemetry.h"
+
+#include <string.h>
+#include <telemetry.h>
+
+/**
+ * @brief	COBS encoded data has no zeros and is decoded back, also with long blocks
+ */
+MunitResult test_telemetry_cobs(const MunitParameter params[], void *user_data_or_fixture) {
+	uint8_t data[600];
+	uint8_t encoded[TELEMETRY_ENCODED_SIZE(sizeof(data))];
+	uint8_t decoded[sizeof(encoded)];
+
+	// Runs of non zero bytes longer than a COBS block and some zeros
+	for (size_t i = 0; i < sizeof(data); i++)
+		data[i] = (i % 300 == 0 || i == sizeof(data) - 1) ? 0 : (uint8_t)(i | 1);
+
+	size_t len = telemetry_cobs_encode(data, sizeof(data), encoded);
+	munit_assert_size(len, <=, sizeof(data) + sizeof(data) / 254 + 1);
+	munit_assert_null(memchr(encoded, 0, len));
+	munit_assert_size(telemetry_cobs_decode(encoded, len, decoded), ==, sizeof(data));
+	munit_assert_memory_equal(sizeof(data), decoded, data);
+
+	uint8_t zero = 0;
+	len = telemetry_cobs_encode(&zero, 1, encoded);
+	munit_assert_size(len, ==, 2);
+	munit_assert_size(telemetry_cobs_decode(encoded, len, decoded), ==, 1);
+	munit_assert_uint8(decoded[0], ==, 0);
+
+	// A block longer than the data is not valid
+	encoded[0] = 5;
+	munit_assert_size(telemetry_cobs_decode(encoded, len, decoded), ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a frame is decoded back and a corrupted one is discarded
+ */
+MunitResult test_telemetry_frame(const MunitParameter params[], void *user_data_or_fixture) {
+	munit_assert_uint16(telemetry_crc16((const uint8_t *)"123456789", 9), ==, 0x29B1);
+
+	telemetry_snapshot_t snapshot = {0};
+	snapshot.timestamp = 123456;
+	snapshot.current = -1500;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		snapshot.voltages[i] = 30000 + i;
+	snapshot.feedback_high = 0x0100;
+
+	uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+	size_t size = telemetry_snapshot_serialize(&snapshot, payload);
+	munit_assert_size(size, ==, TELEMETRY_SNAPSHOT_SIZE);
+
+	uint8_t frame[TELEMETRY_ENCODED_SIZE(TELEMETRY_MAX_PAYLOAD)];
+	size_t len = telemetry_frame_encode(TELEMETRY_FRAME_SNAPSHOT, 7, payload, size, frame);
+	munit_assert_size(len, <=, TELEMETRY_ENCODED_SIZE(size));
+	munit_assert_uint8(frame[0], ==, 0);
+	munit_assert_uint8(frame[len - 1], ==, 0);
+	munit_assert_null(memchr(frame + 1, 0, len - 2));
+
+	uint8_t type, seq;
+	uint8_t decoded[TELEMETRY_MAX_PAYLOAD];
+	munit_assert_int32(telemetry_frame_decode(frame + 1, len - 2, &type, &seq, decoded), ==, size);
+	munit_assert_uint8(type, ==, TELEMETRY_FRAME_SNAPSHOT);
+	munit_assert_uint8(seq, ==, 7);
+	munit_assert_memory_equal(size, decoded, payload);
+
+	// Little endian fields
+	munit_assert_uint8(decoded[0], ==, 0x40);
+	munit_assert_uint8(decoded[1], ==, 0xE2);
+	munit_assert_uint8(decoded[5], ==, 0x24);
+	munit_assert_uint8(decoded[8], ==, 0xFF);
+
+	frame[10] ^= 0x01;
+	munit_assert_int32(telemetry_frame_decode(frame + 1, len - 2, &type, &seq, decoded), ==, -1);
+
+	munit_assert_size(telemetry_frame_encode(TELEMETRY_FRAME_SNAPSHOT, 0, payload, TELEMETRY_MAX_PAYLOAD + 1, frame), ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	each cellboard is serialized in its own frame, tagged with the timestamp of the snapshot
+ */
+MunitResult test_telemetry_cellboard(const MunitParameter params[], void *user_data_or_fixture) {
+	telemetry_snapshot_t snapshot = {0};
+	snapshot.timestamp = 123456;
+	for (size_t i = 0; i < PACK_CELL_COUNT; i++)
+		snapshot.voltages[i] = 30000 + i;
+	snapshot.temp_min[CELLBOARD_COUNT - 1] = 10;
+	snapshot.temp_max[CELLBOARD_COUNT - 1] = 30;
+	snapshot.temp_avg[CELLBOARD_COUNT - 1] = 20;
+
+	uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+	munit_assert_size(telemetry_snapshot_serialize(&snapshot, payload), ==, TELEMETRY_SNAPSHOT_SIZE);
+	munit_assert_uint8(payload[17], ==, CELLBOARD_COUNT);
+	munit_assert_uint8(payload[18], ==, CELLBOARD_CELL_COUNT);
+
+	size_t size = telemetry_cellboard_serialize(&snapshot, CELLBOARD_COUNT - 1, payload);
+	munit_assert_size(size, ==, TELEMETRY_CELLBOARD_SIZE);
+	munit_assert_uint8(payload[0], ==, 0x40);
+	munit_assert_uint8(payload[4], ==, CELLBOARD_COUNT - 1);
+	munit_assert_uint8(payload[5], ==, 10);
+	munit_assert_uint8(payload[6], ==, 30);
+	munit_assert_uint8(payload[7], ==, 20);
+	// First cell of the last cellboard
+	uint16_t voltage = payload[8] | ((uint16_t)payload[9] << 8);
+	munit_assert_uint16(voltage, ==, 30000 + (CELLBOARD_COUNT - 1) * CELLBOARD_CELL_COUNT);
+
+	munit_assert_size(telemetry_cellboard_serialize(&snapshot, CELLBOARD_COUNT, payload), ==, 0);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_telemetry_tests[] = {
+	{(char *)"/cobs", test_telemetry_cobs, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/frame", test_telemetry_frame, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/cellboard", test_telemetry_cellboard, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_telemetry_suite = {"/telemetry", test_telemetry_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_TELEMETRY_H
+#define TEST_TELEMETRY_H
+
+#include <munit.h>
+
+#endif
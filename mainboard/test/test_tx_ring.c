@@ -0,0 +1,83 @@
+#include "test_tx_ring.h"
+
+#include <string.h>
+#include <tx_ring.h>
+
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+static tx_ring_t ring;
+
+/**
+ * @brief	messages are read back in order, also across the end of the buffer
+ */
+MunitResult test_tx_ring_wrap(const MunitParameter params[], void *user_data_or_fixture) {
+	char msg[100];
+	char *data;
+	tx_ring_init(&ring);
+
+	munit_assert_size(tx_ring_peek(&ring, &data), ==, 0);
+
+	// Move the tail 5 bytes before the end of the buffer
+	memset(msg, 'a', sizeof(msg));
+	for (size_t written = 0; written < TX_RING_SIZE - 5; ) {
+		size_t chunk = MIN(sizeof(msg), TX_RING_SIZE - 5 - written);
+		munit_assert_true(tx_ring_write(&ring, msg, chunk));
+		munit_assert_size(tx_ring_peek(&ring, &data), ==, chunk);
+		tx_ring_consume(&ring, chunk);
+		written += chunk;
+	}
+
+	munit_assert_true(tx_ring_write(&ring, "hello ", 6));
+	munit_assert_true(tx_ring_write(&ring, "world", 5));
+	munit_assert_size(tx_ring_get_pending(&ring), ==, 11);
+
+	// The data is split in two blocks at the end of the buffer
+	char out[16] = {'\0'};
+	size_t len = tx_ring_peek(&ring, &data);
+	munit_assert_size(len, ==, 5);
+	memcpy(out, data, len);
+	tx_ring_consume(&ring, len);
+	size_t rest = tx_ring_peek(&ring, &data);
+	memcpy(out + len, data, rest);
+	tx_ring_consume(&ring, rest);
+
+	munit_assert_size(len + rest, ==, 11);
+	munit_assert_string_equal(out, "hello world");
+	munit_assert_size(tx_ring_get_pending(&ring), ==, 0);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a message that does not fit is dropped entirely and counted
+ */
+MunitResult test_tx_ring_drop(const MunitParameter params[], void *user_data_or_fixture) {
+	static char msg[TX_RING_SIZE];
+	char *data;
+	tx_ring_init(&ring);
+
+	memset(msg, 'b', sizeof(msg));
+	munit_assert_true(tx_ring_write(&ring, msg, TX_RING_SIZE - 10));
+	munit_assert_false(tx_ring_write(&ring, msg, 11));
+	munit_assert_true(tx_ring_write(&ring, msg, 10));
+	munit_assert_false(tx_ring_write(&ring, msg, 1));
+
+	munit_assert_uint32(ring.dropped, ==, 2);
+	munit_assert_uint32(ring.dropped_bytes, ==, 12);
+	munit_assert_size(tx_ring_get_pending(&ring), ==, TX_RING_SIZE);
+
+	// The space is available again once consumed
+	size_t len = tx_ring_peek(&ring, &data);
+	tx_ring_consume(&ring, len);
+	munit_assert_true(tx_ring_write(&ring, msg, 1));
+
+	return MUNIT_OK;
+}
+
+MunitTest test_tx_ring_tests[] = {
+	{(char *)"/wrap", test_tx_ring_wrap, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/drop", test_tx_ring_drop, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_tx_ring_suite = {"/tx_ring", test_tx_ring_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
@@ -0,0 +1,6 @@
+#ifndef TEST_TX_RING_H
+#define TEST_TX_RING_H
+
+#include <munit.h>
+
+#endif
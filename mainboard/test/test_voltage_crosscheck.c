@@ -0,0 +1,175 @@
+#include "test_voltage_crosscheck.h"
+
+#include <math.h>
+
+#include <voltage_crosscheck.h>
+
+#define TEST_CROSSCHECK_SUM 400.f      // V
+#define TEST_CROSSCHECK_GAIN 0.99f     // Gain error of the VBATT divider
+#define TEST_CROSSCHECK_OFFSET 0.5f    // V, offset of the VBATT divider
+#define TEST_CROSSCHECK_R 0.025f       // Ohm, real resistance between the cells and VBATT
+
+static voltage_crosscheck_t check;
+
+/** @brief A deterministic noise within +-amplitude */
+static float _test_crosscheck_noise(uint32_t step, float amplitude) {
+	return amplitude * (float)((int)((step * 37U) % 21U) - 10) / 10.f;
+}
+
+/** @brief Measures of a healthy pack with a divider slightly out of calibration */
+static voltage_crosscheck_sample_t _test_crosscheck_sample(uint32_t step, float current, float noise) {
+	voltage_crosscheck_sample_t sample = {
+		.cell_sum = TEST_CROSSCHECK_SUM - current * 0.1f,
+		.current = current,
+		.ts_connected = true
+	};
+	float bat = sample.cell_sum - current * TEST_CROSSCHECK_R;
+	sample.bat = bat * TEST_CROSSCHECK_GAIN + TEST_CROSSCHECK_OFFSET + _test_crosscheck_noise(step, noise);
+	sample.tsp = sample.bat - current * VOLTAGE_CROSSCHECK_TS_RESISTANCE;
+	return sample;
+}
+
+/** @brief Feed a healthy pack at rest until the offset is learned */
+static void _test_crosscheck_learn(uint32_t steps) {
+	for (uint32_t i = 0; i < steps; ++i) {
+		voltage_crosscheck_sample_t sample = _test_crosscheck_sample(i, 0.5f, 0.2f);
+		munit_assert_uint8(voltage_crosscheck_update(&check, &sample) & ~VOLTAGE_CROSSCHECK_SKIPPED, ==, VOLTAGE_CROSSCHECK_OK);
+	}
+}
+
+/**
+ * @brief	the offset of the divider is learned at rest and the drop is corrected under load
+ */
+MunitResult test_voltage_crosscheck_offset(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_crosscheck_init(&check);
+	_test_crosscheck_learn(10000U);
+
+	// 400 V * (0.99 - 1) + 0.5 V
+	munit_assert_float(fabsf(check.offset + 3.5f), <, 0.1f);
+	munit_assert_float(fabsf(check.bat_residual), <, 0.5f);
+
+	// Under load the residual is the error of the resistance only
+	for (uint32_t i = 0; i < 200U; ++i) {
+		voltage_crosscheck_sample_t sample = _test_crosscheck_sample(i, 150.f, 0.2f);
+		munit_assert_uint8(voltage_crosscheck_update(&check, &sample) & ~VOLTAGE_CROSSCHECK_SKIPPED, ==, VOLTAGE_CROSSCHECK_OK);
+	}
+	munit_assert_float(fabsf(check.bat_residual), <, 1.5f);
+	munit_assert_float(check.bat_tolerance, >, VOLTAGE_CROSSCHECK_TOLERANCE);
+	munit_assert_float(check.bat_tolerance, <=, VOLTAGE_CROSSCHECK_TOLERANCE_MAX);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a real difference is detected and is never learned as an offset
+ */
+MunitResult test_voltage_crosscheck_mismatch(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_crosscheck_init(&check);
+	_test_crosscheck_learn(10000U);
+	const float offset = check.offset;
+
+	// A cellboard reads 15 V less than the real voltage
+	for (uint32_t i = 0; i < 5000U; ++i) {
+		voltage_crosscheck_sample_t sample = _test_crosscheck_sample(i, 0.5f, 0.2f);
+		sample.cell_sum -= 15.f;
+		munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_BAT_MISMATCH);
+	}
+	munit_assert_float(check.offset, ==, offset);
+
+	// The learned offset is bounded
+	voltage_crosscheck_init(&check);
+	for (uint32_t i = 0; i < 100000U; ++i) {
+		voltage_crosscheck_sample_t sample = _test_crosscheck_sample(i, 0.f, 0.f);
+		sample.bat = sample.cell_sum + 7.f;
+		voltage_crosscheck_update(&check, &sample);
+	}
+	munit_assert_float(check.offset, ==, VOLTAGE_CROSSCHECK_MAX_OFFSET);
+	munit_assert_float(fabsf(check.bat_residual), >, 1.f);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	the samples taken while the current steps are skipped, the others pass
+ */
+MunitResult test_voltage_crosscheck_transient(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_crosscheck_init(&check);
+
+	// The first sample has no reference
+	voltage_crosscheck_sample_t sample = _test_crosscheck_sample(0U, 0.f, 0.f);
+	munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_SKIPPED);
+	_test_crosscheck_learn(2000U);
+
+	// Full throttle and full regen, VBATT is read 10 ms after the current
+	float current = 0.5f;
+	for (uint32_t i = 0; i < 2000U; ++i) {
+		float next = (i / 20U) % 2U ? 180.f : -20.f;
+		sample = _test_crosscheck_sample(i, next, 0.2f);
+		sample.bat -= (next - current) * 0.5f;
+		uint8_t result = voltage_crosscheck_update(&check, &sample);
+		if (fabsf(next - current) > VOLTAGE_CROSSCHECK_MAX_STEP)
+			munit_assert_uint8(result, ==, VOLTAGE_CROSSCHECK_SKIPPED);
+		else
+			munit_assert_uint8(result, ==, VOLTAGE_CROSSCHECK_OK);
+		current = next;
+	}
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	a noisy divider widens the tolerance instead of tripping
+ */
+MunitResult test_voltage_crosscheck_noise(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_crosscheck_init(&check);
+	_test_crosscheck_learn(2000U);
+	const float tolerance = check.bat_tolerance;
+
+	for (uint32_t i = 0; i < 5000U; ++i) {
+		voltage_crosscheck_sample_t sample = _test_crosscheck_sample(i, 0.5f, 3.f);
+		munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_OK);
+	}
+	munit_assert_float(check.bat_tolerance, >, tolerance + 3.f);
+	munit_assert_float(check.bat_tolerance, <=, VOLTAGE_CROSSCHECK_TOLERANCE_MAX);
+
+	return MUNIT_OK;
+}
+
+/**
+ * @brief	TS+ is compared with VBATT only when the TS is connected
+ */
+MunitResult test_voltage_crosscheck_ts(const MunitParameter params[], void *user_data_or_fixture) {
+	voltage_crosscheck_init(&check);
+	_test_crosscheck_learn(2000U);
+
+	// The AIRs are open
+	voltage_crosscheck_sample_t sample = _test_crosscheck_sample(0U, 0.5f, 0.2f);
+	sample.tsp = 0.f;
+	sample.ts_connected = false;
+	munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_OK);
+
+	// An AIR opened while the TS is on
+	sample.ts_connected = true;
+	munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_TS_MISMATCH);
+
+	// Under load the drop on the AIRs is expected
+	for (uint32_t i = 0; i < 100U; ++i) {
+		sample = _test_crosscheck_sample(i, 150.f, 0.2f);
+		voltage_crosscheck_update(&check, &sample);
+	}
+	munit_assert_uint8(voltage_crosscheck_update(&check, &sample), ==, VOLTAGE_CROSSCHECK_OK);
+	munit_assert_float(fabsf(check.ts_residual), <, 0.01f);
+
+	return MUNIT_OK;
+}
+
+MunitTest test_voltage_crosscheck_tests[] = {
+	{(char *)"/offset", test_voltage_crosscheck_offset, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/mismatch", test_voltage_crosscheck_mismatch, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/transient", test_voltage_crosscheck_transient, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/noise", test_voltage_crosscheck_noise, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+	{(char *)"/ts", test_voltage_crosscheck_ts, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL},
+
+	{NULL, NULL, NULL, NULL, MUNIT_TEST_OPTION_NONE, NULL}};
+
+MunitSuite test_voltage_crosscheck_suite = {"/voltage_crosscheck", test_voltage_crosscheck_tests, NULL, 1, MUNIT_SUITE_OPTION_NONE};
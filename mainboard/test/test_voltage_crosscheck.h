@@ -0,0 +1,6 @@
+#ifndef TEST_VOLTAGE_CROSSCHECK_H
+#define TEST_VOLTAGE_CROSSCHECK_H
+
+#include <munit.h>
+
+#endif
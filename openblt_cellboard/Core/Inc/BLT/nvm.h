@@ -33,6 +33,7 @@
 ****************************************************************************************/
 void     NvmInit(void);
 void     NvmReinit(void);
+void     NvmTask(void);
 blt_bool NvmWrite(blt_addr addr, blt_int32u len, blt_int8u *data);
 blt_bool NvmErase(blt_addr addr, blt_int32u len);
 blt_bool NvmVerifyChecksum(void);
@@ -84,6 +84,8 @@ void BootTask(void)
   /* process possibly pending communication data */
   ComTask();
 #endif
+  /* program the received data in the background */
+  NvmTask();
 #if (ADDON_GATEWAY_MOD_ENABLE > 0)
   /* run the gateway */
   GatewayTask();
@@ -43,6 +43,15 @@
 #define FLASH_WRITE_BLOCK_SIZE          (512)
 /** \brief Standard size of a flash sector for erasing. */
 #define FLASH_ERASE_SECTOR_SIZE         (2048)
+/** \brief Size of the unit programmed at once. */
+#define FLASH_PROGRAM_UNIT_SIZE         (sizeof(uint64_t))
+/** \brief Number of program units written by each call of FlashTask(). */
+#define FLASH_PROGRAM_UNITS_PER_TASK    (2)
+/** \brief Largest sector whose erase is delayed until the data programmed into it
+ *         differs from its content. The part of the sector which was already checked is
+ *         copied to RAM before erasing it, larger sectors are erased right away.
+ */
+#define FLASH_SECTOR_COPY_SIZE          (FLASH_ERASE_SECTOR_SIZE)
 /** \brief Total numbers of segments in array flashLayout[]. */
 #define FLASH_TOTAL_SEGMENTS            (sizeof(flashLayout)/sizeof(flashLayout[0]))
 /** \brief Index of the last segment in array flashLayout[]. */
@@ -99,6 +108,19 @@ typedef struct
   blt_int8u data[FLASH_WRITE_BLOCK_SIZE];
 } tFlashBlockInfo;
 
+/** \brief    Structure type for the sectors waiting to be erased.
+ *  \details  FlashErase() erases the sectors only when the data programmed into them
+ *            differs from their content, so the sectors which did not change are not
+ *            erased and programmed again. The sectors are checked in order from start to
+ *            end: the content of the first one is known to match up to verified.
+ */
+typedef struct
+{
+  blt_addr start;                                /**< first sector waiting for erase   */
+  blt_addr end;                                  /**< end of the last sector           */
+  blt_addr verified;                             /**< end of the checked content       */
+} tFlashEraseInfo;
+
 
 /****************************************************************************************
 * Hook functions
@@ -118,6 +140,15 @@ static blt_bool   FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
 static blt_bool   FlashWriteBlock(tFlashBlockInfo *block);
 static blt_int32u FlashGetPage(blt_addr address);
 static blt_int32u FlashGetBank(blt_addr address);
+static blt_bool   FlashWaitProgram(void);
+static blt_bool   FlashCheckErase(tFlashBlockInfo *block, blt_bool *skip);
+static blt_bool   FlashFinishSector(tFlashBlockInfo *block);
+static blt_bool   FlashFinishErase(void);
+static blt_bool   FlashIsErased(blt_addr start, blt_addr end);
+static blt_addr   FlashGetSectorStart(blt_addr address);
+static blt_addr   FlashGetSectorEnd(blt_addr address);
+static blt_bool   FlashEraseRange(blt_addr start, blt_addr end);
+static blt_bool   FlashProgram(blt_addr addr, blt_int8u *data, blt_int32u len);
 
 
 /****************************************************************************************
@@ -228,6 +259,25 @@ static tFlashBlockInfo blockInfo;
  */
 static tFlashBlockInfo bootBlockInfo;
 
+/** \brief   Local variable with the block being programmed in the background.
+ *  \details Once a block is complete it is copied here and programmed by FlashTask(),
+ *           a few words at a time, while the next block is received. Only one block is
+ *           programmed at a time: the next one waits for this one to be done.
+ */
+static tFlashBlockInfo programBlockInfo;
+
+/** \brief Offset of the next byte of programBlockInfo to be programmed. */
+static blt_int32u programOffset;
+
+/** \brief Set when the background programming failed, reported by the next operation. */
+static blt_bool programError;
+
+/** \brief Local variable with the sectors waiting to be erased. */
+static tFlashEraseInfo eraseInfo;
+
+/** \brief Copy of the checked part of a sector while it is erased. */
+static blt_int8u sectorCopy[FLASH_SECTOR_COPY_SIZE];
+
 
 /************************************************************************************//**
 ** \brief     Initializes the flash driver.
@@ -239,6 +289,12 @@ void FlashInit(void)
   /* init the flash block info structs by setting the address to an invalid address */
   blockInfo.base_addr = FLASH_INVALID_ADDRESS;
   bootBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programError = BLT_FALSE;
+  /* no sectors waiting to be erased */
+  eraseInfo.start = FLASH_INVALID_ADDRESS;
+  eraseInfo.end = FLASH_INVALID_ADDRESS;
+  eraseInfo.verified = FLASH_INVALID_ADDRESS;
 } /*** end of FlashInit ***/
 
 
@@ -252,6 +308,12 @@ void FlashReinit(void)
   /* init the flash block info structs by setting the address to an invalid address */
   blockInfo.base_addr = FLASH_INVALID_ADDRESS;
   bootBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programError = BLT_FALSE;
+  /* no sectors waiting to be erased */
+  eraseInfo.start = FLASH_INVALID_ADDRESS;
+  eraseInfo.end = FLASH_INVALID_ADDRESS;
+  eraseInfo.verified = FLASH_INVALID_ADDRESS;
 } /*** end of FlashReinit ***/
 
 
@@ -305,76 +367,56 @@ blt_bool FlashWrite(blt_addr addr, blt_int32u len, blt_int8u *data)
 ****************************************************************************************/
 blt_bool FlashErase(blt_addr addr, blt_int32u len)
 {
-  blt_addr erase_base_addr;
-  blt_addr erase_current_addr;
-  blt_int32u total_erase_len;
-  blt_int16u nr_of_erase_sectors;
-  blt_bool result = BLT_TRUE;
-  blt_int16u sector_cnt;
-  blt_int32u dummy;
-  FLASH_EraseInitTypeDef eraseInitStruct;
-  
+  blt_addr start;
+  blt_addr end;
+  blt_addr lazy_end;
+
   /* validate the len parameter */
   if ((len - 1) > (FLASH_END_ADDRESS - addr))
   {
     return BLT_FALSE;
   }
-  
-  /* determine the base address for the erase operation, by aligning to
-   * FLASH_ERASE_SECTOR_SIZE.
-   */
-  erase_base_addr = (addr/FLASH_ERASE_SECTOR_SIZE)*FLASH_ERASE_SECTOR_SIZE;
 
   /* make sure the addresses are within the flash device */
-  if ((erase_base_addr < FLASH_START_ADDRESS) || ((addr+len-1) > FLASH_END_ADDRESS))
+  if ((FlashGetSectorStart(addr) < FLASH_START_ADDRESS) || ((addr+len-1) > FLASH_END_ADDRESS))
   {
     return BLT_FALSE;
   }
 
-  /* determine number of bytes to erase from base address */
-  total_erase_len = len + (addr - erase_base_addr);
-
-  /* determine the number of sectors to erase */
-  nr_of_erase_sectors = (blt_int16u)(total_erase_len / FLASH_ERASE_SECTOR_SIZE);
-  if ((total_erase_len % FLASH_ERASE_SECTOR_SIZE) > 0)
+  /* a new region completes the previous one */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
   {
-    nr_of_erase_sectors++;
+    return BLT_FALSE;
   }
-  
-  /* unlock access to the flash device */
-  HAL_FLASH_Unlock();
 
-  /* clear OPTVERR bit set on virgin samples */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_OPTVERR); 
-  
-  /* prepare erase init structure */
-  eraseInitStruct.TypeErase = FLASH_TYPEERASE_PAGES;
-  eraseInitStruct.NbPages = 1;
-
-  /* erase all sectors one by one */
-  for (sector_cnt=0; sector_cnt<nr_of_erase_sectors; sector_cnt++)
+  start = FlashGetSectorStart(addr);
+  end = FlashGetSectorEnd(addr+len-1);
+  /* the first sector is always erased, so that the user program is not valid until its
+   * checksum is written at the end of the programming session
+   */
+  if (start == flashLayout[0].sector_start)
   {
-    /* keep the watchdog happy */
-    CopService();
-    /* set the sector base address */
-    erase_current_addr = erase_base_addr + (sector_cnt * FLASH_ERASE_SECTOR_SIZE);
-    /* update erase init structure */
-    eraseInitStruct.Page = FlashGetPage(erase_current_addr);
-    eraseInitStruct.Banks = FlashGetBank(erase_current_addr);
-    /* perform sector erase operation */
-    if (HAL_FLASHEx_Erase(&eraseInitStruct, (uint32_t *)&dummy) != HAL_OK)
+    if (FlashEraseRange(start, FlashGetSectorEnd(start)) == BLT_FALSE)
     {
-      /* error detected. flag it and stop */
-      result = BLT_FALSE;
-      break;
+      return BLT_FALSE;
     }
+    start = FlashGetSectorEnd(start);
   }
-  
-  /* lock access to the flash device */
-  HAL_FLASH_Lock();
-  
-  /* return the result */
-  return result;
+  /* the next sectors are erased only when needed, as long as they fit sectorCopy */
+  lazy_end = start;
+  while ((lazy_end < end) &&
+         ((FlashGetSectorEnd(lazy_end) - lazy_end) <= FLASH_SECTOR_COPY_SIZE))
+  {
+    lazy_end = FlashGetSectorEnd(lazy_end);
+  }
+  if ((lazy_end < end) && (FlashEraseRange(lazy_end, end) == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+  eraseInfo.start = start;
+  eraseInfo.end = lazy_end;
+  eraseInfo.verified = start;
+  return BLT_TRUE;
 } /*** end of FlashErase ***/
 
 
@@ -487,7 +529,24 @@ blt_bool FlashVerifyChecksum(void)
 ****************************************************************************************/
 blt_bool FlashDone(void)
 {
-  /* check if there is still data waiting to be programmed in the boot block */
+  /* check if there is still data waiting to be programmed */
+  if (blockInfo.base_addr != FLASH_INVALID_ADDRESS)
+  {
+    if (FlashWriteBlock(&blockInfo) == BLT_FALSE)
+    {
+      return BLT_FALSE;
+    }
+  }
+
+  /* complete the background programming and the sectors waiting to be erased */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+
+  /* check if there is still data waiting to be programmed in the boot block, this is
+   * done last because it makes the user program valid
+   */
   if (bootBlockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
     if (FlashWriteBlock(&bootBlockInfo) == BLT_FALSE)
@@ -495,7 +554,21 @@ blt_bool FlashDone(void)
       return BLT_FALSE;
     }
   }
+  /* still here so all is okay */
+  return BLT_TRUE;
+} /*** end of FlashDone ***/
+
 
+/************************************************************************************//**
+** \brief     Programs the data waiting in the currently active block, the boot block is
+**            kept until FlashDone() so that the user program stays invalid until the
+**            checksum is written. Used by the delta programming to verify a region right
+**            after it was programmed.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+blt_bool FlashFlush(void)
+{
   /* check if there is still data waiting to be programmed */
   if (blockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
@@ -503,10 +576,55 @@ blt_bool FlashDone(void)
     {
       return BLT_FALSE;
     }
+    blockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  }
+  /* complete the background programming and the sectors waiting to be erased */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
+  {
+    return BLT_FALSE;
   }
   /* still here so all is okay */
   return BLT_TRUE;
-} /*** end of FlashDone ***/
+} /*** end of FlashFlush ***/
+
+
+/************************************************************************************//**
+** \brief     Programs part of the block waiting in programBlockInfo. Called continuously
+**            by NvmTask(), so that the next block is received while the previous one is
+**            being programmed.
+** \return    none.
+**
+****************************************************************************************/
+void FlashTask(void)
+{
+  blt_int32u len;
+
+  /* check if there is a block waiting to be programmed */
+  if (programBlockInfo.base_addr == FLASH_INVALID_ADDRESS)
+  {
+    return;
+  }
+
+  len = FLASH_PROGRAM_UNITS_PER_TASK * FLASH_PROGRAM_UNIT_SIZE;
+  if (len > (FLASH_WRITE_BLOCK_SIZE - programOffset))
+  {
+    len = FLASH_WRITE_BLOCK_SIZE - programOffset;
+  }
+  if (FlashProgram(programBlockInfo.base_addr + programOffset,
+                   &programBlockInfo.data[programOffset], len) == BLT_FALSE)
+  {
+    /* the error is reported by the next flash operation */
+    programError = BLT_TRUE;
+    programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+    return;
+  }
+  programOffset += len;
+  if (programOffset >= FLASH_WRITE_BLOCK_SIZE)
+  {
+    /* block done */
+    programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  }
+} /*** end of FlashTask ***/
 
 
 /************************************************************************************//**
@@ -542,9 +660,18 @@ static blt_bool FlashInitBlock(tFlashBlockInfo *block, blt_addr address)
     /* block already initialized, so nothing to do */
     return BLT_TRUE;
   }
-  /* set the base address and copies the current data from flash */
+  /* set the base address and copies the current data from flash. a sector waiting to
+   * be erased is already considered erased.
+   */
   block->base_addr = address;
-  CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+  if ((address >= eraseInfo.start) && (address < eraseInfo.end))
+  {
+    CpuMemSet((blt_addr)block->data, 0xff, FLASH_WRITE_BLOCK_SIZE);
+  }
+  else
+  {
+    CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+  }
   return BLT_TRUE;
 } /*** end of FlashInitBlock ***/
 
@@ -683,11 +810,8 @@ static blt_bool FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
 ****************************************************************************************/
 static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
 {
-  blt_addr   prog_addr;
-  uint64_t   prog_data;
-  blt_int32u doubleword_cnt;
-  blt_bool   result = BLT_TRUE;
-  
+  blt_bool skip;
+
 #if (BOOT_FLASH_CRYPTO_HOOKS_ENABLE > 0)
   #if (BOOT_NVM_CHECKSUM_HOOKS_ENABLE == 0)
   /* note that the bootblock is already decrypted in FlashWriteChecksum(), if the
@@ -704,41 +828,218 @@ static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
   }
 #endif
 
+  /* wait for the previous block, only one block is programmed at a time */
+  if (FlashWaitProgram() == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
 
-  /* unlock access to the flash device */
-  HAL_FLASH_Unlock();
+  /* the boot block is the last one and it is programmed right away */
+  if (block == &bootBlockInfo)
+  {
+    return FlashProgram(block->base_addr, block->data, FLASH_WRITE_BLOCK_SIZE);
+  }
 
-  /* clear OPTVERR bit set on virgin samples */
-  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_OPTVERR); 
-  
-  /* program all double words in the block one by one */
-  for (doubleword_cnt=0; doubleword_cnt<(FLASH_WRITE_BLOCK_SIZE/sizeof(uint64_t)); doubleword_cnt++)
+  /* the block might already be in flash, or its sector might need to be erased */
+  if (FlashCheckErase(block, &skip) == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+  if (skip == BLT_TRUE)
+  {
+    return BLT_TRUE;
+  }
+
+  /* program the block in the background while the next one is received */
+  programBlockInfo.base_addr = block->base_addr;
+  CpuMemCopy((blt_addr)programBlockInfo.data, (blt_addr)block->data, FLASH_WRITE_BLOCK_SIZE);
+  programOffset = 0;
+  return BLT_TRUE;
+} /*** end of FlashWriteBlock ***/
+
+
+/************************************************************************************//**
+** \brief     Completes the programming of the block in programBlockInfo.
+** \return    BLT_TRUE if successful, BLT_FALSE if the block or a previous one could not
+**            be programmed.
+**
+****************************************************************************************/
+static blt_bool FlashWaitProgram(void)
+{
+  blt_bool result = BLT_TRUE;
+
+  while (programBlockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
-    prog_addr = block->base_addr + (doubleword_cnt * sizeof(uint64_t));
-    prog_data = *(volatile uint64_t *)(&block->data[doubleword_cnt * sizeof(uint64_t)]);
     /* keep the watchdog happy */
     CopService();
-    /* program the double word */
-    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, prog_addr, prog_data) != HAL_OK)
+    FlashTask();
+  }
+  /* report and clear the error of the background programming */
+  if (programError == BLT_TRUE)
+  {
+    programError = BLT_FALSE;
+    result = BLT_FALSE;
+  }
+  return result;
+} /*** end of FlashWaitProgram ***/
+
+
+/************************************************************************************//**
+** \brief     Checks a block against the content of its sector when the sector is still
+**            waiting to be erased. The block is skipped if the sector already holds it,
+**            otherwise the sector is erased and programmed together with the block.
+** \param     block Pointer to flash block info structure to operate on.
+** \param     skip  Set to BLT_TRUE when the block does not need to be programmed anymore.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashCheckErase(tFlashBlockInfo *block, blt_bool *skip)
+{
+  blt_addr addr = block->base_addr;
+  blt_int32u idx;
+
+  *skip = BLT_FALSE;
+  /* nothing to do if the sector is not waiting to be erased */
+  if ((addr < eraseInfo.start) || (addr >= eraseInfo.end))
+  {
+    return BLT_TRUE;
+  }
+
+  /* the sectors before the block are complete */
+  while (addr >= FlashGetSectorEnd(eraseInfo.start))
+  {
+    if (FlashFinishSector(BLT_NULL) == BLT_FALSE)
     {
-      /* error detected. flag it and stop */
-      result = BLT_FALSE;
-      break;
+      return BLT_FALSE;
     }
-    /* verify that the written data is actually there */
-    if (*(volatile uint64_t *)prog_addr != prog_data)
+  }
+
+  /* the block is already in flash if it matches and everything between the checked
+   * content and the block is erased
+   */
+  *skip = BLT_TRUE;
+  if ((addr >= eraseInfo.verified) && (FlashIsErased(eraseInfo.verified, addr) == BLT_TRUE))
+  {
+    for (idx = 0; idx < FLASH_WRITE_BLOCK_SIZE; idx++)
     {
-      result = BLT_FALSE;
-      break;
+      if (block->data[idx] != *(volatile blt_int8u *)(addr + idx))
+      {
+        break;
+      }
+    }
+    if (idx == FLASH_WRITE_BLOCK_SIZE)
+    {
+      eraseInfo.verified = addr + FLASH_WRITE_BLOCK_SIZE;
+      return BLT_TRUE;
     }
   }
+  /* the sector differs, erase it and program it with the block */
+  return FlashFinishSector(block);
+} /*** end of FlashCheckErase ***/
 
-  /* lock access to the flash device */
-  HAL_FLASH_Lock();
-  
-  /* return the result */
-  return result;
-} /*** end of FlashWriteBlock ***/
+
+/************************************************************************************//**
+** \brief     Completes the first sector waiting to be erased. The sector is erased only
+**            if its content differs from the one it would have after the erase and the
+**            programming of the checked content and of the block.
+** \param     block Pointer to the block to program in the sector, or BLT_NULL.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashFinishSector(tFlashBlockInfo *block)
+{
+  blt_addr   start = eraseInfo.start;
+  blt_addr   end = FlashGetSectorEnd(start);
+  blt_int32u len = eraseInfo.verified - start;
+  blt_int32u idx;
+
+  /* move to the next sector */
+  eraseInfo.start = end;
+  eraseInfo.verified = end;
+
+  /* the rest of the sector has to be erased to keep it */
+  if ((block == BLT_NULL) && (FlashIsErased(start + len, end) == BLT_TRUE))
+  {
+    return BLT_TRUE;
+  }
+
+  /* copy the checked content and add the block */
+  for (idx = 0; idx < len; idx++)
+  {
+    sectorCopy[idx] = *(volatile blt_int8u *)(start + idx);
+  }
+  if (block != BLT_NULL)
+  {
+    for (; idx < (block->base_addr - start); idx++)
+    {
+      sectorCopy[idx] = 0xff;
+    }
+    for (idx = 0; idx < FLASH_WRITE_BLOCK_SIZE; idx++)
+    {
+      sectorCopy[block->base_addr - start + idx] = block->data[idx];
+    }
+    if (len < (block->base_addr - start + FLASH_WRITE_BLOCK_SIZE))
+    {
+      len = block->base_addr - start + FLASH_WRITE_BLOCK_SIZE;
+    }
+  }
+
+  /* erase the sector and program it again */
+  if (FlashEraseRange(start, end) == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+  if (len == 0)
+  {
+    return BLT_TRUE;
+  }
+  return FlashProgram(start, sectorCopy, len);
+} /*** end of FlashFinishSector ***/
+
+
+/************************************************************************************//**
+** \brief     Completes all the sectors waiting to be erased.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashFinishErase(void)
+{
+  while (eraseInfo.start < eraseInfo.end)
+  {
+    if (FlashFinishSector(BLT_NULL) == BLT_FALSE)
+    {
+      eraseInfo.start = FLASH_INVALID_ADDRESS;
+      eraseInfo.end = FLASH_INVALID_ADDRESS;
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of FlashFinishErase ***/
+
+
+/************************************************************************************//**
+** \brief     Checks if a flash region is erased.
+** \param     start First address of the region.
+** \param     end   End address of the region, not included.
+** \return    BLT_TRUE if every byte is erased, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashIsErased(blt_addr start, blt_addr end)
+{
+  for (; start < end; start++)
+  {
+    /* keep the watchdog happy */
+    if ((start % FLASH_WRITE_BLOCK_SIZE) == 0)
+    {
+      CopService();
+    }
+    if (*(volatile blt_int8u *)start != 0xff)
+    {
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of FlashIsErased ***/
 
 
 /************************************************************************************//**
@@ -818,4 +1119,129 @@ static blt_int32u FlashGetBank(blt_addr address)
 } /*** end of FlashGetBank ***/
 
 
+/************************************************************************************//**
+** \brief     Determines the start address of the flash sector the address is in.
+** \param     address Address in the flash sector.
+** \return    Start address of the sector.
+**
+****************************************************************************************/
+static blt_addr FlashGetSectorStart(blt_addr address)
+{
+  return (address/FLASH_ERASE_SECTOR_SIZE)*FLASH_ERASE_SECTOR_SIZE;
+} /*** end of FlashGetSectorStart ***/
+
+
+/************************************************************************************//**
+** \brief     Determines the end address of the flash sector the address is in.
+** \param     address Address in the flash sector.
+** \return    First address after the sector.
+**
+****************************************************************************************/
+static blt_addr FlashGetSectorEnd(blt_addr address)
+{
+  return FlashGetSectorStart(address) + FLASH_ERASE_SECTOR_SIZE;
+} /*** end of FlashGetSectorEnd ***/
+
+
+/************************************************************************************//**
+** \brief     Erases the flash sectors of a region.
+** \param     start First address of the region, at the start of a sector.
+** \param     end   End address of the region, not included.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashEraseRange(blt_addr start, blt_addr end)
+{
+  blt_addr erase_current_addr;
+  blt_bool result = BLT_TRUE;
+  blt_int32u dummy;
+  FLASH_EraseInitTypeDef eraseInitStruct;
+
+  /* unlock access to the flash device */
+  HAL_FLASH_Unlock();
+
+  /* clear OPTVERR bit set on virgin samples */
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_OPTVERR); 
+  
+  /* prepare erase init structure */
+  eraseInitStruct.TypeErase = FLASH_TYPEERASE_PAGES;
+  eraseInitStruct.NbPages = 1;
+
+  /* erase all sectors one by one */
+  for (erase_current_addr = start; erase_current_addr < end;
+       erase_current_addr += FLASH_ERASE_SECTOR_SIZE)
+  {
+    /* keep the watchdog happy */
+    CopService();
+    /* update erase init structure */
+    eraseInitStruct.Page = FlashGetPage(erase_current_addr);
+    eraseInitStruct.Banks = FlashGetBank(erase_current_addr);
+    /* perform sector erase operation */
+    if (HAL_FLASHEx_Erase(&eraseInitStruct, (uint32_t *)&dummy) != HAL_OK)
+    {
+      /* error detected. flag it and stop */
+      result = BLT_FALSE;
+      break;
+    }
+  }
+  
+  /* lock access to the flash device */
+  HAL_FLASH_Lock();
+  
+  /* return the result */
+  return result;
+} /*** end of FlashEraseRange ***/
+
+
+/************************************************************************************//**
+** \brief     Programs data to flash one double word at a time.
+** \param     addr Start address, aligned to a double word.
+** \param     data Pointer to the data.
+** \param     len  Number of bytes, a multiple of a double word.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashProgram(blt_addr addr, blt_int8u *data, blt_int32u len)
+{
+  blt_addr   prog_addr;
+  uint64_t   prog_data;
+  blt_int32u doubleword_cnt;
+  blt_bool   result = BLT_TRUE;
+
+  /* unlock access to the flash device */
+  HAL_FLASH_Unlock();
+
+  /* clear OPTVERR bit set on virgin samples */
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_OPTVERR); 
+  
+  /* program all double words one by one */
+  for (doubleword_cnt=0; doubleword_cnt<(len/sizeof(uint64_t)); doubleword_cnt++)
+  {
+    prog_addr = addr + (doubleword_cnt * sizeof(uint64_t));
+    prog_data = *(volatile uint64_t *)(&data[doubleword_cnt * sizeof(uint64_t)]);
+    /* keep the watchdog happy */
+    CopService();
+    /* program the double word */
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, prog_addr, prog_data) != HAL_OK)
+    {
+      /* error detected. flag it and stop */
+      result = BLT_FALSE;
+      break;
+    }
+    /* verify that the written data is actually there */
+    if (*(volatile uint64_t *)prog_addr != prog_data)
+    {
+      result = BLT_FALSE;
+      break;
+    }
+  }
+
+  /* lock access to the flash device */
+  HAL_FLASH_Lock();
+  
+  /* return the result */
+  return result;
+} /*** end of FlashProgram ***/
+
+
 /*********************************** end of flash.c ************************************/
@@ -90,6 +90,19 @@ void NvmReinit(void)
 } /*** end of NvmReinit ***/
 
 
+/************************************************************************************//**
+** \brief     Task function of the non-volatile memory driver, programs the data
+**            received so far while the next data is received.
+** \return    none
+**
+****************************************************************************************/
+void NvmTask(void)
+{
+  /* run the task of the internal driver */
+  FlashTask();
+} /*** end of NvmTask ***/
+
+
 /************************************************************************************//**
 ** \brief     Programs the non-volatile memory.
 ** \param     addr Start address.
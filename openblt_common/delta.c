@@ -0,0 +1,440 @@
+/************************************************************************************//**
+* \file         Source/delta.c
+* \brief        Delta programming of the user program source file.
+* \ingroup      Core
+* \internal
+*----------------------------------------------------------------------------------------
+* Extension of the XCP programming commands which lets the host rewrite only the
+* sectors that changed, sending their content compressed. Added for the Fenice BMS, it
+* is not part of the OpenBLT sources.
+*
+* The host reads the CRC32 of the user program and of each of its sectors, then for
+* every sector that differs from the new image:
+*   1. DELTA_CMD_BEGIN erases the sector
+*   2. DELTA_CMD_DATA sends the compressed content, which is decompressed and
+*      programmed in place
+*   3. DELTA_CMD_END verifies the CRC32 of the content before moving to the next sector
+* The first sector of the user program is always rewritten so that the user program is
+* invalid until the end: its first block, with the checksum of the vector table, is
+* only programmed when the host commits the update with the standard XCP PROGRAM command
+* with no data, exactly like a full programming.
+*
+* The compressed stream is a sequence of tokens:
+*   - 0b0nnnnnnn: n + 1 literal bytes follow
+*   - 0b1lllllDD 0bDDDDDDDD: copy l + 3 bytes from D + 1 bytes before, the copy can
+*     overlap the bytes it writes so runs of the same value are compressed too
+*   - 0b111111DD 0bDDDDDDDD 0bEEEEEEEE: like the previous one but copies E + 34 bytes,
+*     for the long runs of padding in the images
+* Starting a region at the beginning of the user program and as long as the whole image
+* turns the delta programming into a compressed full programming.
+* \endinternal
+****************************************************************************************/
+
+/****************************************************************************************
+* Include files
+****************************************************************************************/
+#include "boot.h"                                /* bootloader generic header          */
+#include "xcp.h"                                 /* xcp communication layer            */
+#include "flash.h"                               /* flash driver                       */
+#include "delta.h"                               /* delta programming                  */
+
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief Number of decompressed bytes collected before programming them. */
+#define DELTA_OUT_SIZE               (32)
+/** \brief Length of the data in a DELTA_CMD_DATA packet. */
+#define DELTA_DATA_OFFSET            (2)
+
+/** \brief States of the decompression. */
+#define DELTA_STATE_IDLE             (0)
+#define DELTA_STATE_TOKEN            (1)
+#define DELTA_STATE_LITERAL          (2)
+#define DELTA_STATE_MATCH            (3)
+#define DELTA_STATE_MATCH_EXTRA      (4)
+
+/** \brief Length field of a match token which is followed by the extra length. */
+#define DELTA_MATCH_EXTRA            (0x1F)
+/** \brief Shortest match, encoded as 0 in the length field. */
+#define DELTA_MATCH_MIN              (3)
+
+
+/****************************************************************************************
+* Type definitions
+****************************************************************************************/
+typedef struct
+{
+  blt_addr   start;                              /**< first address of the region      */
+  blt_int32u length;                             /**< length of the region             */
+  blt_int32u written;                            /**< decompressed bytes so far        */
+  blt_int32u crc;                                /**< crc32 of the decompressed bytes  */
+  blt_int8u  state;                              /**< state of the decompression       */
+  blt_int8u  token;                              /**< first byte of a match            */
+  blt_int16u distance;                           /**< distance of a long match         */
+  blt_int8u  literals;                           /**< literal bytes left in the token  */
+  blt_int16u window_pos;                         /**< next position in the window      */
+  blt_int8u  window[DELTA_WINDOW_SIZE];          /**< last decompressed bytes          */
+  blt_int8u  out[DELTA_OUT_SIZE];                /**< bytes waiting to be programmed   */
+  blt_int8u  out_len;                            /**< number of bytes in out           */
+  blt_int8u  boot_block[DELTA_BOOT_BLOCK_SIZE];  /**< copy of the first block          */
+} tDeltaInfo;
+
+
+/****************************************************************************************
+* Local data declarations
+****************************************************************************************/
+static tDeltaInfo deltaInfo;
+
+
+/************************************************************************************//**
+** \brief     Adds a byte to a CRC32 (IEEE 802.3, reflected).
+** \param     crc The current CRC, inverted.
+** \param     value The byte to add.
+** \return    The updated CRC, inverted.
+**
+****************************************************************************************/
+static blt_int32u DeltaCrcUpdate(blt_int32u crc, blt_int8u value)
+{
+  blt_int8u bit;
+
+  crc ^= value;
+  for (bit = 0; bit < 8; bit++)
+  {
+    crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  }
+  return crc;
+} /*** end of DeltaCrcUpdate ***/
+
+
+/************************************************************************************//**
+** \brief     Reads a byte of the user program. The first block is read from the copy
+**            of the decompressed data while it is still waiting to be programmed.
+** \param     addr The address of the byte.
+** \return    The value of the byte.
+**
+****************************************************************************************/
+static blt_int8u DeltaReadByte(blt_addr addr)
+{
+  blt_addr offset = addr - NvmGetUserProgBaseAddress();
+
+  if ((deltaInfo.state != DELTA_STATE_IDLE) && (offset < DELTA_BOOT_BLOCK_SIZE) &&
+      (deltaInfo.start == NvmGetUserProgBaseAddress()))
+  {
+    return deltaInfo.boot_block[offset];
+  }
+  return *((blt_int8u *)addr);
+} /*** end of DeltaReadByte ***/
+
+
+/************************************************************************************//**
+** \brief     Computes the CRC32 of a memory region.
+** \param     addr The first address.
+** \param     len The length of the region.
+** \return    The CRC32.
+**
+****************************************************************************************/
+static blt_int32u DeltaCrc(blt_addr addr, blt_int32u len)
+{
+  blt_int32u crc = 0xFFFFFFFFu;
+
+  while (len-- > 0)
+  {
+    /* reading a large region can take a while, keep the watchdog happy */
+    if ((len % 1024) == 0)
+    {
+      CopService();
+    }
+    crc = DeltaCrcUpdate(crc, DeltaReadByte(addr++));
+  }
+  return ~crc;
+} /*** end of DeltaCrc ***/
+
+
+/************************************************************************************//**
+** \brief     Programs the decompressed bytes collected so far.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool DeltaFlushOut(void)
+{
+  blt_bool result = BLT_TRUE;
+
+  if (deltaInfo.out_len > 0)
+  {
+    result = NvmWrite(deltaInfo.start + deltaInfo.written - deltaInfo.out_len,
+                      deltaInfo.out_len, deltaInfo.out);
+    deltaInfo.out_len = 0;
+  }
+  return result;
+} /*** end of DeltaFlushOut ***/
+
+
+/************************************************************************************//**
+** \brief     Adds a decompressed byte to the region.
+** \param     value The byte.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool DeltaOutput(blt_int8u value)
+{
+  blt_addr offset;
+
+  if (deltaInfo.written >= deltaInfo.length)
+  {
+    return BLT_FALSE;
+  }
+
+  offset = deltaInfo.start + deltaInfo.written - NvmGetUserProgBaseAddress();
+  if (offset < DELTA_BOOT_BLOCK_SIZE)
+  {
+    deltaInfo.boot_block[offset] = value;
+  }
+  deltaInfo.window[deltaInfo.window_pos] = value;
+  deltaInfo.window_pos = (deltaInfo.window_pos + 1) % DELTA_WINDOW_SIZE;
+  deltaInfo.crc = DeltaCrcUpdate(deltaInfo.crc, value);
+  deltaInfo.out[deltaInfo.out_len++] = value;
+  deltaInfo.written++;
+
+  if (deltaInfo.out_len == DELTA_OUT_SIZE)
+  {
+    return DeltaFlushOut();
+  }
+  return BLT_TRUE;
+} /*** end of DeltaOutput ***/
+
+
+/************************************************************************************//**
+** \brief     Copies bytes already decompressed to the region.
+** \param     count The number of bytes.
+** \param     distance How many bytes before the current one the copy starts.
+** \return    BLT_TRUE if successful, BLT_FALSE if the stream is not valid.
+**
+****************************************************************************************/
+static blt_bool DeltaCopy(blt_int16u count, blt_int16u distance)
+{
+  blt_int8u value;
+
+  if (distance > deltaInfo.written)
+  {
+    return BLT_FALSE;
+  }
+  while (count-- > 0)
+  {
+    value = deltaInfo.window[(deltaInfo.window_pos + DELTA_WINDOW_SIZE - distance) %
+                             DELTA_WINDOW_SIZE];
+    if (DeltaOutput(value) == BLT_FALSE)
+    {
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of DeltaCopy ***/
+
+
+/************************************************************************************//**
+** \brief     Decompresses a byte of the stream.
+** \param     value The byte.
+** \return    BLT_TRUE if successful, BLT_FALSE if the stream is not valid.
+**
+****************************************************************************************/
+static blt_bool DeltaDecode(blt_int8u value)
+{
+  blt_int16u count;
+  blt_int16u distance;
+
+  switch (deltaInfo.state)
+  {
+    case DELTA_STATE_TOKEN:
+      if ((value & 0x80) == 0)
+      {
+        deltaInfo.literals = value + 1;
+        deltaInfo.state = DELTA_STATE_LITERAL;
+      }
+      else
+      {
+        deltaInfo.token = value;
+        deltaInfo.state = DELTA_STATE_MATCH;
+      }
+      return BLT_TRUE;
+
+    case DELTA_STATE_LITERAL:
+      if (--deltaInfo.literals == 0)
+      {
+        deltaInfo.state = DELTA_STATE_TOKEN;
+      }
+      return DeltaOutput(value);
+
+    case DELTA_STATE_MATCH:
+      count = (deltaInfo.token >> 2) & 0x1F;
+      distance = (((blt_int16u)(deltaInfo.token & 0x03) << 8) | value) + 1;
+      if (count == DELTA_MATCH_EXTRA)
+      {
+        deltaInfo.distance = distance;
+        deltaInfo.state = DELTA_STATE_MATCH_EXTRA;
+        return BLT_TRUE;
+      }
+      deltaInfo.state = DELTA_STATE_TOKEN;
+      return DeltaCopy(count + DELTA_MATCH_MIN, distance);
+
+    case DELTA_STATE_MATCH_EXTRA:
+      deltaInfo.state = DELTA_STATE_TOKEN;
+      return DeltaCopy(DELTA_MATCH_EXTRA + DELTA_MATCH_MIN + value, deltaInfo.distance);
+
+    default:
+      return BLT_FALSE;
+  }
+} /*** end of DeltaDecode ***/
+
+
+/************************************************************************************//**
+** \brief     Reads a 24 bit little endian value.
+** \param     data Pointer to the first byte.
+** \return    The value.
+**
+****************************************************************************************/
+static blt_int32u DeltaGet24(blt_int8u const *data)
+{
+  return (blt_int32u)data[0] | ((blt_int32u)data[1] << 8) | ((blt_int32u)data[2] << 16);
+} /*** end of DeltaGet24 ***/
+
+
+/************************************************************************************//**
+** \brief     Sends the answer to a delta command.
+** \param     error XCP error code, 0 for a positive answer.
+** \param     crc Value sent in the last 4 bytes of a positive answer.
+** \param     len Length of the positive answer, 1 or 8.
+** \return    none
+**
+****************************************************************************************/
+static void DeltaAnswer(blt_int8u error, blt_int32u crc, blt_int8u len)
+{
+  blt_int8u answer[8] = { 0 };
+
+  if (error != 0)
+  {
+    answer[0] = XCP_PID_ERR;
+    answer[1] = error;
+    len = 2;
+  }
+  else
+  {
+    answer[0] = XCP_PID_RES;
+    answer[4] = (blt_int8u)crc;
+    answer[5] = (blt_int8u)(crc >> 8);
+    answer[6] = (blt_int8u)(crc >> 16);
+    answer[7] = (blt_int8u)(crc >> 24);
+  }
+  ComTransmitPacket(answer, len);
+} /*** end of DeltaAnswer ***/
+
+
+/************************************************************************************//**
+** \brief     Processes the delta commands before the XCP core.
+** \param     data Pointer to byte buffer with packet data.
+** \param     len Number of bytes in the packet.
+** \return    BLT_TRUE if the packet was a delta command, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+blt_bool XcpPacketReceivedHook(blt_int8u *data, blt_int8u len)
+{
+  blt_addr   addr;
+  blt_int32u length;
+  blt_int8u  i;
+
+  if ((data[0] != DELTA_XCP_CMD_USER) || (len < 2) || (XcpIsConnected() == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+
+  switch (data[1])
+  {
+    case DELTA_CMD_CRC:
+      if (len < 8)
+      {
+        DeltaAnswer(XCP_ERR_OUT_OF_RANGE, 0, 0);
+        break;
+      }
+      addr = NvmGetUserProgBaseAddress() + DeltaGet24(&data[2]);
+      DeltaAnswer(0, DeltaCrc(addr, DeltaGet24(&data[5])), 8);
+      break;
+
+    case DELTA_CMD_BEGIN:
+      if (len < 8)
+      {
+        DeltaAnswer(XCP_ERR_OUT_OF_RANGE, 0, 0);
+        break;
+      }
+      addr = NvmGetUserProgBaseAddress() + DeltaGet24(&data[2]);
+      length = DeltaGet24(&data[5]);
+      deltaInfo.state = DELTA_STATE_IDLE;
+      if ((length == 0) || (NvmErase(addr, length) == BLT_FALSE))
+      {
+        DeltaAnswer(XCP_ERR_GENERIC, 0, 0);
+        break;
+      }
+      deltaInfo.start = addr;
+      deltaInfo.length = length;
+      deltaInfo.written = 0;
+      deltaInfo.crc = 0xFFFFFFFFu;
+      deltaInfo.window_pos = 0;
+      deltaInfo.out_len = 0;
+      deltaInfo.state = DELTA_STATE_TOKEN;
+      DeltaAnswer(0, 0, 1);
+      break;
+
+    case DELTA_CMD_DATA:
+      if (deltaInfo.state == DELTA_STATE_IDLE)
+      {
+        DeltaAnswer(XCP_ERR_SEQUENCE, 0, 0);
+        break;
+      }
+      for (i = DELTA_DATA_OFFSET; i < len; i++)
+      {
+        if (DeltaDecode(data[i]) == BLT_FALSE)
+        {
+          deltaInfo.state = DELTA_STATE_IDLE;
+          break;
+        }
+      }
+      if (deltaInfo.state == DELTA_STATE_IDLE)
+      {
+        DeltaAnswer(XCP_ERR_GENERIC, 0, 0);
+        break;
+      }
+      DeltaAnswer(0, 0, 1);
+      break;
+
+    case DELTA_CMD_END:
+      if ((deltaInfo.state != DELTA_STATE_TOKEN) || (len < 8))
+      {
+        deltaInfo.state = DELTA_STATE_IDLE;
+        DeltaAnswer(XCP_ERR_SEQUENCE, 0, 0);
+        break;
+      }
+      /* program everything but the first block, then check both what was received and
+       * what was programmed
+       */
+      length = (blt_int32u)data[4] | ((blt_int32u)data[5] << 8) |
+               ((blt_int32u)data[6] << 16) | ((blt_int32u)data[7] << 24);
+      if ((DeltaFlushOut() == BLT_FALSE) || (FlashFlush() == BLT_FALSE) ||
+          (deltaInfo.written != deltaInfo.length) || (~deltaInfo.crc != length) ||
+          (DeltaCrc(deltaInfo.start, deltaInfo.length) != length))
+      {
+        deltaInfo.state = DELTA_STATE_IDLE;
+        DeltaAnswer(XCP_ERR_GENERIC, 0, 0);
+        break;
+      }
+      deltaInfo.state = DELTA_STATE_IDLE;
+      DeltaAnswer(0, 0, 1);
+      break;
+
+    default:
+      DeltaAnswer(XCP_ERR_CMD_UNKNOWN, 0, 0);
+      break;
+  }
+  return BLT_TRUE;
+} /*** end of XcpPacketReceivedHook ***/
+
+
+/*********************************** end of delta.c ************************************/
@@ -0,0 +1,53 @@
+/************************************************************************************//**
+* \file         Source/delta.h
+* \brief        Delta programming of the user program header file.
+* \ingroup      Core
+* \internal
+*----------------------------------------------------------------------------------------
+* Extension of the XCP programming commands which lets the host rewrite only the
+* sectors that changed, sending their content compressed. Added for the Fenice BMS, it
+* is not part of the OpenBLT sources.
+* \endinternal
+****************************************************************************************/
+#ifndef DELTA_H
+#define DELTA_H
+
+/****************************************************************************************
+* Macro definitions
+****************************************************************************************/
+/** \brief XCP user command which carries the delta programming sub-commands. */
+#define DELTA_XCP_CMD_USER           (0xf1)
+
+/** \brief Computes the CRC32 of a memory region: offset (24 bit) and length (24 bit).
+ *         The answer holds the CRC in the last 4 bytes.
+ */
+#define DELTA_CMD_CRC                (0x01)
+/** \brief Erases a region and starts its programming: offset (24 bit) and length
+ *         (24 bit). The region has to start at the beginning of a flash sector.
+ */
+#define DELTA_CMD_BEGIN              (0x02)
+/** \brief Up to 6 bytes of the compressed content of the region. */
+#define DELTA_CMD_DATA               (0x03)
+/** \brief Ends the programming of a region: CRC32 (32 bit) of its content, which is
+ *         verified against both the decompressed data and the data read back from flash.
+ */
+#define DELTA_CMD_END                (0x04)
+
+/** \brief Size of the window of the compressed stream, matches can only refer to the
+ *         last DELTA_WINDOW_SIZE bytes.
+ */
+#define DELTA_WINDOW_SIZE            (1024)
+/** \brief Size of the first block of the user program, which is kept in RAM by the flash
+ *         driver until the end of the programming. Has to match FLASH_WRITE_BLOCK_SIZE.
+ */
+#define DELTA_BOOT_BLOCK_SIZE        (512)
+
+
+/****************************************************************************************
+* Function prototypes
+****************************************************************************************/
+blt_bool XcpPacketReceivedHook(blt_int8u *data, blt_int8u len);
+
+
+#endif /* DELTA_H */
+/*********************************** end of delta.h ************************************/
@@ -251,5 +251,13 @@
 #define BOOT_XCP_SEED_KEY_ENABLE        (0)
 
 
+/* The delta programming in openblt_common/delta.c, shared by both bootloaders, extends
+ * the XCP commands through the packet received hook, which is called before the XCP core
+ * processes a packet. It lets the host rewrite only the sectors that changed, see
+ * docs/bootloader/openblt.md.
+ */
+#define BOOT_XCP_PACKET_RECEIVED_HOOK   (1)
+
+
 #endif /* BLT_CONF_H */
 /*********************************** end of blt_conf.h *********************************/
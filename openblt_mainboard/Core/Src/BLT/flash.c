@@ -42,6 +42,15 @@
 #define FLASH_INVALID_ADDRESS           (0xffffffff)
 /** \brief Standard size of a flash block for writing. */
 #define FLASH_WRITE_BLOCK_SIZE          (512)
+/** \brief Size of the unit programmed at once. */
+#define FLASH_PROGRAM_UNIT_SIZE         (sizeof(blt_int32u))
+/** \brief Number of program units written by each call of FlashTask(). */
+#define FLASH_PROGRAM_UNITS_PER_TASK    (8)
+/** \brief Largest sector whose erase is delayed until the data programmed into it
+ *         differs from its content. The part of the sector which was already checked is
+ *         copied to RAM before erasing it, larger sectors are erased right away.
+ */
+#define FLASH_SECTOR_COPY_SIZE          (0x10000)
 /** \brief Total numbers of sectors in array flashLayout[]. */
 #define FLASH_TOTAL_SECTORS             (sizeof(flashLayout)/sizeof(flashLayout[0]))
 /** \brief End address of the bootloader programmable flash. */
@@ -95,6 +104,19 @@ typedef struct
   blt_int8u data[FLASH_WRITE_BLOCK_SIZE];
 } tFlashBlockInfo;
 
+/** \brief    Structure type for the sectors waiting to be erased.
+ *  \details  FlashErase() erases the sectors only when the data programmed into them
+ *            differs from their content, so the sectors which did not change are not
+ *            erased and programmed again. The sectors are checked in order from start to
+ *            end: the content of the first one is known to match up to verified.
+ */
+typedef struct
+{
+  blt_addr start;                                /**< first sector waiting for erase   */
+  blt_addr end;                                  /**< end of the last sector           */
+  blt_addr verified;                             /**< end of the checked content       */
+} tFlashEraseInfo;
+
 
 /****************************************************************************************
 * Hook functions
@@ -114,6 +136,15 @@ static blt_bool  FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
 static blt_bool  FlashWriteBlock(tFlashBlockInfo *block);
 static blt_bool  FlashEraseSectors(blt_int8u first_sector, blt_int8u last_sector);
 static blt_int8u FlashGetSector(blt_addr address);
+static blt_bool  FlashWaitProgram(void);
+static blt_bool  FlashCheckErase(tFlashBlockInfo *block, blt_bool *skip);
+static blt_bool  FlashFinishSector(tFlashBlockInfo *block);
+static blt_bool  FlashFinishErase(void);
+static blt_bool  FlashIsErased(blt_addr start, blt_addr end);
+static blt_addr  FlashGetSectorStart(blt_addr address);
+static blt_addr  FlashGetSectorEnd(blt_addr address);
+static blt_bool  FlashEraseRange(blt_addr start, blt_addr end);
+static blt_bool  FlashProgram(blt_addr addr, blt_int8u *data, blt_int32u len);
 
 
 /****************************************************************************************
@@ -216,6 +247,25 @@ static tFlashBlockInfo blockInfo;
  */
 static tFlashBlockInfo bootBlockInfo;
 
+/** \brief   Local variable with the block being programmed in the background.
+ *  \details Once a block is complete it is copied here and programmed by FlashTask(),
+ *           a few words at a time, while the next block is received. Only one block is
+ *           programmed at a time: the next one waits for this one to be done.
+ */
+static tFlashBlockInfo programBlockInfo;
+
+/** \brief Offset of the next byte of programBlockInfo to be programmed. */
+static blt_int32u programOffset;
+
+/** \brief Set when the background programming failed, reported by the next operation. */
+static blt_bool programError;
+
+/** \brief Local variable with the sectors waiting to be erased. */
+static tFlashEraseInfo eraseInfo;
+
+/** \brief Copy of the checked part of a sector while it is erased. */
+static blt_int8u sectorCopy[FLASH_SECTOR_COPY_SIZE];
+
 
 /************************************************************************************//**
 ** \brief     Initializes the flash driver.
@@ -227,6 +277,12 @@ void FlashInit(void)
   /* init the flash block info structs by setting the address to an invalid address */
   blockInfo.base_addr = FLASH_INVALID_ADDRESS;
   bootBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programError = BLT_FALSE;
+  /* no sectors waiting to be erased */
+  eraseInfo.start = FLASH_INVALID_ADDRESS;
+  eraseInfo.end = FLASH_INVALID_ADDRESS;
+  eraseInfo.verified = FLASH_INVALID_ADDRESS;
 } /*** end of FlashInit ***/
 
 
@@ -240,6 +296,12 @@ void FlashReinit(void)
   /* init the flash block info structs by setting the address to an invalid address */
   blockInfo.base_addr = FLASH_INVALID_ADDRESS;
   bootBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  programError = BLT_FALSE;
+  /* no sectors waiting to be erased */
+  eraseInfo.start = FLASH_INVALID_ADDRESS;
+  eraseInfo.end = FLASH_INVALID_ADDRESS;
+  eraseInfo.verified = FLASH_INVALID_ADDRESS;
 } /*** end of FlashReinit ***/
 
 
@@ -295,6 +357,9 @@ blt_bool FlashErase(blt_addr addr, blt_int32u len)
 {
   blt_int8u first_sector;
   blt_int8u last_sector;
+  blt_addr  start;
+  blt_addr  end;
+  blt_addr  lazy_end;
 
   /* validate the len parameter */
   if ((len - 1) > (FLASH_END_ADDRESS - addr))
@@ -310,8 +375,40 @@ blt_bool FlashErase(blt_addr addr, blt_int32u len)
   {
     return BLT_FALSE;
   }
-  /* erase the sectors */
-  return FlashEraseSectors(first_sector, last_sector);
+  /* a new region completes the previous one */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+
+  start = FlashGetSectorStart(addr);
+  end = FlashGetSectorEnd(addr+len-1);
+  /* the first sector is always erased, so that the user program is not valid until its
+   * checksum is written at the end of the programming session
+   */
+  if (start == flashLayout[0].sector_start)
+  {
+    if (FlashEraseRange(start, FlashGetSectorEnd(start)) == BLT_FALSE)
+    {
+      return BLT_FALSE;
+    }
+    start = FlashGetSectorEnd(start);
+  }
+  /* the next sectors are erased only when needed, as long as they fit sectorCopy */
+  lazy_end = start;
+  while ((lazy_end < end) &&
+         ((FlashGetSectorEnd(lazy_end) - lazy_end) <= FLASH_SECTOR_COPY_SIZE))
+  {
+    lazy_end = FlashGetSectorEnd(lazy_end);
+  }
+  if ((lazy_end < end) && (FlashEraseRange(lazy_end, end) == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+  eraseInfo.start = start;
+  eraseInfo.end = lazy_end;
+  eraseInfo.verified = start;
+  return BLT_TRUE;
 } /*** end of FlashErase ***/
 
 
@@ -424,7 +521,24 @@ blt_bool FlashVerifyChecksum(void)
 ****************************************************************************************/
 blt_bool FlashDone(void)
 {
-  /* check if there is still data waiting to be programmed in the boot block */
+  /* check if there is still data waiting to be programmed */
+  if (blockInfo.base_addr != FLASH_INVALID_ADDRESS)
+  {
+    if (FlashWriteBlock(&blockInfo) == BLT_FALSE)
+    {
+      return BLT_FALSE;
+    }
+  }
+
+  /* complete the background programming and the sectors waiting to be erased */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
+  {
+    return BLT_FALSE;
+  }
+
+  /* check if there is still data waiting to be programmed in the boot block, this is
+   * done last because it makes the user program valid
+   */
   if (bootBlockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
     if (FlashWriteBlock(&bootBlockInfo) == BLT_FALSE)
@@ -432,7 +546,21 @@ blt_bool FlashDone(void)
       return BLT_FALSE;
     }
   }
+  /* still here so all is okay */
+  return BLT_TRUE;
+} /*** end of FlashDone ***/
+
 
+/************************************************************************************//**
+** \brief     Programs the data waiting in the currently active block, the boot block is
+**            kept until FlashDone() so that the user program stays invalid until the
+**            checksum is written. Used by the delta programming to verify a region right
+**            after it was programmed.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+blt_bool FlashFlush(void)
+{
   /* check if there is still data waiting to be programmed */
   if (blockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
@@ -440,10 +568,55 @@ blt_bool FlashDone(void)
     {
       return BLT_FALSE;
     }
+    blockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  }
+  /* complete the background programming and the sectors waiting to be erased */
+  if ((FlashWaitProgram() == BLT_FALSE) || (FlashFinishErase() == BLT_FALSE))
+  {
+    return BLT_FALSE;
   }
   /* still here so all is okay */
   return BLT_TRUE;
-} /*** end of FlashDone ***/
+} /*** end of FlashFlush ***/
+
+
+/************************************************************************************//**
+** \brief     Programs part of the block waiting in programBlockInfo. Called continuously
+**            by NvmTask(), so that the next block is received while the previous one is
+**            being programmed.
+** \return    none.
+**
+****************************************************************************************/
+void FlashTask(void)
+{
+  blt_int32u len;
+
+  /* check if there is a block waiting to be programmed */
+  if (programBlockInfo.base_addr == FLASH_INVALID_ADDRESS)
+  {
+    return;
+  }
+
+  len = FLASH_PROGRAM_UNITS_PER_TASK * FLASH_PROGRAM_UNIT_SIZE;
+  if (len > (FLASH_WRITE_BLOCK_SIZE - programOffset))
+  {
+    len = FLASH_WRITE_BLOCK_SIZE - programOffset;
+  }
+  if (FlashProgram(programBlockInfo.base_addr + programOffset,
+                   &programBlockInfo.data[programOffset], len) == BLT_FALSE)
+  {
+    /* the error is reported by the next flash operation */
+    programError = BLT_TRUE;
+    programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+    return;
+  }
+  programOffset += len;
+  if (programOffset >= FLASH_WRITE_BLOCK_SIZE)
+  {
+    /* block done */
+    programBlockInfo.base_addr = FLASH_INVALID_ADDRESS;
+  }
+} /*** end of FlashTask ***/
 
 
 /************************************************************************************//**
@@ -479,9 +652,18 @@ static blt_bool FlashInitBlock(tFlashBlockInfo *block, blt_addr address)
     /* block already initialized, so nothing to do */
     return BLT_TRUE;
   }
-  /* set the base address and copies the current data from flash */
+  /* set the base address and copies the current data from flash. a sector waiting to
+   * be erased is already considered erased.
+   */
   block->base_addr = address;
-  CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+  if ((address >= eraseInfo.start) && (address < eraseInfo.end))
+  {
+    CpuMemSet((blt_addr)block->data, 0xff, FLASH_WRITE_BLOCK_SIZE);
+  }
+  else
+  {
+    CpuMemCopy((blt_addr)block->data, address, FLASH_WRITE_BLOCK_SIZE);
+  }
   return BLT_TRUE;
 } /*** end of FlashInitBlock ***/
 
@@ -620,10 +802,7 @@ static blt_bool FlashAddToBlock(tFlashBlockInfo *block, blt_addr address,
 ****************************************************************************************/
 static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
 {
-  blt_addr   prog_addr;
-  blt_int32u prog_data;
-  blt_int32u word_cnt;
-  blt_bool   result = BLT_TRUE;
+  blt_bool skip;
 
 #if (BOOT_FLASH_CRYPTO_HOOKS_ENABLE > 0)
   #if (BOOT_NVM_CHECKSUM_HOOKS_ENABLE == 0)
@@ -641,36 +820,218 @@ static blt_bool FlashWriteBlock(tFlashBlockInfo *block)
   }
 #endif
 
-  /* unlock the flash peripheral to enable the flash control register access. */
-  HAL_FLASH_Unlock();
+  /* wait for the previous block, only one block is programmed at a time */
+  if (FlashWaitProgram() == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+
+  /* the boot block is the last one and it is programmed right away */
+  if (block == &bootBlockInfo)
+  {
+    return FlashProgram(block->base_addr, block->data, FLASH_WRITE_BLOCK_SIZE);
+  }
+
+  /* the block might already be in flash, or its sector might need to be erased */
+  if (FlashCheckErase(block, &skip) == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+  if (skip == BLT_TRUE)
+  {
+    return BLT_TRUE;
+  }
+
+  /* program the block in the background while the next one is received */
+  programBlockInfo.base_addr = block->base_addr;
+  CpuMemCopy((blt_addr)programBlockInfo.data, (blt_addr)block->data, FLASH_WRITE_BLOCK_SIZE);
+  programOffset = 0;
+  return BLT_TRUE;
+} /*** end of FlashWriteBlock ***/
+
+
+/************************************************************************************//**
+** \brief     Completes the programming of the block in programBlockInfo.
+** \return    BLT_TRUE if successful, BLT_FALSE if the block or a previous one could not
+**            be programmed.
+**
+****************************************************************************************/
+static blt_bool FlashWaitProgram(void)
+{
+  blt_bool result = BLT_TRUE;
 
-  /* program all words in the block one by one */
-  for (word_cnt=0; word_cnt<(FLASH_WRITE_BLOCK_SIZE/sizeof(blt_int32u)); word_cnt++)
+  while (programBlockInfo.base_addr != FLASH_INVALID_ADDRESS)
   {
-    prog_addr = block->base_addr + (word_cnt * sizeof(blt_int32u));
-    prog_data = *(volatile blt_int32u *)(&block->data[word_cnt * sizeof(blt_int32u)]);
     /* keep the watchdog happy */
     CopService();
-    /* program the word */
-    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, prog_addr, prog_data) != HAL_OK)
+    FlashTask();
+  }
+  /* report and clear the error of the background programming */
+  if (programError == BLT_TRUE)
+  {
+    programError = BLT_FALSE;
+    result = BLT_FALSE;
+  }
+  return result;
+} /*** end of FlashWaitProgram ***/
+
+
+/************************************************************************************//**
+** \brief     Checks a block against the content of its sector when the sector is still
+**            waiting to be erased. The block is skipped if the sector already holds it,
+**            otherwise the sector is erased and programmed together with the block.
+** \param     block Pointer to flash block info structure to operate on.
+** \param     skip  Set to BLT_TRUE when the block does not need to be programmed anymore.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashCheckErase(tFlashBlockInfo *block, blt_bool *skip)
+{
+  blt_addr addr = block->base_addr;
+  blt_int32u idx;
+
+  *skip = BLT_FALSE;
+  /* nothing to do if the sector is not waiting to be erased */
+  if ((addr < eraseInfo.start) || (addr >= eraseInfo.end))
+  {
+    return BLT_TRUE;
+  }
+
+  /* the sectors before the block are complete */
+  while (addr >= FlashGetSectorEnd(eraseInfo.start))
+  {
+    if (FlashFinishSector(BLT_NULL) == BLT_FALSE)
     {
-      result = BLT_FALSE;
-      break;
+      return BLT_FALSE;
     }
-    /* verify that the written data is actually there */
-    if (*(volatile blt_int32u *)prog_addr != prog_data)
+  }
+
+  /* the block is already in flash if it matches and everything between the checked
+   * content and the block is erased
+   */
+  *skip = BLT_TRUE;
+  if ((addr >= eraseInfo.verified) && (FlashIsErased(eraseInfo.verified, addr) == BLT_TRUE))
+  {
+    for (idx = 0; idx < FLASH_WRITE_BLOCK_SIZE; idx++)
     {
-      result = BLT_FALSE;
-      break;
+      if (block->data[idx] != *(volatile blt_int8u *)(addr + idx))
+      {
+        break;
+      }
+    }
+    if (idx == FLASH_WRITE_BLOCK_SIZE)
+    {
+      eraseInfo.verified = addr + FLASH_WRITE_BLOCK_SIZE;
+      return BLT_TRUE;
     }
   }
+  /* the sector differs, erase it and program it with the block */
+  return FlashFinishSector(block);
+} /*** end of FlashCheckErase ***/
 
-  /* lock the flash peripheral to disable the flash control register access. */
-  HAL_FLASH_Lock();
 
-  /* Give the result back to the caller. */
-  return result;
-} /*** end of FlashWriteBlock ***/
+/************************************************************************************//**
+** \brief     Completes the first sector waiting to be erased. The sector is erased only
+**            if its content differs from the one it would have after the erase and the
+**            programming of the checked content and of the block.
+** \param     block Pointer to the block to program in the sector, or BLT_NULL.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashFinishSector(tFlashBlockInfo *block)
+{
+  blt_addr   start = eraseInfo.start;
+  blt_addr   end = FlashGetSectorEnd(start);
+  blt_int32u len = eraseInfo.verified - start;
+  blt_int32u idx;
+
+  /* move to the next sector */
+  eraseInfo.start = end;
+  eraseInfo.verified = end;
+
+  /* the rest of the sector has to be erased to keep it */
+  if ((block == BLT_NULL) && (FlashIsErased(start + len, end) == BLT_TRUE))
+  {
+    return BLT_TRUE;
+  }
+
+  /* copy the checked content and add the block */
+  for (idx = 0; idx < len; idx++)
+  {
+    sectorCopy[idx] = *(volatile blt_int8u *)(start + idx);
+  }
+  if (block != BLT_NULL)
+  {
+    for (; idx < (block->base_addr - start); idx++)
+    {
+      sectorCopy[idx] = 0xff;
+    }
+    for (idx = 0; idx < FLASH_WRITE_BLOCK_SIZE; idx++)
+    {
+      sectorCopy[block->base_addr - start + idx] = block->data[idx];
+    }
+    if (len < (block->base_addr - start + FLASH_WRITE_BLOCK_SIZE))
+    {
+      len = block->base_addr - start + FLASH_WRITE_BLOCK_SIZE;
+    }
+  }
+
+  /* erase the sector and program it again */
+  if (FlashEraseRange(start, end) == BLT_FALSE)
+  {
+    return BLT_FALSE;
+  }
+  if (len == 0)
+  {
+    return BLT_TRUE;
+  }
+  return FlashProgram(start, sectorCopy, len);
+} /*** end of FlashFinishSector ***/
+
+
+/************************************************************************************//**
+** \brief     Completes all the sectors waiting to be erased.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashFinishErase(void)
+{
+  while (eraseInfo.start < eraseInfo.end)
+  {
+    if (FlashFinishSector(BLT_NULL) == BLT_FALSE)
+    {
+      eraseInfo.start = FLASH_INVALID_ADDRESS;
+      eraseInfo.end = FLASH_INVALID_ADDRESS;
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of FlashFinishErase ***/
+
+
+/************************************************************************************//**
+** \brief     Checks if a flash region is erased.
+** \param     start First address of the region.
+** \param     end   End address of the region, not included.
+** \return    BLT_TRUE if every byte is erased, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashIsErased(blt_addr start, blt_addr end)
+{
+  for (; start < end; start++)
+  {
+    /* keep the watchdog happy */
+    if ((start % FLASH_WRITE_BLOCK_SIZE) == 0)
+    {
+      CopService();
+    }
+    if (*(volatile blt_int8u *)start != 0xff)
+    {
+      return BLT_FALSE;
+    }
+  }
+  return BLT_TRUE;
+} /*** end of FlashIsErased ***/
 
 
 /************************************************************************************//**
@@ -767,4 +1128,110 @@ static blt_int8u FlashGetSector(blt_addr address)
 } /*** end of FlashGetSector ***/
 
 
+/************************************************************************************//**
+** \brief     Determines the start address of the flash sector the address is in.
+** \param     address Address in the flash sector.
+** \return    Start address of the sector or FLASH_INVALID_ADDRESS.
+**
+****************************************************************************************/
+static blt_addr FlashGetSectorStart(blt_addr address)
+{
+  blt_int8u sectorIdx;
+
+  for (sectorIdx = 0; sectorIdx < FLASH_TOTAL_SECTORS; sectorIdx++)
+  {
+    if ((address >= flashLayout[sectorIdx].sector_start) && \
+        (address < (flashLayout[sectorIdx].sector_start + \
+                    flashLayout[sectorIdx].sector_size)))
+    {
+      return flashLayout[sectorIdx].sector_start;
+    }
+  }
+  return FLASH_INVALID_ADDRESS;
+} /*** end of FlashGetSectorStart ***/
+
+
+/************************************************************************************//**
+** \brief     Determines the end address of the flash sector the address is in.
+** \param     address Address in the flash sector.
+** \return    First address after the sector or FLASH_INVALID_ADDRESS.
+**
+****************************************************************************************/
+static blt_addr FlashGetSectorEnd(blt_addr address)
+{
+  blt_int8u sectorIdx;
+
+  for (sectorIdx = 0; sectorIdx < FLASH_TOTAL_SECTORS; sectorIdx++)
+  {
+    if ((address >= flashLayout[sectorIdx].sector_start) && \
+        (address < (flashLayout[sectorIdx].sector_start + \
+                    flashLayout[sectorIdx].sector_size)))
+    {
+      return flashLayout[sectorIdx].sector_start + flashLayout[sectorIdx].sector_size;
+    }
+  }
+  return FLASH_INVALID_ADDRESS;
+} /*** end of FlashGetSectorEnd ***/
+
+
+/************************************************************************************//**
+** \brief     Erases the flash sectors of a region.
+** \param     start First address of the region, at the start of a sector.
+** \param     end   End address of the region, not included.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashEraseRange(blt_addr start, blt_addr end)
+{
+  return FlashEraseSectors(FlashGetSector(start), FlashGetSector(end-1));
+} /*** end of FlashEraseRange ***/
+
+
+/************************************************************************************//**
+** \brief     Programs data to flash one word at a time.
+** \param     addr Start address, aligned to a word.
+** \param     data Pointer to the data.
+** \param     len  Number of bytes, a multiple of a word.
+** \return    BLT_TRUE if successful, BLT_FALSE otherwise.
+**
+****************************************************************************************/
+static blt_bool FlashProgram(blt_addr addr, blt_int8u *data, blt_int32u len)
+{
+  blt_addr   prog_addr;
+  blt_int32u prog_data;
+  blt_int32u word_cnt;
+  blt_bool   result = BLT_TRUE;
+
+  /* unlock the flash peripheral to enable the flash control register access. */
+  HAL_FLASH_Unlock();
+
+  /* program all words one by one */
+  for (word_cnt=0; word_cnt<(len/sizeof(blt_int32u)); word_cnt++)
+  {
+    prog_addr = addr + (word_cnt * sizeof(blt_int32u));
+    prog_data = *(volatile blt_int32u *)(&data[word_cnt * sizeof(blt_int32u)]);
+    /* keep the watchdog happy */
+    CopService();
+    /* program the word */
+    if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, prog_addr, prog_data) != HAL_OK)
+    {
+      result = BLT_FALSE;
+      break;
+    }
+    /* verify that the written data is actually there */
+    if (*(volatile blt_int32u *)prog_addr != prog_data)
+    {
+      result = BLT_FALSE;
+      break;
+    }
+  }
+
+  /* lock the flash peripheral to disable the flash control register access. */
+  HAL_FLASH_Lock();
+
+  /* Give the result back to the caller. */
+  return result;
+} /*** end of FlashProgram ***/
+
+
 /*********************************** end of flash.c ************************************/
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""
+Update a board through its OpenBLT bootloader sending only the sectors that changed
+
+The bootloader computes the CRC32 of the firmware it holds, sector by sector, so
+only the sectors which differ from the new image are erased and sent again,
+compressed (see openblt_common/delta.c for the protocol and the
+format). The first sector is always rewritten because the bootloader writes the
+checksum which makes the firmware valid only at the end of the update. If the
+whole firmware already matches the board is just restarted.
+
+With --full the whole image is sent compressed as a single region, without
+reading anything from the board first.
+
+The board has to be in its bootloader already, like with bootcommander.
+
+Usage:
+    delta_flash.py -d can1 -tid 667 -rid 7E1 -t mainboard fenice-bms.bin
+    delta_flash.py -d can0 -tid 004 -rid 005 -t cellboard cellboard.bin
+"""
+
+import argparse
+import os
+import re
+import socket
+import struct
+import sys
+import time
+import zlib
+
+BASE_ADDRESS = 0x08004000
+
+# Erase sectors of the firmware as (offset, size), must match flashLayout[] in flash.c
+LAYOUTS = {
+    "mainboard": [(0x00000, 0x4000), (0x04000, 0x4000), (0x08000, 0x4000), (0x0C000, 0x10000),
+                  (0x1C000, 0x20000), (0x3C000, 0x20000), (0x5C000, 0x20000)],
+    "cellboard": [(offset, 0x800) for offset in range(0, 0x3C000, 0x800)],
+}
+
+# Configuration of the bootloader of each target, it holds the offset of the checksum
+BLT_CONF = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "openblt_%s", "Core", "Inc", "BLT", "blt_conf.h")
+
+XCP_CONNECT = 0xFF
+XCP_PROGRAM = 0xD0
+XCP_PROGRAM_RESET = 0xCF
+XCP_USER = 0xF1
+XCP_PID_RES = 0xFF
+
+DELTA_CMD_CRC = 0x01
+DELTA_CMD_BEGIN = 0x02
+DELTA_CMD_DATA = 0x03
+DELTA_CMD_END = 0x04
+
+WINDOW_SIZE = 1024
+MIN_MATCH = 3
+MATCH_EXTRA = 31
+MAX_MATCH = MATCH_EXTRA + MIN_MATCH + 255
+MAX_LITERALS = 128
+MAX_CHAIN = 32
+
+CAN_FRAME = struct.Struct("=IB3x8s")
+
+
+class XcpError(Exception):
+    pass
+
+
+class Xcp:
+    def __init__(self, interface, tid, rid):
+        self.tid = tid
+        self.rid = rid
+        self.sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+        self.sock.bind((interface,))
+
+    def command(self, data, timeout=0.1):
+        self.sock.send(CAN_FRAME.pack(self.tid, len(data), bytes(data).ljust(8, b"\x00")))
+        end = time.monotonic() + timeout
+        while True:
+            left = end - time.monotonic()
+            if left <= 0:
+                raise XcpError("timeout on command 0x%02X" % data[0])
+            self.sock.settimeout(left)
+            try:
+                can_id, length, payload = CAN_FRAME.unpack(self.sock.recv(CAN_FRAME.size))
+            except socket.timeout:
+                continue
+            if can_id != self.rid:
+                continue
+            if payload[0] != XCP_PID_RES:
+                raise XcpError("command 0x%02X failed with error 0x%02X" % (data[0], payload[1]))
+            return payload[:length]
+
+    def connect(self, attempts=50):
+        for _ in range(attempts):
+            try:
+                return self.command([XCP_CONNECT, 0x00], timeout=0.02)
+            except XcpError:
+                pass
+        raise XcpError("the bootloader does not answer")
+
+    def crc(self, offset, length):
+        answer = self.command([XCP_USER, DELTA_CMD_CRC] + list(struct.pack("<I", offset)[:3]) +
+                              list(struct.pack("<I", length)[:3]), timeout=2.0)
+        return struct.unpack("<I", answer[4:8])[0]
+
+
+def load_image(path):
+    """Read a .bin starting at BASE_ADDRESS or a .srec, the gaps are filled with 0xFF"""
+    with open(path, "rb") as f:
+        content = f.read()
+    if not path.endswith(".srec"):
+        return bytearray(content)
+
+    records = []
+    for line in content.decode().split():
+        if line[:2] not in ("S1", "S2", "S3"):
+            continue
+        record = bytes.fromhex(line[4:])
+        address_length = int(line[1]) + 1
+        address = int.from_bytes(record[:address_length], "big")
+        records.append((address - BASE_ADDRESS, record[address_length:-1]))
+    image = bytearray(b"\xFF" * max(offset + len(data) for offset, data in records))
+    for offset, data in records:
+        image[offset:offset + len(data)] = data
+    return image
+
+
+def checksum_offset(target):
+    """Read BOOT_FLASH_VECTOR_TABLE_CS_OFFSET from the configuration of the bootloader"""
+    with open(BLT_CONF % target) as f:
+        match = re.search(r"#define\s+BOOT_FLASH_VECTOR_TABLE_CS_OFFSET\s+\(?\s*(0[xX][0-9a-fA-F]+|\d+)", f.read())
+    if match is None:
+        sys.exit("BOOT_FLASH_VECTOR_TABLE_CS_OFFSET not found for the %s" % target)
+    return int(match.group(1), 0)
+
+
+def patch_checksum(image, target):
+    """Write the checksum of the vector table like FlashWriteChecksum() does"""
+    offset = checksum_offset(target)
+    words = struct.unpack("<7I", image[:28])
+    image[offset:offset + 4] = struct.pack("<I", (-sum(words)) & 0xFFFFFFFF)
+
+
+def compress(data):
+    """Greedy LZ with a hash chain over the last 3 bytes, see delta.c for the format"""
+    out = bytearray()
+    literals = bytearray()
+    heads = {}
+    chain = [0] * len(data)
+    i = 0
+
+    def flush_literals():
+        while literals:
+            run = literals[:MAX_LITERALS]
+            out.append(len(run) - 1)
+            out.extend(run)
+            del literals[:MAX_LITERALS]
+
+    def insert(pos):
+        if pos + MIN_MATCH <= len(data):
+            key = bytes(data[pos:pos + MIN_MATCH])
+            chain[pos] = heads.get(key, -1)
+            heads[key] = pos
+
+    while i < len(data):
+        best_length, best_distance = 0, 0
+        if i + MIN_MATCH <= len(data):
+            candidate = heads.get(bytes(data[i:i + MIN_MATCH]), -1)
+            for _ in range(MAX_CHAIN):
+                if candidate < 0 or i - candidate > WINDOW_SIZE:
+                    break
+                length = 0
+                limit = min(MAX_MATCH, len(data) - i)
+                while length < limit and data[candidate + length] == data[i + length]:
+                    length += 1
+                if length > best_length:
+                    best_length, best_distance = length, i - candidate
+                    if length == limit:
+                        break
+                candidate = chain[candidate]
+
+        if best_length >= MIN_MATCH:
+            flush_literals()
+            distance = best_distance - 1
+            length = min(best_length - MIN_MATCH, MATCH_EXTRA)
+            out.append(0x80 | (length << 2) | (distance >> 8))
+            out.append(distance & 0xFF)
+            if length == MATCH_EXTRA:
+                out.append(best_length - MATCH_EXTRA - MIN_MATCH)
+            for pos in range(i, i + best_length):
+                insert(pos)
+            i += best_length
+        else:
+            literals.append(data[i])
+            insert(i)
+            i += 1
+    flush_literals()
+    return bytes(out)
+
+
+def program_region(xcp, offset, data):
+    """Erase, send and verify a region, returns the number of bytes sent"""
+    stream = compress(data)
+    crc = zlib.crc32(data) & 0xFFFFFFFF
+    # Erasing a 128 KB sector of the F4 takes up to 2 seconds
+    xcp.command([XCP_USER, DELTA_CMD_BEGIN] + list(struct.pack("<I", offset)[:3]) +
+                list(struct.pack("<I", len(data))[:3]), timeout=5.0 + 2.0 * len(data) / 0x20000)
+    for i in range(0, len(stream), 6):
+        xcp.command([XCP_USER, DELTA_CMD_DATA] + list(stream[i:i + 6]))
+    xcp.command([XCP_USER, DELTA_CMD_END, 0, 0] + list(struct.pack("<I", crc)), timeout=2.0)
+    return len(stream)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("-d", "--device", required=True, help="CAN interface, like can1")
+    parser.add_argument("-tid", required=True, type=lambda x: int(x, 16), help="transmission ID (hex)")
+    parser.add_argument("-rid", required=True, type=lambda x: int(x, 16), help="reception ID (hex)")
+    parser.add_argument("-t", "--target", required=True, choices=LAYOUTS.keys())
+    parser.add_argument("--full", action="store_true", help="send the whole image compressed")
+    parser.add_argument("image", help="firmware .srec or binary starting at 0x%08X" % BASE_ADDRESS)
+    args = parser.parse_args()
+
+    image = load_image(args.image)
+    layout = LAYOUTS[args.target]
+    if len(image) > layout[-1][0] + layout[-1][1]:
+        sys.exit("the image does not fit in the %s flash" % args.target)
+    patch_checksum(image, args.target)
+
+    xcp = Xcp(args.device, args.tid, args.rid)
+    xcp.connect()
+    start = time.monotonic()
+
+    if not args.full and xcp.crc(0, len(image)) == zlib.crc32(image) & 0xFFFFFFFF:
+        print("the firmware is already up to date")
+    else:
+        sent = 0
+        if args.full:
+            regions = [(0, image)]
+        else:
+            regions = [(offset, image[offset:offset + size]) for offset, size in layout if offset < len(image)]
+        for index, (offset, data) in enumerate(regions):
+            if index != 0 and xcp.crc(offset, len(data)) == zlib.crc32(data) & 0xFFFFFFFF:
+                continue
+            print("sector at 0x%08X: %d bytes" % (BASE_ADDRESS + offset, len(data)))
+            try:
+                sent += program_region(xcp, offset, data)
+            except XcpError as error:
+                print("  %s, trying again" % error)
+                sent += program_region(xcp, offset, data)
+        # Program the first block and the checksum which make the firmware valid
+        xcp.command([XCP_PROGRAM, 0x00], timeout=5.0)
+        print("sent %d bytes instead of %d (%.1f%% saved) in %.1f s" %
+              (sent, len(image), 100.0 * (1 - sent / len(image)), time.monotonic() - start))
+
+    try:
+        xcp.command([XCP_PROGRAM_RESET], timeout=0.05)
+    except XcpError:
+        pass  # The bootloader does not answer the reset
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except XcpError as error:
+        sys.exit("update failed: %s" % error)
@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""
+Estimate the bytes on the CAN bus and the time needed to flash an image
+
+Compares the plain XCP programming done by bootcommander with the compressed
+stream of delta_flash.py --full and, when the image already on the board is
+given with --old, with the sector delta of delta_flash.py. The time is modeled
+from the frames on the bus, the round trip of every command, which are all
+synchronous, and the flash programming and erase times from the datasheets.
+The bootloader programs a block while the next one is received and erases a
+sector only when the data differs from its content (see flash.c), the time
+spent waiting for the flash is reported separately.
+
+Usage:
+    flash_benchmark.py                      (the images in scripts/binaries)
+    flash_benchmark.py -t cellboard new.srec --old old.srec
+"""
+
+import argparse
+import os
+import sys
+
+import delta_flash
+
+# Block programmed in the background and largest sector erased only when it differs,
+# must match FLASH_WRITE_BLOCK_SIZE and FLASH_SECTOR_COPY_SIZE in flash.c
+WRITE_BLOCK_SIZE = 512
+SECTOR_COPY_SIZE = {"mainboard": 0x10000, "cellboard": 0x800}
+
+# Typical programming time of a byte and erase time of a sector, in seconds
+FLASH_TIMING = {
+    # STM32F4 with x32 parallelism: 16 us per word, sectors of 16/64/128 KB
+    "mainboard": (16e-6 / 4, {0x4000: 0.5, 0x10000: 1.1, 0x20000: 2.0}),
+    # STM32L4: 81.69 us per double word, pages of 2 KB
+    "cellboard": (81.69e-6 / 8, {0x800: 0.022}),
+}
+
+DEFAULT_IMAGES = [("mainboard", "binaries/fenice-bms.srec"), ("cellboard", "binaries/cellboard.srec")]
+
+
+def frame_bits(length):
+    """Bits of a standard CAN frame with the worst case bit stuffing"""
+    return 47 + 8 * length + (34 + 8 * length - 1) // 4
+
+
+class Bus:
+    def __init__(self, bitrate, latency):
+        self.bitrate = bitrate
+        self.latency = latency
+        self.bytes = 0
+        self.bits = 0
+        self.time = 0.0
+        self.busy = 0.0
+
+    def command(self, length, answer_length=1, busy=0.0):
+        """A request and its answer, busy is the time the bootloader needs to execute it"""
+        self.bytes += length + answer_length
+        bits = frame_bits(length) + frame_bits(answer_length)
+        self.bits += bits
+        self.time += bits / self.bitrate + self.latency + busy
+        self.busy += busy
+
+
+def erase_time(target, offset, length, old=None, image=None):
+    """Time to erase the sectors which contain a region. The bootloader always erases the
+    first sector and those larger than SECTOR_COPY_SIZE, the others only if they differ
+    from the image on the board, when it is known"""
+    timing = FLASH_TIMING[target][1]
+    total = 0.0
+    for index, (sector_offset, size) in enumerate(delta_flash.LAYOUTS[target]):
+        if sector_offset < offset + length and offset < sector_offset + size:
+            end = min(sector_offset + size, len(image)) if image is not None else 0
+            if (old is None or index == 0 or size > SECTOR_COPY_SIZE[target] or
+                    image[sector_offset:end] != old[sector_offset:end]):
+                total += timing[size]
+    return total
+
+
+def block_wait(target, frames_per_block, frame_length, bus):
+    """A block is programmed while the next one is received, the frame completing a block
+    waits only if the previous one is not done yet"""
+    block_transfer = frames_per_block * ((frame_bits(frame_length) + frame_bits(1)) / bus.bitrate + bus.latency)
+    return max(0.0, FLASH_TIMING[target][0] * WRITE_BLOCK_SIZE - block_transfer)
+
+
+def plain(target, image, bus, old=None):
+    """bootcommander: PROGRAM_MAX with 7 bytes per frame after clearing the memory"""
+    wait = block_wait(target, WRITE_BLOCK_SIZE / 7, 8, bus)
+    bus.command(2, 8)                                       # CONNECT
+    bus.command(8)                                          # SET_MTA
+    bus.command(8, busy=erase_time(target, 0, len(image), old, image))  # PROGRAM_CLEAR
+    for offset in range(0, len(image), 7):
+        ends_block = offset // WRITE_BLOCK_SIZE != (offset + 7) // WRITE_BLOCK_SIZE
+        bus.command(min(7, len(image) - offset) + 1, busy=wait if ends_block else 0.0)
+    bus.command(2)                                          # PROGRAM with no data
+    bus.command(1, 0)                                       # PROGRAM_RESET
+
+
+def compressed(target, regions, bus):
+    """delta_flash.py: each region erased, sent compressed and verified"""
+    bus.command(2, 8)                                       # CONNECT
+    for offset, data in regions:
+        stream = delta_flash.compress(data)
+        frames_per_block = WRITE_BLOCK_SIZE * len(stream) / len(data) / 6
+        wait = block_wait(target, frames_per_block, 8, bus)
+        bus.command(8, busy=erase_time(target, offset, len(data)))
+        for i in range(0, len(stream), 6):
+            chunk = min(6, len(stream) - i)
+            bus.command(chunk + 2, busy=wait / frames_per_block)
+        # The last block is programmed and the region is read back
+        bus.command(8, busy=FLASH_TIMING[target][0] * WRITE_BLOCK_SIZE)
+    bus.command(2)                                          # PROGRAM with no data
+    bus.command(1, 0)                                       # PROGRAM_RESET
+
+
+def delta_regions(target, image, old):
+    """Sectors which differ from the image on the board, the first is always sent"""
+    regions = []
+    for index, (offset, size) in enumerate(delta_flash.LAYOUTS[target]):
+        if offset >= len(image):
+            break
+        data = image[offset:offset + size]
+        if index == 0 or data != old[offset:offset + len(data)]:
+            regions.append((offset, data))
+    return regions
+
+
+def report(name, bus):
+    print("  %-12s %8d bytes %9d bits %7.2f s (%.2f s waiting for the flash)" %
+          (name, bus.bytes, bus.bits, bus.time, bus.busy))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    parser.add_argument("-t", "--target", choices=delta_flash.LAYOUTS.keys())
+    parser.add_argument("image", nargs="?", help="image to flash, .srec or .bin")
+    parser.add_argument("--old", help="image already on the board, .srec or .bin")
+    parser.add_argument("-b", "--bitrate", type=int, default=1000000)
+    parser.add_argument("--latency", type=float, default=0.5, help="round trip of a command in ms")
+    args = parser.parse_args()
+
+    if args.image is not None:
+        if args.target is None:
+            sys.exit("the target is needed with an image")
+        images = [(args.target, args.image)]
+    else:
+        here = os.path.dirname(os.path.abspath(__file__))
+        images = [(target, os.path.join(here, path)) for target, path in DEFAULT_IMAGES]
+
+    for target, path in images:
+        image = delta_flash.load_image(path)
+        stream = delta_flash.compress(image)
+        print("%s (%s): %d bytes, compressed %d (%.1f%%)" %
+              (os.path.basename(path), target, len(image), len(stream), 100.0 * len(stream) / len(image)))
+
+        runs = [("plain", lambda bus: plain(target, image, bus)),
+                ("compressed", lambda bus: compressed(target, [(0, image)], bus))]
+        if args.old is not None:
+            old = delta_flash.load_image(args.old)
+            runs.append(("plain, skip", lambda bus: plain(target, image, bus, old)))
+            runs.append(("delta", lambda bus: compressed(target, delta_regions(target, image, old), bus)))
+        for name, run in runs:
+            bus = Bus(args.bitrate, args.latency / 1000.0)
+            run(bus)
+            report(name, bus)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,189 @@
+#!/usr/bin/env python3
+"""
+Decode the binary telemetry stream of the mainboard into a CSV file
+
+The stream is enabled from the CLI with `telemetry <rate>`, each snapshot is
+sent as a frame with the state of the pack followed by a frame for each
+cellboard. The frames are COBS encoded and enclosed between zero bytes (see
+mainboard/Inc/telemetry.h for the format). Any text printed by the CLI in
+between is discarded because it does not pass the CRC check. The size of the
+pack is read from the stream, the cells of a cellboard whose frame is lost are
+left empty.
+
+Usage:
+    telemetry_decode.py /dev/ttyUSB0 -o capture.csv     (requires pyserial)
+    telemetry_decode.py raw_capture.bin -o capture.csv
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+FEEDBACK_COUNT = 20
+
+FRAME_SNAPSHOT = 0x01
+FRAME_CELLBOARD = 0x02
+STATE_NAMES = ["init", "idle", "fatal_error", "wait_airn_close", "wait_ts_precharge", "wait_airp_close", "ts_on"]
+
+SNAPSHOT = struct.Struct("<IBiIIBB")
+CELLBOARD = struct.Struct("<IBBBB")
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def decode_frame(data):
+    raw = cobs_decode(data)
+    if raw is None or len(raw) < 4:
+        return None
+    if crc16(raw[:-2]) != struct.unpack("<H", raw[-2:])[0]:
+        return None
+    return raw[0], raw[1], raw[2:-2]
+
+
+def temperature(value):
+    return round(value / 2.56 - 20, 2)
+
+
+def header(cellboard_count, cell_count):
+    columns = ["timestamp_ms", "seq", "state", "current_A"]
+    columns += ["cell_%d_V" % i for i in range(cellboard_count * cell_count)]
+    for name in ["min", "max", "avg"]:
+        columns += ["cellboard_%d_temp_%s_C" % (i, name) for i in range(cellboard_count)]
+    columns += ["feedback_%d" % i for i in range(FEEDBACK_COUNT)]
+    return columns
+
+
+class Snapshot:
+    def __init__(self, seq, payload):
+        (self.timestamp, self.state, self.current, self.high, self.error,
+         self.cellboard_count, self.cell_count) = SNAPSHOT.unpack(payload)
+        self.seq = seq
+        self.cellboards = {}
+
+    def add_cellboard(self, payload):
+        """Store the frame of a cellboard, False if it is not part of this snapshot"""
+        if len(payload) != CELLBOARD.size + self.cell_count * 2:
+            return False
+        timestamp, index, temp_min, temp_max, temp_avg = CELLBOARD.unpack_from(payload)
+        if timestamp != self.timestamp or index >= self.cellboard_count:
+            return False
+        voltages = struct.unpack_from("<%dH" % self.cell_count, payload, CELLBOARD.size)
+        self.cellboards[index] = (voltages, (temp_min, temp_max, temp_avg))
+        return True
+
+    def row(self):
+        state = STATE_NAMES[self.state] if self.state < len(STATE_NAMES) else self.state
+        row = [self.timestamp, self.seq, state, self.current / 1000.0]
+        for i in range(self.cellboard_count):
+            voltages = self.cellboards[i][0] if i in self.cellboards else [None] * self.cell_count
+            row += ["" if v is None else v / 10000.0 for v in voltages]
+        for t in range(3):
+            row += [temperature(self.cellboards[i][1][t]) if i in self.cellboards else ""
+                    for i in range(self.cellboard_count)]
+        for i in range(FEEDBACK_COUNT):
+            row.append("E" if self.error & (1 << i) else ("H" if self.high & (1 << i) else "L"))
+        return row
+
+
+def open_input(path, baudrate):
+    if path == "-":
+        return sys.stdin.buffer
+    if path.startswith("/dev/") or path.upper().startswith("COM"):
+        import serial
+        return serial.Serial(path, baudrate, timeout=1)
+    return open(path, "rb")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the mainboard telemetry stream into a CSV file")
+    parser.add_argument("input", help="serial port, raw capture file or - for stdin")
+    parser.add_argument("-o", "--output", default="-", help="output CSV file (default stdout)")
+    parser.add_argument("-b", "--baudrate", type=int, default=115200)
+    args = parser.parse_args()
+
+    src = open_input(args.input, args.baudrate)
+    dst = sys.stdout if args.output == "-" else open(args.output, "w", newline="")
+    writer = csv.writer(dst)
+
+    buffer = bytearray()
+    frames = errors = lost = 0
+    last_seq = None
+    columns = None
+    snapshot = None
+
+    def write(snapshot):
+        nonlocal columns
+        if columns is None:
+            columns = header(snapshot.cellboard_count, snapshot.cell_count)
+            writer.writerow(columns)
+        row = snapshot.row()
+        if len(row) != len(columns):
+            return False
+        writer.writerow(row)
+        return True
+
+    try:
+        while True:
+            chunk = src.read(4096)
+            if not chunk:
+                # A serial port returns nothing on timeout, a file at the end
+                if hasattr(src, "in_waiting"):
+                    continue
+                break
+            buffer += chunk
+            while True:
+                end = buffer.find(0)
+                if end < 0:
+                    break
+                frame = decode_frame(bytes(buffer[:end]))
+                del buffer[:end + 1]
+                if end == 0:
+                    continue
+                if frame is None:
+                    errors += 1
+                    continue
+                frame_type, seq, payload = frame
+                if last_seq is not None:
+                    lost += (seq - last_seq - 1) & 0xFF
+                last_seq = seq
+                if frame_type == FRAME_SNAPSHOT and len(payload) == SNAPSHOT.size:
+                    if snapshot is not None and write(snapshot):
+                        frames += 1
+                    snapshot = Snapshot(seq, payload)
+                elif frame_type != FRAME_CELLBOARD or snapshot is None or not snapshot.add_cellboard(payload):
+                    errors += 1
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if snapshot is not None and write(snapshot):
+            frames += 1
+        dst.flush()
+        print("%d snapshots, %d frames lost, %d invalid frames" % (frames, lost, errors), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()